@@ -0,0 +1,63 @@
+#include "Benchmarks.h"
+#include "Engine/Utils/LoggingManager.h"
+
+#include <vector>
+#include <utility>
+
+namespace Benchmarks
+{
+	void runBenchmarks(const std::string& filter)
+	{
+		const std::vector<std::pair<std::string, void(*)()>> BENCHMARKS
+		{
+			{ "BodyIntegration", benchmarkBodyIntegration },
+			{ "BarnesHut", benchmarkBarnesHut },
+			{ "JobScaling", benchmarkJobScaling },
+			{ "TransformKernels", benchmarkTransformKernels },
+			{ "Integrators", benchmarkIntegrators },
+			{ "RandomGeneration", benchmarkRandomGeneration },
+			{ "Collisions", benchmarkCollisions },
+#ifndef HEADLESS_ONLY
+			// The rendering benchmarks need the GL headers, so a headless only build leaves them out
+			{ "FrustumCulling", benchmarkFrustumCulling },
+			{ "LODSelection", benchmarkLODSelection },
+			{ "InstanceFormat", benchmarkInstanceFormat },
+			{ "VertexFormat", benchmarkVertexFormat },
+			{ "VertexCache", benchmarkVertexCache },
+			{ "LightClustering", benchmarkLightClustering },
+			{ "OcclusionCulling", benchmarkOcclusionCulling },
+			{ "Impostors", benchmarkImpostors },
+			{ "RenderQueue", benchmarkRenderQueue },
+			{ "DrawBatching", benchmarkDrawBatching },
+			{ "GeometryPool", benchmarkGeometryPool },
+			{ "StreamingBuffer", benchmarkStreamingBuffer },
+			{ "UniformHandles", benchmarkUniformHandles },
+			{ "ImpostorFrames", benchmarkImpostorFrames }
+#endif
+		};
+
+		for (const auto& benchmark : BENCHMARKS)
+		{
+			if (!filter.empty() && benchmark.first.find(filter) == std::string::npos)
+				continue;
+
+			OutputLog("Running benchmark: " + benchmark.first, Logging::Severity::NOTIFICATION);
+			benchmark.second();
+		}
+	}
+
+	TimePoint startTimer()
+	{
+		return std::chrono::high_resolution_clock::now();
+	}
+
+	double getElapsedSeconds(const TimePoint& start)
+	{
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	void reportResult(const std::string& result)
+	{
+		OutputLog(result, Logging::Severity::NOTIFICATION);
+	}
+}
\ No newline at end of file
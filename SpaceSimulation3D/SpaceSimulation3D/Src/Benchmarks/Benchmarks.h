@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+namespace Benchmarks
+{
+	typedef std::chrono::high_resolution_clock::time_point TimePoint;
+
+	constexpr uint64_t BENCHMARK_SEED = 0x5EED; // Every benchmark generates the same asteroid belt, so runs stay comparable
+
+	void runBenchmarks(const std::string& filter); // Runs every benchmark whose name contains the filter (all if empty)
+
+	TimePoint startTimer(); // Returns the current time point to measure from
+	double getElapsedSeconds(const TimePoint& start); // Returns the seconds passed since the given time point
+	void reportResult(const std::string& result); // Outputs a benchmark result line to the log
+
+	void benchmarkBodyIntegration(); // Reports ns/body/step of the orbital integration at 10k, 100k and 1M bodies
+	void benchmarkBarnesHut(); // Compares Barnes-Hut throughput and force error against direct summation
+	void benchmarkJobScaling(); // Reports the speedup of the instance matrix build loop across 1-N threads
+	void benchmarkTransformKernels(); // Compares matrices/sec of the glm chain against the scalar, SSE and AVX2 kernels
+	void benchmarkIntegrators(); // Reports the cost and energy/angular momentum drift of each integrator over several orbits
+	void benchmarkRandomGeneration(); // Compares the counter-based fill rate against std::mt19937 and checks belt reproducibility
+	void benchmarkCollisions(); // Reports pairs tested per second and the update time of the spatial hash broad phase
+	void benchmarkFrustumCulling(); // Reports the cull throughput at 1M instances for several views and checks it against per-sphere tests
+	void benchmarkLODSelection(); // Reports the offline simplification time and the per-frame binning cost and triangle savings of the LOD chain
+	void benchmarkInstanceFormat(); // Compares the upload size, build cost and vertex work of mat4 instances against the compact format
+	void benchmarkVertexFormat(); // Reports the memory saved, the cost and the error of quantizing the vertices of a mesh
+	void benchmarkVertexCache(); // Reports the simulated post-transform cache ACMR/ATVR and overdraw before and after optimizing the indices
+	void benchmarkLightClustering(); // Reports the light assignment cost, upload size and per-fragment light loop length at 1-1024 point lights
+	void benchmarkOcclusionCulling(); // Reports the rasterize and test cost of culling the asteroids behind the planet and checks nothing visible is culled
+	void benchmarkImpostors(); // Compares the binning cost, triangles and vertex shader runs of a 100k asteroid belt with and without impostors
+	void benchmarkRenderQueue(); // Compares the state switches of 1k-100k mixed draws in submission and sort key order, and the radix sort against std::stable_sort
+	void benchmarkDrawBatching(); // Reports the draw calls saved by batching 1-500 copies of each of a set of meshes and the cost of building the batches
+	void benchmarkGeometryPool(); // Reports the cost and fragmentation of churning the pool sub-allocator and the vao switches saved by sharing pool vaos
+	void benchmarkStreamingBuffer(); // Streams frames through a hidden context's ring buffer past the segment wrap and checks the data the GPU reads back
+	void benchmarkUniformHandles(); // Compares the CPU cost per draw of setting a draw's uniforms by name against setting them through handles
+	void benchmarkImpostorFrames(); // Reports the average frame time of drawing the 100k asteroid belt on a hidden context with and without impostors
+}
\ No newline at end of file
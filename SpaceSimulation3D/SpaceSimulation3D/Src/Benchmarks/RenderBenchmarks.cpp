@@ -0,0 +1,1573 @@
+#include "Benchmarks.h"
+#include "Engine/Buffers/RangeAllocator.h"
+#include "Engine/Buffers/StreamingBuffer.h"
+#include "Engine/Graphics/FrustumCuller.h"
+#include "Engine/Graphics/ImpostorAtlas.h"
+#include "Engine/Graphics/LightClusterer.h"
+#include "Engine/Graphics/LODSelector.h"
+#include "Engine/Graphics/OcclusionCuller.h"
+#include "Engine/Graphics/RenderQueue.h"
+#include "Engine/Graphics/ShaderPrograms.h"
+#include "Engine/Graphics/MeshOptimizer.h"
+#include "Engine/Graphics/MeshSimplifier.h"
+#include "Engine/Graphics/SceneLighting.h"
+#include "Engine/Graphics/SceneModel.h"
+#include "Engine/Graphics/VertexQuantizer.h"
+#include "Engine/Graphics/WindowFrame.h"
+#include "Engine/Simulation/OrbitalSimulation.h"
+#include "Engine/Utils/GLStateCache.h"
+#include "Engine/Utils/RandomGenerator.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <thread>
+
+namespace
+{
+	// Builds a lumpy rock from a subdivided icosahedron, standing in for the asteroid model which the benchmarks can't
+	// load without the graphics libraries
+	void generateRockMesh(uint32_t subdivisions, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+	{
+		const float GOLDEN = (1.0f + std::sqrt(5.0f)) * 0.5f;
+		positions =
+		{
+			{ -1.0f, GOLDEN, 0.0f }, { 1.0f, GOLDEN, 0.0f }, { -1.0f, -GOLDEN, 0.0f }, { 1.0f, -GOLDEN, 0.0f },
+			{ 0.0f, -1.0f, GOLDEN }, { 0.0f, 1.0f, GOLDEN }, { 0.0f, -1.0f, -GOLDEN }, { 0.0f, 1.0f, -GOLDEN },
+			{ GOLDEN, 0.0f, -1.0f }, { GOLDEN, 0.0f, 1.0f }, { -GOLDEN, 0.0f, -1.0f }, { -GOLDEN, 0.0f, 1.0f }
+		};
+
+		indices =
+		{
+			0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+			3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1
+		};
+
+		for (auto& position : positions)
+			position = glm::normalize(position);
+
+		// Split every triangle into four, sharing the new midpoint vertices between neighbouring triangles
+		for (uint32_t level = 0; level < subdivisions; level++)
+		{
+			std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+			auto getMidpoint = [&positions, &midpoints](uint32_t a, uint32_t b)
+			{
+				const auto KEY = std::make_pair(std::min(a, b), std::max(a, b));
+				const auto FOUND = midpoints.find(KEY);
+				if (FOUND != midpoints.end())
+					return FOUND->second;
+
+				positions.emplace_back(glm::normalize((positions[a] + positions[b]) * 0.5f));
+				return midpoints[KEY] = static_cast<uint32_t>(positions.size() - 1);
+			};
+
+			std::vector<uint32_t> subdivided;
+			for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+			{
+				const uint32_t A = indices[triangle], B = indices[triangle + 1], C = indices[triangle + 2];
+				const uint32_t AB = getMidpoint(A, B), BC = getMidpoint(B, C), CA = getMidpoint(C, A);
+				subdivided.insert(subdivided.end(), { A, AB, CA, B, BC, AB, C, CA, BC, AB, BC, CA });
+			}
+
+			indices.swap(subdivided);
+		}
+
+		for (auto& position : positions)
+		{
+			position = position * (1.0f + 0.15f * std::sin(3.0f * position.x) * std::cos(2.0f * position.y) +
+				0.05f * std::sin(9.0f * position.z));
+		}
+	}
+
+	// Counts the program, material and vao switches of executing the commands in the given order, the same way the render
+	// queue does
+	RenderQueueStats countSwitches(const std::vector<RenderCommand>& commands, const std::vector<uint32_t>& order)
+	{
+		RenderQueueStats stats;
+		uint32_t boundProgram = 0, boundMaterial = 0, boundVAO = 0;
+
+		for (uint32_t index : order)
+		{
+			const RenderCommand& COMMAND = commands[index];
+			if (COMMAND.m_program != boundProgram)
+			{
+				boundProgram = COMMAND.m_program;
+				boundMaterial = 0;
+				stats.m_programSwitches++;
+			}
+
+			if (COMMAND.m_material != boundMaterial)
+			{
+				boundMaterial = COMMAND.m_material;
+				stats.m_materialSwitches++;
+			}
+
+			if (COMMAND.m_vao != boundVAO)
+			{
+				boundVAO = COMMAND.m_vao;
+				stats.m_vaoSwitches++;
+			}
+		}
+
+		stats.m_commands = static_cast<uint32_t>(order.size());
+		return stats;
+	}
+
+	// The name-keyed uniform cache ShaderProgram had before uniform handles, kept to compare the handles against. Every set
+	// hashes the name to find its cached location (querying GL the first time) and compares the value against the last one
+	class NamedUniformCache
+	{
+	private:
+		const uint32_t m_program;
+		std::unordered_map<std::string, CachedUniform> m_uniformCache;
+
+		// Caches the value, returns the location to set or -1 if unchanged
+		int updateUniform(const std::string& uniform, const void* value, uint32_t size)
+		{
+			auto cached = m_uniformCache.find(uniform);
+			if (cached == m_uniformCache.end())
+			{
+				cached = m_uniformCache.emplace(uniform, CachedUniform()).first;
+				cached->second.m_location = glGetUniformLocation(m_program, uniform.c_str());
+			}
+
+			CachedUniform& entry = cached->second;
+			const bool CHANGED = entry.m_location >= 0 && (entry.m_size != size || std::memcmp(entry.m_value, value, size) != 0);
+
+			GLState::countCall(CHANGED);
+			if (!CHANGED)
+				return -1;
+
+			std::memcpy(entry.m_value, value, size);
+			entry.m_size = size;
+			return entry.m_location;
+		}
+	public:
+		explicit NamedUniformCache(uint32_t program) :
+			m_program(program)
+		{}
+
+		void setUniform(const std::string& uniform, int value)
+		{
+			const int LOCATION = this->updateUniform(uniform, &value, sizeof(value));
+			if (LOCATION >= 0)
+				glUniform1i(LOCATION, value);
+		}
+
+		void setUniform(const std::string& uniform, float value)
+		{
+			const int LOCATION = this->updateUniform(uniform, &value, sizeof(value));
+			if (LOCATION >= 0)
+				glUniform1f(LOCATION, value);
+		}
+
+		void setUniform(const std::string& uniform, bool value)
+		{
+			this->setUniform(uniform, static_cast<int>(value));
+		}
+
+		void setUniform(const std::string& uniform, const glm::mat4& matrix)
+		{
+			const int LOCATION = this->updateUniform(uniform, &matrix[0][0], sizeof(matrix));
+			if (LOCATION >= 0)
+				glUniformMatrix4fv(LOCATION, 1, GL_FALSE, &matrix[0][0]);
+		}
+
+		void setUniform(const std::string& uniform, const glm::vec3& vector)
+		{
+			const int LOCATION = this->updateUniform(uniform, &vector[0], sizeof(vector));
+			if (LOCATION >= 0)
+				glUniform3fv(LOCATION, 1, &vector[0]);
+		}
+	};
+}
+
+namespace Benchmarks
+{
+	void benchmarkFrustumCulling()
+	{
+		constexpr uint32_t NUM_INSTANCES = 1000000;
+		constexpr uint32_t NUM_REPEATS = 20;
+		constexpr float MODEL_RADIUS = 1.0f;
+
+		OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+		simulation.generateAsteroidBelt(NUM_INSTANCES, 14.0f, BENCHMARK_SEED);
+		std::vector<InstanceData> instances(NUM_INSTANCES), visible(NUM_INSTANCES);
+		simulation.buildInstances(instances);
+
+		const glm::mat4 PROJECTION = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100000.0f);
+		const std::vector<std::pair<std::string, glm::mat4>> VIEWS
+		{
+			{ "whole belt", glm::lookAt(glm::vec3(0.0f, 10.0f, 45.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)) },
+			{ "inside belt", glm::lookAt(glm::vec3(14.0f, 0.0f, 0.0f), glm::vec3(14.0f, 0.0f, -10.0f),
+				glm::vec3(0.0f, 1.0f, 0.0f)) },
+			{ "facing away", glm::lookAt(glm::vec3(0.0f, 0.0f, 45.0f), glm::vec3(0.0f, 0.0f, 90.0f),
+				glm::vec3(0.0f, 1.0f, 0.0f)) }
+		};
+
+		const uint32_t MAX_THREADS = std::max(1u, std::thread::hardware_concurrency());
+		for (const auto& view : VIEWS)
+		{
+			FrustumCuller culler;
+			culler.setFrustum(PROJECTION * view.second);
+
+			// The one-at-a-time sphere test is the reference the batched cull has to match exactly, in the same order
+			std::vector<uint32_t> reference;
+			for (uint32_t index = 0; index < NUM_INSTANCES; index++)
+			{
+				if (culler.isSphereVisible(instances[index].m_position, instances[index].m_scale * MODEL_RADIUS))
+					reference.emplace_back(index);
+			}
+
+			for (uint32_t numThreads : { 1u, MAX_THREADS })
+			{
+				culler.setJobSystem(numThreads > 1 ? std::make_shared<JobSystem>(numThreads) : nullptr);
+				const uint32_t NUM_VISIBLE = culler.cullInstances(instances.data(), NUM_INSTANCES, MODEL_RADIUS,
+					visible.data());
+
+				bool matches = NUM_VISIBLE == reference.size();
+				for (uint32_t index = 0; matches && index < NUM_VISIBLE; index++)
+					matches = std::memcmp(&visible[index], &instances[reference[index]], sizeof(InstanceData)) == 0;
+
+				const TimePoint START = startTimer();
+				for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+					culler.cullInstances(instances.data(), NUM_INSTANCES, MODEL_RADIUS, visible.data());
+				const double ELAPSED = getElapsedSeconds(START) / NUM_REPEATS;
+
+				std::stringstream result;
+				result << "FrustumCulling " << view.first << ", " << NUM_INSTANCES << " instances, " << numThreads <<
+					" threads: " << ELAPSED * 1e3 << " ms, " << NUM_INSTANCES / ELAPSED / 1e6 << " M instances/s, " <<
+					culler.getStats().m_visible << " visible (" << (matches ? "matches" : "DIFFERS FROM") <<
+					" reference)";
+				reportResult(result.str());
+
+				if (numThreads == MAX_THREADS)
+					break;
+			}
+		}
+	}
+
+	void benchmarkLODSelection()
+	{
+		constexpr uint32_t NUM_LEVELS = 4;
+		constexpr float MODEL_RADIUS = 1.2f;
+
+		// Offline simplification cost for a couple of mesh sizes
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		std::vector<SimplifiedLevel> levels;
+
+		for (uint32_t subdivisions : { 4u, 6u })
+		{
+			generateRockMesh(subdivisions, positions, indices);
+
+			const TimePoint START = startTimer();
+			levels = MeshSimplifier::buildLODChain(positions, indices, NUM_LEVELS);
+			const double ELAPSED = getElapsedSeconds(START);
+
+			std::stringstream result;
+			result << "LODSelection simplify " << indices.size() / 3 << " triangles: " << ELAPSED * 1e3 << " ms,";
+			for (const auto& level : levels)
+				result << " [" << level.m_indices.size() / 3 << " triangles, error " << level.m_errorBound << "]";
+			reportResult(result.str());
+		}
+
+		// Per-frame cost and triangle savings over the belt, using the smaller rock like the real asteroid model
+		generateRockMesh(4, positions, indices);
+		levels = MeshSimplifier::buildLODChain(positions, indices, NUM_LEVELS);
+
+		std::vector<float> levelErrors;
+		std::vector<uint32_t> levelTriangles;
+		for (const auto& level : levels)
+		{
+			levelErrors.emplace_back(level.m_errorBound);
+			levelTriangles.emplace_back(static_cast<uint32_t>(level.m_indices.size() / 3));
+		}
+
+		const glm::mat4 PROJECTION = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100000.0f);
+		const float PIXELS_PER_UNIT = PROJECTION[1][1] * 0.5f * 900.0f;
+		const glm::vec3 CAMERA_POSITION = glm::vec3(0.0f, 3.0f, 24.0f);
+		const glm::mat4 VIEW = glm::lookAt(CAMERA_POSITION, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		for (uint32_t numInstances : { 10000u, 1000000u })
+		{
+			OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+			simulation.generateAsteroidBelt(numInstances, 14.0f, BENCHMARK_SEED);
+			std::vector<InstanceData> instances(numInstances), binned(numInstances);
+			std::vector<uint32_t> visibleIndices(numInstances);
+			simulation.buildInstances(instances);
+
+			FrustumCuller culler;
+			culler.setFrustum(PROJECTION * VIEW);
+			const uint32_t NUM_VISIBLE = culler.cullInstances(instances.data(), numInstances, MODEL_RADIUS, nullptr,
+				visibleIndices.data());
+
+			LODSelector selector(levelErrors, levelTriangles, MODEL_RADIUS);
+			const uint32_t NUM_REPEATS = std::max(2u, 10000000u / numInstances);
+
+			const TimePoint START = startTimer();
+			for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+				selector.binInstances(instances.data(), numInstances, visibleIndices.data(), NUM_VISIBLE, CAMERA_POSITION,
+					PIXELS_PER_UNIT, binned.data());
+			const double ELAPSED = getElapsedSeconds(START) / NUM_REPEATS;
+
+			const LODStats& STATS = selector.getStats();
+			std::stringstream result;
+			result << "LODSelection bin " << NUM_VISIBLE << "/" << numInstances << " visible: " << ELAPSED * 1e3 <<
+				" ms, triangles " << STATS.m_trianglesWithoutLOD << " -> " << STATS.m_trianglesSubmitted <<
+				", instances per level:";
+			for (uint32_t count : STATS.m_instancesPerLevel)
+				result << " " << count;
+			reportResult(result.str());
+		}
+	}
+
+	void benchmarkInstanceFormat()
+	{
+		constexpr uint32_t NUM_INSTANCES = 1000000;
+		constexpr uint32_t NUM_REPEATS = 10;
+		constexpr uint32_t NUM_SHADED_INSTANCES = 200; // Instances run through the emulated vertex shaders
+
+		OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+		simulation.generateAsteroidBelt(NUM_INSTANCES, 14.0f, BENCHMARK_SEED);
+		std::vector<glm::mat4> matrices(NUM_INSTANCES);
+		std::vector<InstanceData> instances(NUM_INSTANCES);
+
+		// Bytes uploaded per frame if every instance is visible, and the single threaded cost of building them
+		simulation.buildInstanceMatrices(matrices);
+		TimePoint start = startTimer();
+		for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+			simulation.buildInstanceMatrices(matrices);
+		const double MATRIX_BUILD_TIME = getElapsedSeconds(start) / NUM_REPEATS;
+
+		simulation.buildInstances(instances);
+		start = startTimer();
+		for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+			simulation.buildInstances(instances);
+		const double COMPACT_BUILD_TIME = getElapsedSeconds(start) / NUM_REPEATS;
+
+		const double MATRIX_MB = sizeof(glm::mat4) * static_cast<double>(NUM_INSTANCES) / 1e6;
+		const double COMPACT_MB = sizeof(InstanceData) * static_cast<double>(NUM_INSTANCES) / 1e6;
+
+		std::stringstream upload;
+		upload << "InstanceFormat upload, " << NUM_INSTANCES << " instances: mat4 " << sizeof(glm::mat4) << " B -> " <<
+			MATRIX_MB << " MB/frame (" << MATRIX_MB * 60.0 / 1e3 << " GB/s at 60 fps), compact " << sizeof(InstanceData) <<
+			" B -> " << COMPACT_MB << " MB/frame (" << COMPACT_MB * 60.0 / 1e3 << " GB/s at 60 fps)";
+		reportResult(upload.str());
+
+		std::stringstream build;
+		build << "InstanceFormat build, " << NUM_INSTANCES << " instances, 1 thread: mat4 " << MATRIX_BUILD_TIME * 1e3 <<
+			" ms, compact " << COMPACT_BUILD_TIME * 1e3 << " ms";
+		reportResult(build.str());
+
+		// Emulates the per-vertex work of both vertex shaders over the rock mesh: the old one transformed by the
+		// instance matrix and took the inverse transpose for the normal, the new one unpacks and rotates by the
+		// quaternion. Both are checked against each other so the quantized rotation is known to be close enough
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		generateRockMesh(4, positions, indices);
+
+		std::vector<glm::vec3> normals(positions.size());
+		for (size_t vertex = 0; vertex < positions.size(); vertex++)
+			normals[vertex] = glm::normalize(positions[vertex]);
+
+		const uint32_t NUM_VERTICES = static_cast<uint32_t>(positions.size());
+		const uint32_t STRIDE = NUM_INSTANCES / NUM_SHADED_INSTANCES;
+		std::vector<glm::vec3> matrixPositions(NUM_VERTICES), matrixNormals(NUM_VERTICES);
+		std::vector<glm::vec3> compactPositions(NUM_VERTICES), compactNormals(NUM_VERTICES);
+
+		auto rotate = [](const glm::vec4& q, const glm::vec3& v)
+		{
+			const glm::vec3 AXIS(q.x, q.y, q.z);
+			return v + 2.0f * glm::cross(AXIS, glm::cross(AXIS, v) + q.w * v);
+		};
+
+		double matrixTime = 0.0, compactTime = 0.0;
+		float maxPositionError = 0.0f, maxNormalError = 0.0f;
+		for (uint32_t shaded = 0; shaded < NUM_SHADED_INSTANCES; shaded++)
+		{
+			const uint32_t INSTANCE = shaded * STRIDE;
+
+			start = startTimer();
+			for (uint32_t vertex = 0; vertex < NUM_VERTICES; vertex++)
+			{
+				const glm::mat4& MODEL = matrices[INSTANCE];
+				matrixPositions[vertex] = glm::vec3(MODEL * glm::vec4(positions[vertex], 1.0f));
+				matrixNormals[vertex] = glm::mat3(glm::transpose(glm::inverse(MODEL))) * normals[vertex];
+			}
+			matrixTime += getElapsedSeconds(start);
+
+			start = startTimer();
+			for (uint32_t vertex = 0; vertex < NUM_VERTICES; vertex++)
+			{
+				const InstanceData& DATA = instances[INSTANCE];
+				const glm::vec4 ROTATION = glm::normalize(glm::vec4(DATA.m_rotation[0], DATA.m_rotation[1],
+					DATA.m_rotation[2], DATA.m_rotation[3]) * (1.0f / 32767.0f));
+
+				compactPositions[vertex] = DATA.m_position + DATA.m_scale * rotate(ROTATION, positions[vertex]);
+				compactNormals[vertex] = rotate(ROTATION, normals[vertex]);
+			}
+			compactTime += getElapsedSeconds(start);
+
+			// The inverse transpose also scales the normal by 1 / scale, so only the directions are compared
+			for (uint32_t vertex = 0; vertex < NUM_VERTICES; vertex++)
+			{
+				const glm::vec3 POSITION_ERROR = (compactPositions[vertex] - matrixPositions[vertex]) /
+					instances[INSTANCE].m_scale;
+				const float ALIGNMENT = glm::dot(glm::normalize(compactNormals[vertex]),
+					glm::normalize(matrixNormals[vertex]));
+
+				maxPositionError = std::max(maxPositionError, std::sqrt(glm::dot(POSITION_ERROR, POSITION_ERROR)));
+				maxNormalError = std::max(maxNormalError, std::acos(std::min(ALIGNMENT, 1.0f)));
+			}
+		}
+
+		const double NUM_SHADED_VERTICES = static_cast<double>(NUM_VERTICES) * NUM_SHADED_INSTANCES;
+		std::stringstream shading;
+		shading << "InstanceFormat vertex work, " << NUM_VERTICES << " vertices x " << NUM_SHADED_INSTANCES <<
+			" instances: mat4 + inverse " << matrixTime / NUM_SHADED_VERTICES * 1e9 << " ns/vertex, quaternion " <<
+			compactTime / NUM_SHADED_VERTICES * 1e9 << " ns/vertex, max difference " << maxPositionError <<
+			" model units / " << glm::degrees(maxNormalError) << " degrees";
+		reportResult(shading.str());
+	}
+
+	void benchmarkVertexFormat()
+	{
+		constexpr uint32_t NUM_REPEATS = 10;
+		constexpr float PI = 3.14159265f;
+
+		// The rock at the asteroid's size and at roughly the planet's, with sphere normals and a spherical UV mapping
+		for (uint32_t subdivisions : { 4u, 7u })
+		{
+			std::vector<glm::vec3> positions;
+			std::vector<uint32_t> indices;
+			generateRockMesh(subdivisions, positions, indices);
+
+			std::vector<VertexData> vertices(positions.size());
+			for (size_t index = 0; index < positions.size(); index++)
+			{
+				const glm::vec3 DIRECTION = glm::normalize(positions[index]);
+				vertices[index].m_vertexPos = positions[index];
+				vertices[index].m_normalPos = DIRECTION;
+				vertices[index].m_texturePos = glm::vec2(0.5f + std::atan2(DIRECTION.z, DIRECTION.x) / (2.0f * PI),
+					0.5f - std::asin(DIRECTION.y) / PI);
+			}
+
+			std::vector<QuantizedVertexData> quantized;
+			QuantizationStats stats = VertexQuantizer::quantizeVertices(vertices, quantized);
+
+			const TimePoint START = startTimer();
+			for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+				stats = VertexQuantizer::quantizeVertices(vertices, quantized);
+			const double ELAPSED = getElapsedSeconds(START) / NUM_REPEATS;
+
+			const glm::vec3 EXTENT = stats.m_positionScale;
+			const float LARGEST_EXTENT = std::max(EXTENT.x, std::max(EXTENT.y, EXTENT.z));
+
+			std::stringstream result;
+			result << "VertexFormat " << vertices.size() << " vertices: " << sizeof(VertexData) * vertices.size() /
+				1024.0 << " KB -> " << sizeof(QuantizedVertexData) * quantized.size() / 1024.0 << " KB in " <<
+				ELAPSED * 1e3 << " ms, max error " << stats.m_maxPositionError << " units (" <<
+				stats.m_maxPositionError / LARGEST_EXTENT * 100.0f << "% of the bounds), " << stats.m_maxNormalError <<
+				" degrees, " << stats.m_maxTextureError << " UV (" << stats.m_maxTextureError * 4096.0f <<
+				" texels at 4096)";
+			reportResult(result.str());
+		}
+	}
+
+	void benchmarkVertexCache()
+	{
+		for (uint32_t subdivisions : { 4u, 7u })
+		{
+			std::vector<glm::vec3> positions;
+			std::vector<uint32_t> subdividedIndices;
+			generateRockMesh(subdivisions, positions, subdividedIndices);
+			const uint32_t NUM_VERTICES = static_cast<uint32_t>(positions.size());
+			const uint32_t NUM_TRIANGLES = static_cast<uint32_t>(subdividedIndices.size() / 3);
+
+			// Subdivision already leaves neighbouring triangles close together, so a shuffled copy stands in for an
+			// exporter that writes the faces in no useful order
+			std::vector<uint32_t> shuffledIndices(subdividedIndices.size());
+			std::vector<uint32_t> triangleOrder(NUM_TRIANGLES);
+			for (uint32_t triangle = 0; triangle < NUM_TRIANGLES; triangle++)
+				triangleOrder[triangle] = triangle;
+
+			for (uint32_t triangle = NUM_TRIANGLES - 1; triangle > 0; triangle--)
+			{
+				const int OTHER = Random::getInt(BENCHMARK_SEED, 0, triangle, 0, static_cast<int>(triangle));
+				std::swap(triangleOrder[triangle], triangleOrder[OTHER]);
+			}
+
+			for (uint32_t triangle = 0; triangle < NUM_TRIANGLES; triangle++)
+				std::copy_n(&subdividedIndices[triangleOrder[triangle] * 3], 3, &shuffledIndices[triangle * 3]);
+
+			const std::vector<std::pair<std::string, std::vector<uint32_t>*>> ORDERS
+			{
+				{ "subdivision order", &subdividedIndices },
+				{ "shuffled", &shuffledIndices }
+			};
+
+			for (const auto& order : ORDERS)
+			{
+				std::vector<uint32_t> indices = *order.second;
+				const VertexCacheStats BEFORE16 = MeshOptimizer::analyzeVertexCache(indices, NUM_VERTICES, 16);
+				const VertexCacheStats BEFORE32 = MeshOptimizer::analyzeVertexCache(indices, NUM_VERTICES, 32);
+				const float OVERDRAW_BEFORE = MeshOptimizer::analyzeOverdraw(positions, indices);
+
+				TimePoint start = startTimer();
+				MeshOptimizer::optimizeVertexCache(indices, NUM_VERTICES);
+				const double CACHE_TIME = getElapsedSeconds(start);
+				const VertexCacheStats CACHE16 = MeshOptimizer::analyzeVertexCache(indices, NUM_VERTICES, 16);
+
+				start = startTimer();
+				MeshOptimizer::optimizeOverdraw(positions, indices);
+				const double OVERDRAW_TIME = getElapsedSeconds(start);
+				const VertexCacheStats AFTER16 = MeshOptimizer::analyzeVertexCache(indices, NUM_VERTICES, 16);
+				const VertexCacheStats AFTER32 = MeshOptimizer::analyzeVertexCache(indices, NUM_VERTICES, 32);
+				const float OVERDRAW_AFTER = MeshOptimizer::analyzeOverdraw(positions, indices);
+
+				start = startTimer();
+				MeshOptimizer::optimizeVertexFetch(indices, NUM_VERTICES);
+				const double FETCH_TIME = getElapsedSeconds(start);
+
+				std::stringstream result;
+				result << "VertexCache " << NUM_TRIANGLES << " triangles, " << order.first << ": ACMR (FIFO 16) " <<
+					BEFORE16.m_acmr << " -> " << CACHE16.m_acmr << " (cache pass) -> " << AFTER16.m_acmr <<
+					" (overdraw pass), ATVR " << BEFORE16.m_atvr << " -> " << AFTER16.m_atvr << ", FIFO 32 ACMR " <<
+					BEFORE32.m_acmr << " -> " << AFTER32.m_acmr << ", overdraw " << OVERDRAW_BEFORE << " -> " <<
+					OVERDRAW_AFTER << ", passes took " << CACHE_TIME * 1e3 << " / " << OVERDRAW_TIME * 1e3 << " / " <<
+					FETCH_TIME * 1e3 << " ms";
+				reportResult(result.str());
+			}
+		}
+	}
+
+	void benchmarkLightClustering()
+	{
+		constexpr uint32_t NUM_ASTEROIDS = 10000;
+		constexpr uint32_t NUM_REPEATS = 50;
+		constexpr float VIEWPORT_WIDTH = 1600.0f, VIEWPORT_HEIGHT = 900.0f;
+		constexpr float LIGHT_RADIUS = 1.5f;
+
+		// The lights ride on asteroids like the beacons do, and the asteroids double as the fragments being shaded
+		OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+		simulation.generateAsteroidBelt(NUM_ASTEROIDS, 14.0f, BENCHMARK_SEED);
+		std::vector<InstanceData> instances(NUM_ASTEROIDS);
+		simulation.buildInstances(instances);
+
+		const glm::mat4 PROJECTION = glm::perspective(glm::radians(45.0f), VIEWPORT_WIDTH / VIEWPORT_HEIGHT, 0.1f,
+			100000.0f);
+		const std::vector<std::pair<std::string, glm::mat4>> VIEWS
+		{
+			{ "whole belt", glm::lookAt(glm::vec3(0.0f, 10.0f, 45.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)) },
+			{ "inside belt", glm::lookAt(glm::vec3(14.0f, 0.0f, 0.0f), glm::vec3(14.0f, 0.0f, -10.0f),
+				glm::vec3(0.0f, 1.0f, 0.0f)) }
+		};
+
+		const uint32_t MAX_THREADS = std::max(1u, std::thread::hardware_concurrency());
+		for (const auto& view : VIEWS)
+		{
+			for (uint32_t numLights : { 1u, 4u, 16u, 64u, 256u, 1024u })
+			{
+				std::vector<PointLight> lights(numLights);
+				for (uint32_t index = 0; index < numLights; index++)
+				{
+					lights[index].m_position = instances[index * (NUM_ASTEROIDS / numLights)].m_position +
+						glm::vec3(0.0f, 0.2f, 0.0f);
+					lights[index].m_radius = LIGHT_RADIUS;
+					lights[index].m_color = glm::vec3(1.0f);
+					lights[index].m_intensity = 1.0f;
+				}
+
+				LightClusterer clusterer(16, 9, 24, 0.1f, 200.0f);
+				for (uint32_t numThreads : { 1u, MAX_THREADS })
+				{
+					clusterer.setJobSystem(numThreads > 1 ? std::make_shared<JobSystem>(numThreads) : nullptr);
+					clusterer.assignLights(lights.data(), numLights, view.second, PROJECTION);
+
+					const TimePoint START = startTimer();
+					for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+						clusterer.assignLights(lights.data(), numLights, view.second, PROJECTION);
+					const double ELAPSED = getElapsedSeconds(START) / NUM_REPEATS;
+
+					// Look up the cluster of every asteroid in view the way the shaders do, counting the lights its
+					// fragments would loop over, how many of them actually reach it, and any reaching light missing
+					const ClusterGridParams PARAMS = clusterer.getGridParams(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+					const std::vector<uint32_t>& RANGES = clusterer.getClusterRanges();
+					const std::vector<uint16_t>& INDICES = clusterer.getLightIndices();
+					uint64_t numSamples = 0, lightsLooped = 0, lightsInRange = 0, lightsMissed = 0;
+
+					for (const InstanceData& INSTANCE : instances)
+					{
+						const glm::vec4 CLIP = PROJECTION * view.second * glm::vec4(INSTANCE.m_position, 1.0f);
+						const float DEPTH = CLIP.w;
+						if (DEPTH <= 0.1f || std::abs(CLIP.x) > DEPTH || std::abs(CLIP.y) > DEPTH)
+							continue;
+
+						const uint32_t TILE_X = std::min(static_cast<uint32_t>((CLIP.x / DEPTH * 0.5f + 0.5f) *
+							VIEWPORT_WIDTH * PARAMS.m_tileScale.x), PARAMS.m_gridSize.x - 1);
+						const uint32_t TILE_Y = std::min(static_cast<uint32_t>((CLIP.y / DEPTH * 0.5f + 0.5f) *
+							VIEWPORT_HEIGHT * PARAMS.m_tileScale.y), PARAMS.m_gridSize.y - 1);
+						const uint32_t SLICE = static_cast<uint32_t>(std::min(std::max(std::log(DEPTH) *
+							PARAMS.m_sliceScale + PARAMS.m_sliceBias, 0.0f), static_cast<float>(PARAMS.m_gridSize.z - 1)));
+						const uint32_t CLUSTER = (SLICE * PARAMS.m_gridSize.y + TILE_Y) * PARAMS.m_gridSize.x + TILE_X;
+
+						const uint32_t OFFSET = RANGES[CLUSTER * 2], COUNT = RANGES[CLUSTER * 2 + 1];
+						numSamples++;
+						lightsLooped += COUNT;
+
+						for (uint32_t light = 0; light < numLights; light++)
+						{
+							if (glm::length(lights[light].m_position - INSTANCE.m_position) >= LIGHT_RADIUS)
+								continue;
+
+							lightsInRange++;
+							if (std::find(INDICES.begin() + OFFSET, INDICES.begin() + OFFSET + COUNT, light) ==
+								INDICES.begin() + OFFSET + COUNT)
+								lightsMissed++;
+						}
+					}
+
+					const ClusterStats& STATS = clusterer.getStats();
+					const size_t UPLOAD_BYTES = sizeof(PointLight) * numLights + sizeof(uint32_t) * RANGES.size() +
+						sizeof(uint16_t) * INDICES.size();
+					const double SAMPLES = static_cast<double>(std::max<uint64_t>(numSamples, 1));
+
+					std::stringstream result;
+					result << "LightClustering " << view.first << ", " << numLights << " lights, " << numThreads <<
+						" threads: assign " << ELAPSED * 1e3 << " ms, " << STATS.m_visibleLights << " in view across " <<
+						STATS.m_occupiedClusters << " clusters (max " << STATS.m_maxLightsPerCluster << " per cluster), " <<
+						UPLOAD_BYTES / 1024.0 << " KB uploaded, per fragment " << lightsLooped / SAMPLES <<
+						" lights looped vs " << numLights << " unclustered (" << lightsInRange / SAMPLES <<
+						" in range), " << lightsMissed << " missed";
+					reportResult(result.str());
+
+					if (numThreads == MAX_THREADS)
+						break;
+				}
+			}
+		}
+	}
+
+	void benchmarkOcclusionCulling()
+	{
+		constexpr uint32_t NUM_REPEATS = 20;
+		constexpr float MODEL_RADIUS = 1.0f;
+		constexpr float PLANET_RADIUS = 5.0f; // Stands in for the planet, which the benchmarks can't load
+
+		const glm::mat4 PROJECTION = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100000.0f);
+		const std::vector<std::pair<std::string, glm::vec3>> VIEWS
+		{
+			{ "level with the belt", glm::vec3(0.0f, 0.5f, 30.0f) },
+			{ "inside belt", glm::vec3(14.0f, 0.0f, 0.0f) },
+			{ "above belt", glm::vec3(0.0f, 10.0f, 45.0f) }
+		};
+
+		const uint32_t MAX_THREADS = std::max(1u, std::thread::hardware_concurrency());
+		for (uint32_t numInstances : { 10000u, 1000000u })
+		{
+			OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+			simulation.generateAsteroidBelt(numInstances, 14.0f, BENCHMARK_SEED);
+			std::vector<InstanceData> instances(numInstances);
+			std::vector<uint32_t> frustumIndices(numInstances), indices(numInstances);
+			simulation.buildInstances(instances);
+
+			for (const auto& view : VIEWS)
+			{
+				// Every view looks at the planet, the asteroids behind it being the ones to cull
+				const glm::mat4 VIEW = glm::lookAt(view.second, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+				FrustumCuller frustumCuller;
+				frustumCuller.setFrustum(PROJECTION * VIEW);
+				const uint32_t NUM_IN_FRUSTUM = frustumCuller.cullInstances(instances.data(), numInstances, MODEL_RADIUS,
+					nullptr, frustumIndices.data());
+
+				// An instance can only be hidden if it lies wholly within the planet's silhouette, and it surely is if
+				// it also lies past where the silhouette touches the planet
+				const float PLANET_DISTANCE = glm::length(view.second);
+				const float SILHOUETTE_ANGLE = std::asin(PLANET_RADIUS / PLANET_DISTANCE);
+				const float SILHOUETTE_DEPTH = std::sqrt(PLANET_DISTANCE * PLANET_DISTANCE - PLANET_RADIUS * PLANET_RADIUS);
+				std::vector<uint8_t> withinSilhouette(numInstances, 0);
+				uint32_t numSurelyHidden = 0;
+
+				for (uint32_t index = 0; index < NUM_IN_FRUSTUM; index++)
+				{
+					const InstanceData& INSTANCE = instances[frustumIndices[index]];
+					const glm::vec3 OFFSET = INSTANCE.m_position - view.second;
+					const float DISTANCE = glm::length(OFFSET), RADIUS = INSTANCE.m_scale * MODEL_RADIUS;
+					const float ANGLE = std::acos(std::min(glm::dot(OFFSET / DISTANCE, -view.second / PLANET_DISTANCE),
+						1.0f));
+
+					if (DISTANCE <= RADIUS || ANGLE + std::asin(RADIUS / DISTANCE) > SILHOUETTE_ANGLE)
+						continue;
+
+					withinSilhouette[frustumIndices[index]] = 1;
+					numSurelyHidden += DISTANCE - RADIUS >= SILHOUETTE_DEPTH ? 1 : 0;
+				}
+
+				for (uint32_t numThreads : { 1u, MAX_THREADS })
+				{
+					OcclusionCuller culler(256, 144, numThreads > 1 ? std::make_shared<JobSystem>(numThreads) : nullptr);
+					uint32_t numVisible = 0;
+					double rasterSeconds = 0.0, testSeconds = 0.0;
+
+					for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+					{
+						std::copy_n(frustumIndices.begin(), NUM_IN_FRUSTUM, indices.begin());
+
+						culler.beginFrame(VIEW, PROJECTION);
+						culler.addSphereOccluder(glm::vec3(0.0f), PLANET_RADIUS);
+						culler.rasterizeOccluders();
+						numVisible = culler.cullIndices(instances.data(), indices.data(), NUM_IN_FRUSTUM, MODEL_RADIUS);
+
+						rasterSeconds += culler.getStats().m_rasterSeconds;
+						testSeconds += culler.getStats().m_testSeconds;
+					}
+
+					// The kept indices stay in order, so whatever got culled is what's missing in between them
+					uint32_t numWrongfullyCulled = 0, kept = 0;
+					for (uint32_t index = 0; index < NUM_IN_FRUSTUM; index++)
+					{
+						if (kept < numVisible && indices[kept] == frustumIndices[index])
+							kept++;
+						else
+							numWrongfullyCulled += withinSilhouette[frustumIndices[index]] ? 0 : 1;
+					}
+
+					std::stringstream result;
+					result << "OcclusionCulling " << view.first << ", " << numInstances << " instances, " << numThreads <<
+						" threads: rasterize " << rasterSeconds / NUM_REPEATS * 1e3 << " ms (" <<
+						culler.getStats().m_rasterizedTriangles << "/" << culler.getStats().m_occluderTriangles <<
+						" triangles), test " << testSeconds / NUM_REPEATS * 1e3 << " ms, " << NUM_IN_FRUSTUM - numVisible <<
+						"/" << NUM_IN_FRUSTUM << " in the frustum culled (" << numSurelyHidden << " surely hidden), " <<
+						numWrongfullyCulled << " culled outside the silhouette";
+					reportResult(result.str());
+
+					if (numThreads == MAX_THREADS)
+						break;
+				}
+			}
+		}
+	}
+
+	void benchmarkImpostors()
+	{
+		constexpr uint32_t NUM_ASTEROIDS = 100000;
+		constexpr uint32_t NUM_LEVELS = 4, NUM_REPEATS = 50;
+		constexpr float MODEL_RADIUS = 1.2f;
+		constexpr float FADE_START = 10.0f, FADE_END = 12.0f; // Same band as the simulation window uses
+		constexpr uint32_t IMPOSTOR_VERTICES = 4; // One triangle strip quad per impostor
+
+		// The levels of the rock stand-in, reordered for the vertex cache like at import, and how many vertices each
+		// runs through the vertex shader per instance
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		generateRockMesh(4, positions, indices);
+		const uint32_t NUM_VERTICES = static_cast<uint32_t>(positions.size());
+		std::vector<SimplifiedLevel> levels = MeshSimplifier::buildLODChain(positions, indices, NUM_LEVELS);
+
+		std::vector<float> levelErrors;
+		std::vector<uint32_t> levelTriangles;
+		std::vector<double> levelVertices;
+		for (auto& level : levels)
+		{
+			MeshOptimizer::optimizeVertexCache(level.m_indices, NUM_VERTICES);
+			levelErrors.emplace_back(level.m_errorBound);
+			levelTriangles.emplace_back(static_cast<uint32_t>(level.m_indices.size() / 3));
+			levelVertices.emplace_back(MeshOptimizer::analyzeVertexCache(level.m_indices, NUM_VERTICES).m_acmr *
+				level.m_indices.size() / 3.0);
+		}
+
+		OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+		simulation.generateAsteroidBelt(NUM_ASTEROIDS, 14.0f, BENCHMARK_SEED);
+		std::vector<InstanceData> instances(NUM_ASTEROIDS), binned(2 * NUM_ASTEROIDS);
+		std::vector<uint32_t> visibleIndices(NUM_ASTEROIDS);
+		simulation.buildInstances(instances);
+
+		const glm::mat4 PROJECTION = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100000.0f);
+		const float PIXELS_PER_UNIT = PROJECTION[1][1] * 0.5f * 900.0f;
+		const std::vector<std::pair<std::string, std::pair<glm::vec3, glm::vec3>>> VIEWS // Camera position and target
+		{
+			{ "outside belt", { glm::vec3(0.0f, 3.0f, 24.0f), glm::vec3(0.0f) } },
+			{ "inside belt", { glm::vec3(14.0f, 0.3f, 0.0f), glm::vec3(14.0f, 0.3f, -10.0f) } },
+			{ "above planet", { glm::vec3(0.0f, 20.0f, 0.1f), glm::vec3(0.0f) } }
+		};
+
+		for (const auto& view : VIEWS)
+		{
+			const glm::vec3 CAMERA_POSITION = view.second.first;
+			FrustumCuller culler;
+			culler.setFrustum(PROJECTION * glm::lookAt(CAMERA_POSITION, view.second.second, glm::vec3(0.0f, 1.0f, 0.0f)));
+			const uint32_t NUM_VISIBLE = culler.cullInstances(instances.data(), NUM_ASTEROIDS, MODEL_RADIUS, nullptr,
+				visibleIndices.data());
+
+			// The same selection with and without the impostors past the fade band
+			double binSeconds[2] = {}, vertices[2] = {};
+			uint64_t triangles[2] = {};
+			uint32_t numBinned[2] = {};
+			LODStats stats;
+
+			for (uint32_t withImpostors = 0; withImpostors < 2; withImpostors++)
+			{
+				LODSelector selector(levelErrors, levelTriangles, MODEL_RADIUS);
+				if (withImpostors)
+					selector.setImpostorRange(FADE_START, FADE_END);
+
+				const TimePoint START = startTimer();
+				for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+				{
+					numBinned[withImpostors] = selector.selectLevels(instances.data(), NUM_ASTEROIDS, visibleIndices.data(),
+						NUM_VISIBLE, CAMERA_POSITION, PIXELS_PER_UNIT);
+					selector.scatterInstances(instances.data(), visibleIndices.data(), binned.data());
+				}
+				binSeconds[withImpostors] = getElapsedSeconds(START) / NUM_REPEATS;
+
+				stats = selector.getStats();
+				triangles[withImpostors] = stats.m_trianglesSubmitted;
+				vertices[withImpostors] = static_cast<double>(stats.m_impostors) * IMPOSTOR_VERTICES;
+				for (uint32_t level = 0; level < NUM_LEVELS; level++)
+					vertices[withImpostors] += stats.m_instancesPerLevel[level] * levelVertices[level];
+			}
+
+			std::stringstream result;
+			result << "Impostors " << view.first << ", " << NUM_VISIBLE << "/" << NUM_ASTEROIDS << " visible: bin " <<
+				binSeconds[0] * 1e3 << " -> " << binSeconds[1] * 1e3 << " ms, triangles " << triangles[0] << " -> " <<
+				triangles[1] << ", vertex shader runs " << static_cast<uint64_t>(vertices[0]) << " -> " <<
+				static_cast<uint64_t>(vertices[1]) << ", instances uploaded " << numBinned[0] << " -> " << numBinned[1] <<
+				" (" << stats.m_impostors << " impostors, " << stats.m_crossFading << " of them fading in)";
+			reportResult(result.str());
+		}
+	}
+
+	void benchmarkRenderQueue()
+	{
+		constexpr uint32_t NUM_PROGRAMS = 8, NUM_MATERIALS = 64, NUM_VAOS = 32;
+		constexpr uint32_t NUM_REPEATS = 200;
+
+		for (uint32_t numDraws : { 1000u, 10000u, 100000u })
+		{
+			// Mixed draws submitted in no particular order, like a scene walked object by object. Each material belongs to
+			// one program, the vaos (meshes) get shared across materials, and a few draws land in the sky and blended passes
+			RenderQueue queue;
+			queue.beginFrame(glm::mat4(1.0f));
+
+			for (uint32_t draw = 0; draw < numDraws; draw++)
+			{
+				const int PASS_ROLL = Random::getInt(BENCHMARK_SEED, 0, draw, 0, 99);
+				const RenderPass PASS = PASS_ROLL < 90 ? RenderPass::SOLID : PASS_ROLL < 95 ? RenderPass::SKY :
+					RenderPass::BLENDED;
+
+				RenderCommand command;
+				command.m_material = 1 + static_cast<uint32_t>(Random::getInt(BENCHMARK_SEED, 1, draw, 0, NUM_MATERIALS - 1));
+				command.m_program = 1 + command.m_material % NUM_PROGRAMS;
+				command.m_vao = 1 + static_cast<uint32_t>(Random::getInt(BENCHMARK_SEED, 2, draw, 0, NUM_VAOS - 1));
+				queue.submit(command, PASS, Random::getFloat(BENCHMARK_SEED, 3, draw, 0.1f, 500.0f));
+			}
+
+			const std::vector<RenderCommand>& COMMANDS = queue.getCommands();
+			std::vector<uint32_t> submitted(numDraws);
+			for (uint32_t index = 0; index < numDraws; index++)
+				submitted[index] = index;
+
+			TimePoint start = startTimer();
+			for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+				queue.sort();
+			const double RADIX_SECONDS = getElapsedSeconds(start) / NUM_REPEATS;
+
+			// Compare against a stable comparison sort of the same keys, which has to come out in the same order
+			std::vector<uint32_t> stableOrder;
+			start = startTimer();
+			for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+			{
+				stableOrder = submitted;
+				std::stable_sort(stableOrder.begin(), stableOrder.end(), [&COMMANDS](uint32_t a, uint32_t b)
+				{
+					return COMMANDS[a].m_sortKey < COMMANDS[b].m_sortKey;
+				});
+			}
+			const double STABLE_SECONDS = getElapsedSeconds(start) / NUM_REPEATS;
+
+			const RenderQueueStats UNSORTED = countSwitches(COMMANDS, submitted);
+			const RenderQueueStats SORTED = countSwitches(COMMANDS, queue.getOrder());
+
+			std::stringstream result;
+			result << "RenderQueue " << numDraws << " draws: radix sort " << RADIX_SECONDS * 1e6 << " us vs " <<
+				STABLE_SECONDS * 1e6 << " us std::stable_sort (" << (queue.getOrder() == stableOrder ? "same" : "DIFFERENT") <<
+				" order), switches in submission order: " << UNSORTED.m_programSwitches << " program, " <<
+				UNSORTED.m_materialSwitches << " material, " << UNSORTED.m_vaoSwitches << " vao, sorted: " <<
+				SORTED.m_programSwitches << " program, " << SORTED.m_materialSwitches << " material, " <<
+				SORTED.m_vaoSwitches << " vao";
+			reportResult(result.str());
+		}
+	}
+
+	void benchmarkDrawBatching()
+	{
+		constexpr uint32_t NUM_MESHES = 16, NUM_PROGRAMS = 4, NUM_INSTANCED = 64;
+		constexpr uint32_t NUM_REPEATS = 200;
+
+		// The queue only compares the mesh pointers, so each mesh is stood in for by the address of a tag. The instanced
+		// draws get meshes of their own
+		const uint8_t MESH_TAGS[2 * NUM_MESHES] = {};
+
+		for (uint32_t numCopies : { 1u, 10u, 100u, 500u })
+		{
+			// Copies of every mesh placed around the scene, submitted object by object in no particular order, along with
+			// a few instanced draws which can't be batched
+			const uint32_t NUM_COPIES = NUM_MESHES * numCopies;
+			std::vector<uint32_t> submitOrder(NUM_COPIES + NUM_INSTANCED);
+			for (uint32_t index = 0; index < submitOrder.size(); index++)
+				submitOrder[index] = index;
+
+			for (uint32_t index = static_cast<uint32_t>(submitOrder.size()) - 1; index > 0; index--)
+				std::swap(submitOrder[index], submitOrder[Random::getInt(BENCHMARK_SEED, 0, index, 0, index)]);
+
+			RenderQueue queue;
+			queue.beginFrame(glm::mat4(1.0f));
+			std::vector<glm::mat4> transforms;
+
+			for (uint32_t draw : submitOrder)
+			{
+				RenderCommand command;
+				const uint32_t MESH = draw % NUM_MESHES + (draw < NUM_COPIES ? 0 : NUM_MESHES);
+				command.m_mesh = reinterpret_cast<const MeshObject*>(&MESH_TAGS[MESH]);
+				command.m_program = 1 + MESH % NUM_PROGRAMS;
+				command.m_material = 1 + MESH;
+				command.m_vao = 1 + MESH;
+				command.m_batchable = draw < NUM_COPIES;
+
+				const glm::vec3 POSITION(Random::getFloat(BENCHMARK_SEED, 1, draw, -100.0f, 100.0f),
+					Random::getFloat(BENCHMARK_SEED, 2, draw, -100.0f, 100.0f), Random::getFloat(BENCHMARK_SEED, 3, draw,
+					-100.0f, 100.0f));
+				transforms.emplace_back(glm::translate(glm::mat4(1.0f), POSITION));
+				command.m_transform = queue.addTransform(transforms.back());
+				queue.submit(command, RenderPass::SOLID, -POSITION.z);
+			}
+
+			TimePoint start = startTimer();
+			for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+				queue.sort();
+			const double SORT_SECONDS = getElapsedSeconds(start) / NUM_REPEATS;
+
+			queue.setBatching(false);
+			queue.buildBatches();
+			const RenderQueueStats UNBATCHED = queue.getStats();
+
+			queue.setBatching(true);
+			start = startTimer();
+			for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+				queue.buildBatches();
+			const double BATCH_SECONDS = getElapsedSeconds(start) / NUM_REPEATS;
+			const RenderQueueStats BATCHED = queue.getStats();
+
+			// Every batch has to hold copies of one mesh only, with each copy's model matrix where the batch reads it
+			const std::vector<RenderCommand>& COMMANDS = queue.getCommands();
+			const std::vector<uint32_t>& ORDER = queue.getOrder();
+			bool consistent = true;
+
+			for (const RenderBatch& BATCH : queue.getBatches())
+			{
+				for (uint32_t offset = 0; offset < BATCH.m_numCommands; offset++)
+				{
+					const RenderCommand& COMMAND = COMMANDS[ORDER[BATCH.m_first + offset]];
+					if (COMMAND.m_mesh != COMMANDS[ORDER[BATCH.m_first]].m_mesh || (COMMAND.m_batchable &&
+						queue.getBatchTransforms()[BATCH.m_firstTransform + offset] != transforms[COMMAND.m_transform]))
+						consistent = false;
+				}
+			}
+
+			std::stringstream result;
+			result << "DrawBatching " << NUM_MESHES << " meshes x " << numCopies << " copies + " << NUM_INSTANCED <<
+				" instanced draws: " << UNBATCHED.m_drawCalls << " -> " << BATCHED.m_drawCalls << " draw calls (" <<
+				BATCHED.m_batchedCommands << " commands batched, " << sizeof(glm::mat4) * queue.getBatchTransforms().size() /
+				1024.0 << " KB of transforms), batching took " << BATCH_SECONDS * 1e6 << " us on top of the " <<
+				SORT_SECONDS * 1e6 << " us sort" << (consistent ? "" : " (MISMATCHED BATCH)");
+			reportResult(result.str());
+		}
+	}
+
+	void benchmarkGeometryPool()
+	{
+		constexpr uint32_t CAPACITY = 1 << 20, MIN_SIZE = 64, MAX_SIZE = 16384;
+		constexpr uint32_t NUM_ROUNDS = 1000;
+
+		// Fill a range allocator with meshes of random sizes, then churn it (releasing a random mesh and allocating a new
+		// one in its place) the way streaming models in and out would, checking no two live ranges ever overlap
+		for (uint32_t targetFill : { 50u, 75u, 90u })
+		{
+			RangeAllocator allocator(CAPACITY);
+			std::map<uint32_t, uint32_t> live; // Size of every live range, by its offset
+			std::vector<uint32_t> liveOffsets;
+			uint32_t draw = 0, failed = 0, operations = 0;
+
+			while (allocator.getUsed() < static_cast<uint64_t>(CAPACITY) * targetFill / 100)
+			{
+				const uint32_t SIZE = static_cast<uint32_t>(Random::getInt(BENCHMARK_SEED, 0, draw++, MIN_SIZE, MAX_SIZE));
+				uint32_t offset = 0;
+				if (!allocator.allocate(SIZE, offset))
+					break;
+
+				live[offset] = SIZE;
+				liveOffsets.push_back(offset);
+			}
+
+			TimePoint start = startTimer();
+			for (uint32_t round = 0; round < NUM_ROUNDS; round++)
+			{
+				const uint32_t VICTIM = static_cast<uint32_t>(Random::getInt(BENCHMARK_SEED, 1, round, 0,
+					static_cast<int>(liveOffsets.size()) - 1));
+				allocator.release(liveOffsets[VICTIM], live[liveOffsets[VICTIM]]);
+				live.erase(liveOffsets[VICTIM]);
+				liveOffsets[VICTIM] = liveOffsets.back();
+				liveOffsets.pop_back();
+
+				const uint32_t SIZE = static_cast<uint32_t>(Random::getInt(BENCHMARK_SEED, 2, round, MIN_SIZE, MAX_SIZE));
+				uint32_t offset = 0;
+				if (allocator.allocate(SIZE, offset))
+				{
+					live[offset] = SIZE;
+					liveOffsets.push_back(offset);
+				}
+				else
+				{
+					failed++;
+				}
+
+				operations += 2;
+			}
+			const double CHURN_SECONDS = getElapsedSeconds(start);
+
+			bool overlapping = false;
+			uint32_t end = 0;
+			for (const auto& RANGE : live)
+			{
+				overlapping = overlapping || RANGE.first < end;
+				end = RANGE.first + RANGE.second;
+			}
+
+			std::stringstream result;
+			result << "GeometryPool churn at " << targetFill << "% full: " << CHURN_SECONDS * 1e9 / operations <<
+				" ns per allocate/release, " << live.size() << " meshes holding " << allocator.getUsed() * 100.0 / CAPACITY <<
+				"% of the page, " << allocator.getNumFreeRanges() << " free ranges (largest " <<
+				allocator.getLargestFreeRange() << "), fragmentation " << allocator.getFragmentation() * 100.0f << "%, " <<
+				failed << "/" << NUM_ROUNDS << " allocations failed" << (overlapping ? " (OVERLAPPING RANGES)" : "");
+			reportResult(result.str());
+		}
+
+		// Then the vao switches of a sorted frame of mixed draws, with a vao per mesh against the meshes sharing the vao of
+		// the pool page they got allocated in
+		constexpr uint32_t NUM_PROGRAMS = 8, NUM_MATERIALS = 64, NUM_DRAWS = 10000;
+		constexpr uint32_t PAGE_VERTICES = 1 << 18;
+
+		for (uint32_t numMeshes : { 32u, 256u })
+		{
+			std::vector<RangeAllocator> pages;
+			std::vector<uint32_t> meshPages(numMeshes);
+			for (uint32_t mesh = 0; mesh < numMeshes; mesh++)
+			{
+				const uint32_t SIZE = static_cast<uint32_t>(Random::getInt(BENCHMARK_SEED, 3, mesh, 500, 20000));
+				uint32_t offset = 0, page = 0;
+				while (page < pages.size() && !pages[page].allocate(SIZE, offset))
+					page++;
+
+				if (page == pages.size())
+				{
+					pages.emplace_back(PAGE_VERTICES);
+					pages.back().allocate(SIZE, offset);
+				}
+
+				meshPages[mesh] = page;
+			}
+
+			RenderQueueStats sorted[2];
+			for (uint32_t pooled = 0; pooled < 2; pooled++)
+			{
+				RenderQueue queue;
+				queue.beginFrame(glm::mat4(1.0f));
+
+				for (uint32_t draw = 0; draw < NUM_DRAWS; draw++)
+				{
+					const uint32_t MESH = static_cast<uint32_t>(Random::getInt(BENCHMARK_SEED, 4, draw, 0, numMeshes - 1));
+
+					RenderCommand command;
+					command.m_material = 1 + static_cast<uint32_t>(Random::getInt(BENCHMARK_SEED, 5, draw, 0, NUM_MATERIALS - 1));
+					command.m_program = 1 + command.m_material % NUM_PROGRAMS;
+					command.m_vao = 1 + (pooled ? meshPages[MESH] : MESH);
+					queue.submit(command, RenderPass::SOLID, Random::getFloat(BENCHMARK_SEED, 6, draw, 0.1f, 500.0f));
+				}
+
+				queue.sort();
+				sorted[pooled] = countSwitches(queue.getCommands(), queue.getOrder());
+			}
+
+			std::stringstream result;
+			result << "GeometryPool " << numMeshes << " meshes, " << NUM_DRAWS << " draws: " << pages.size() <<
+				" pages, vao switches once sorted: " << sorted[0].m_vaoSwitches << " with a vao per mesh -> " <<
+				sorted[1].m_vaoSwitches << " pooled";
+			reportResult(result.str());
+		}
+	}
+
+	void benchmarkStreamingBuffer()
+	{
+		// The buffer needs a context to map, so a hidden window is made just for the benchmark
+		WindowFrame window("Benchmark", 64, 64, false, true);
+
+		constexpr GLsizeiptr SEGMENT_SIZE = 1 << 20, WRITE_SIZE = 64 * 1024;
+		constexpr uint32_t NUM_SEGMENTS = 3, NUM_FRAMES = 64;
+		constexpr uint32_t WORDS_PER_FRAME = WRITE_SIZE / sizeof(uint32_t);
+
+		// Every frame writes its own pattern, which the GPU copies out of the frame's segment into a readback buffer.
+		// Running many more frames than there are segments wraps the ring over and over, so a segment being overwritten
+		// before the GPU copied it out shows up as the wrong pattern once read back
+		for (bool allowPersistent : { true, false })
+		{
+			StreamingBuffer buffer(SEGMENT_SIZE, NUM_SEGMENTS, allowPersistent);
+			const GLsizeiptr ALIGNMENT = buffer.getUniformAlignment();
+
+			uint32_t readback = 0;
+			glGenBuffers(1, &readback);
+			GLState::bindBuffer(GL_COPY_WRITE_BUFFER, readback);
+			glBufferData(GL_COPY_WRITE_BUFFER, WRITE_SIZE * NUM_FRAMES, nullptr, GL_STREAM_READ);
+
+			bool allocated = true, ringOrdered = true, aligned = true, outOfSpaceRefused = true;
+			TimePoint start = startTimer();
+			for (uint32_t frame = 0; frame < NUM_FRAMES; frame++)
+			{
+				buffer.beginFrame();
+
+				// An odd sized allocation first, so the next one has to be realigned
+				const StreamAllocation HEADER = buffer.allocate(ALIGNMENT / 2 + 4);
+				const StreamAllocation DATA = buffer.allocate(WRITE_SIZE, ALIGNMENT);
+				if (!HEADER.m_data || !DATA.m_data)
+				{
+					allocated = false;
+					break;
+				}
+
+				// Frame 0 goes into segment 1, as beginFrame() moves on before handing out any space
+				ringOrdered = ringOrdered && static_cast<uint32_t>(DATA.m_offset / SEGMENT_SIZE) ==
+					(frame + 1) % NUM_SEGMENTS;
+				aligned = aligned && DATA.m_offset % ALIGNMENT == 0;
+
+				// Asking for more than the segment has left should log a warning and hand out nothing
+				if (frame == 0)
+					outOfSpaceRefused = buffer.allocate(SEGMENT_SIZE).m_data == nullptr;
+
+				uint32_t* words = static_cast<uint32_t*>(DATA.m_data);
+				for (uint32_t word = 0; word < WORDS_PER_FRAME; word++)
+					words[word] = frame * 0x9E3779B1u + word;
+
+				buffer.finishWrites();
+
+				GLState::bindBuffer(GL_COPY_READ_BUFFER, buffer.getID());
+				GLState::bindBuffer(GL_COPY_WRITE_BUFFER, readback);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, DATA.m_offset, WRITE_SIZE * frame,
+					WRITE_SIZE);
+
+				buffer.endFrame();
+			}
+			glFinish();
+			const double SECONDS = getElapsedSeconds(start);
+
+			std::vector<uint32_t> copied(WORDS_PER_FRAME * NUM_FRAMES);
+			GLState::bindBuffer(GL_COPY_WRITE_BUFFER, readback);
+			glGetBufferSubData(GL_COPY_WRITE_BUFFER, 0, WRITE_SIZE * NUM_FRAMES, copied.data());
+
+			uint32_t mismatches = 0;
+			for (uint32_t frame = 0; frame < NUM_FRAMES; frame++)
+			{
+				for (uint32_t word = 0; word < WORDS_PER_FRAME; word++)
+					mismatches += copied[frame * WORDS_PER_FRAME + word] != frame * 0x9E3779B1u + word;
+			}
+
+			glDeleteBuffers(1, &readback);
+			GLState::onBufferDeleted(readback);
+
+			std::stringstream result;
+			result << "StreamingBuffer " << (buffer.isPersistent() ? "persistent" : "unsynchronized") << " mapping, " <<
+				NUM_FRAMES << " frames of " << WRITE_SIZE / 1024 << " KB through " << NUM_SEGMENTS << " segments: " <<
+				SECONDS * 1e6 / NUM_FRAMES << " us per frame, " << buffer.getNumStalls() << " stalls, " << mismatches <<
+				"/" << WORDS_PER_FRAME * NUM_FRAMES << " words read back wrong" << (allocated ? "" : " (ALLOCATION FAILED)") <<
+				(ringOrdered ? "" : " (SEGMENTS OUT OF ORDER)") << (aligned ? "" : " (MISALIGNED)") <<
+				(outOfSpaceRefused ? "" : " (OVERSIZED ALLOCATION ACCEPTED)");
+			reportResult(result.str());
+		}
+	}
+
+	void benchmarkUniformHandles()
+	{
+		// The program needs a context, so a hidden window is made just for the benchmark. The replay shader still has the
+		// lights and material as plain uniforms, the way every draw used to set them
+		WindowFrame window("Benchmark", 64, 64, false, true);
+		const ShaderProgram SHADER("Resources/Shaders/UniformReplay.glsl.vsh", "Resources/Shaders/UniformReplay.glsl.fsh");
+		SHADER.bindProgram();
+
+		constexpr uint32_t NUM_DRAWS = 100000, NUM_MODELS = 64;
+		std::vector<glm::mat4> models(NUM_MODELS);
+		for (uint32_t model = 0; model < NUM_MODELS; model++)
+			models[model] = glm::translate(glm::mat4(1.0f), glm::vec3(model * 3.0f, 0.0f, 0.0f));
+
+		const glm::vec3 CAMERA_POS(0.0f, 2.0f, 10.0f), FLASHLIGHT_DIRECTION(0.0f, 0.0f, -1.0f);
+		const std::pair<std::string, int> TEXTURES[] = { { "DIFFUSE_TEXTURE", 0 }, { "SPECULAR_TEXTURE", 1 } };
+
+		// The uniforms SceneModel and MeshObject set for a textured, flashlit draw before handles, names built the same way
+		NamedUniformCache named(SHADER.getID());
+		auto drawByName = [&](uint32_t draw)
+		{
+			named.setUniform("model", models[draw % NUM_MODELS]);
+			named.setUniform("cameraPos", CAMERA_POS);
+
+			named.setUniform("sunlight.direction", glm::vec3(0.0f, -0.3f, 0.65f));
+			named.setUniform("sunlight.ambient", glm::vec3(0.0f));
+			named.setUniform("sunlight.diffuse", glm::vec3(1.0f));
+			named.setUniform("sunlight.specular", glm::vec3(0.5f));
+
+			named.setUniform("flashlight.enabled", true);
+			named.setUniform("flashlight.position", CAMERA_POS);
+			named.setUniform("flashlight.direction", FLASHLIGHT_DIRECTION);
+			named.setUniform("flashlight.ambient", glm::vec3(0.05f));
+			named.setUniform("flashlight.diffuse", glm::vec3(0.8f));
+			named.setUniform("flashlight.specular", glm::vec3(1.0f));
+			named.setUniform("flashlight.constant", 1.0f);
+			named.setUniform("flashlight.linear", 0.09f);
+			named.setUniform("flashlight.quadratic", 0.032f);
+			named.setUniform("flashlight.innerCutOff", 0.976f);
+			named.setUniform("flashlight.outerCutOff", 0.953f);
+
+			named.setUniform("mat.shininess", 32.0f);
+			named.setUniform("mat.useTextures", true);
+
+			int numDiffuse = 0, numSpecular = 0;
+			for (const auto& texture : TEXTURES)
+			{
+				if (texture.first == "DIFFUSE_TEXTURE")
+					named.setUniform("mat.diffuseTexture" + std::to_string(numDiffuse++), texture.second);
+				else if (texture.first == "SPECULAR_TEXTURE")
+					named.setUniform("mat.specularTexture" + std::to_string(numSpecular++), texture.second);
+			}
+		};
+
+		// The same uniforms set through handles fetched once up front
+		const UniformHandle MODEL = SHADER.getUniformHandle("model"), CAMERA = SHADER.getUniformHandle("cameraPos");
+		const UniformHandle SUN_DIRECTION = SHADER.getUniformHandle("sunlight.direction"),
+			SUN_AMBIENT = SHADER.getUniformHandle("sunlight.ambient"), SUN_DIFFUSE = SHADER.getUniformHandle("sunlight.diffuse"),
+			SUN_SPECULAR = SHADER.getUniformHandle("sunlight.specular");
+		const UniformHandle FLASH_ENABLED = SHADER.getUniformHandle("flashlight.enabled"),
+			FLASH_POSITION = SHADER.getUniformHandle("flashlight.position"),
+			FLASH_DIRECTION = SHADER.getUniformHandle("flashlight.direction"),
+			FLASH_AMBIENT = SHADER.getUniformHandle("flashlight.ambient"),
+			FLASH_DIFFUSE = SHADER.getUniformHandle("flashlight.diffuse"),
+			FLASH_SPECULAR = SHADER.getUniformHandle("flashlight.specular"),
+			FLASH_CONSTANT = SHADER.getUniformHandle("flashlight.constant"),
+			FLASH_LINEAR = SHADER.getUniformHandle("flashlight.linear"),
+			FLASH_QUADRATIC = SHADER.getUniformHandle("flashlight.quadratic"),
+			FLASH_INNER = SHADER.getUniformHandle("flashlight.innerCutOff"),
+			FLASH_OUTER = SHADER.getUniformHandle("flashlight.outerCutOff");
+		const UniformHandle SHININESS = SHADER.getUniformHandle("mat.shininess"),
+			USE_TEXTURES = SHADER.getUniformHandle("mat.useTextures"),
+			SAMPLERS[] = { SHADER.getUniformHandle("mat.diffuseTexture0"), SHADER.getUniformHandle("mat.specularTexture0") };
+
+		auto drawByHandle = [&](uint32_t draw)
+		{
+			SHADER.setUniform(MODEL, models[draw % NUM_MODELS]);
+			SHADER.setUniform(CAMERA, CAMERA_POS);
+
+			SHADER.setUniform(SUN_DIRECTION, glm::vec3(0.0f, -0.3f, 0.65f));
+			SHADER.setUniform(SUN_AMBIENT, glm::vec3(0.0f));
+			SHADER.setUniform(SUN_DIFFUSE, glm::vec3(1.0f));
+			SHADER.setUniform(SUN_SPECULAR, glm::vec3(0.5f));
+
+			SHADER.setUniform(FLASH_ENABLED, true);
+			SHADER.setUniform(FLASH_POSITION, CAMERA_POS);
+			SHADER.setUniform(FLASH_DIRECTION, FLASHLIGHT_DIRECTION);
+			SHADER.setUniform(FLASH_AMBIENT, glm::vec3(0.05f));
+			SHADER.setUniform(FLASH_DIFFUSE, glm::vec3(0.8f));
+			SHADER.setUniform(FLASH_SPECULAR, glm::vec3(1.0f));
+			SHADER.setUniform(FLASH_CONSTANT, 1.0f);
+			SHADER.setUniform(FLASH_LINEAR, 0.09f);
+			SHADER.setUniform(FLASH_QUADRATIC, 0.032f);
+			SHADER.setUniform(FLASH_INNER, 0.976f);
+			SHADER.setUniform(FLASH_OUTER, 0.953f);
+
+			SHADER.setUniform(SHININESS, 32.0f);
+			SHADER.setUniform(USE_TEXTURES, true);
+			for (uint32_t texture = 0; texture < 2; texture++)
+				SHADER.setUniform(SAMPLERS[texture], TEXTURES[texture].second);
+		};
+
+		// Both paths go through the same value cache, so only the model matrix (different every draw) reaches the driver.
+		// A first draw fills the caches, then the state change counters check both paths issue the same calls
+		drawByName(NUM_DRAWS - 1);
+		drawByHandle(NUM_DRAWS - 1);
+
+		double seconds[2] = {};
+		GLStateCounters counters[2];
+		for (uint32_t handles = 0; handles < 2; handles++)
+		{
+			glFinish();
+			GLState::beginFrame();
+
+			TimePoint start = startTimer();
+			for (uint32_t draw = 0; draw < NUM_DRAWS; draw++)
+			{
+				if (handles)
+					drawByHandle(draw);
+				else
+					drawByName(draw);
+			}
+			glFinish();
+			seconds[handles] = getElapsedSeconds(start);
+
+			GLState::beginFrame();
+			counters[handles] = GLState::getFrameCounters();
+		}
+
+		std::stringstream result;
+		result << "UniformHandles textured, flashlit draw: by name " <<
+			seconds[0] * 1e6 / NUM_DRAWS << " us -> by handle " << seconds[1] * 1e6 / NUM_DRAWS << " us per draw (" <<
+			seconds[0] / seconds[1] << "x), " << static_cast<float>(counters[1].m_issued) / NUM_DRAWS << " uniform calls and " <<
+			static_cast<float>(counters[1].m_skipped) / NUM_DRAWS << " cache hits per draw" <<
+			(counters[0].m_issued == counters[1].m_issued && counters[0].m_skipped == counters[1].m_skipped ? "" :
+			" (PATHS SET DIFFERENT UNIFORMS)");
+		reportResult(result.str());
+	}
+
+	void benchmarkImpostorFrames()
+	{
+		constexpr uint32_t NUM_ASTEROIDS = 100000, NUM_LEVELS = 4, NUM_FRAMES = 5;
+		constexpr uint32_t WIDTH = 1600, HEIGHT = 900; // Same as the simulation window
+		constexpr float MODEL_RADIUS = 1.2f, SHININESS = 32.0f;
+		constexpr float FADE_START = 10.0f, FADE_END = 12.0f;
+		constexpr uint32_t FRAMES_PER_SIDE = 8, FRAME_SIZE = 128;
+
+		// Everything GL lives inside of this scope, so it all gets deleted before the window takes the context with it
+		WindowFrame window("Benchmark", WIDTH, HEIGHT, false, true);
+		{
+			auto asteroidShader = std::make_shared<ShaderProgram>("Resources/Shaders/AsteroidInstancing.glsl.vsh",
+				"Resources/Shaders/AsteroidInstancing.glsl.fsh");
+			auto impostorShader = std::make_shared<ShaderProgram>("Resources/Shaders/Impostor.glsl.vsh",
+				"Resources/Shaders/Impostor.glsl.fsh");
+			auto bakeShader = std::make_shared<ShaderProgram>("Resources/Shaders/ImpostorBake.glsl.vsh",
+				"Resources/Shaders/ImpostorBake.glsl.fsh");
+			bakeShader->bindUniformBlock("Material", MATERIAL_BLOCK_BINDING);
+
+			for (const std::shared_ptr<ShaderProgram>& litShader : { asteroidShader, impostorShader })
+			{
+				litShader->bindUniformBlock("Matrices", MATRICES_BLOCK_BINDING);
+				litShader->bindUniformBlock("Lights", LIGHTS_BLOCK_BINDING);
+				litShader->bindUniformBlock("Material", MATERIAL_BLOCK_BINDING);
+				litShader->bindProgram();
+				litShader->setUniform(litShader->getUniformHandle("pointLights"), static_cast<int>(POINT_LIGHTS_TEXTURE_UNIT));
+				litShader->setUniform(litShader->getUniformHandle("clusterRanges"),
+					static_cast<int>(CLUSTER_RANGES_TEXTURE_UNIT));
+				litShader->setUniform(litShader->getUniformHandle("clusterLights"),
+					static_cast<int>(CLUSTER_LIGHTS_TEXTURE_UNIT));
+			}
+
+			// The rock stand-in with its levels of detail one after another in the indices, quantized like the asteroid
+			std::vector<glm::vec3> positions;
+			std::vector<uint32_t> indices;
+			generateRockMesh(4, positions, indices);
+			const uint32_t NUM_VERTICES = static_cast<uint32_t>(positions.size());
+
+			std::vector<VertexData> vertices(NUM_VERTICES, { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.5f) });
+			float outerRadius = 0.0f;
+			for (uint32_t vertex = 0; vertex < NUM_VERTICES; vertex++)
+			{
+				vertices[vertex].m_vertexPos = positions[vertex];
+				outerRadius = std::max(outerRadius, glm::length(positions[vertex]));
+			}
+
+			for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+			{
+				const glm::vec3 FACE_NORMAL = glm::cross(positions[indices[triangle + 1]] - positions[indices[triangle]],
+					positions[indices[triangle + 2]] - positions[indices[triangle]]);
+				for (size_t corner = 0; corner < 3; corner++)
+					vertices[indices[triangle + corner]].m_normalPos += FACE_NORMAL;
+			}
+
+			std::vector<float> levelErrors;
+			std::vector<uint32_t> levelTriangles, levelIndices, levelIndexCounts;
+			for (auto& level : MeshSimplifier::buildLODChain(positions, indices, NUM_LEVELS))
+			{
+				MeshOptimizer::optimizeVertexCache(level.m_indices, NUM_VERTICES);
+				levelErrors.emplace_back(level.m_errorBound);
+				levelTriangles.emplace_back(static_cast<uint32_t>(level.m_indices.size() / 3));
+				levelIndexCounts.emplace_back(static_cast<uint32_t>(level.m_indices.size()));
+				levelIndices.insert(levelIndices.end(), level.m_indices.begin(), level.m_indices.end());
+			}
+
+			OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+			simulation.generateAsteroidBelt(NUM_ASTEROIDS, 14.0f, BENCHMARK_SEED);
+			std::vector<InstanceData> instances(NUM_ASTEROIDS), binned(2 * NUM_ASTEROIDS);
+			std::vector<uint32_t> visibleIndices(NUM_ASTEROIDS);
+			simulation.buildInstances(instances);
+
+			Material material;
+			material.m_ambient = material.m_diffuse = glm::vec3(0.6f, 0.55f, 0.5f);
+			material.m_specular = glm::vec3(0.2f);
+			material.shininess = SHININESS;
+
+			MeshObject rock(vertices, levelIndices, material, instances.data(), NUM_ASTEROIDS, levelIndexCounts,
+				VertexFormat::QUANTIZED);
+			const MaterialBlock MATERIAL_BLOCK = rock.getMaterialBlock();
+			auto materialBuffer = std::make_shared<UniformBuffer>(&MATERIAL_BLOCK, sizeof(MaterialBlock), GL_STATIC_DRAW);
+			rock.setMaterialBuffer(materialBuffer, 0);
+
+			// Bake the atlas the same way SceneModel::bakeImpostor() does
+			ImpostorAtlas atlas(FRAMES_PER_SIDE, FRAME_SIZE, outerRadius, SHININESS, NUM_ASTEROIDS);
+			bakeShader->bindProgram();
+			const UniformHandle VIEW_PROJECTION = bakeShader->getUniformHandle("viewProjection");
+			const MeshUniforms BAKE_UNIFORMS = MeshObject::getMeshUniforms(*bakeShader);
+
+			atlas.beginBake();
+			for (uint32_t frameY = 0; frameY < FRAMES_PER_SIDE; frameY++)
+			{
+				for (uint32_t frameX = 0; frameX < FRAMES_PER_SIDE; frameX++)
+				{
+					bakeShader->setUniform(VIEW_PROJECTION, atlas.bindFrame(frameX, frameY));
+					rock.renderSingle(bakeShader, BAKE_UNIFORMS);
+				}
+			}
+			atlas.endBake();
+
+			ModelUniforms rockUniforms;
+			rockUniforms.m_program = asteroidShader->getID();
+			rockUniforms.m_mesh = MeshObject::getMeshUniforms(*asteroidShader);
+
+			// The scene gets drawn into a multisampled target like the simulation window's, lit by the sun and flashlight
+			FrameBuffer sceneFBO;
+			sceneFBO.attachColorBuffer(GL_TEXTURE_2D_MULTISAMPLE, WIDTH, HEIGHT);
+			sceneFBO.attachDepthStencilRBO(WIDTH, HEIGHT);
+
+			const glm::vec3 CAMERA_POSITION(0.0f, 3.0f, 24.0f); // Outside the belt, the view the impostors help the most
+			const glm::mat4 VIEW = glm::lookAt(CAMERA_POSITION, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			const glm::mat4 PROJECTION = glm::perspective(glm::radians(45.0f), static_cast<float>(WIDTH) / HEIGHT, 0.1f,
+				100000.0f);
+			const float PIXELS_PER_UNIT = PROJECTION[1][1] * 0.5f * HEIGHT;
+
+			DirectionalLight sunlight { glm::vec3(0.0f, -0.3f, 0.65f), glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(0.5f) };
+			SpotLight flashlight;
+			flashlight.m_position = CAMERA_POSITION;
+			flashlight.m_direction = glm::normalize(-CAMERA_POSITION);
+			flashlight.m_ambient = glm::vec3(0.1f);
+			flashlight.m_diffuse = flashlight.m_specular = glm::vec3(1.0f);
+			flashlight.m_constant = 1.0f;
+			flashlight.m_linear = 0.7f;
+			flashlight.m_quadratic = 1.8f;
+			flashlight.m_innerCutOff = std::cos(glm::radians(12.5f));
+			flashlight.m_outerCutOff = std::cos(glm::radians(17.5f));
+
+			// No beacons, like the simulation starts out, so the clusters are all empty
+			LightClusterer clusterer(16, 9, 24, 0.1f, 200.0f);
+			clusterer.assignLights(nullptr, 0, VIEW, PROJECTION);
+			const LightsBlock LIGHTS_BLOCK(sunlight, flashlight, CAMERA_POSITION, clusterer.getGridParams(WIDTH, HEIGHT));
+
+			TextureBuffer pointLightBuffer(GL_RGBA32F, sizeof(PointLight));
+			TextureBuffer clusterRangeBuffer(GL_RG32UI, sizeof(uint32_t) * clusterer.getClusterRanges().size());
+			TextureBuffer clusterLightBuffer(GL_R16UI, sizeof(uint16_t) * std::max<size_t>(clusterer.getLightIndices().size(), 1));
+			clusterRangeBuffer.replaceData(clusterer.getClusterRanges().data(),
+				sizeof(uint32_t) * clusterer.getClusterRanges().size());
+
+			FrustumCuller culler;
+			culler.setFrustum(PROJECTION * VIEW);
+			const uint32_t NUM_VISIBLE = culler.cullInstances(instances.data(), NUM_ASTEROIDS, MODEL_RADIUS, nullptr,
+				visibleIndices.data());
+
+			StreamingBuffer frameBuffer(2 * sizeof(glm::mat4) + sizeof(LightsBlock) + 2 * NUM_ASTEROIDS * sizeof(InstanceData) +
+				1024);
+			RenderQueue queue;
+
+			// Every frame bins the belt, streams it and draws it the way the simulation window does, waiting for the GPU
+			// to finish before the next one. The first frame of each setting is left out, as it compiles the shaders
+			double frameSeconds[2] = {};
+			uint64_t triangles[2] = {};
+			uint32_t numImpostors[2] = {};
+			for (uint32_t withImpostors = 0; withImpostors < 2; withImpostors++)
+			{
+				const float FADE_START_SETTING = withImpostors ? FADE_START : std::numeric_limits<float>::max();
+				const float FADE_END_SETTING = withImpostors ? FADE_END : std::numeric_limits<float>::max();
+
+				LODSelector selector(levelErrors, levelTriangles, MODEL_RADIUS);
+				selector.setImpostorRange(FADE_START_SETTING, FADE_END_SETTING);
+				for (const std::shared_ptr<ShaderProgram>& fadingShader : { asteroidShader, impostorShader })
+				{
+					fadingShader->bindProgram();
+					fadingShader->setUniform(fadingShader->getUniformHandle("impostorFadeStart"), FADE_START_SETTING);
+					fadingShader->setUniform(fadingShader->getUniformHandle("impostorFadeEnd"), FADE_END_SETTING);
+				}
+
+				TimePoint start = startTimer();
+				for (uint32_t frame = 0; frame <= NUM_FRAMES; frame++)
+				{
+					if (frame == 1)
+						start = startTimer();
+
+					const uint32_t NUM_BINNED = selector.selectLevels(instances.data(), NUM_ASTEROIDS, visibleIndices.data(),
+						NUM_VISIBLE, CAMERA_POSITION, PIXELS_PER_UNIT);
+					selector.scatterInstances(instances.data(), visibleIndices.data(), binned.data());
+					const std::vector<uint32_t>& LEVEL_OFFSETS = selector.getLevelOffsets();
+					const uint32_t FIRST_IMPOSTOR = LEVEL_OFFSETS[LEVEL_OFFSETS.size() - 2];
+					const uint32_t NUM_IMPOSTORS = LEVEL_OFFSETS.back() - FIRST_IMPOSTOR;
+
+					RenderCommand command;
+					command.m_shader = asteroidShader.get();
+					command.m_modelUniforms = &rockUniforms;
+					queue.beginFrame(VIEW);
+					command.m_transform = queue.addTransform(glm::mat4(1.0f));
+					rock.submit(queue, command, 0.0f, LEVEL_OFFSETS.data());
+					atlas.submit(queue, impostorShader, 0.0f, NUM_IMPOSTORS);
+					queue.prepare();
+
+					frameBuffer.beginFrame();
+					const StreamAllocation MATRICES = frameBuffer.allocate(2 * sizeof(glm::mat4), frameBuffer.getUniformAlignment());
+					std::memcpy(MATRICES.m_data, &VIEW[0][0], sizeof(glm::mat4));
+					std::memcpy(static_cast<glm::mat4*>(MATRICES.m_data) + 1, &PROJECTION[0][0], sizeof(glm::mat4));
+
+					const StreamAllocation LIGHTS = frameBuffer.allocate(sizeof(LightsBlock), frameBuffer.getUniformAlignment());
+					std::memcpy(LIGHTS.m_data, &LIGHTS_BLOCK, sizeof(LightsBlock));
+
+					const StreamAllocation ASTEROIDS = frameBuffer.allocate(sizeof(InstanceData) * NUM_BINNED);
+					std::memcpy(ASTEROIDS.m_data, binned.data(), sizeof(InstanceData) * NUM_BINNED);
+					rock.setLODInstanceSource(frameBuffer.getID(), ASTEROIDS.m_offset, LEVEL_OFFSETS.data());
+					atlas.setInstanceSource(frameBuffer.getID(), ASTEROIDS.m_offset +
+						static_cast<GLintptr>(sizeof(InstanceData)) * FIRST_IMPOSTOR, NUM_IMPOSTORS);
+
+					frameBuffer.finishWrites();
+					frameBuffer.bindUniformRange(MATRICES_BLOCK_BINDING, MATRICES);
+					frameBuffer.bindUniformRange(LIGHTS_BLOCK_BINDING, LIGHTS);
+					pointLightBuffer.bindTexture(POINT_LIGHTS_TEXTURE_UNIT);
+					clusterRangeBuffer.bindTexture(CLUSTER_RANGES_TEXTURE_UNIT);
+					clusterLightBuffer.bindTexture(CLUSTER_LIGHTS_TEXTURE_UNIT);
+
+					sceneFBO.bindBuffer();
+					window.setDepthTestState(true);
+					window.clearScreen(glm::vec3(0.2f));
+					queue.execute(0, 0);
+					sceneFBO.unbindBuffer();
+
+					frameBuffer.endFrame();
+					glFinish();
+
+					triangles[withImpostors] = selector.getStats().m_trianglesSubmitted;
+					numImpostors[withImpostors] = selector.getStats().m_impostors;
+				}
+				frameSeconds[withImpostors] = getElapsedSeconds(start) / NUM_FRAMES;
+			}
+
+			std::stringstream result;
+			result << "ImpostorFrames outside belt, " << NUM_VISIBLE << "/" << NUM_ASTEROIDS << " visible at " << WIDTH << "x" <<
+				HEIGHT << " (4x MSAA): impostors off " << frameSeconds[0] * 1e3 << " ms, on " << frameSeconds[1] * 1e3 <<
+				" ms per frame (" << frameSeconds[0] / frameSeconds[1] << "x), triangles " << triangles[0] << " -> " <<
+				triangles[1] << " (" << numImpostors[1] << " impostors)";
+			reportResult(result.str());
+		}
+	}
+}
\ No newline at end of file
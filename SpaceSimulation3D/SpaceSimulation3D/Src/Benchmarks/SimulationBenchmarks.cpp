@@ -0,0 +1,380 @@
+#include "Benchmarks.h"
+#include "Engine/Simulation/OrbitalSimulation.h"
+#include "Engine/Simulation/TransformKernels.h"
+#include "Engine/Utils/RandomGenerator.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <thread>
+
+namespace Benchmarks
+{
+	void benchmarkBodyIntegration()
+	{
+		for (uint32_t numBodies : { 10000u, 100000u, 1000000u })
+		{
+			OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+			simulation.generateAsteroidBelt(numBodies, 14.0f, BENCHMARK_SEED);
+
+			// Keep the total amount of work roughly constant so every size runs for a similar wall time
+			const uint32_t NUM_STEPS = std::max(10u, 20000000u / numBodies);
+			simulation.stepTick(1.0f / 120.0f); // Warm up the caches
+
+			const TimePoint START = startTimer();
+			for (uint32_t step = 0; step < NUM_STEPS; step++)
+				simulation.stepTick(1.0f / 120.0f);
+			const double ELAPSED = getElapsedSeconds(START);
+
+			std::stringstream result;
+			result << "BodyIntegration " << numBodies << " bodies: " << (ELAPSED * 1e9) / (double(numBodies) * NUM_STEPS)
+				<< " ns/body/step (" << NUM_STEPS << " steps in " << ELAPSED * 1e3 << " ms)";
+			reportResult(result.str());
+		}
+	}
+
+	void benchmarkBarnesHut()
+	{
+		constexpr uint32_t NUM_SAMPLES = 1000; // Bodies the direct-summation reference is evaluated for
+		constexpr uint32_t NUM_REPEATS = 3;
+
+		for (uint32_t numBodies : { 10000u, 100000u })
+		{
+			OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+			simulation.generateAsteroidBelt(numBodies, 14.0f, BENCHMARK_SEED);
+			const BodyStore& BODIES = simulation.getBodies();
+
+			// Direct summation reference on an evenly spread sample, the full O(N^2) cost is extrapolated from it
+			BarnesHutSolver solver(0.5f, 1.0f, 0.05f, std::make_shared<JobSystem>());
+			const uint32_t SAMPLE_STRIDE = numBodies / NUM_SAMPLES;
+			std::vector<glm::vec3> reference(NUM_SAMPLES);
+
+			const TimePoint DIRECT_START = startTimer();
+			for (uint32_t sample = 0; sample < NUM_SAMPLES; sample++)
+				reference[sample] = solver.computeDirectAcceleration(BODIES, sample * SAMPLE_STRIDE);
+			const double DIRECT_STEP = getElapsedSeconds(DIRECT_START) / NUM_SAMPLES * numBodies;
+
+			std::stringstream directResult;
+			directResult << "BarnesHut " << numBodies << " bodies, direct summation (1 thread): " << DIRECT_STEP * 1e3
+				<< " ms/step, " << (double(numBodies) * numBodies) / DIRECT_STEP / 1e6 << " M interactions/s";
+			reportResult(directResult.str());
+
+			std::vector<float> accX(numBodies), accY(numBodies), accZ(numBodies);
+			for (float theta : { 0.3f, 0.5f, 0.7f, 1.0f })
+			{
+				solver.setTheta(theta);
+				solver.computeAccelerations(BODIES, accX.data(), accY.data(), accZ.data()); // Warm up
+
+				const TimePoint START = startTimer();
+				for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+					solver.computeAccelerations(BODIES, accX.data(), accY.data(), accZ.data());
+				const double STEP_TIME = getElapsedSeconds(START) / NUM_REPEATS;
+
+				// Relative error of the sampled bodies against the reference
+				std::vector<float> errors(NUM_SAMPLES);
+				double errorSum = 0.0;
+				for (uint32_t sample = 0; sample < NUM_SAMPLES; sample++)
+				{
+					const uint32_t BODY = sample * SAMPLE_STRIDE;
+					const glm::vec3 DIFFERENCE = glm::vec3(accX[BODY], accY[BODY], accZ[BODY]) - reference[sample];
+					errors[sample] = glm::length(DIFFERENCE) / std::max(glm::length(reference[sample]), 1e-20f);
+					errorSum += errors[sample];
+				}
+
+				std::sort(errors.begin(), errors.end());
+
+				std::stringstream result;
+				result << "BarnesHut " << numBodies << " bodies, theta " << theta << ": " << STEP_TIME * 1e3
+					<< " ms/step on all threads (" << DIRECT_STEP / STEP_TIME << "x direct, " << solver.getNodeCount()
+					<< " nodes), relative force error mean " << errorSum / NUM_SAMPLES << ", p99 "
+					<< errors[NUM_SAMPLES * 99 / 100] << ", max " << errors.back();
+				reportResult(result.str());
+			}
+		}
+	}
+
+	void benchmarkJobScaling()
+	{
+		constexpr uint32_t NUM_BODIES = 1000000;
+		constexpr uint32_t NUM_REPEATS = 10;
+
+		OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+		simulation.generateAsteroidBelt(NUM_BODIES, 14.0f, BENCHMARK_SEED);
+		std::vector<glm::mat4> instances(NUM_BODIES);
+
+		// Try every power of two up to the core count, plus the core count itself
+		const uint32_t MAX_THREADS = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<uint32_t> threadCounts;
+		for (uint32_t numThreads = 1; numThreads < MAX_THREADS; numThreads *= 2)
+			threadCounts.emplace_back(numThreads);
+		threadCounts.emplace_back(MAX_THREADS);
+
+		double singleThreadTime = 0.0;
+		for (uint32_t numThreads : threadCounts)
+		{
+			simulation.setJobSystem(std::make_shared<JobSystem>(numThreads));
+			simulation.buildInstanceMatrices(instances); // Warm up
+
+			const TimePoint START = startTimer();
+			for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+				simulation.buildInstanceMatrices(instances);
+			const double ELAPSED = getElapsedSeconds(START) / NUM_REPEATS;
+
+			if (numThreads == 1)
+				singleThreadTime = ELAPSED;
+
+			std::stringstream result;
+			result << "JobScaling instance build, " << NUM_BODIES << " bodies, " << numThreads << " threads: "
+				<< ELAPSED * 1e3 << " ms (" << singleThreadTime / ELAPSED << "x speedup)";
+			reportResult(result.str());
+		}
+	}
+
+	void benchmarkTransformKernels()
+	{
+		constexpr uint32_t MATRICES_PER_SIZE = 20000000; // Matrices built per measurement, spread over the repeats
+
+		for (uint32_t numBodies : { 10000u, 100000u, 1000000u })
+		{
+			OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+			simulation.generateAsteroidBelt(numBodies, 14.0f, BENCHMARK_SEED);
+			const BodyStore& BODIES = simulation.getBodies();
+
+			std::vector<float> quatX(numBodies), quatY(numBodies), quatZ(numBodies), quatW(numBodies);
+			TransformKernels::axisAngleToQuaternion(BODIES.m_rotationAxisX.data(), BODIES.m_rotationAxisY.data(),
+				BODIES.m_rotationAxisZ.data(), BODIES.m_rotationAngle.data(), quatX.data(), quatY.data(), quatZ.data(),
+				quatW.data(), numBodies);
+
+			const uint32_t NUM_REPEATS = std::max(2u, MATRICES_PER_SIZE / numBodies);
+			std::vector<glm::mat4> reference(numBodies), instances(numBodies);
+
+			// The glm chain the kernels replace, also used as the reference for the accuracy check
+			auto buildReference = [&]()
+			{
+				for (uint32_t index = 0; index < numBodies; index++)
+				{
+					glm::mat4 model;
+					model = glm::translate(model, glm::vec3(BODIES.m_positionX[index], BODIES.m_positionY[index],
+						BODIES.m_positionZ[index]));
+					model = glm::scale(model, glm::vec3(BODIES.m_scale[index]));
+					model = glm::rotate(model, BODIES.m_rotationAngle[index], glm::vec3(BODIES.m_rotationAxisX[index],
+						BODIES.m_rotationAxisY[index], BODIES.m_rotationAxisZ[index]));
+
+					reference[index] = model;
+				}
+			};
+
+			buildReference(); // Warm up
+			TimePoint start = startTimer();
+			for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+				buildReference();
+			const double REFERENCE_RATE = double(numBodies) * NUM_REPEATS / getElapsedSeconds(start);
+
+			std::stringstream result;
+			result << "TransformKernels " << numBodies << " bodies, glm chain: " << REFERENCE_RATE / 1e6 << " M matrices/s";
+			reportResult(result.str());
+
+			const std::pair<KernelPath, const char*> PATHS[] { { KernelPath::SCALAR, "scalar" },
+				{ KernelPath::SSE, "SSE" }, { KernelPath::AVX2, "AVX2" } };
+
+			for (const auto& path : PATHS)
+			{
+				result.str("");
+				if (path.first > TransformKernels::getBestKernelPath())
+				{
+					result << "TransformKernels " << numBodies << " bodies, " << path.second << ": not supported by this CPU";
+					reportResult(result.str());
+					continue;
+				}
+
+				auto buildKernel = [&]()
+				{
+					TransformKernels::buildTRSMatricesWith(path.first, BODIES.m_positionX.data(),
+						BODIES.m_positionY.data(), BODIES.m_positionZ.data(), BODIES.m_scale.data(), quatX.data(),
+						quatY.data(), quatZ.data(), quatW.data(), instances.data(), numBodies);
+				};
+
+				buildKernel(); // Warm up
+				start = startTimer();
+				for (uint32_t repeat = 0; repeat < NUM_REPEATS; repeat++)
+					buildKernel();
+				const double RATE = double(numBodies) * NUM_REPEATS / getElapsedSeconds(start);
+
+				float maxError = 0.0f;
+				for (uint32_t index = 0; index < numBodies; index++)
+				{
+					for (uint32_t column = 0; column < 4; column++)
+					{
+						for (uint32_t row = 0; row < 4; row++)
+							maxError = std::max(maxError, std::abs(instances[index][column][row] - reference[index][column][row]));
+					}
+				}
+
+				result << "TransformKernels " << numBodies << " bodies, " << path.second << ": " << RATE / 1e6
+					<< " M matrices/s (" << RATE / REFERENCE_RATE << "x glm, max abs error " << maxError << ")";
+				reportResult(result.str());
+			}
+		}
+	}
+
+	void benchmarkIntegrators()
+	{
+		constexpr uint32_t NUM_BODIES = 1000;
+		constexpr float NUM_ORBITS = 10.0f;
+		constexpr float CENTRAL_GM = 7.5f, BELT_RADIUS = 14.0f;
+
+		// The period of a circular orbit at the belt radius, which sets how long every run lasts
+		const float ORBITAL_PERIOD = glm::radians(360.0f) * std::sqrt(BELT_RADIUS * BELT_RADIUS * BELT_RADIUS / CENTRAL_GM);
+
+		const std::pair<IntegratorType, const char*> INTEGRATORS[] { { IntegratorType::SEMI_IMPLICIT_EULER, "Euler" },
+			{ IntegratorType::VELOCITY_VERLET, "Verlet" }, { IntegratorType::YOSHIDA4, "Yoshida4" },
+			{ IntegratorType::RK4, "RK4" } };
+
+		// The real-time tick, then time warps of 30x and 120x where the integrators start to differ. With the real-time
+		// tick every scheme is down at the float rounding error
+		for (float timeStep : { 1.0f / 120.0f, 0.25f, 1.0f })
+		{
+			const uint32_t NUM_STEPS = static_cast<uint32_t>(NUM_ORBITS * ORBITAL_PERIOD / timeStep);
+
+			for (const auto& integrator : INTEGRATORS)
+			{
+				OrbitalSimulation simulation(glm::vec3(0.0f), CENTRAL_GM);
+				simulation.generateAsteroidBelt(NUM_BODIES, BELT_RADIUS, BENCHMARK_SEED);
+				simulation.setIntegrator(integrator.first);
+
+				const double START_ENERGY = simulation.computeEnergy();
+				const glm::vec3 START_MOMENTUM = simulation.computeAngularMomentum();
+				double maxEnergyDrift = 0.0;
+
+				const TimePoint START = startTimer();
+				for (uint32_t step = 0; step < NUM_STEPS; step++)
+				{
+					simulation.stepTick(timeStep);
+
+					// Sampled every so often, the symplectic schemes oscillate around the true energy instead of
+					// drifting away from it, so the worst point of the run matters as much as the end
+					if (step % 256 == 0)
+						maxEnergyDrift = std::max(maxEnergyDrift, std::abs((simulation.computeEnergy() - START_ENERGY) /
+							START_ENERGY));
+				}
+				const double ELAPSED = getElapsedSeconds(START);
+
+				const double END_ENERGY_DRIFT = std::abs((simulation.computeEnergy() - START_ENERGY) / START_ENERGY);
+				const double MOMENTUM_DRIFT = glm::length(simulation.computeAngularMomentum() - START_MOMENTUM) /
+					glm::length(START_MOMENTUM);
+
+				std::stringstream result;
+				result << "Integrators " << integrator.second << ", dt " << timeStep << ", " << NUM_ORBITS << " orbits ("
+					<< NUM_STEPS << " steps, " << NUM_BODIES << " bodies): " << ELAPSED * 1e3 << " ms, "
+					<< NUM_STEPS / ELAPSED << " steps/s, energy drift " << END_ENERGY_DRIFT << " (max "
+					<< std::max(maxEnergyDrift, END_ENERGY_DRIFT) << "), angular momentum drift " << MOMENTUM_DRIFT;
+				reportResult(result.str());
+			}
+		}
+	}
+
+	void benchmarkRandomGeneration()
+	{
+		constexpr uint32_t NUM_VALUES = 10000000;
+		std::vector<float> values(NUM_VALUES);
+
+		TimePoint start = startTimer();
+		for (uint32_t index = 0; index < NUM_VALUES; index++)
+			values[index] = Random::generateFloat(0.0f, 1.0f);
+		const double MT_RATE = NUM_VALUES / getElapsedSeconds(start);
+
+		start = startTimer();
+		Random::fillFloats(BENCHMARK_SEED, 0, 0, values.data(), NUM_VALUES, 0.0f, 1.0f);
+		const double FILL_RATE = NUM_VALUES / getElapsedSeconds(start);
+
+		std::stringstream result;
+		result << "RandomGeneration floats: std::mt19937 " << MT_RATE / 1e6 << " M/s, counter-based fill " << FILL_RATE / 1e6
+			<< " M/s";
+		reportResult(result.str());
+
+		// The same seed has to give the same belt no matter how many threads generated it
+		for (uint32_t numBodies : { 100000u, 1000000u })
+		{
+			OrbitalSimulation serial(glm::vec3(0.0f), 7.5f);
+			start = startTimer();
+			serial.generateAsteroidBelt(numBodies, 14.0f, BENCHMARK_SEED);
+			const double SERIAL_TIME = getElapsedSeconds(start);
+
+			auto jobSystem = std::make_shared<JobSystem>(std::max(4u, std::thread::hardware_concurrency()));
+			OrbitalSimulation parallel(glm::vec3(0.0f), 7.5f);
+			parallel.setJobSystem(jobSystem);
+
+			start = startTimer();
+			parallel.generateAsteroidBelt(numBodies, 14.0f, BENCHMARK_SEED);
+			const double PARALLEL_TIME = getElapsedSeconds(start);
+
+			const BodyStore& SERIAL_BODIES = serial.getBodies();
+			const BodyStore& PARALLEL_BODIES = parallel.getBodies();
+			const std::vector<float> BodyStore::* const ARRAYS[] = { &BodyStore::m_positionX, &BodyStore::m_positionY,
+				&BodyStore::m_positionZ, &BodyStore::m_velocityX, &BodyStore::m_velocityY, &BodyStore::m_velocityZ,
+				&BodyStore::m_mass, &BodyStore::m_scale, &BodyStore::m_rotationAxisX, &BodyStore::m_rotationAxisY,
+				&BodyStore::m_rotationAxisZ, &BodyStore::m_rotationAngle, &BodyStore::m_spinRate };
+
+			bool identical = true;
+			for (const std::vector<float> BodyStore::* array : ARRAYS)
+				identical = identical && SERIAL_BODIES.*array == PARALLEL_BODIES.*array;
+
+			result.str("");
+			result << "RandomGeneration belt of " << numBodies << " asteroids: serial " << SERIAL_TIME * 1e3 << " ms, "
+				<< jobSystem->getThreadCount() << " threads " << PARALLEL_TIME * 1e3 << " ms, "
+				<< (identical ? "identical" : "MISMATCH");
+			reportResult(result.str());
+		}
+	}
+
+	void benchmarkCollisions()
+	{
+		constexpr uint32_t NUM_STEPS = 120;
+		constexpr uint32_t NUM_WARMUP_STEPS = 30; // Lets the overlaps of the generated belt settle first
+		constexpr double TICK_BUDGET = 1.0 / 120.0;
+
+		for (uint32_t numBodies : { 10000u, 100000u })
+		{
+			auto jobSystem = std::make_shared<JobSystem>();
+			OrbitalSimulation simulation(glm::vec3(0.0f), 7.5f);
+			simulation.setJobSystem(jobSystem);
+			simulation.generateAsteroidBelt(numBodies, 14.0f, BENCHMARK_SEED);
+
+			CollisionSystem collisions(1.0f, 0.4f, jobSystem);
+			for (uint32_t step = 0; step < NUM_WARMUP_STEPS; step++)
+			{
+				simulation.stepTick(1.0f / 120.0f);
+				collisions.update(simulation.getBodies());
+			}
+
+			// Only the collision update is timed, the integration in between just keeps the bodies moving
+			double elapsed = 0.0;
+			uint64_t pairsTested = 0, contacts = 0, cellChanges = 0;
+
+			for (uint32_t step = 0; step < NUM_STEPS; step++)
+			{
+				simulation.stepTick(1.0f / 120.0f);
+
+				const TimePoint START = startTimer();
+				collisions.update(simulation.getBodies());
+				elapsed += getElapsedSeconds(START);
+
+				pairsTested += collisions.getStats().m_pairsTested;
+				contacts += collisions.getStats().m_contacts;
+				cellChanges += collisions.getStats().m_cellChanges;
+			}
+
+			const double UPDATE_TIME = elapsed / NUM_STEPS;
+
+			std::stringstream result;
+			result << "Collisions " << numBodies << " bodies, " << jobSystem->getThreadCount() << " threads: "
+				<< UPDATE_TIME * 1e3 << " ms/update (" << UPDATE_TIME / TICK_BUDGET * 100.0 << "% of a 120 Hz tick), "
+				<< pairsTested / elapsed / 1e6 << " M pairs tested/s, " << pairsTested / NUM_STEPS << " pairs, "
+				<< contacts / NUM_STEPS << " contacts, " << cellChanges / NUM_STEPS << " cell changes per update";
+			reportResult(result.str());
+		}
+	}
+}
\ No newline at end of file
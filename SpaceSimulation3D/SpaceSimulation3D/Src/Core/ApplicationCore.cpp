@@ -1,12 +1,55 @@
 #include "ApplicationCore.h"
+#include "Engine/Utils/LoggingManager.h"
 #include "Engine/Utils/RandomGenerator.h"
+#include "Engine/Utils/GLStateCache.h"
 
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <ctime>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+	constexpr uint32_t NUM_ASTEROIDS = 10000;
+	constexpr float CAMERA_COLLISION_RADIUS = 0.2f;
+	constexpr uint32_t ASTEROID_LOD_LEVELS = 4;
+	constexpr uint32_t MAX_CATCHUP_STEPS = 8; // Most ticks ran in one frame before simulation time is dropped
+	constexpr float PLANET_SCALE = 0.01f;
+	constexpr uint32_t OCCLUSION_BUFFER_WIDTH = 256, OCCLUSION_BUFFER_HEIGHT = 144; // Same aspect ratio as the window
+	constexpr uint32_t NUM_FRAME_PACKETS = 2; // One being drawn by the render thread, one being prepared
+
+	// Asteroids past the fade band get drawn as impostors, from an atlas of views baked from the asteroid model
+	constexpr float IMPOSTOR_FADE_START = 10.0f, IMPOSTOR_FADE_END = 12.0f;
+	constexpr uint32_t IMPOSTOR_FRAMES_PER_SIDE = 8, IMPOSTOR_FRAME_SIZE = 128;
+
+	// The light clusters cover the belt and its surroundings, lights further out than that aren't shaded
+	constexpr uint32_t CLUSTER_GRID_X = 16, CLUSTER_GRID_Y = 9, CLUSTER_GRID_Z = 24;
+	constexpr float CLUSTER_NEAR_PLANE = 0.1f, CLUSTER_FAR_PLANE = 200.0f;
+
+	// The moons circle the planet past the asteroid belt, each a copy of the planet model batched into a single draw
+	constexpr uint32_t NUM_MOONS = 128;
+	constexpr uint64_t MOON_SEED = 0x6D6F6F6E73;
+	constexpr float MOON_RING_INNER_RADIUS = 22.0f, MOON_RING_OUTER_RADIUS = 30.0f;
+	constexpr float MOON_MIN_SCALE = 0.1f, MOON_MAX_SCALE = 0.25f; // Relative to the planet
+
+	constexpr uint32_t BEACON_COUNTS[] = { 0, 64, 256, 1024 };
+	constexpr uint64_t BEACON_SEED = 0x626561636F6E73;
+	constexpr float BEACON_RADIUS = 1.5f, BEACON_INTENSITY = 2.0f;
+}
 
 ApplicationCore::ApplicationCore() :
-	m_window(std::make_shared<WindowFrame>("Space Simulation 3D", 1600, 900))
+	m_window(std::make_shared<WindowFrame>("Space Simulation 3D", 1600, 900)),
+	m_simulation(std::make_shared<SimulationCore>(NUM_ASTEROIDS, Random::generateSeed())),
+	m_moonSpinAxis(glm::normalize(glm::vec3(0.3f, 1.0f, 0.0f))), m_batchingEnabled(true), m_numVisibleAsteroids(0),
+	m_asteroidCuller(m_simulation->getJobSystem()),
+	m_occlusionCuller(OCCLUSION_BUFFER_WIDTH, OCCLUSION_BUFFER_HEIGHT, m_simulation->getJobSystem()),
+	m_occlusionEnabled(true), m_impostorsEnabled(true), m_impostorFadeStart(0.0f), m_impostorFadeEnd(0.0f), m_beaconSetting(0),
+	m_lightClusterer(CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z, CLUSTER_NEAR_PLANE, CLUSTER_FAR_PLANE),
+	m_reportSeconds(0.0), m_reportFrames(0)
 {
 	this->initResources();
 	this->mainLoop();
@@ -22,22 +65,66 @@ void ApplicationCore::initResources()
 	// Setup the shaders needed
 	m_planetShader = std::make_shared<ShaderProgram>("Resources/Shaders/Planet.glsl.vsh",
 		"Resources/Shaders/Planet.glsl.fsh");
-	m_planetShader->bindUniformBlock("Matrices", 0);
+	m_planetShader->bindUniformBlock("Matrices", MATRICES_BLOCK_BINDING);
+	m_planetShader->bindUniformBlock("Lights", LIGHTS_BLOCK_BINDING);
+	m_planetShader->bindUniformBlock("Material", MATERIAL_BLOCK_BINDING);
 
 	m_asteroidShader = std::make_shared<ShaderProgram>("Resources/Shaders/AsteroidInstancing.glsl.vsh",
 		"Resources/Shaders/AsteroidInstancing.glsl.fsh");
-	m_asteroidShader->bindUniformBlock("Matrices", 0);
+	m_asteroidShader->bindUniformBlock("Matrices", MATRICES_BLOCK_BINDING);
+	m_asteroidShader->bindUniformBlock("Lights", LIGHTS_BLOCK_BINDING);
+	m_asteroidShader->bindUniformBlock("Material", MATERIAL_BLOCK_BINDING);
+
+	m_impostorShader = std::make_shared<ShaderProgram>("Resources/Shaders/Impostor.glsl.vsh",
+		"Resources/Shaders/Impostor.glsl.fsh");
+	m_impostorShader->bindUniformBlock("Matrices", MATRICES_BLOCK_BINDING);
+	m_impostorShader->bindUniformBlock("Lights", LIGHTS_BLOCK_BINDING);
+
+	m_asteroidFadeUniforms[0] = m_asteroidShader->getUniformHandle("impostorFadeStart");
+	m_asteroidFadeUniforms[1] = m_asteroidShader->getUniformHandle("impostorFadeEnd");
+	m_impostorFadeUniforms[0] = m_impostorShader->getUniformHandle("impostorFadeStart");
+	m_impostorFadeUniforms[1] = m_impostorShader->getUniformHandle("impostorFadeEnd");
+
+	m_impostorBakeShader = std::make_shared<ShaderProgram>("Resources/Shaders/ImpostorBake.glsl.vsh",
+		"Resources/Shaders/ImpostorBake.glsl.fsh");
+	m_impostorBakeShader->bindUniformBlock("Material", MATERIAL_BLOCK_BINDING);
+
+	// The lit shaders read the point lights and their clusters from texture buffers on fixed units
+	for (const std::shared_ptr<ShaderProgram>& litShader : { m_planetShader, m_asteroidShader, m_impostorShader })
+	{
+		litShader->bindProgram();
+		litShader->setUniform(litShader->getUniformHandle("pointLights"), static_cast<int>(POINT_LIGHTS_TEXTURE_UNIT));
+		litShader->setUniform(litShader->getUniformHandle("clusterRanges"),
+			static_cast<int>(CLUSTER_RANGES_TEXTURE_UNIT));
+		litShader->setUniform(litShader->getUniformHandle("clusterLights"),
+			static_cast<int>(CLUSTER_LIGHTS_TEXTURE_UNIT));
+	}
 
 	m_skyboxShader = std::make_shared<ShaderProgram>("Resources/Shaders/Skybox.glsl.vsh",
 		"Resources/Shaders/Skybox.glsl.fsh");
-	m_skyboxShader->bindUniformBlock("Matrices", 0);
+	m_skyboxShader->bindUniformBlock("Matrices", MATRICES_BLOCK_BINDING);
 
 	m_multisamplingShader = std::make_shared<ShaderProgram>("Resources/Shaders/Multisampling.glsl.vsh",
 		"Resources/Shaders/Multisampling.glsl.fsh");
-
-	// Initialize the matrices ubo
-	m_matricesUBO = std::make_shared<UniformBuffer>(nullptr, 2 * sizeof(glm::mat4), GL_STATIC_DRAW);
-	m_matricesUBO->setBindingPoint(0, 0, 2 * sizeof(glm::mat4));
+	m_numSamplesUniform = m_multisamplingShader->getUniformHandle("numSamples");
+	m_colorAttachmentUniform = m_multisamplingShader->getUniformHandle("colorAttachment0");
+
+	// Initialize the buffer everything rewritten each frame streams through, with room for the matrices, lights and every
+	// asteroid (twice over for the ones drawn both ways while fading into impostors), and the model matrices of the
+	// batched draws (the moons and planet, any number of meshes each before running out of room)
+	m_frameBuffer = std::make_shared<StreamingBuffer>(2 * sizeof(glm::mat4) + 2 * NUM_ASTEROIDS * sizeof(InstanceData) +
+		sizeof(LightsBlock) + 16 * (NUM_MOONS + 1) * sizeof(glm::mat4) + 1024);
+
+	// Then the buffers the light clusters are uploaded to every frame, which grow if they need to
+	m_lightClusterer.setJobSystem(m_simulation->getJobSystem());
+	m_clusterParams = m_lightClusterer.getGridParams(static_cast<float>(m_window->getWidth()),
+		static_cast<float>(m_window->getHeight()));
+
+	m_pointLightBuffer = std::make_shared<TextureBuffer>(GL_RGBA32F, sizeof(PointLight) * BEACON_COUNTS[3]);
+	m_clusterRangeBuffer = std::make_shared<TextureBuffer>(GL_RG32UI, sizeof(uint32_t) * 2 *
+		m_lightClusterer.getNumClusters());
+	m_clusterLightBuffer = std::make_shared<TextureBuffer>(GL_R16UI, sizeof(uint16_t) * 16 *
+		m_lightClusterer.getNumClusters());
 
 	// Create the skybox for the scene
 	std::array<std::string, 6> texturePaths
@@ -52,48 +139,43 @@ void ApplicationCore::initResources()
 
 	m_sceneSkybox = std::make_shared<Skybox>(texturePaths);
 
-	// Setup the planet model
+	// Setup the planet model, its large mesh stored in the quantized vertex format
 	m_planet = std::make_shared<SceneModel>("Resources/Models/MarsPlanet/mars_planet.obj",
-		"Resources/Textures/MarsPlanet");
-	m_planet->setPosition(glm::vec3(-20.0f, 0.0f, 10.0f));
-	m_planet->setScale(glm::vec3(0.01f));
+		"Resources/Textures/MarsPlanet", 128.0f, nullptr, 0, 1, VertexFormat::QUANTIZED);
+	m_planet->setPosition(m_simulation->getPlanetPosition());
+	m_planet->setScale(glm::vec3(PLANET_SCALE));
 
-	// Setup the asteroid instances on the scene
-	constexpr int NUM_ASTEROIDS = 10000;
-	glm::mat4* instancedArray = new glm::mat4[NUM_ASTEROIDS];
-	
-	for (int index = 0; index < NUM_ASTEROIDS; index++)
+	// Scatter the moons around a ring past the asteroid belt, in roughly the same plane
+	m_moonPlacements.resize(NUM_MOONS);
+	for (uint32_t index = 0; index < NUM_MOONS; index++)
 	{
-		// Generate a position for the asteroid
-		const float RADIUS = 14.0f;
-		float angle = static_cast<float>(index) / static_cast<float>(NUM_ASTEROIDS) * 360.0f;
-		float xOffset = Random::generateFloat(-2.5f, 4.0f);
-		float yOffset = Random::generateFloat(-0.5f, 0.5f);
-		float zOffset = Random::generateFloat(-2.5f, 4.0f);
-
-		glm::vec3 position;
-		position.x = m_planet->getPosition().x + (cos(angle) * RADIUS) + xOffset;
-		position.y = yOffset;
-		position.z = m_planet->getPosition().z + (sin(angle) * RADIUS) + zOffset;
+		const float ANGLE = Random::getFloat(MOON_SEED, 0, index, 0.0f, 6.2831853f);
+		const float RADIUS = Random::getFloat(MOON_SEED, 1, index, MOON_RING_INNER_RADIUS, MOON_RING_OUTER_RADIUS);
+		const glm::vec3 OFFSET(cos(ANGLE) * RADIUS, Random::getFloat(MOON_SEED, 2, index, -1.5f, 1.5f), sin(ANGLE) * RADIUS);
 
-		// Generate a scale for the asteroid
-		float scale = Random::generateFloat(0.03f, 0.1f);
-
-		// Generate rotation for the asteroid
-		glm::vec3 rotationAxis = glm::vec3(Random::generateFloat(0.0f, 1.0f), Random::generateFloat(0.0f, 1.0f),
-			Random::generateFloat(0.0f, 1.0f));
-		float rotationAngle = Random::generateFloat(0.0f, 360.0f);
+		m_moonPlacements[index] = glm::vec4(m_planet->getPosition() + OFFSET, PLANET_SCALE *
+			Random::getFloat(MOON_SEED, 3, index, MOON_MIN_SCALE, MOON_MAX_SCALE));
+	}
 
-		glm::mat4 model;
-		model = glm::translate(model, position);
-		model = glm::scale(model, glm::vec3(scale));
-		model = glm::rotate(model, glm::radians(rotationAngle), rotationAxis);
+	// Build the asteroid instances from the belt simulation orbiting around the planet
+	m_simulation->getAsteroidField()->buildInstances(m_asteroidInstances);
+	m_visibleAsteroidIndices.resize(m_asteroidInstances.size());
 
-		instancedArray[index] = model;
+	// Every packet has room for all the asteroids, twice over for the ones drawn both ways while fading into impostors
+	m_framePackets.resize(NUM_FRAME_PACKETS);
+	for (FramePacket& packet : m_framePackets)
+	{
+		packet.m_asteroids.resize(2 * m_asteroidInstances.size());
+		packet.m_renderQueue = std::make_shared<RenderQueue>();
 	}
 
 	m_asteroid = std::make_shared<SceneModel>("Resources/Models/Asteroid/rock.obj", "Resources/Textures/Asteroid", 
-		32.0f, instancedArray, NUM_ASTEROIDS);
+		32.0f, m_asteroidInstances.data(), NUM_ASTEROIDS, ASTEROID_LOD_LEVELS, VertexFormat::QUANTIZED);
+	m_asteroidLODs = std::make_shared<LODSelector>(m_asteroid->getLODErrors(), m_asteroid->getLODTriangles(),
+		ASTEROID_BOUNDING_RADIUS);
+
+	m_asteroid->bakeImpostor(m_impostorBakeShader, IMPOSTOR_FRAMES_PER_SIDE, IMPOSTOR_FRAME_SIZE);
+	this->applyImpostorRange();
 
 	// Create the perspective camera for the scene
 	m_camera = SceneCamera(m_window, glm::vec3(0.0f, 0.0f, 3.0f));
@@ -121,7 +203,12 @@ void ApplicationCore::initResources()
 	m_multisampleFBO->attachDepthStencilRBO(static_cast<int>(m_window->getWidth()), 
 		static_cast<int>(m_window->getHeight()));
 
-	// Setup the spotlight (AKA the flashlight) properties
+	// Setup the sunlight and the spotlight (AKA the flashlight) properties
+	m_sunlight.m_direction = glm::vec3(0.0f, -0.3f, 0.65f);
+	m_sunlight.m_ambient = glm::vec3(0.0f);
+	m_sunlight.m_diffuse = glm::vec3(1.0f);
+	m_sunlight.m_specular = glm::vec3(0.5f);
+
 	m_flashlight.m_ambient = glm::vec3(0.1f);
 	m_flashlight.m_diffuse = glm::vec3(1.0f);
 	m_flashlight.m_specular = glm::vec3(1.0f);
@@ -134,19 +221,73 @@ void ApplicationCore::initResources()
 	m_flashlight.m_outerCutOff = cos(glm::radians(17.5f));
 }
 
+void ApplicationCore::setupBeacons(uint32_t num_beacons)
+{
+	// The colors are fixed here, the positions follow the asteroids every frame
+	m_pointLights.resize(num_beacons);
+	for (uint32_t index = 0; index < num_beacons; index++)
+	{
+		m_pointLights[index].m_radius = BEACON_RADIUS;
+		m_pointLights[index].m_intensity = BEACON_INTENSITY;
+		m_pointLights[index].m_color = glm::vec3(Random::getFloat(BEACON_SEED, 0, index, 0.2f, 1.0f),
+			Random::getFloat(BEACON_SEED, 1, index, 0.2f, 1.0f), Random::getFloat(BEACON_SEED, 2, index, 0.2f, 1.0f));
+	}
+
+	OutputLog("Asteroid beacons: " + std::to_string(num_beacons), Logging::Severity::NOTIFICATION);
+}
+
+void ApplicationCore::applyImpostorRange()
+{
+	// Turning them off pushes the fade out past anything that gets drawn. The shaders get the range with each packet
+	m_impostorFadeStart = m_impostorsEnabled ? IMPOSTOR_FADE_START : std::numeric_limits<float>::max();
+	m_impostorFadeEnd = m_impostorsEnabled ? IMPOSTOR_FADE_END : std::numeric_limits<float>::max();
+	m_asteroidLODs->setImpostorRange(m_impostorFadeStart, m_impostorFadeEnd);
+}
+
 void ApplicationCore::mainLoop()
 {
-	float previousTime = 0.0f;
+	// From here on the render thread owns the context, drawing each packet while the next one gets prepared here
+	m_renderThread = std::make_shared<RenderThread>(m_window, NUM_FRAME_PACKETS,
+		[this](uint32_t packet_index) { this->render(m_framePackets[packet_index]); });
+
+	double previousTime = glfwGetTime();
+	double accumulator = 0.0;
+
 	while (!m_window->wasRequestedClose())
 	{
+		// Wait for a packet the render thread is done with before starting on the frame, so the input is fresh
+		const uint32_t PACKET_INDEX = m_renderThread->acquirePacket();
+		m_lastQueueStats = m_framePackets[PACKET_INDEX].m_renderQueue->getStats();
+
 		// Calculate the delta time of each loop
-		const float CURRENT_TIME = static_cast<float>(glfwGetTime());
-		const float DELTA_TIME = CURRENT_TIME - previousTime;
+		const double CURRENT_TIME = glfwGetTime();
+		const double DELTA_TIME = CURRENT_TIME - previousTime;
 		previousTime = CURRENT_TIME;
 
-		this->updateTick(DELTA_TIME);
-		this->render();
+		this->updateTick(static_cast<float>(DELTA_TIME));
+
+		// Step the simulation at a fixed rate with however many ticks the frame time covers. If a frame spike needs
+		// more than the catch-up cap, the leftover time is dropped instead of spiralling into ever longer frames
+		accumulator += DELTA_TIME;
+		uint32_t numSteps = 0;
+
+		while (accumulator >= FIXED_TIME_STEP && numSteps < MAX_CATCHUP_STEPS)
+		{
+			m_simulation->simulateTick(static_cast<float>(FIXED_TIME_STEP));
+			accumulator -= FIXED_TIME_STEP;
+			numSteps++;
+		}
+
+		if (accumulator >= FIXED_TIME_STEP)
+			accumulator = std::fmod(accumulator, FIXED_TIME_STEP);
+
+		// Render the state blended between the last two ticks by how far we are into the next one
+		this->interpolateState(static_cast<float>(accumulator / FIXED_TIME_STEP), m_framePackets[PACKET_INDEX]);
+		m_renderThread->submitPacket(PACKET_INDEX, glfwGetTime() - CURRENT_TIME);
 	}
+
+	// Draw what is left and take the context back, so the resources can be deleted on this thread
+	m_renderThread.reset();
 }
 
 void ApplicationCore::updateTick(const float& DELTA_TIME)
@@ -161,10 +302,129 @@ void ApplicationCore::updateTick(const float& DELTA_TIME)
 		m_flashlight.m_enabled = !m_flashlight.m_enabled;
 		prevTime = CURRENT_TIME;
 	}
+	else if (m_window->wasKeyPressed(GLFW_KEY_G) && (CURRENT_TIME - prevTime > 0.5f))
+	{
+		// Toggle the mutual attraction between the asteroids
+		m_simulation->setMutualGravity(!m_simulation->getAsteroidField()->getMutualGravity());
+
+		prevTime = CURRENT_TIME;
+	}
+	else if (m_window->wasKeyPressed(GLFW_KEY_I) && (CURRENT_TIME - prevTime > 0.5f))
+	{
+		// Cycle through the integration schemes of the asteroid field
+		const std::shared_ptr<OrbitalSimulation> ASTEROID_FIELD = m_simulation->getAsteroidField();
+		const IntegratorType NEXT_TYPE = static_cast<IntegratorType>((static_cast<int>(
+			ASTEROID_FIELD->getIntegrator().getType()) + 1) % (static_cast<int>(IntegratorType::RK4) + 1));
+
+		ASTEROID_FIELD->setIntegrator(NEXT_TYPE);
+		OutputLog(std::string("Asteroid integrator: ") + ASTEROID_FIELD->getIntegrator().getName(),
+			Logging::Severity::NOTIFICATION);
+
+		prevTime = CURRENT_TIME;
+	}
+	else if (m_window->wasKeyPressed(GLFW_KEY_O) && (CURRENT_TIME - prevTime > 0.5f))
+	{
+		// Toggle culling the asteroids hidden behind the planet
+		m_occlusionEnabled = !m_occlusionEnabled;
+		OutputLog(std::string("Occlusion culling: ") + (m_occlusionEnabled ? "ON" : "OFF"), Logging::Severity::NOTIFICATION);
+
+		prevTime = CURRENT_TIME;
+	}
+	else if (m_window->wasKeyPressed(GLFW_KEY_P) && (CURRENT_TIME - prevTime > 0.5f))
+	{
+		// Toggle drawing the distant asteroids as impostors
+		m_impostorsEnabled = !m_impostorsEnabled;
+		this->applyImpostorRange();
+		OutputLog(std::string("Asteroid impostors: ") + (m_impostorsEnabled ? "ON" : "OFF"), Logging::Severity::NOTIFICATION);
+
+		prevTime = CURRENT_TIME;
+	}
+	else if (m_window->wasKeyPressed(GLFW_KEY_K) && (CURRENT_TIME - prevTime > 0.5f))
+	{
+		// Toggle merging the copies of a mesh into single draws
+		m_batchingEnabled = !m_batchingEnabled;
+		OutputLog(std::string("Draw batching: ") + (m_batchingEnabled ? "ON" : "OFF"), Logging::Severity::NOTIFICATION);
+
+		prevTime = CURRENT_TIME;
+	}
+	else if (m_window->wasKeyPressed(GLFW_KEY_B) && (CURRENT_TIME - prevTime > 0.5f))
+	{
+		// Cycle through the number of asteroids carrying a point light
+		m_beaconSetting = (m_beaconSetting + 1) % (sizeof(BEACON_COUNTS) / sizeof(BEACON_COUNTS[0]));
+		this->setupBeacons(BEACON_COUNTS[m_beaconSetting]);
 
-	m_window->updateTick();
+		prevTime = CURRENT_TIME;
+	}
+	else if (m_window->wasKeyPressed(GLFW_KEY_L) && (CURRENT_TIME - prevTime > 0.5f))
+	{
+		// Report how much the culling, levels of detail, light clusters and state cache are saving this frame, and how the
+		// geometry pools are filled
+		const LODStats& STATS = m_asteroidLODs->getStats();
+		const OcclusionStats& OCCLUSION = m_occlusionCuller.getStats();
+		const ClusterStats& CLUSTERS = m_lightClusterer.getStats();
+		const RenderTimings TIMINGS = m_renderThread->takeTimings();
+		const double FRAMES = static_cast<double>(std::max(TIMINGS.m_numFrames, 1u));
+		std::stringstream report;
+		report << "Asteroids visible: " << m_numVisibleAsteroids << "/" << m_asteroidCuller.getStats().m_tested <<
+			" (" << m_asteroidCuller.getStats().m_visible << " in the frustum";
+
+		if (m_occlusionEnabled)
+			report << ", " << OCCLUSION.m_occluded << " of them hidden by the planet, occlusion took " <<
+				OCCLUSION.m_rasterSeconds * 1e3 << " ms to rasterize " << OCCLUSION.m_rasterizedTriangles << "/" <<
+				OCCLUSION.m_occluderTriangles << " triangles and " << OCCLUSION.m_testSeconds * 1e3 << " ms to test";
+
+		report << "), frame time: " << m_reportSeconds * 1e3 / std::max(m_reportFrames, 1u) << " ms (CPU frame: " <<
+			TIMINGS.m_cpuSeconds * 1e3 / FRAMES << " ms + " << TIMINGS.m_acquireWaitSeconds * 1e3 / FRAMES <<
+			" ms waiting for the render thread, GL submit: " << TIMINGS.m_submitSeconds * 1e3 / FRAMES << " ms + " <<
+			TIMINGS.m_swapSeconds * 1e3 / FRAMES << " ms swapping + " << TIMINGS.m_idleSeconds * 1e3 / FRAMES <<
+			" ms waiting for a packet), triangles submitted: " <<
+			STATS.m_trianglesSubmitted << " (" << STATS.m_trianglesWithoutLOD << " without LOD or impostors), per level:";
+
+		for (uint32_t numInstances : STATS.m_instancesPerLevel)
+			report << " " << numInstances;
+
+		if (m_impostorsEnabled)
+			report << ", impostors: " << STATS.m_impostors << " (" << STATS.m_crossFading << " fading in)";
+
+		report << ", point lights in view: " << CLUSTERS.m_visibleLights << "/" << CLUSTERS.m_numLights << " across " <<
+			CLUSTERS.m_occupiedClusters << "/" << m_lightClusterer.getNumClusters() << " clusters (at most " <<
+			CLUSTERS.m_maxLightsPerCluster << " per cluster, " << CLUSTERS.m_droppedAssignments << " dropped)";
+
+		report << ", draws: " << m_lastQueueStats.m_commands << " in " << m_lastQueueStats.m_drawCalls << " draw calls (" <<
+			m_lastQueueStats.m_batchedCommands << " batched with a copy, " << m_lastQueueStats.m_programSwitches <<
+			" program, " << m_lastQueueStats.m_materialSwitches << " material and " << m_lastQueueStats.m_vaoSwitches <<
+			" vao switches, sorted in " << m_lastQueueStats.m_sortSeconds * 1e6 << " us)";
+
+		const GeometryPoolStats GEOMETRY = GeometryPool::getTotalStats();
+		report << ", geometry pools: " << GEOMETRY.m_usedBytes / 1024 << "/" << GEOMETRY.m_reservedBytes / 1024 << " KB used by " <<
+			GEOMETRY.m_numAllocations << " meshes across " << GEOMETRY.m_numPages << " pages (" << GEOMETRY.m_freeRanges <<
+			" free ranges, fragmentation " << GEOMETRY.m_vertexFragmentation * 100.0f << "% of vertices and " <<
+			GEOMETRY.m_indexFragmentation * 100.0f << "% of indices)";
+
+		report << ", GL state changes: " << TIMINGS.m_stateChanges.m_issued << " issued, " << TIMINGS.m_stateChanges.m_skipped <<
+			" skipped as redundant";
+
+		OutputLog(report.str(), Logging::Severity::NOTIFICATION);
+		m_reportSeconds = 0.0;
+		m_reportFrames = 0;
+
+		prevTime = CURRENT_TIME;
+	}
+
+	m_reportSeconds += DELTA_TIME;
+	m_reportFrames++;
+
+	m_window->pollEvents();
 
 	m_camera.updateMovement(DELTA_TIME);
+
+	// Stop the camera from flying through the asteroids
+	glm::vec3 cameraPosition = m_camera.getPosition();
+	const std::shared_ptr<OrbitalSimulation> ASTEROID_FIELD = m_simulation->getAsteroidField();
+	if (ASTEROID_FIELD->getCollisions()->resolveSphere(cameraPosition, CAMERA_COLLISION_RADIUS,
+		ASTEROID_FIELD->getBodies()))
+		m_camera.setPosition(cameraPosition);
+
 	m_camera.updateView();
 
 	// Update necessary camera properties
@@ -172,25 +432,170 @@ void ApplicationCore::updateTick(const float& DELTA_TIME)
 	m_flashlight.m_direction = m_camera.getFrontDir();
 }
 
-void ApplicationCore::render() const
+void ApplicationCore::interpolateState(float alpha, FramePacket& packet)
+{
+	m_simulation->getAsteroidField()->buildInstances(m_asteroidInstances, alpha);
+
+	// Only the asteroids in view get uploaded and drawn, each at a level of detail fitting its size on screen
+	const uint32_t NUM_INSTANCES = static_cast<uint32_t>(m_asteroidInstances.size());
+	m_asteroidCuller.setFrustum(m_camera.getProjectionMatrix() * m_camera.getViewMatrix());
+	m_numVisibleAsteroids = m_asteroidCuller.cullInstances(m_asteroidInstances.data(), NUM_INSTANCES,
+		ASTEROID_BOUNDING_RADIUS, nullptr, m_visibleAsteroidIndices.data());
+
+	// Then the ones hidden behind the planet, drawn as the largest sphere that fits inside its mesh
+	if (m_occlusionEnabled)
+	{
+		m_occlusionCuller.beginFrame(m_camera.getViewMatrix(), m_camera.getProjectionMatrix());
+		m_occlusionCuller.addSphereOccluder(m_planet->getPosition(), m_planet->getInnerRadius() * PLANET_SCALE);
+		m_occlusionCuller.rasterizeOccluders();
+
+		m_numVisibleAsteroids = m_occlusionCuller.cullIndices(m_asteroidInstances.data(),
+			m_visibleAsteroidIndices.data(), m_numVisibleAsteroids, ASTEROID_BOUNDING_RADIUS);
+	}
+
+	// The binned instances go into the packet, the render thread copies them into its part of the streaming buffer
+	const float PIXELS_PER_UNIT = m_camera.getProjectionMatrix()[1][1] * 0.5f * m_window->getHeight();
+	packet.m_numAsteroids = m_asteroidLODs->selectLevels(m_asteroidInstances.data(), NUM_INSTANCES,
+		m_visibleAsteroidIndices.data(), m_numVisibleAsteroids, m_camera.getPosition(), PIXELS_PER_UNIT);
+
+	m_asteroidLODs->scatterInstances(m_asteroidInstances.data(), m_visibleAsteroidIndices.data(),
+		packet.m_asteroids.data());
+	packet.m_levelOffsets = m_asteroidLODs->getLevelOffsets();
+	packet.m_impostorFadeStart = m_impostorFadeStart;
+	packet.m_impostorFadeEnd = m_impostorFadeEnd;
+
+	// Move the beacons along with their asteroids, hovering just above them, then sort them into the light clusters
+	const uint32_t NUM_BEACONS = static_cast<uint32_t>(m_pointLights.size());
+	for (uint32_t index = 0; index < NUM_BEACONS; index++)
+	{
+		const InstanceData& CARRIER = m_asteroidInstances[index * (NUM_INSTANCES / NUM_BEACONS)];
+		m_pointLights[index].m_position = CARRIER.m_position + glm::vec3(0.0f, 2.0f * CARRIER.m_scale *
+			ASTEROID_BOUNDING_RADIUS, 0.0f);
+	}
+
+	m_lightClusterer.assignLights(m_pointLights.data(), NUM_BEACONS, m_camera.getViewMatrix(),
+		m_camera.getProjectionMatrix());
+
+	packet.m_pointLights = m_pointLights;
+	packet.m_clusterRanges = m_lightClusterer.getClusterRanges();
+	packet.m_clusterLights = m_lightClusterer.getLightIndices();
+
+	// Lastly the view everything was culled for
+	packet.m_view = m_camera.getViewMatrix();
+	packet.m_projection = m_camera.getProjectionMatrix();
+	packet.m_cameraPosition = m_camera.getPosition();
+	packet.m_flashlight = m_flashlight;
+
+	this->queueDraws(m_simulation->getPlanetSpin(alpha), packet);
+}
+
+void ApplicationCore::queueDraws(float planet_spin, FramePacket& packet)
 {
+	// The render thread only draws the planet through the commands queued here, so its transform is this thread's to set
+	m_planet->setRotation(glm::vec3(1.0, 1.0f, 0.0f), planet_spin);
+
+	// Queue the scene's draws and order them by the state they bind, batching the copies of the planet
+	RenderQueue& queue = *packet.m_renderQueue;
+	queue.setBatching(m_batchingEnabled);
+	queue.beginFrame(packet.m_view);
+	m_sceneSkybox->submit(queue, m_skyboxShader);
+	m_planet->submit(queue, m_planetShader);
+
+	// The moons spin along with the planet
+	for (const glm::vec4& PLACEMENT : m_moonPlacements)
+	{
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(PLACEMENT));
+		model = glm::scale(model, glm::vec3(PLACEMENT.w));
+		m_planet->submit(queue, m_planetShader, glm::rotate(model, glm::radians(planet_spin), m_moonSpinAxis));
+	}
+
+	// The asteroid levels and impostors are counted from where they were binned into the packet
+	const std::vector<uint32_t>& LEVEL_OFFSETS = packet.m_levelOffsets;
+	m_asteroid->submit(queue, m_asteroidShader, LEVEL_OFFSETS.data());
+	m_asteroid->submitImpostors(queue, m_impostorShader, LEVEL_OFFSETS.back() - LEVEL_OFFSETS[LEVEL_OFFSETS.size() - 2]);
+	queue.prepare();
+}
+
+void ApplicationCore::render(FramePacket& packet) const
+{
+	GLState::beginFrame();
+	m_frameBuffer->beginFrame();
+
+	// Upload the point lights and their clusters, then set the state the packet carries
+	m_pointLightBuffer->replaceData(packet.m_pointLights.data(), sizeof(PointLight) * packet.m_pointLights.size());
+	m_clusterRangeBuffer->replaceData(packet.m_clusterRanges.data(), sizeof(uint32_t) * packet.m_clusterRanges.size());
+	m_clusterLightBuffer->replaceData(packet.m_clusterLights.data(), sizeof(uint16_t) * packet.m_clusterLights.size());
+
+	// The cached uniforms only reach the driver when the impostors got toggled
+	m_asteroidShader->bindProgram();
+	m_asteroidShader->setUniform(m_asteroidFadeUniforms[0], packet.m_impostorFadeStart);
+	m_asteroidShader->setUniform(m_asteroidFadeUniforms[1], packet.m_impostorFadeEnd);
+	m_impostorShader->bindProgram();
+	m_impostorShader->setUniform(m_impostorFadeUniforms[0], packet.m_impostorFadeStart);
+	m_impostorShader->setUniform(m_impostorFadeUniforms[1], packet.m_impostorFadeEnd);
+
 	///////////////////// RENDER THE SCENE /////////////////////
 	m_multisampleFBO->bindBuffer();
 
 	m_window->setDepthTestState(true);
 	m_window->clearScreen(glm::vec3(0.2f, 0.2f, 0.2f));
 
-	// Update the contents of the matrices UBO
-	m_matricesUBO->modifyData(&m_camera.getViewMatrix()[0][0], 0, sizeof(glm::mat4));
-	m_matricesUBO->modifyData(&m_camera.getProjectionMatrix()[0][0], sizeof(glm::mat4), sizeof(glm::mat4));
+	// Write the matrices uniform block for this frame
+	const StreamAllocation MATRICES = m_frameBuffer->allocate(2 * sizeof(glm::mat4),
+		m_frameBuffer->getUniformAlignment());
+	if (MATRICES.m_data)
+	{
+		std::memcpy(MATRICES.m_data, &packet.m_view[0][0], sizeof(glm::mat4));
+		std::memcpy(static_cast<glm::mat4*>(MATRICES.m_data) + 1, &packet.m_projection[0][0], sizeof(glm::mat4));
+	}
 
-	// Update rotation of the planet
-	m_planet->setRotation(glm::vec3(1.0, 1.0f, 0.0f), static_cast<float>(glfwGetTime() * 1.5f));
+	// Then the lights every lit shader reads, once for all of them
+	const StreamAllocation LIGHTS = m_frameBuffer->allocate(sizeof(LightsBlock), m_frameBuffer->getUniformAlignment());
+	if (LIGHTS.m_data)
+	{
+		const LightsBlock BLOCK(m_sunlight, packet.m_flashlight, packet.m_cameraPosition, m_clusterParams);
+		std::memcpy(LIGHTS.m_data, &BLOCK, sizeof(LightsBlock));
+	}
+
+	// And the asteroids in view, grouped by level of detail
+	const StreamAllocation ASTEROIDS = m_frameBuffer->allocate(sizeof(InstanceData) * packet.m_numAsteroids);
+	if (ASTEROIDS.m_data)
+		std::memcpy(ASTEROIDS.m_data, packet.m_asteroids.data(), sizeof(InstanceData) * packet.m_numAsteroids);
+
+	// Point the asteroids in view at where they were binned, the impostors right after the last level
+	const std::vector<uint32_t>& LEVEL_OFFSETS = packet.m_levelOffsets;
+	const uint32_t FIRST_IMPOSTOR = LEVEL_OFFSETS[LEVEL_OFFSETS.size() - 2];
+	const uint32_t NUM_IMPOSTORS = LEVEL_OFFSETS.back() - FIRST_IMPOSTOR;
+
+	if (ASTEROIDS.m_data)
+	{
+		m_asteroid->setLODInstanceSource(m_frameBuffer->getID(), ASTEROIDS.m_offset, LEVEL_OFFSETS.data());
+		m_asteroid->setImpostorInstanceSource(m_frameBuffer->getID(), ASTEROIDS.m_offset +
+			static_cast<GLintptr>(sizeof(InstanceData)) * FIRST_IMPOSTOR, NUM_IMPOSTORS);
+	}
+	else
+	{
+		m_asteroid->updateLODInstances(packet.m_asteroids.data(), LEVEL_OFFSETS.data());
+		m_asteroid->updateImpostorInstances(packet.m_asteroids.data() + FIRST_IMPOSTOR, NUM_IMPOSTORS);
+	}
+
+	// Then the model matrices of the batches the packet's draws were merged into, in the order the batches draw them
+	RenderQueue& queue = *packet.m_renderQueue;
+	const std::vector<glm::mat4>& BATCH_TRANSFORMS = queue.getBatchTransforms();
+	const StreamAllocation TRANSFORMS = m_frameBuffer->allocate(sizeof(glm::mat4) * BATCH_TRANSFORMS.size());
+	if (TRANSFORMS.m_data)
+		std::memcpy(TRANSFORMS.m_data, BATCH_TRANSFORMS.data(), sizeof(glm::mat4) * BATCH_TRANSFORMS.size());
 
-	// Render the scene
-	m_sceneSkybox->render(m_skyboxShader);
-	m_planet->render(m_planetShader, m_camera, &m_flashlight);
-	m_asteroid->render(m_asteroidShader, m_camera, &m_flashlight);
+	m_frameBuffer->finishWrites();
+	m_frameBuffer->bindUniformRange(MATRICES_BLOCK_BINDING, MATRICES);
+	m_frameBuffer->bindUniformRange(LIGHTS_BLOCK_BINDING, LIGHTS);
+
+	m_pointLightBuffer->bindTexture(POINT_LIGHTS_TEXTURE_UNIT);
+	m_clusterRangeBuffer->bindTexture(CLUSTER_RANGES_TEXTURE_UNIT);
+	m_clusterLightBuffer->bindTexture(CLUSTER_LIGHTS_TEXTURE_UNIT);
+
+	// Render the scene, in whatever order binds the least state
+	queue.execute(TRANSFORMS.m_data ? m_frameBuffer->getID() : 0, TRANSFORMS.m_offset);
 
 	///////////////////// RENDER THE QUAD FOR THE SCENE TO BE DISPLAYED ON /////////////////////
 	m_multisampleFBO->unbindBuffer();
@@ -199,11 +604,15 @@ void ApplicationCore::render() const
 	m_window->clearScreen(glm::vec3(0.0f));
 
 	m_multisamplingShader->bindProgram();
-	m_multisamplingShader->setUniform("numSamples", 4);
-	m_multisamplingShader->setUniform("colorAttachment0", 0);
+	m_multisamplingShader->setUniform(m_numSamplesUniform, 4);
+	m_multisamplingShader->setUniform(m_colorAttachmentUniform, 0);
 
 	m_multisampleFBO->bindColorAttachment(0);
 	m_quadVAO->bind();
 
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	// Every draw reading this frame's streamed data has been issued
+	m_frameBuffer->endFrame();
+	GLState::validate();
 }
\ No newline at end of file
@@ -5,36 +5,105 @@
 #include "Engine/Graphics/SceneSkybox.h"
 #include "Engine/Graphics/SceneModel.h"
 #include "Engine/Graphics/SceneLighting.h"
+#include "Engine/Graphics/FrustumCuller.h"
+#include "Engine/Graphics/LODSelector.h"
+#include "Engine/Graphics/LightClusterer.h"
+#include "Engine/Graphics/OcclusionCuller.h"
+#include "Engine/Graphics/RenderThread.h"
+#include "Engine/Graphics/RenderQueue.h"
+#include "Engine/Buffers/StreamingBuffer.h"
+#include "Core/SimulationCore.h"
 
 #include <memory>
 
+// Everything the render thread needs to draw a frame, prepared while it is still drawing the frame before
+struct FramePacket
+{
+	glm::mat4 m_view, m_projection;
+	glm::vec3 m_cameraPosition;
+	SpotLight m_flashlight;
+	float m_impostorFadeStart = 0.0f, m_impostorFadeEnd = 0.0f;
+
+	std::vector<InstanceData> m_asteroids; // Visible asteroids grouped by level of detail, the impostors after the last level
+	std::vector<uint32_t> m_levelOffsets; // Where each level (then the impostors) starts in the asteroids
+	uint32_t m_numAsteroids = 0;
+
+	std::vector<PointLight> m_pointLights;
+	std::vector<uint32_t> m_clusterRanges; // The light clusters, as assigned for the packet's view
+	std::vector<uint16_t> m_clusterLights;
+
+	// The scene's draws, already sorted and batched, so the render thread only uploads the batch transforms and executes
+	// them. Its stats get the switches filled in once the packet was drawn
+	std::shared_ptr<RenderQueue> m_renderQueue;
+};
+
 class ApplicationCore
 {
 private:
 	const std::shared_ptr<WindowFrame> m_window;
+	const std::shared_ptr<SimulationCore> m_simulation;
 	
 	std::shared_ptr<FrameBuffer> m_multisampleFBO;
 	std::shared_ptr<VertexArray> m_quadVAO;
 
 	std::shared_ptr<ShaderProgram> m_planetShader;
 	std::shared_ptr<ShaderProgram> m_asteroidShader;
+	std::shared_ptr<ShaderProgram> m_impostorShader;
+	std::shared_ptr<ShaderProgram> m_impostorBakeShader;
 	std::shared_ptr<ShaderProgram> m_skyboxShader;
 	std::shared_ptr<ShaderProgram> m_multisamplingShader;
+	UniformHandle m_numSamplesUniform, m_colorAttachmentUniform;
+	UniformHandle m_asteroidFadeUniforms[2], m_impostorFadeUniforms[2]; // Start and end of the impostor fade band
 
-	std::shared_ptr<UniformBuffer> m_matricesUBO;
+	std::shared_ptr<StreamingBuffer> m_frameBuffer; // Per-frame data: the matrices uniform block and the asteroid instances
 
 	std::shared_ptr<Skybox> m_sceneSkybox;
 	std::shared_ptr<SceneModel> m_planet;
 	std::shared_ptr<SceneModel> m_asteroid;
 
+	std::vector<glm::vec4> m_moonPlacements; // Position and scale of each moon, drawn as small copies of the planet
+	glm::vec3 m_moonSpinAxis;
+	bool m_batchingEnabled; // Whether the render queue merges copies of a mesh into single draws
+
+	std::vector<InstanceData> m_asteroidInstances;
+	std::vector<uint32_t> m_visibleAsteroidIndices; // Instances that passed the frustum cull, packed at the front
+	uint32_t m_numVisibleAsteroids;
+	FrustumCuller m_asteroidCuller;
+	OcclusionCuller m_occlusionCuller; // Drops the asteroids in view hidden behind the planet
+	bool m_occlusionEnabled;
+	std::shared_ptr<LODSelector> m_asteroidLODs;
+	bool m_impostorsEnabled; // Whether distant asteroids get drawn as impostors
+	float m_impostorFadeStart, m_impostorFadeEnd;
+
+	DirectionalLight m_sunlight;
 	SpotLight m_flashlight;
 	SceneCamera m_camera;
+
+	std::vector<PointLight> m_pointLights; // Beacons riding on some of the asteroids, shaded through the light clusters
+	uint32_t m_beaconSetting; // Which of the beacon counts is in use
+	LightClusterer m_lightClusterer;
+	ClusterGridParams m_clusterParams;
+	std::shared_ptr<TextureBuffer> m_pointLightBuffer, m_clusterRangeBuffer, m_clusterLightBuffer;
+
+	double m_reportSeconds; // Frame time summed since the last statistics report
+	uint32_t m_reportFrames;
+
+	std::vector<FramePacket> m_framePackets;
+	RenderQueueStats m_lastQueueStats; // Of the last packet the render thread drew
+	std::shared_ptr<RenderThread> m_renderThread; // Owns the context while the main loop runs, drawing the packets
 private:
 	void initResources(); // Initializes the resources needed for the application
+	void setupBeacons(uint32_t num_beacons); // Gives the given number of asteroids a colored point light
+	void applyImpostorRange(); // Sets the distances the asteroids fade into impostors across, or turns them off
 	void mainLoop(); // Contains the main loop of the application
 
 	void updateTick(const float& DELTA_TIME); // Updates the application logic per loop/tick
-	void render() const; // Renders objects to the scene
+
+	// interpolateState() : Blends the previous and current simulation ticks into the state that gets rendered, then
+	// culls and bins it into the frame packet and queues its draws
+	void interpolateState(float alpha, FramePacket& packet);
+	void queueDraws(float planet_spin, FramePacket& packet); // Fills the packet's render queue with the scene's draws, sorted and batched
+	void render(FramePacket& packet) const; // Renders the frame packet to the scene (render thread only)
 public:
 	ApplicationCore();
 	~ApplicationCore();
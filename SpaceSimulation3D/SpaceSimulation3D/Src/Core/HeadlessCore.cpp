@@ -0,0 +1,118 @@
+#include "HeadlessCore.h"
+#include "Engine/Utils/LoggingManager.h"
+#include "Engine/Utils/RandomGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double getElapsedSeconds(const Clock::time_point& start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+}
+
+HeadlessCore::HeadlessCore(const HeadlessSettings& settings) :
+	m_settings(settings), m_simulation(std::make_shared<SimulationCore>(settings.m_numAsteroids,
+		settings.m_seed != 0 ? settings.m_seed : Random::generateSeed(), settings.m_numThreads)),
+	m_totalPairsTested(0), m_totalContacts(0), m_wallSeconds(0.0)
+{
+	m_simulation->setMutualGravity(m_settings.m_mutualGravity);
+
+	const uint32_t NUM_TICKS = m_settings.m_simulatedSeconds > 0.0 ?
+		static_cast<uint32_t>(std::ceil(m_settings.m_simulatedSeconds * SIMULATION_RATE)) : m_settings.m_numTicks;
+
+	const std::shared_ptr<OrbitalSimulation> ASTEROID_FIELD = m_simulation->getAsteroidField();
+	const double INITIAL_ENERGY = ASTEROID_FIELD->computeEnergy();
+	const glm::vec3 INITIAL_MOMENTUM = ASTEROID_FIELD->computeAngularMomentum();
+
+	this->runTicks(NUM_TICKS);
+	this->reportStatistics(INITIAL_ENERGY, INITIAL_MOMENTUM);
+}
+
+HeadlessCore::~HeadlessCore() {}
+
+void HeadlessCore::runTicks(uint32_t num_ticks)
+{
+	const std::shared_ptr<CollisionSystem> COLLISIONS = m_simulation->getAsteroidField()->getCollisions();
+	m_tickSeconds.resize(num_ticks);
+
+	const Clock::time_point RUN_START = Clock::now();
+	for (uint32_t tick = 0; tick < num_ticks; tick++)
+	{
+		const Clock::time_point TICK_START = Clock::now();
+		m_simulation->simulateTick(static_cast<float>(FIXED_TIME_STEP));
+		m_tickSeconds[tick] = getElapsedSeconds(TICK_START);
+
+		if (COLLISIONS)
+		{
+			m_totalPairsTested += COLLISIONS->getStats().m_pairsTested;
+			m_totalContacts += COLLISIONS->getStats().m_contacts;
+		}
+	}
+
+	m_wallSeconds = getElapsedSeconds(RUN_START);
+}
+
+void HeadlessCore::reportStatistics(double initial_energy, const glm::vec3& initial_momentum) const
+{
+	const std::shared_ptr<OrbitalSimulation> ASTEROID_FIELD = m_simulation->getAsteroidField();
+	const uint32_t NUM_TICKS = static_cast<uint32_t>(m_tickSeconds.size());
+	const double SIMULATED_SECONDS = NUM_TICKS * FIXED_TIME_STEP;
+
+	std::stringstream report;
+	report << "Headless run: " << ASTEROID_FIELD->getBodies().getCount() << " bodies, " <<
+		m_simulation->getJobSystem()->getThreadCount() << " threads, " << ASTEROID_FIELD->getIntegrator().getName() <<
+		", mutual gravity " << (ASTEROID_FIELD->getMutualGravity() ? "on" : "off");
+	OutputLog(report.str(), Logging::Severity::NOTIFICATION);
+
+	if (NUM_TICKS == 0)
+		return;
+
+	// Tick time distribution, the p99 being what decides whether the rate holds up in a windowed run
+	std::vector<double> sortedSeconds = m_tickSeconds;
+	std::sort(sortedSeconds.begin(), sortedSeconds.end());
+
+	double sumSeconds = 0.0;
+	for (double seconds : sortedSeconds)
+		sumSeconds += seconds;
+
+	const uint32_t P99_INDEX = std::min(NUM_TICKS - 1, static_cast<uint32_t>(std::ceil(0.99 * NUM_TICKS)) - 1);
+
+	report.str("");
+	report << "Ticks: " << NUM_TICKS << " (" << SIMULATED_SECONDS << " s simulated) in " << m_wallSeconds <<
+		" s wall, " << NUM_TICKS / m_wallSeconds << " ticks/s, " << SIMULATED_SECONDS / m_wallSeconds <<
+		"x real time";
+	OutputLog(report.str(), Logging::Severity::NOTIFICATION);
+
+	report.str("");
+	report << "Tick ms: min " << sortedSeconds.front() * 1e3 << ", mean " << sumSeconds / NUM_TICKS * 1e3 <<
+		", p99 " << sortedSeconds[P99_INDEX] * 1e3 << ", max " << sortedSeconds.back() * 1e3 << " (budget " <<
+		FIXED_TIME_STEP * 1e3 << ")";
+	OutputLog(report.str(), Logging::Severity::NOTIFICATION);
+
+	// Conservation of the central field quantities, which mutual gravity and collisions are expected to disturb
+	const double FINAL_ENERGY = ASTEROID_FIELD->computeEnergy();
+	const glm::vec3 FINAL_MOMENTUM = ASTEROID_FIELD->computeAngularMomentum();
+
+	report.str("");
+	report << "Energy: " << initial_energy << " -> " << FINAL_ENERGY << " (relative drift " <<
+		std::abs((FINAL_ENERGY - initial_energy) / initial_energy) << "), angular momentum drift " <<
+		glm::length(FINAL_MOMENTUM - initial_momentum) / glm::length(initial_momentum);
+	OutputLog(report.str(), Logging::Severity::NOTIFICATION);
+
+	if (ASTEROID_FIELD->getCollisions())
+	{
+		const CollisionStats& STATS = ASTEROID_FIELD->getCollisions()->getStats();
+
+		report.str("");
+		report << "Collisions: " << m_totalContacts << " contacts from " << m_totalPairsTested <<
+			" pair tests, last tick " << STATS.m_contacts << " contacts in " << STATS.m_occupiedCells << " cells";
+		OutputLog(report.str(), Logging::Severity::NOTIFICATION);
+	}
+}
\ No newline at end of file
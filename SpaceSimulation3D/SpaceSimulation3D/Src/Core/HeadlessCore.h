@@ -0,0 +1,35 @@
+#pragma once
+#include "Core/SimulationCore.h"
+
+#include <vector>
+#include <memory>
+
+struct HeadlessSettings
+{
+	uint32_t m_numTicks = 1200; // Ignored if a simulated duration is given
+	double m_simulatedSeconds = 0.0;
+
+	uint32_t m_numAsteroids = 10000;
+	uint64_t m_seed = 0; // 0 = random seed
+	uint32_t m_numThreads = 0; // 0 = one per core
+	bool m_mutualGravity = true;
+};
+
+// Runs the simulation for a fixed amount of ticks without creating a window or touching GLFW/OpenGL, then reports
+// the tick timings and how well the simulated state was conserved
+class HeadlessCore
+{
+private:
+	const HeadlessSettings m_settings;
+	const std::shared_ptr<SimulationCore> m_simulation;
+
+	std::vector<double> m_tickSeconds; // Wall time spent on each tick
+	uint64_t m_totalPairsTested, m_totalContacts;
+	double m_wallSeconds;
+private:
+	void runTicks(uint32_t num_ticks); // Steps the simulation as fast as possible, timing every tick
+	void reportStatistics(double initial_energy, const glm::vec3& initial_momentum) const; // Outputs the run statistics to the log
+public:
+	HeadlessCore(const HeadlessSettings& settings);
+	~HeadlessCore();
+};
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "SimulationCore.h"
+
+namespace
+{
+	const glm::vec3 PLANET_POSITION = { -20.0f, 0.0f, 10.0f };
+	constexpr float PLANET_SPIN_RATE = 1.5f; // Degrees per second
+
+	constexpr float ASTEROID_BELT_RADIUS = 14.0f;
+	constexpr float ASTEROID_BELT_GM = 7.5f; // Gives the belt an orbital period of roughly two minutes
+	constexpr float ASTEROID_MUTUAL_G = 0.05f;
+	constexpr float BARNES_HUT_THETA = 0.7f;
+	constexpr float ASTEROID_RESTITUTION = 0.4f;
+}
+
+SimulationCore::SimulationCore(uint32_t num_asteroids, uint64_t seed, uint32_t num_threads) :
+	m_jobSystem(std::make_shared<JobSystem>(num_threads)), m_planetSpin(0.0f), m_previousPlanetSpin(0.0f)
+{
+	// Setup the asteroid belt simulation orbiting around the planet
+	m_asteroidField = std::make_shared<OrbitalSimulation>(PLANET_POSITION, ASTEROID_BELT_GM);
+	m_asteroidField->setJobSystem(m_jobSystem);
+	m_asteroidField->generateAsteroidBelt(num_asteroids, ASTEROID_BELT_RADIUS, seed);
+	m_asteroidField->setCollisions(std::make_shared<CollisionSystem>(ASTEROID_BOUNDING_RADIUS, ASTEROID_RESTITUTION,
+		m_jobSystem));
+
+	this->setMutualGravity(true);
+}
+
+SimulationCore::~SimulationCore() {}
+
+void SimulationCore::simulateTick(float delta_time)
+{
+	m_previousPlanetSpin = m_planetSpin;
+	m_planetSpin += PLANET_SPIN_RATE * delta_time;
+
+	m_asteroidField->stepTick(delta_time);
+}
+
+void SimulationCore::setMutualGravity(bool enabled)
+{
+	if (enabled)
+		m_asteroidField->setMutualGravity(std::make_shared<BarnesHutSolver>(BARNES_HUT_THETA, ASTEROID_MUTUAL_G, 0.05f,
+			m_jobSystem));
+	else
+		m_asteroidField->setMutualGravity(nullptr);
+}
+
+std::shared_ptr<JobSystem> SimulationCore::getJobSystem() const
+{
+	return m_jobSystem;
+}
+
+std::shared_ptr<OrbitalSimulation> SimulationCore::getAsteroidField() const
+{
+	return m_asteroidField;
+}
+
+const glm::vec3& SimulationCore::getPlanetPosition() const
+{
+	return PLANET_POSITION;
+}
+
+float SimulationCore::getPlanetSpin(float alpha) const
+{
+	return glm::mix(m_previousPlanetSpin, m_planetSpin, alpha);
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include "Engine/Simulation/OrbitalSimulation.h"
+#include "Engine/Utils/JobSystem.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+
+constexpr double SIMULATION_RATE = 120.0; // Simulation ticks per second, independent of the frame rate
+constexpr double FIXED_TIME_STEP = 1.0 / SIMULATION_RATE;
+constexpr float ASTEROID_BOUNDING_RADIUS = 1.0f; // Bounding radius of the asteroid model at a scale of 1
+
+// The simulated world without anything graphical, so it can be stepped with or without a window and GL context
+class SimulationCore
+{
+private:
+	const std::shared_ptr<JobSystem> m_jobSystem;
+	std::shared_ptr<OrbitalSimulation> m_asteroidField;
+
+	float m_planetSpin, m_previousPlanetSpin;
+public:
+	SimulationCore(uint32_t num_asteroids, uint64_t seed, uint32_t num_threads = 0); // 0 threads = one per core
+	~SimulationCore();
+
+	void simulateTick(float delta_time); // Advances the simulation by one fixed time step
+	void setMutualGravity(bool enabled); // Switches the attraction between the asteroids on or off
+public:
+	std::shared_ptr<JobSystem> getJobSystem() const; // Returns the job system the simulation is split across
+	std::shared_ptr<OrbitalSimulation> getAsteroidField() const; // Returns the simulation of the asteroid belt
+
+	const glm::vec3& getPlanetPosition() const; // Returns the position of the planet the asteroids orbit around
+	float getPlanetSpin(float alpha) const; // Returns the planet's spin angle blended between the last two ticks
+};
\ No newline at end of file
@@ -1,37 +1,38 @@
 #include "BufferObjects.h"
 #include "Engine/Utils/LoggingManager.h"
+#include "Engine/Utils/GLStateCache.h"
+
+#include <algorithm>
 
 ////////////////////////////////////////////////////////////////////////////////////
 
 VertexBuffer::VertexBuffer(const void* data, GLsizeiptr size, GLenum usage)
 {
 	glGenBuffers(1, &m_ID);
-	glBindBuffer(GL_ARRAY_BUFFER, m_ID);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_ID);
 	glBufferData(GL_ARRAY_BUFFER, size, data, usage);
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 VertexBuffer::~VertexBuffer()
 {
 	glDeleteBuffers(1, &m_ID);
+	GLState::onBufferDeleted(m_ID);
 }
 
 void VertexBuffer::modifyData(const void* data, GLintptr offset, GLsizeiptr size) const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, m_ID);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_ID);
 	glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void VertexBuffer::bindBuffer() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, m_ID);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_ID);
 }
 
 void VertexBuffer::unbindBuffer() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 const uint32_t& VertexBuffer::getID() const
@@ -44,32 +45,33 @@ const uint32_t& VertexBuffer::getID() const
 IndexBuffer::IndexBuffer(const void* data, GLsizeiptr size, GLenum usage)
 {
 	glGenBuffers(1, &m_ID);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
+	// The ibo binding belongs to the bound vao, so keep it out of whichever one was left bound
+	GLState::bindVertexArray(0);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, usage);
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 IndexBuffer::~IndexBuffer()
 {
 	glDeleteBuffers(1, &m_ID);
+	GLState::onBufferDeleted(m_ID);
 }
 
 void IndexBuffer::modifyData(const void* data, GLintptr offset, GLsizeiptr size) const
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
+	GLState::bindVertexArray(0);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
 	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, size, data);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 void IndexBuffer::bindBuffer() const
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
 }
 
 void IndexBuffer::unbindBuffer() const
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 const uint32_t& IndexBuffer::getID() const
@@ -82,39 +84,35 @@ const uint32_t& IndexBuffer::getID() const
 UniformBuffer::UniformBuffer(const void* data, GLsizeiptr size, GLenum usage)
 {
 	glGenBuffers(1, &m_ID);
-	glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, m_ID);
 	glBufferData(GL_UNIFORM_BUFFER, size, data, usage);
-
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
 UniformBuffer::~UniformBuffer()
 {
 	glDeleteBuffers(1, &m_ID);
+	GLState::onBufferDeleted(m_ID);
 }
 
 void UniformBuffer::setBindingPoint(uint32_t unit, GLintptr offset, GLsizeiptr size) const
 {
-	glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
-	glBindBufferRange(GL_UNIFORM_BUFFER, unit, m_ID, offset, size);
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	GLState::bindBufferRange(GL_UNIFORM_BUFFER, unit, m_ID, offset, size);
 }
 
 void UniformBuffer::modifyData(const void* data, GLintptr offset, GLsizeiptr size) const
 {
-	glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, m_ID);
 	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
 void UniformBuffer::bindBuffer() const
 {
-	glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, m_ID);
 }
 
 void UniformBuffer::unbindBuffer() const
 {
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
 const uint32_t& UniformBuffer::getID() const
@@ -124,8 +122,58 @@ const uint32_t& UniformBuffer::getID() const
 
 ////////////////////////////////////////////////////////////////////////////////////
 
+TextureBuffer::TextureBuffer(GLenum format, GLsizeiptr size) :
+	m_format(format), m_size(size)
+{
+	glGenBuffers(1, &m_ID);
+	GLState::bindBuffer(GL_TEXTURE_BUFFER, m_ID);
+	glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+	glGenTextures(1, &m_textureID);
+	GLState::bindTexture(0, GL_TEXTURE_BUFFER, m_textureID);
+	glTexBuffer(GL_TEXTURE_BUFFER, m_format, m_ID);
+}
+
+TextureBuffer::~TextureBuffer()
+{
+	glDeleteTextures(1, &m_textureID);
+	glDeleteBuffers(1, &m_ID);
+
+	GLState::onTextureDeleted(m_textureID);
+	GLState::onBufferDeleted(m_ID);
+}
+
+void TextureBuffer::replaceData(const void* data, GLsizeiptr size)
+{
+	// Respecifying the storage lets the driver hand out fresh memory while the GPU still reads last frame's contents.
+	// The texture keeps pointing at the buffer object, so it sees the new storage without being attached again
+	m_size = std::max(m_size, size);
+
+	GLState::bindBuffer(GL_TEXTURE_BUFFER, m_ID);
+	glBufferData(GL_TEXTURE_BUFFER, m_size, nullptr, GL_STREAM_DRAW);
+	if (size > 0)
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+}
+
+void TextureBuffer::bindTexture(uint32_t unit) const
+{
+	GLState::bindTexture(unit, GL_TEXTURE_BUFFER, m_textureID);
+}
+
+const uint32_t& TextureBuffer::getID() const
+{
+	return m_ID;
+}
+
+GLsizeiptr TextureBuffer::getSize() const
+{
+	return m_size;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+
 FrameBuffer::FrameBuffer() :
-	m_colorAttachment(0), m_depthStencilRBO(0), m_textureTarget(0xFF)
+	m_depthStencilRBO(0), m_textureTarget(0xFF), m_checkedComplete(false)
 {
 	glGenFramebuffers(1, &m_ID);
 }
@@ -133,58 +181,104 @@ FrameBuffer::FrameBuffer() :
 FrameBuffer::~FrameBuffer()
 {
 	glDeleteFramebuffers(1, &m_ID);
-	glDeleteTextures(1, &m_colorAttachment);
 	glDeleteRenderbuffers(1, &m_depthStencilRBO);
+	GLState::onFramebufferDeleted(m_ID);
+
+	for (uint32_t colorAttachment : m_colorAttachments)
+	{
+		glDeleteTextures(1, &colorAttachment);
+		GLState::onTextureDeleted(colorAttachment);
+	}
 }
 
-void FrameBuffer::attachColorBuffer(GLenum target, int width, int height)
+void FrameBuffer::attachColorBuffer(GLenum target, int width, int height, GLenum internal_format)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
-	glGenTextures(1, &m_colorAttachment);
-	glBindTexture(target, m_colorAttachment);
+	GLState::bindFramebuffer(m_ID);
+
+	uint32_t colorAttachment = 0;
+	glGenTextures(1, &colorAttachment);
+	GLState::bindTexture(0, target, colorAttachment);
 
 	if(target == GL_TEXTURE_2D_MULTISAMPLE)
-		glTexImage2DMultisample(target, 4, GL_RGB, width, height, GL_TRUE);
+		glTexImage2DMultisample(target, 4, internal_format, width, height, GL_TRUE);
 	else
-		glTexImage2D(target, 0, GL_RGB, 1600, 900, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-	
-	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_colorAttachment, 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glBindTexture(target, 0);
+	{
+		// Without mipmaps the default filter would leave the texture incomplete to sample from
+		glTexImage2D(target, 0, internal_format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	const GLenum ATTACHMENT = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(m_colorAttachments.size());
+	glFramebufferTexture(GL_FRAMEBUFFER, ATTACHMENT, colorAttachment, 0);
+	m_colorAttachments.emplace_back(colorAttachment);
+
+	// Every attached color buffer gets drawn to, the Nth by fragment shader output N
+	std::vector<GLenum> drawBuffers;
+	for (uint32_t index = 0; index < m_colorAttachments.size(); index++)
+		drawBuffers.emplace_back(GL_COLOR_ATTACHMENT0 + index);
+
+	glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
 
 	m_textureTarget = target;
+	m_checkedComplete = false;
 }
 
-void FrameBuffer::attachDepthStencilRBO(int width, int height)
+void FrameBuffer::attachDepthStencilRBO(int width, int height, int samples)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+	GLState::bindFramebuffer(m_ID);
 	glGenRenderbuffers(1, &m_depthStencilRBO);
 	glBindRenderbuffer(GL_RENDERBUFFER, m_depthStencilRBO);
 
-	glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH24_STENCIL8, width, height);
+	if (samples > 0)
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+	else
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthStencilRBO);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	m_checkedComplete = false;
 }
 
-void FrameBuffer::bindColorAttachment(int unit) const
+void FrameBuffer::generateMipmaps(int max_level) const
 {
-	glActiveTexture(GL_TEXTURE0 + unit);
-	glBindTexture(m_textureTarget, m_colorAttachment);
+	if (m_textureTarget != GL_TEXTURE_2D)
+		return;
+
+	for (uint32_t colorAttachment : m_colorAttachments)
+	{
+		GLState::bindTexture(0, GL_TEXTURE_2D, colorAttachment);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_level);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	}
+}
+
+void FrameBuffer::bindColorAttachment(int unit, uint32_t index) const
+{
+	GLState::bindTexture(unit, m_textureTarget, index < m_colorAttachments.size() ? m_colorAttachments[index] : 0);
 }
 
 void FrameBuffer::bindBuffer() const
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+	GLState::bindFramebuffer(m_ID);
+
+	// The attachments only change through this class, so completeness needs checking once after they do
+	if (!m_checkedComplete)
+	{
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			OutputLog("The framebuffer trying to be bound is not complete!", Logging::Severity::FATAL);
 
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		OutputLog("The framebuffer trying to be bound is not complete!", Logging::Severity::FATAL);
+		m_checkedComplete = true;
+	}
 }
 
 void FrameBuffer::unbindBuffer() const
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
 }
 
 const uint32_t& FrameBuffer::getID() const
@@ -53,19 +53,43 @@ public:
 	const uint32_t& getID() const; // Returns the ID of the ubo
 };
 
+// Buffer read by shaders as a samplerBuffer, for arrays too large for a uniform block (GL 3.3 has no storage buffers)
+class TextureBuffer
+{
+private:
+	uint32_t m_ID, m_textureID;
+	GLenum m_format;
+	GLsizeiptr m_size;
+public:
+	TextureBuffer(GLenum format, GLsizeiptr size); // The format is the sized internal format each texel is read as
+	~TextureBuffer();
+
+	void replaceData(const void* data, GLsizeiptr size); // Replaces the whole contents, orphaning the old storage
+
+	void bindTexture(uint32_t unit) const; // Binds the buffer texture to the texture unit
+public:
+	const uint32_t& getID() const; // Returns the ID of the buffer
+	GLsizeiptr getSize() const; // Returns the size of the buffer storage in bytes
+};
+
 class FrameBuffer
 {
 private:
-	uint32_t m_ID, m_colorAttachment, m_depthStencilRBO;
+	uint32_t m_ID, m_depthStencilRBO;
+	std::vector<uint32_t> m_colorAttachments; // Attached as GL_COLOR_ATTACHMENT0 onwards, in the order they were added
 	GLenum m_textureTarget;
+	mutable bool m_checkedComplete; // Whether the fbo was found complete since its attachments last changed
 public:
 	FrameBuffer();
 	~FrameBuffer();
 
-	void attachColorBuffer(GLenum target, int width, int height); // Attaches a color buffer to the fbo
-	void attachDepthStencilRBO(int width, int height); // Attaches a depth and stencil rbo to the fbo
+	// attachColorBuffer() : Attaches another color buffer to the fbo, which fragment shader output N gets written to
+	// for the Nth one attached. Every color buffer of the fbo has to use the same target
+	void attachColorBuffer(GLenum target, int width, int height, GLenum internal_format = GL_RGB);
+	void attachDepthStencilRBO(int width, int height, int samples = 4); // Attaches a depth and stencil rbo to the fbo (0 samples = not multisampled)
+	void generateMipmaps(int max_level) const; // Builds the mip chain of every (non multisampled) color buffer, sampled trilinearly from then on
 
-	void bindColorAttachment(int unit) const; // Binds the color buffer attached to the fbo
+	void bindColorAttachment(int unit, uint32_t index = 0) const; // Binds the color buffer attached to the fbo
 	void bindBuffer() const; // Binds the fbo
 
 	void unbindBuffer() const; // Unbinds the fbo
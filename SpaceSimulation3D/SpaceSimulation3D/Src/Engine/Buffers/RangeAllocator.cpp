@@ -0,0 +1,116 @@
+#include "RangeAllocator.h"
+
+#include <iterator>
+
+RangeAllocator::RangeAllocator(uint32_t capacity) :
+	m_capacity(capacity), m_used(0)
+{
+	if (m_capacity > 0)
+		this->insertRange(0, m_capacity);
+}
+
+RangeAllocator::~RangeAllocator() {}
+
+void RangeAllocator::insertRange(uint32_t offset, uint32_t size)
+{
+	m_rangesByOffset[offset] = size;
+	m_rangesBySize.emplace(size, offset);
+}
+
+void RangeAllocator::eraseRange(uint32_t offset, uint32_t size)
+{
+	m_rangesByOffset.erase(offset);
+
+	auto sized = m_rangesBySize.equal_range(size);
+	for (auto range = sized.first; range != sized.second; range++)
+	{
+		if (range->second == offset)
+		{
+			m_rangesBySize.erase(range);
+			break;
+		}
+	}
+}
+
+bool RangeAllocator::allocate(uint32_t size, uint32_t& offset)
+{
+	// Nothing to store takes no space
+	if (size == 0)
+	{
+		offset = 0;
+		return true;
+	}
+
+	const auto BEST_FIT = m_rangesBySize.lower_bound(size);
+	if (BEST_FIT == m_rangesBySize.end())
+		return false;
+
+	const uint32_t RANGE_OFFSET = BEST_FIT->second, RANGE_SIZE = BEST_FIT->first;
+	this->eraseRange(RANGE_OFFSET, RANGE_SIZE);
+
+	// Whatever the allocation doesn't need stays free
+	if (RANGE_SIZE > size)
+		this->insertRange(RANGE_OFFSET + size, RANGE_SIZE - size);
+
+	offset = RANGE_OFFSET;
+	m_used += size;
+	return true;
+}
+
+void RangeAllocator::release(uint32_t offset, uint32_t size)
+{
+	if (size == 0)
+		return;
+
+	m_used -= size;
+
+	// Merge with the free range right after it, then the one right before it
+	const auto NEXT = m_rangesByOffset.lower_bound(offset);
+	if (NEXT != m_rangesByOffset.end() && NEXT->first == offset + size)
+	{
+		const uint32_t NEXT_SIZE = NEXT->second;
+		this->eraseRange(offset + size, NEXT_SIZE);
+		size += NEXT_SIZE;
+	}
+
+	const auto FOLLOWING = m_rangesByOffset.lower_bound(offset);
+	if (FOLLOWING != m_rangesByOffset.begin())
+	{
+		const auto PREVIOUS = std::prev(FOLLOWING);
+		if (PREVIOUS->first + PREVIOUS->second == offset)
+		{
+			const uint32_t PREVIOUS_OFFSET = PREVIOUS->first, PREVIOUS_SIZE = PREVIOUS->second;
+			this->eraseRange(PREVIOUS_OFFSET, PREVIOUS_SIZE);
+			offset = PREVIOUS_OFFSET;
+			size += PREVIOUS_SIZE;
+		}
+	}
+
+	this->insertRange(offset, size);
+}
+
+uint32_t RangeAllocator::getCapacity() const
+{
+	return m_capacity;
+}
+
+uint32_t RangeAllocator::getUsed() const
+{
+	return m_used;
+}
+
+uint32_t RangeAllocator::getNumFreeRanges() const
+{
+	return static_cast<uint32_t>(m_rangesByOffset.size());
+}
+
+uint32_t RangeAllocator::getLargestFreeRange() const
+{
+	return m_rangesBySize.empty() ? 0 : m_rangesBySize.rbegin()->first;
+}
+
+float RangeAllocator::getFragmentation() const
+{
+	const uint32_t FREE = m_capacity - m_used;
+	return FREE == 0 ? 0.0f : 1.0f - static_cast<float>(this->getLargestFreeRange()) / FREE;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <map>
+
+// Hands out ranges of a fixed capacity (vertices, indices, bytes), keeping the free space as a list of ranges. The
+// free ranges are indexed both by where they start, to merge a released range with its neighbours, and by their size,
+// so allocating takes the smallest range that fits (best fit) in logarithmic time. Splitting off only what is asked for
+// and merging on release keeps the free space in as few ranges as it can be
+class RangeAllocator
+{
+private:
+	std::map<uint32_t, uint32_t> m_rangesByOffset; // Size of every free range, by the offset it starts at
+	std::multimap<uint32_t, uint32_t> m_rangesBySize; // Offset of every free range, by its size
+	uint32_t m_capacity, m_used;
+private:
+	void insertRange(uint32_t offset, uint32_t size); // Adds a free range to both indices
+	void eraseRange(uint32_t offset, uint32_t size); // Removes a free range from both indices
+public:
+	RangeAllocator(uint32_t capacity);
+	~RangeAllocator();
+
+	bool allocate(uint32_t size, uint32_t& offset); // Takes the smallest free range that fits, returning false if none does
+	void release(uint32_t offset, uint32_t size); // Hands an allocated range back, merging it with the free ranges either side
+public:
+	uint32_t getCapacity() const; // Returns the size of the whole space
+	uint32_t getUsed() const; // Returns the size of the space handed out
+	uint32_t getNumFreeRanges() const; // Returns how many separate ranges the free space is split into
+	uint32_t getLargestFreeRange() const; // Returns the size of the largest free range, the most a single allocation can take
+
+	// getFragmentation() : Returns how much of the free space lies outside the largest free range, from 0 (all of it in
+	// one range) towards 1 (scattered in ranges too small to use)
+	float getFragmentation() const;
+};
\ No newline at end of file
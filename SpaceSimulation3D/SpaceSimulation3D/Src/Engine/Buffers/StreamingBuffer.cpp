@@ -0,0 +1,183 @@
+#include "StreamingBuffer.h"
+#include "Engine/Utils/LoggingManager.h"
+#include "Engine/Utils/GLStateCache.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+
+// ARB_buffer_storage is core in 4.4, so the 3.3 loader doesn't know about it
+#ifndef GL_MAP_PERSISTENT_BIT
+	#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+	#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace
+{
+	typedef void (APIENTRY* BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+	constexpr uint32_t MAX_SEGMENTS = 4;
+	constexpr GLuint64 FENCE_TIMEOUT = 1000000000; // One second, in nanoseconds
+
+	// Returns glBufferStorage if the context supports it, loading it the first time
+	BufferStorageProc getBufferStorage()
+	{
+		static const BufferStorageProc BUFFER_STORAGE = glfwExtensionSupported("GL_ARB_buffer_storage") ?
+			reinterpret_cast<BufferStorageProc>(glfwGetProcAddress("glBufferStorage")) : nullptr;
+
+		return BUFFER_STORAGE;
+	}
+}
+
+StreamingBuffer::StreamingBuffer(GLsizeiptr segment_size, uint32_t num_frames, bool allow_persistent) :
+	m_ID(0), m_segmentSize(0), m_uniformAlignment(256), m_numSegments(std::min(std::max(num_frames, 2u), MAX_SEGMENTS)),
+	m_currentSegment(0), m_segmentUsed(0), m_fences(), m_persistent(false), m_mappedData(nullptr), m_numStalls(0)
+{
+	// Segments start on a boundary that suits any allocation alignment, uniform blocks being the strictest
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_uniformAlignment);
+	m_segmentSize = (segment_size + m_uniformAlignment - 1) / m_uniformAlignment * m_uniformAlignment;
+
+	const GLsizeiptr BUFFER_SIZE = m_segmentSize * m_numSegments;
+	glGenBuffers(1, &m_ID);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_ID);
+
+	const BufferStorageProc BUFFER_STORAGE = allow_persistent ? getBufferStorage() : nullptr;
+	if (BUFFER_STORAGE)
+	{
+		const GLbitfield FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		BUFFER_STORAGE(GL_ARRAY_BUFFER, BUFFER_SIZE, nullptr, FLAGS);
+		m_mappedData = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, BUFFER_SIZE, FLAGS));
+		m_persistent = m_mappedData != nullptr;
+	}
+
+	if (!m_persistent)
+	{
+		// The storage made by glBufferStorage is immutable, so a failed mapping needs a fresh buffer
+		if (BUFFER_STORAGE)
+		{
+			glDeleteBuffers(1, &m_ID);
+			GLState::onBufferDeleted(m_ID);
+			glGenBuffers(1, &m_ID);
+			GLState::bindBuffer(GL_ARRAY_BUFFER, m_ID);
+		}
+
+		glBufferData(GL_ARRAY_BUFFER, BUFFER_SIZE, nullptr, GL_STREAM_DRAW);
+		OutputLog("Persistent buffer mapping unavailable, streaming through unsynchronized maps instead",
+			Logging::Severity::WARNING);
+	}
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+	for (GLsync fence : m_fences)
+	{
+		if (fence)
+			glDeleteSync(fence);
+	}
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_ID);
+	if (m_persistent || m_mappedData)
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+
+	glDeleteBuffers(1, &m_ID);
+	GLState::onBufferDeleted(m_ID);
+}
+
+void StreamingBuffer::beginFrame()
+{
+	m_currentSegment = (m_currentSegment + 1) % m_numSegments;
+	m_segmentUsed = 0;
+
+	// Wait for the GPU to be done with the frame that last used this segment
+	GLsync& fence = m_fences[m_currentSegment];
+	if (fence)
+	{
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED)
+		{
+			m_numStalls++;
+			do
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+			while (result == GL_TIMEOUT_EXPIRED);
+		}
+
+		if (result == GL_WAIT_FAILED)
+			OutputLog("Waiting on a streaming buffer fence failed", Logging::Severity::WARNING);
+
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	// The fence already guarantees the GPU is done, so the driver doesn't need to synchronize the mapping
+	if (!m_persistent)
+	{
+		GLState::bindBuffer(GL_ARRAY_BUFFER, m_ID);
+		m_mappedData = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, m_segmentSize * m_currentSegment,
+			m_segmentSize, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+			GL_MAP_FLUSH_EXPLICIT_BIT));
+	}
+}
+
+StreamAllocation StreamingBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+	StreamAllocation allocation;
+	const GLsizeiptr START = (m_segmentUsed + alignment - 1) / alignment * alignment;
+
+	if (!m_mappedData || START + size > m_segmentSize)
+	{
+		OutputLog("Streaming buffer segment is out of space", Logging::Severity::WARNING);
+		return allocation;
+	}
+
+	const GLintptr SEGMENT_OFFSET = m_segmentSize * m_currentSegment;
+	allocation.m_offset = SEGMENT_OFFSET + START;
+	allocation.m_size = size;
+	allocation.m_data = m_persistent ? m_mappedData + allocation.m_offset : m_mappedData + START;
+
+	m_segmentUsed = START + size;
+	return allocation;
+}
+
+void StreamingBuffer::finishWrites()
+{
+	// Coherent persistent mappings need nothing, the explicit flush covers only what the frame wrote
+	if (m_persistent || !m_mappedData)
+		return;
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_ID);
+	glFlushMappedBufferRange(GL_ARRAY_BUFFER, 0, m_segmentUsed);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+
+	m_mappedData = nullptr;
+}
+
+void StreamingBuffer::endFrame()
+{
+	m_fences[m_currentSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamingBuffer::bindUniformRange(uint32_t binding_point, const StreamAllocation& allocation) const
+{
+	GLState::bindBufferRange(GL_UNIFORM_BUFFER, binding_point, m_ID, allocation.m_offset, allocation.m_size);
+}
+
+const uint32_t& StreamingBuffer::getID() const
+{
+	return m_ID;
+}
+
+GLint StreamingBuffer::getUniformAlignment() const
+{
+	return m_uniformAlignment;
+}
+
+bool StreamingBuffer::isPersistent() const
+{
+	return m_persistent;
+}
+
+uint32_t StreamingBuffer::getNumStalls() const
+{
+	return m_numStalls;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+
+struct StreamAllocation
+{
+	void* m_data = nullptr; // Where to write the data to (nullptr if the frame's segment ran out of space)
+	GLintptr m_offset = 0; // Byte offset of the data in the buffer, for binding or attrib pointers
+	GLsizeiptr m_size = 0;
+};
+
+// Ring buffer for data rewritten every frame (instance matrices, per-frame uniforms). The buffer is split into one
+// segment per frame in flight, and every frame sub-allocates from its own segment while the GPU may still be reading
+// the others, a fence per segment stopping the CPU from overwriting data the GPU hasn't finished with. With
+// ARB_buffer_storage the whole buffer stays persistently and coherently mapped, so writes go straight to memory the
+// GPU reads from. Without it, each frame's segment is mapped unsynchronized and flushed explicitly instead.
+//
+// Per frame: beginFrame() -> allocate() and write -> finishWrites() -> draw using the allocations -> endFrame()
+class StreamingBuffer
+{
+private:
+	uint32_t m_ID;
+	GLsizeiptr m_segmentSize;
+	GLint m_uniformAlignment;
+	uint32_t m_numSegments, m_currentSegment;
+	GLsizeiptr m_segmentUsed;
+	GLsync m_fences[4];
+
+	bool m_persistent;
+	uint8_t* m_mappedData; // Whole buffer when persistent, else the current segment while it is mapped
+	uint32_t m_numStalls; // Frames that had to wait on the GPU before writing
+public:
+	// segment_size is the most bytes a single frame may allocate, num_frames how many frames can be in flight (2-4)
+	StreamingBuffer(GLsizeiptr segment_size, uint32_t num_frames = 3, bool allow_persistent = true);
+	~StreamingBuffer();
+
+	void beginFrame(); // Moves to the next segment, waiting for the GPU to finish reading it if needed
+	StreamAllocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16); // Reserves bytes in the current segment
+	void finishWrites(); // Makes the frame's writes visible to the GPU, must come before drawing with them
+	void endFrame(); // Fences the segment once the draws reading from it have been issued
+
+	void bindUniformRange(uint32_t binding_point, const StreamAllocation& allocation) const; // Binds an allocation as a uniform block
+public:
+	const uint32_t& getID() const; // Returns the ID of the buffer
+	GLint getUniformAlignment() const; // Returns the alignment allocations bound as uniform blocks need
+	bool isPersistent() const; // Returns whether the buffer is persistently mapped
+	uint32_t getNumStalls() const; // Returns how many frames had to wait on the GPU so far
+};
\ No newline at end of file
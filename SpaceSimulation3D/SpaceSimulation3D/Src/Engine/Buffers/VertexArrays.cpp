@@ -1,8 +1,10 @@
 #include "VertexArrays.h"
+#include "Engine/Utils/GLStateCache.h"
+
 #include <cassert>
 
 VertexArray::VertexArray() :
-	m_ID(0)
+	m_ID(0), m_instanceBuffer(0), m_instanceOffset(0)
 {
 	glGenVertexArrays(1, &m_ID);
 }
@@ -10,6 +12,7 @@ VertexArray::VertexArray() :
 VertexArray::~VertexArray()
 {
 	glDeleteVertexArrays(1, &m_ID);
+	GLState::onVertexArrayDeleted(m_ID);
 }
 
 void VertexArray::attachBufferObjects(std::shared_ptr<VertexBuffer> vbo, std::shared_ptr<IndexBuffer> ibo)
@@ -20,7 +23,7 @@ void VertexArray::attachBufferObjects(std::shared_ptr<VertexBuffer> vbo, std::sh
 	m_iboStack.emplace_back(ibo);
 
 	// Bind the vao, vbo and ibo (if given) then configure the vertex attrib pointers
-	glBindVertexArray(m_ID);
+	GLState::bindVertexArray(m_ID);
 	vbo->bindBuffer();
 	if (ibo)
 		ibo->bindBuffer();
@@ -32,25 +35,47 @@ void VertexArray::attachBufferObjects(std::shared_ptr<VertexBuffer> vbo, std::sh
 			layout.offset);
 
 		glVertexAttribDivisor(layout.index, layout.divisor);
+
+		if (layout.divisor != 0)
+		{
+			m_instanceLayouts.emplace_back(layout);
+			m_instanceBuffer = vbo->getID();
+			m_instanceOffset = 0;
+		}
 	}
 
 	m_layoutStack.clear();
+}
 
-	// Finally just unbind the vao, vbo and ibo (if given)
-	glBindVertexArray(0);
-	vbo->unbindBuffer();
-	if (ibo)
-		ibo->unbindBuffer();
+void VertexArray::setInstanceSource(uint32_t buffer_id, GLintptr offset) const
+{
+	GLState::bindVertexArray(m_ID);
+
+	// The attrib pointers are part of the vao, so they only need redoing when the source moved
+	const bool MOVED = buffer_id != m_instanceBuffer || offset != m_instanceOffset;
+	GLState::countCall(MOVED);
+	if (!MOVED)
+		return;
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, buffer_id);
+	for (const auto& layout : m_instanceLayouts)
+	{
+		glVertexAttribPointer(layout.index, layout.size, layout.type, layout.normalized, layout.stride,
+			static_cast<const char*>(layout.offset) + offset);
+	}
+
+	m_instanceBuffer = buffer_id;
+	m_instanceOffset = offset;
 }
 
 void VertexArray::bind() const
 {
-	glBindVertexArray(m_ID);
+	GLState::bindVertexArray(m_ID);
 }
 
 void VertexArray::unbind() const
 {
-	glBindVertexArray(0);
+	GLState::bindVertexArray(0);
 }
 
 const uint32_t& VertexArray::getID() const
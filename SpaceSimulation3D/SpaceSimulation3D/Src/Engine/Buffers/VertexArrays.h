@@ -17,6 +17,17 @@ struct VertexLayout
 	GLuint divisor;
 };
 
+// Packed attribute formats get their own types, so pushLayout<>() can tell them apart from plain integers
+struct HalfFloat
+{
+	GLhalf m_bits;
+};
+
+struct PackedSnorm10
+{
+	GLuint m_bits; // x, y and z as 10 bit signed normalized values from the low bits up, then a 2 bit w
+};
+
 class VertexArray
 {
 private:
@@ -25,6 +36,9 @@ private:
 	std::vector<std::shared_ptr<VertexBuffer>> m_vboStack;
 	std::vector<std::shared_ptr<IndexBuffer>> m_iboStack;
 	std::vector<VertexLayout> m_layoutStack;
+	std::vector<VertexLayout> m_instanceLayouts; // Per-instance layouts that were attached, kept to repoint them
+	mutable uint32_t m_instanceBuffer; // Buffer the per-instance attribs point into right now
+	mutable GLintptr m_instanceOffset;
 public:
 	VertexArray();
 	~VertexArray();
@@ -32,6 +46,10 @@ public:
 	void attachBufferObjects(std::shared_ptr<VertexBuffer> vbo, 
 		std::shared_ptr<IndexBuffer> ibo = nullptr); // Attaches the given vbo (and ibo) to the vao
 	
+	// setInstanceSource() : Binds the vao and points its per-instance attribs at the given buffer, starting at the given
+	// byte offset (used to draw instances straight out of a streaming buffer)
+	void setInstanceSource(uint32_t buffer_id, GLintptr offset) const;
+
 	void bind() const; // Binds the vao
 	void unbind() const; // Unbinds the vao
 public:
@@ -49,6 +67,18 @@ public:
 	template<>
 	void pushLayout<GLubyte>(GLuint index, GLint size, GLsizei stride, GLsizei offset, GLuint divisor,
 		GLboolean normalized);
+	template<>
+	void pushLayout<GLshort>(GLuint index, GLint size, GLsizei stride, GLsizei offset, GLuint divisor,
+		GLboolean normalized);
+	template<>
+	void pushLayout<GLushort>(GLuint index, GLint size, GLsizei stride, GLsizei offset, GLuint divisor,
+		GLboolean normalized);
+	template<>
+	void pushLayout<HalfFloat>(GLuint index, GLint size, GLsizei stride, GLsizei offset, GLuint divisor,
+		GLboolean normalized);
+	template<>
+	void pushLayout<PackedSnorm10>(GLuint index, GLint size, GLsizei stride, GLsizei offset, GLuint divisor,
+		GLboolean normalized);
 public:
 	const uint32_t& getID() const; // Returns the ID of the vao
 
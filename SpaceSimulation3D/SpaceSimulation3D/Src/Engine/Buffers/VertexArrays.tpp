@@ -26,4 +26,33 @@ void VertexArray::pushLayout<GLubyte>(GLuint index, GLint size, GLsizei stride,
 	GLboolean normalized)
 {
 	m_layoutStack.push_back({ index, size, GL_UNSIGNED_BYTE, normalized, stride, (void*)offset, divisor });
+}
+
+template<>
+void VertexArray::pushLayout<GLshort>(GLuint index, GLint size, GLsizei stride, GLsizei offset, GLuint divisor,
+	GLboolean normalized)
+{
+	m_layoutStack.push_back({ index, size, GL_SHORT, normalized, stride, (void*)offset, divisor });
+}
+
+template<>
+void VertexArray::pushLayout<GLushort>(GLuint index, GLint size, GLsizei stride, GLsizei offset, GLuint divisor,
+	GLboolean normalized)
+{
+	m_layoutStack.push_back({ index, size, GL_UNSIGNED_SHORT, normalized, stride, (void*)offset, divisor });
+}
+
+template<>
+void VertexArray::pushLayout<HalfFloat>(GLuint index, GLint size, GLsizei stride, GLsizei offset, GLuint divisor,
+	GLboolean normalized)
+{
+	m_layoutStack.push_back({ index, size, GL_HALF_FLOAT, normalized, stride, (void*)offset, divisor });
+}
+
+template<>
+void VertexArray::pushLayout<PackedSnorm10>(GLuint index, GLint size, GLsizei stride, GLsizei offset, GLuint divisor,
+	GLboolean normalized)
+{
+	// The packed format always holds four components
+	m_layoutStack.push_back({ index, 4, GL_INT_2_10_10_10_REV, normalized, stride, (void*)offset, divisor });
 }
\ No newline at end of file
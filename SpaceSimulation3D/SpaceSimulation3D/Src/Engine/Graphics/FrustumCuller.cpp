@@ -0,0 +1,192 @@
+#include "FrustumCuller.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define FRUSTUM_CULLER_SSE
+	#include <immintrin.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t CULL_GRAIN_SIZE = 16384; // Multiple of 4, so every job starts on its own mask entry
+	constexpr uint32_t NUM_PLANES = 6;
+}
+
+FrustumCuller::FrustumCuller(std::shared_ptr<JobSystem> job_system) :
+	m_jobSystem(job_system)
+{
+	// Until a frustum is set every plane lets everything through
+	for (uint32_t plane = 0; plane < NUM_PLANES; plane++)
+		m_planes[plane] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+FrustumCuller::~FrustumCuller() {}
+
+uint32_t FrustumCuller::testRange(const InstanceData* instances, float model_radius, uint32_t begin, uint32_t end)
+{
+	uint32_t numVisible = 0;
+	uint32_t index = begin;
+
+#ifdef FRUSTUM_CULLER_SSE
+	__m128 planeX[NUM_PLANES], planeY[NUM_PLANES], planeZ[NUM_PLANES], planeW[NUM_PLANES];
+	for (uint32_t plane = 0; plane < NUM_PLANES; plane++)
+	{
+		planeX[plane] = _mm_set1_ps(m_planes[plane].x);
+		planeY[plane] = _mm_set1_ps(m_planes[plane].y);
+		planeZ[plane] = _mm_set1_ps(m_planes[plane].z);
+		planeW[plane] = _mm_set1_ps(m_planes[plane].w);
+	}
+
+	const __m128 MODEL_RADIUS = _mm_set1_ps(model_radius);
+
+	// Four instances at a time: transposing their position and scale gives the centre and radius of each sphere in
+	// separate registers, which are then run against all six planes at once
+	for (; index + 4 <= end; index += 4)
+	{
+		__m128 centerX = _mm_loadu_ps(&instances[index].m_position.x);
+		__m128 centerY = _mm_loadu_ps(&instances[index + 1].m_position.x);
+		__m128 centerZ = _mm_loadu_ps(&instances[index + 2].m_position.x);
+		__m128 scale = _mm_loadu_ps(&instances[index + 3].m_position.x);
+		_MM_TRANSPOSE4_PS(centerX, centerY, centerZ, scale);
+
+		const __m128 NEGATIVE_RADIUS = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(scale, MODEL_RADIUS));
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (uint32_t plane = 0; plane < NUM_PLANES; plane++)
+		{
+			const __m128 DISTANCE = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[plane], centerX),
+				_mm_mul_ps(planeY[plane], centerY)), _mm_add_ps(_mm_mul_ps(planeZ[plane], centerZ), planeW[plane]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(DISTANCE, NEGATIVE_RADIUS));
+		}
+
+		const int MASK = _mm_movemask_ps(inside);
+		m_visibilityMasks[index / 4] = static_cast<uint8_t>(MASK);
+		numVisible += static_cast<uint32_t>(((MASK >> 0) & 1) + ((MASK >> 1) & 1) + ((MASK >> 2) & 1) + ((MASK >> 3) & 1));
+	}
+#endif
+
+	// Whatever is left over (or everything, without SSE)
+	for (; index < end; index++)
+	{
+		const InstanceData& INSTANCE = instances[index];
+		uint8_t& mask = m_visibilityMasks[index / 4];
+		if (index % 4 == 0)
+			mask = 0;
+
+		if (this->isSphereVisible(INSTANCE.m_position, INSTANCE.m_scale * model_radius))
+		{
+			mask |= static_cast<uint8_t>(1 << (index % 4));
+			numVisible++;
+		}
+	}
+
+	return numVisible;
+}
+
+void FrustumCuller::compactRange(const InstanceData* instances, uint32_t begin, uint32_t end, InstanceData* visible,
+	uint32_t* visible_indices) const
+{
+	for (uint32_t group = begin; group < end; group += 4)
+	{
+		uint32_t mask = m_visibilityMasks[group / 4];
+
+		// Fully culled groups are the common case when looking away from the belt, so skip them in one go
+		while (mask != 0)
+		{
+			uint32_t lane = 0;
+			while (!(mask & (1u << lane)))
+				lane++;
+
+			if (visible)
+				*visible++ = instances[group + lane];
+			if (visible_indices)
+				*visible_indices++ = group + lane;
+
+			mask &= mask - 1;
+		}
+	}
+}
+
+void FrustumCuller::setJobSystem(std::shared_ptr<JobSystem> job_system)
+{
+	m_jobSystem = job_system;
+}
+
+void FrustumCuller::setFrustum(const glm::mat4& view_projection)
+{
+	// Gribb/Hartmann: each plane is the fourth row of the matrix plus or minus one of the other rows
+	for (uint32_t plane = 0; plane < NUM_PLANES; plane++)
+	{
+		const int ROW = static_cast<int>(plane / 2);
+		const float SIGN = (plane % 2 == 0) ? 1.0f : -1.0f;
+
+		glm::vec4 equation;
+		for (int column = 0; column < 4; column++)
+			equation[column] = view_projection[column][3] + SIGN * view_projection[column][ROW];
+
+		// Normalized, so the plane distance can be compared against the sphere radius directly
+		const float LENGTH = std::sqrt(equation.x * equation.x + equation.y * equation.y + equation.z * equation.z);
+		m_planes[plane] = LENGTH > 0.0f ? equation * (1.0f / LENGTH) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+uint32_t FrustumCuller::cullInstances(const InstanceData* instances, uint32_t num_instances, float model_radius,
+	InstanceData* visible, uint32_t* visible_indices)
+{
+	const uint32_t NUM_RANGES = (num_instances + CULL_GRAIN_SIZE - 1) / CULL_GRAIN_SIZE;
+	m_visibilityMasks.resize((num_instances + 3) / 4);
+	m_rangeOffsets.resize(NUM_RANGES + 1);
+
+	// Small counts aren't worth waking the other threads for
+	if (!m_jobSystem || NUM_RANGES <= 1)
+	{
+		const uint32_t NUM_VISIBLE = this->testRange(instances, model_radius, 0, num_instances);
+		this->compactRange(instances, 0, num_instances, visible, visible_indices);
+
+		m_stats.m_tested = num_instances;
+		m_stats.m_visible = NUM_VISIBLE;
+		return NUM_VISIBLE;
+	}
+
+	// First every job tests its range and counts the survivors, the counts then give each job the place to write its
+	// survivors to, so the second pass can compact all the ranges in parallel and still keep the original order
+	m_jobSystem->parallelFor(0, num_instances, CULL_GRAIN_SIZE, [this, instances, model_radius](uint32_t begin,
+		uint32_t end)
+	{
+		m_rangeOffsets[begin / CULL_GRAIN_SIZE + 1] = this->testRange(instances, model_radius, begin, end);
+	});
+
+	m_rangeOffsets[0] = 0;
+	for (uint32_t range = 0; range < NUM_RANGES; range++)
+		m_rangeOffsets[range + 1] += m_rangeOffsets[range];
+
+	m_jobSystem->parallelFor(0, num_instances, CULL_GRAIN_SIZE, [this, instances, visible, visible_indices](uint32_t begin,
+		uint32_t end)
+	{
+		const uint32_t OFFSET = m_rangeOffsets[begin / CULL_GRAIN_SIZE];
+		this->compactRange(instances, begin, end, visible ? visible + OFFSET : nullptr,
+			visible_indices ? visible_indices + OFFSET : nullptr);
+	});
+
+	m_stats.m_tested = num_instances;
+	m_stats.m_visible = m_rangeOffsets[NUM_RANGES];
+	return m_stats.m_visible;
+}
+
+bool FrustumCuller::isSphereVisible(const glm::vec3& center, float radius) const
+{
+	for (uint32_t plane = 0; plane < NUM_PLANES; plane++)
+	{
+		const glm::vec4& PLANE = m_planes[plane];
+		if (PLANE.x * center.x + PLANE.y * center.y + PLANE.z * center.z + PLANE.w < -radius)
+			return false;
+	}
+
+	return true;
+}
+
+const CullingStats& FrustumCuller::getStats() const
+{
+	return m_stats;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include "Engine/Utils/JobSystem.h"
+#include "Engine/Simulation/TransformKernels.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+
+struct CullingStats
+{
+	uint32_t m_tested = 0; // Instances tested against the frustum by the last cull
+	uint32_t m_visible = 0;
+};
+
+// Culls instances against the view frustum. Every instance is bounded by a sphere around its translation,
+// with the given model radius scaled by the instance's scale, and the instances that touch the frustum are packed
+// together in their original order so the result can be uploaded straight into an instance buffer
+class FrustumCuller
+{
+private:
+	glm::vec4 m_planes[6]; // Left, right, bottom, top, near and far planes, normals pointing inwards
+	std::shared_ptr<JobSystem> m_jobSystem;
+
+	std::vector<uint8_t> m_visibilityMasks; // One bit per instance, four instances per entry
+	std::vector<uint32_t> m_rangeOffsets; // Where each job writes its visible instances to
+	CullingStats m_stats;
+private:
+	uint32_t testRange(const InstanceData* instances, float model_radius, uint32_t begin, uint32_t end); // Fills the masks of the range and returns how many are visible
+	void compactRange(const InstanceData* instances, uint32_t begin, uint32_t end, InstanceData* visible,
+		uint32_t* visible_indices) const; // Copies the visible instances (and/or their indices) of the range in order
+public:
+	FrustumCuller(std::shared_ptr<JobSystem> job_system = nullptr);
+	~FrustumCuller();
+
+	void setJobSystem(std::shared_ptr<JobSystem> job_system); // Sets the job system large culls are split across (nullptr = serial)
+	void setFrustum(const glm::mat4& view_projection); // Extracts the frustum planes from the combined projection * view matrix
+
+	// cullInstances() : Writes the instances inside the frustum to the visible array and/or their indices to the index
+	// array (either can be nullptr, both must fit all the instances) and returns how many were written
+	uint32_t cullInstances(const InstanceData* instances, uint32_t num_instances, float model_radius,
+		InstanceData* visible, uint32_t* visible_indices = nullptr);
+
+	bool isSphereVisible(const glm::vec3& center, float radius) const; // Tests a single sphere against the frustum
+public:
+	const CullingStats& getStats() const; // Returns the counters of the last cull
+};
\ No newline at end of file
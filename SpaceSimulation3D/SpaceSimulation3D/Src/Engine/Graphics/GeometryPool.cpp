@@ -0,0 +1,210 @@
+#include "GeometryPool.h"
+
+#include <algorithm>
+
+namespace
+{
+	// A new page fits the models loaded here many times over: 8 MB of full vertices (4 MB quantized) and 4 MB of indices
+	constexpr uint32_t PAGE_VERTICES = 1 << 18, PAGE_INDICES = 1 << 20;
+
+	std::weak_ptr<GeometryPool> sharedPools[NUM_VERTEX_FORMATS]; // Kept alive by the meshes allocated in them (main thread only)
+
+	GLsizei getVertexStride(VertexFormat format)
+	{
+		return format == VertexFormat::QUANTIZED ? sizeof(QuantizedVertexData) : sizeof(VertexData);
+	}
+}
+
+GeometryPool::GeometryPool(VertexFormat format, uint32_t page_vertices, uint32_t page_indices) :
+	m_format(format), m_vertexStride(getVertexStride(format)), m_pageVertices(page_vertices),
+	m_pageIndices(page_indices), m_numAllocations(0)
+{
+	const glm::mat4 IDENTITY(1.0f);
+	m_identityBuffer = std::make_shared<VertexBuffer>(&IDENTITY[0][0], sizeof(glm::mat4), GL_STATIC_DRAW);
+}
+
+GeometryPool::~GeometryPool() {}
+
+void GeometryPool::addPage(uint32_t num_vertices, uint32_t num_indices)
+{
+	m_pages.emplace_back(num_vertices, num_indices);
+	GeometryPage& page = m_pages.back();
+
+	page.m_vbo = std::make_shared<VertexBuffer>(nullptr, static_cast<GLsizeiptr>(m_vertexStride) * num_vertices,
+		GL_STATIC_DRAW);
+	page.m_ibo = std::make_shared<IndexBuffer>(nullptr, static_cast<GLsizeiptr>(sizeof(uint32_t)) * num_indices,
+		GL_STATIC_DRAW);
+
+	for (uint32_t layout = 0; layout < NUM_INSTANCE_LAYOUTS; layout++)
+	{
+		auto vao = std::make_shared<VertexArray>();
+		switch (m_format)
+		{
+		case VertexFormat::FULL:
+			vao->pushLayout<float>(0, 3, sizeof(VertexData));
+			vao->pushLayout<float>(1, 3, sizeof(VertexData), offsetof(VertexData, m_normalPos));
+			vao->pushLayout<float>(2, 2, sizeof(VertexData), offsetof(VertexData, m_texturePos));
+			break;
+		case VertexFormat::QUANTIZED:
+			vao->pushLayout<GLushort>(0, 3, sizeof(QuantizedVertexData), 0, 0, GL_TRUE);
+			vao->pushLayout<PackedSnorm10>(1, 4, sizeof(QuantizedVertexData), offsetof(QuantizedVertexData, m_normalPos),
+				0, GL_TRUE);
+			vao->pushLayout<HalfFloat>(2, 2, sizeof(QuantizedVertexData), offsetof(QuantizedVertexData, m_texturePos));
+			break;
+		}
+
+		vao->attachBufferObjects(page.m_vbo, page.m_ibo);
+
+		// The instance attribs read the identity matrix until a mesh points them at its own instances
+		switch (static_cast<InstanceLayout>(layout))
+		{
+		case InstanceLayout::INSTANCES:
+			// Position and scale as one vec4, then the quaternion normalized back into [-1, 1]
+			vao->pushLayout<float>(3, 4, sizeof(InstanceData), offsetof(InstanceData, m_position), 1);
+			vao->pushLayout<GLshort>(4, 4, sizeof(InstanceData), offsetof(InstanceData, m_rotation), 1, GL_TRUE);
+			break;
+		case InstanceLayout::TRANSFORMS:
+			// The model matrix takes up a column per attrib
+			for (uint32_t column = 0; column < 4; column++)
+				vao->pushLayout<float>(5 + column, 4, sizeof(glm::mat4), sizeof(glm::vec4) * column, 1);
+			break;
+		}
+
+		vao->attachBufferObjects(m_identityBuffer);
+		page.m_vaos[layout] = vao;
+	}
+}
+
+void GeometryPool::release(const GeometryAllocation& allocation)
+{
+	// The page keeps its buffers, the ranges just become free for the next mesh
+	GeometryPage& page = m_pages[allocation.m_page];
+	page.m_vertices.release(allocation.m_baseVertex, allocation.m_numVertices);
+	page.m_indices.release(allocation.m_firstIndex, allocation.m_numIndices);
+	m_numAllocations--;
+}
+
+std::shared_ptr<const GeometryAllocation> GeometryPool::allocate(std::shared_ptr<GeometryPool> pool,
+	const void* vertices, uint32_t num_vertices, const std::vector<uint32_t>& indices)
+{
+	GeometryAllocation allocation;
+	allocation.m_numVertices = num_vertices;
+	allocation.m_numIndices = static_cast<uint32_t>(indices.size());
+
+	// Take the first page with room for both the vertices and the indices, giving the vertices back if only they fit
+	bool placed = false;
+	for (uint32_t index = 0; index < pool->m_pages.size() && !placed; index++)
+	{
+		GeometryPage& page = pool->m_pages[index];
+		if (!page.m_vertices.allocate(allocation.m_numVertices, allocation.m_baseVertex))
+			continue;
+
+		if (!page.m_indices.allocate(allocation.m_numIndices, allocation.m_firstIndex))
+		{
+			page.m_vertices.release(allocation.m_baseVertex, allocation.m_numVertices);
+			continue;
+		}
+
+		allocation.m_page = index;
+		placed = true;
+	}
+
+	// Otherwise start a new page, at least as large as the mesh needs
+	if (!placed)
+	{
+		pool->addPage(std::max(allocation.m_numVertices, pool->m_pageVertices),
+			std::max(allocation.m_numIndices, pool->m_pageIndices));
+
+		allocation.m_page = static_cast<uint32_t>(pool->m_pages.size() - 1);
+		pool->m_pages.back().m_vertices.allocate(allocation.m_numVertices, allocation.m_baseVertex);
+		pool->m_pages.back().m_indices.allocate(allocation.m_numIndices, allocation.m_firstIndex);
+	}
+
+	const GeometryPage& PAGE = pool->m_pages[allocation.m_page];
+	const GLsizeiptr STRIDE = pool->m_vertexStride, INDEX_SIZE = sizeof(uint32_t);
+	if (allocation.m_numVertices > 0)
+		PAGE.m_vbo->modifyData(vertices, STRIDE * allocation.m_baseVertex, STRIDE * allocation.m_numVertices);
+	if (allocation.m_numIndices > 0)
+		PAGE.m_ibo->modifyData(indices.data(), INDEX_SIZE * allocation.m_firstIndex, INDEX_SIZE * allocation.m_numIndices);
+
+	pool->m_numAllocations++;
+
+	// The deleter holds on to the pool, so it stays alive for as long as any of its allocations do
+	return std::shared_ptr<const GeometryAllocation>(new GeometryAllocation(allocation),
+		[pool](const GeometryAllocation* released)
+	{
+		pool->release(*released);
+		delete released;
+	});
+}
+
+std::shared_ptr<GeometryPool> GeometryPool::getPool(VertexFormat format)
+{
+	std::weak_ptr<GeometryPool>& shared = sharedPools[static_cast<uint32_t>(format)];
+	std::shared_ptr<GeometryPool> pool = shared.lock();
+	if (!pool)
+	{
+		pool = std::make_shared<GeometryPool>(format, PAGE_VERTICES, PAGE_INDICES);
+		shared = pool;
+	}
+
+	return pool;
+}
+
+GeometryPoolStats GeometryPool::getTotalStats()
+{
+	GeometryPoolStats total;
+	for (const auto& shared : sharedPools)
+	{
+		const std::shared_ptr<GeometryPool> POOL = shared.lock();
+		if (!POOL)
+			continue;
+
+		const GeometryPoolStats STATS = POOL->getStats();
+		total.m_numPages += STATS.m_numPages;
+		total.m_numAllocations += STATS.m_numAllocations;
+		total.m_reservedBytes += STATS.m_reservedBytes;
+		total.m_usedBytes += STATS.m_usedBytes;
+		total.m_freeRanges += STATS.m_freeRanges;
+		total.m_vertexFragmentation = std::max(total.m_vertexFragmentation, STATS.m_vertexFragmentation);
+		total.m_indexFragmentation = std::max(total.m_indexFragmentation, STATS.m_indexFragmentation);
+	}
+
+	return total;
+}
+
+const std::shared_ptr<VertexArray>& GeometryPool::getVertexArray(uint32_t page, InstanceLayout layout) const
+{
+	return m_pages[page].m_vaos[static_cast<uint32_t>(layout)];
+}
+
+uint32_t GeometryPool::getIdentityBuffer() const
+{
+	return m_identityBuffer->getID();
+}
+
+VertexFormat GeometryPool::getFormat() const
+{
+	return m_format;
+}
+
+GeometryPoolStats GeometryPool::getStats() const
+{
+	GeometryPoolStats stats;
+	stats.m_numPages = static_cast<uint32_t>(m_pages.size());
+	stats.m_numAllocations = m_numAllocations;
+
+	for (const auto& page : m_pages)
+	{
+		stats.m_reservedBytes += static_cast<size_t>(m_vertexStride) * page.m_vertices.getCapacity() +
+			sizeof(uint32_t) * page.m_indices.getCapacity();
+		stats.m_usedBytes += static_cast<size_t>(m_vertexStride) * page.m_vertices.getUsed() +
+			sizeof(uint32_t) * page.m_indices.getUsed();
+
+		stats.m_freeRanges += page.m_vertices.getNumFreeRanges() + page.m_indices.getNumFreeRanges();
+		stats.m_vertexFragmentation = std::max(stats.m_vertexFragmentation, page.m_vertices.getFragmentation());
+		stats.m_indexFragmentation = std::max(stats.m_indexFragmentation, page.m_indices.getFragmentation());
+	}
+
+	return stats;
+}
\ No newline at end of file
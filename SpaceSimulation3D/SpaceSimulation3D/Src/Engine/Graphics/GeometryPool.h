@@ -0,0 +1,111 @@
+#pragma once
+#include "Engine/Buffers/VertexArrays.h"
+#include "Engine/Buffers/RangeAllocator.h"
+#include "Engine/Simulation/TransformKernels.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+struct VertexData
+{
+	glm::vec3 m_vertexPos;
+	glm::vec3 m_normalPos;
+	glm::vec2 m_texturePos;
+};
+
+// Half the size of VertexData: the position as 16 bit unsigned normalized values across the mesh bounds (the fourth is
+// padding), the normal as packed 10 bit signed normalized values and the texture coordinates as half floats
+struct QuantizedVertexData
+{
+	GLushort m_vertexPos[4];
+	PackedSnorm10 m_normalPos;
+	HalfFloat m_texturePos[2];
+};
+
+enum class VertexFormat
+{
+	FULL, // VertexData
+	QUANTIZED // QuantizedVertexData
+};
+
+constexpr uint32_t NUM_VERTEX_FORMATS = 2;
+
+// Per-instance attribs the vaos of a pool page read, besides the vertices
+enum class InstanceLayout
+{
+	INSTANCES, // InstanceData at locations 3 (position and scale) and 4 (rotation), for instanced meshes
+	TRANSFORMS // A model matrix at locations 5 to 8, for the copies of a non-instanced mesh
+};
+
+constexpr uint32_t NUM_INSTANCE_LAYOUTS = 2;
+
+// Where a mesh lives in a pool: its vertices are numbered from the base vertex in the page's vertex buffer, and its
+// indices (numbered from 0) start at the first index of the page's index buffer
+struct GeometryAllocation
+{
+	uint32_t m_page = 0;
+	uint32_t m_baseVertex = 0, m_numVertices = 0;
+	uint32_t m_firstIndex = 0, m_numIndices = 0;
+};
+
+// Storage of a pool, summed over its pages
+struct GeometryPoolStats
+{
+	uint32_t m_numPages = 0, m_numAllocations = 0;
+	size_t m_reservedBytes = 0; // Vertex and index storage the pages were created with
+	size_t m_usedBytes = 0; // The part of it the meshes hold
+	uint32_t m_freeRanges = 0; // Separate free ranges, vertex and index storage together
+	float m_vertexFragmentation = 0.0f, m_indexFragmentation = 0.0f; // Worst of any page, see RangeAllocator::getFragmentation()
+};
+
+// A page of a geometry pool: one vertex and one index buffer shared by every mesh allocated in it, and a vao for each
+// instance layout reading them
+struct GeometryPage
+{
+	std::shared_ptr<VertexBuffer> m_vbo;
+	std::shared_ptr<IndexBuffer> m_ibo;
+	RangeAllocator m_vertices, m_indices;
+	std::shared_ptr<VertexArray> m_vaos[NUM_INSTANCE_LAYOUTS];
+
+	GeometryPage(uint32_t num_vertices, uint32_t num_indices) : m_vertices(num_vertices), m_indices(num_indices) {}
+};
+
+// Sub-allocates the vertices and indices of every mesh of a vertex format from a few large buffers, so the meshes
+// share their vaos instead of binding one each. The meshes draw their range with the base vertex draws
+// (glDrawElementsBaseVertex and glDrawElementsInstancedBaseVertex), their indices staying numbered from 0. A page gets
+// added whenever a mesh fits in none of the others, at least as large as the mesh needs.
+//
+// Every mesh of a page reads the same buffers through the same vaos, which is what issuing a page's draws as a single
+// multi-draw indirect would need later on (GL 4.3, past the 3.3 context used here). A mesh's allocation is handed
+// back to the pool once the last reference to it goes, and the pool lives on for as long as any allocation does
+class GeometryPool
+{
+private:
+	const VertexFormat m_format;
+	const GLsizei m_vertexStride;
+	const uint32_t m_pageVertices, m_pageIndices; // Size of a new page, unless a mesh needs a larger one
+
+	std::vector<GeometryPage> m_pages;
+	std::shared_ptr<VertexBuffer> m_identityBuffer; // A single identity matrix, the instance source the vaos start out with
+	uint32_t m_numAllocations;
+private:
+	void addPage(uint32_t num_vertices, uint32_t num_indices); // Creates the buffers and vaos of a new page
+	void release(const GeometryAllocation& allocation); // Frees the allocation's ranges of its page
+public:
+	GeometryPool(VertexFormat format, uint32_t page_vertices, uint32_t page_indices);
+	~GeometryPool();
+
+	// allocate() : Copies the vertices (laid out in the pool's format) and the indices into the first page with room
+	// for both, returning the allocation, which gets released when the last reference to it goes
+	static std::shared_ptr<const GeometryAllocation> allocate(std::shared_ptr<GeometryPool> pool, const void* vertices,
+		uint32_t num_vertices, const std::vector<uint32_t>& indices);
+
+	static std::shared_ptr<GeometryPool> getPool(VertexFormat format); // Returns the pool shared by the meshes of the format, creating it if none is alive
+	static GeometryPoolStats getTotalStats(); // Returns the storage of every shared pool alive, summed together
+public:
+	const std::shared_ptr<VertexArray>& getVertexArray(uint32_t page, InstanceLayout layout) const; // Returns the vao of the page reading the instance layout
+	uint32_t getIdentityBuffer() const; // Returns the buffer holding a single identity matrix, for drawing a mesh once as it is
+	VertexFormat getFormat() const; // Returns the format of the vertices
+	GeometryPoolStats getStats() const; // Returns the storage of the pages and how fragmented it is
+};
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "ImpostorAtlas.h"
+#include "Engine/Utils/GLStateCache.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+
+ImpostorAtlas::ImpostorAtlas(uint32_t frames_per_side, uint32_t frame_size, float radius, float shininess,
+	uint32_t instance_capacity) :
+	m_framesPerSide(std::max(frames_per_side, 1u)), m_frameSize(frame_size), m_radius(radius), m_shininess(shininess),
+	m_materialID(RenderQueue::generateMaterialID()), m_instanceCapacity(instance_capacity), m_numInstances(0),
+	m_instanceSource(0), m_instanceOffset(0)
+{
+	std::fill(m_savedViewport, m_savedViewport + 4, 0);
+
+	// Setup the atlas the frames get baked into
+	const int ATLAS_SIZE = static_cast<int>(m_framesPerSide * m_frameSize);
+	m_atlasFBO = std::make_shared<FrameBuffer>();
+	m_atlasFBO->attachColorBuffer(GL_TEXTURE_2D, ATLAS_SIZE, ATLAS_SIZE, GL_RGBA8);
+	m_atlasFBO->attachColorBuffer(GL_TEXTURE_2D, ATLAS_SIZE, ATLAS_SIZE, GL_RGBA8);
+	m_atlasFBO->attachDepthStencilRBO(ATLAS_SIZE, ATLAS_SIZE, 0);
+
+	// Then the quad every instance gets drawn with, its corners spanning [-1, 1] across the bounding sphere
+	float corners[]
+	{
+		-1.0f, -1.0f,
+		 1.0f, -1.0f,
+		-1.0f,  1.0f,
+		 1.0f,  1.0f
+	};
+
+	auto quadVBO = std::make_shared<VertexBuffer>(corners, sizeof(corners), GL_STATIC_DRAW);
+	m_instanceVBO = std::make_shared<VertexBuffer>(nullptr, sizeof(InstanceData) * m_instanceCapacity, GL_DYNAMIC_DRAW);
+
+	m_quadVAO = std::make_shared<VertexArray>();
+	m_quadVAO->pushLayout<float>(0, 2, 2 * sizeof(float));
+	m_quadVAO->attachBufferObjects(quadVBO);
+
+	// Same per-instance layout as the instanced meshes, so the same binned instances can be drawn either way
+	m_quadVAO->pushLayout<float>(3, 4, sizeof(InstanceData), offsetof(InstanceData, m_position), 1);
+	m_quadVAO->pushLayout<GLshort>(4, 4, sizeof(InstanceData), offsetof(InstanceData, m_rotation), 1, GL_TRUE);
+	m_quadVAO->attachBufferObjects(m_instanceVBO);
+	m_instanceSource = m_instanceVBO->getID();
+}
+
+ImpostorAtlas::~ImpostorAtlas() {}
+
+void ImpostorAtlas::beginBake()
+{
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+
+	m_atlasFBO->bindBuffer();
+	GLState::setDepthTest(true);
+
+	// Clear to zero everywhere, so the texels no frame covers filter away to nothing
+	glViewport(0, 0, static_cast<GLsizei>(m_framesPerSide * m_frameSize), static_cast<GLsizei>(m_framesPerSide * m_frameSize));
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+glm::mat4 ImpostorAtlas::bindFrame(uint32_t frame_x, uint32_t frame_y) const
+{
+	glViewport(static_cast<GLint>(frame_x * m_frameSize), static_cast<GLint>(frame_y * m_frameSize),
+		static_cast<GLsizei>(m_frameSize), static_cast<GLsizei>(m_frameSize));
+
+	// Look at the model origin from the bounding sphere, with the depth range spanning the sphere. The shaders build the
+	// same up vector for each frame, which never ends up along a frame direction
+	const glm::vec3 DIRECTION = ImpostorAtlas::getFrameDirection(frame_x, frame_y, m_framesPerSide);
+	const glm::vec3 UP = std::abs(DIRECTION.y) < 0.999f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+
+	const glm::mat4 VIEW = glm::lookAt(DIRECTION * m_radius, glm::vec3(0.0f), UP);
+	const glm::mat4 PROJECTION = glm::ortho(-m_radius, m_radius, -m_radius, m_radius, 0.0f, 2.0f * m_radius);
+	return PROJECTION * VIEW;
+}
+
+void ImpostorAtlas::endBake()
+{
+	// Frames are a power of two across, so the mips never blend neighbouring frames until a frame is only a few texels
+	int maxLevel = 0;
+	while ((m_frameSize >> (maxLevel + 1)) >= 8)
+		maxLevel++;
+
+	m_atlasFBO->generateMipmaps(maxLevel);
+	m_atlasFBO->unbindBuffer();
+
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+}
+
+void ImpostorAtlas::updateInstances(const void* instances_array, uint32_t num_instances)
+{
+	// The instance buffer can't grow, so never write past the amount of instances it was created with
+	m_numInstances = std::min(num_instances, m_instanceCapacity);
+	m_instanceSource = m_instanceVBO->getID();
+	m_instanceOffset = 0;
+
+	if (m_numInstances > 0)
+		m_instanceVBO->modifyData(instances_array, 0, sizeof(InstanceData) * m_numInstances);
+}
+
+void ImpostorAtlas::setInstanceSource(uint32_t buffer_id, GLintptr offset, uint32_t num_instances)
+{
+	m_numInstances = num_instances;
+	m_instanceSource = buffer_id;
+	m_instanceOffset = offset;
+}
+
+void ImpostorAtlas::submit(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader, float depth,
+	uint32_t num_instances) const
+{
+	if (num_instances == 0)
+		return;
+
+	RenderCommand command;
+	command.m_type = DrawType::IMPOSTORS;
+	command.m_shader = shader.get();
+	command.m_material = m_materialID;
+	command.m_vao = m_quadVAO->getID();
+	command.m_impostor = this;
+	queue.submit(command, RenderPass::SOLID, depth);
+}
+
+void ImpostorAtlas::bindMaterial(const ShaderProgram& shader) const
+{
+	if (m_uniforms.m_program != shader.getID())
+	{
+		m_uniforms.m_program = shader.getID();
+		m_uniforms.m_albedoAtlas = shader.getUniformHandle("albedoAtlas");
+		m_uniforms.m_normalDepthAtlas = shader.getUniformHandle("normalDepthAtlas");
+		m_uniforms.m_framesPerSide = shader.getUniformHandle("framesPerSide");
+		m_uniforms.m_radius = shader.getUniformHandle("impostorRadius");
+		m_uniforms.m_shininess = shader.getUniformHandle("shininess");
+	}
+
+	shader.setUniform(m_uniforms.m_albedoAtlas, static_cast<int>(IMPOSTOR_ALBEDO_TEXTURE_UNIT));
+	shader.setUniform(m_uniforms.m_normalDepthAtlas, static_cast<int>(IMPOSTOR_NORMAL_DEPTH_TEXTURE_UNIT));
+	shader.setUniform(m_uniforms.m_framesPerSide, static_cast<int>(m_framesPerSide));
+	shader.setUniform(m_uniforms.m_radius, m_radius);
+	shader.setUniform(m_uniforms.m_shininess, m_shininess);
+
+	m_atlasFBO->bindColorAttachment(IMPOSTOR_ALBEDO_TEXTURE_UNIT, 0);
+	m_atlasFBO->bindColorAttachment(IMPOSTOR_NORMAL_DEPTH_TEXTURE_UNIT, 1);
+}
+
+void ImpostorAtlas::draw() const
+{
+	m_quadVAO->setInstanceSource(m_instanceSource, m_instanceOffset);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, m_numInstances);
+}
+
+glm::vec3 ImpostorAtlas::getFrameDirection(uint32_t frame_x, uint32_t frame_y, uint32_t frames_per_side)
+{
+	// Octahedral decoding of the frame center, which maps the square onto the sphere with +z in the middle and -z folded
+	// out to the corners
+	const float X = (frame_x + 0.5f) / frames_per_side * 2.0f - 1.0f;
+	const float Y = (frame_y + 0.5f) / frames_per_side * 2.0f - 1.0f;
+
+	glm::vec3 direction(X, Y, 1.0f - std::abs(X) - std::abs(Y));
+	if (direction.z < 0.0f)
+	{
+		direction.x = (1.0f - std::abs(Y)) * (X >= 0.0f ? 1.0f : -1.0f);
+		direction.y = (1.0f - std::abs(X)) * (Y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	return glm::normalize(direction);
+}
+
+uint32_t ImpostorAtlas::getNumInstances() const
+{
+	return m_numInstances;
+}
+
+uint32_t ImpostorAtlas::getFramesPerSide() const
+{
+	return m_framesPerSide;
+}
+
+float ImpostorAtlas::getRadius() const
+{
+	return m_radius;
+}
\ No newline at end of file
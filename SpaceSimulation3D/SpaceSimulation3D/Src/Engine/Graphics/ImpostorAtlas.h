@@ -0,0 +1,72 @@
+#pragma once
+#include "Engine/Buffers/VertexArrays.h"
+#include "Engine/Graphics/ShaderPrograms.h"
+#include "Engine/Graphics/RenderQueue.h"
+#include "Engine/Simulation/TransformKernels.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+
+// Texture units of the impostor atlas, next to the units of the light cluster buffers
+constexpr uint32_t IMPOSTOR_ALBEDO_TEXTURE_UNIT = 11;
+constexpr uint32_t IMPOSTOR_NORMAL_DEPTH_TEXTURE_UNIT = 12;
+
+// Handles of the uniforms the impostors set, looked up again whenever they get drawn with another shader
+struct ImpostorUniforms
+{
+	uint32_t m_program = 0; // Shader program the handles belong to
+	UniformHandle m_albedoAtlas, m_normalDepthAtlas;
+	UniformHandle m_framesPerSide, m_radius, m_shininess;
+};
+
+// Views of a model from every direction, baked into a grid of frames laid out by octahedral mapping, so distant
+// instances can be drawn as a single camera-facing quad each. Every frame is an orthographic view of the model's
+// bounding sphere towards its center, and holds:
+// - albedo: the diffuse color, with the specular intensity in alpha
+// - normal and depth: the model space normal octahedrally encoded in rg, the depth towards the camera (0.5 at the
+//   model origin) in b and the coverage in a
+//
+// Empty texels are zero in every channel, so mip filtering leaves the colors weighted by their coverage, which the
+// shaders divide back out. The quads sample the four frames nearest to the view direction, each reprojected onto the
+// quad, blended by how close each one is
+class ImpostorAtlas
+{
+private:
+	std::shared_ptr<FrameBuffer> m_atlasFBO;
+	uint32_t m_framesPerSide, m_frameSize;
+	float m_radius; // Bounding radius of the model, in model units
+	float m_shininess;
+	uint32_t m_materialID; // Tells the atlas apart in the render queue
+	GLint m_savedViewport[4]; // Viewport to put back once the baking is done
+
+	std::shared_ptr<VertexArray> m_quadVAO;
+	std::shared_ptr<VertexBuffer> m_instanceVBO;
+	uint32_t m_instanceCapacity, m_numInstances;
+	uint32_t m_instanceSource; // Buffer the instances are read from, the atlas's own buffer unless streamed
+	GLintptr m_instanceOffset;
+
+	mutable ImpostorUniforms m_uniforms;
+public:
+	// The atlas is frames_per_side * frame_size texels across, and the instance buffer fits instance_capacity instances
+	ImpostorAtlas(uint32_t frames_per_side, uint32_t frame_size, float radius, float shininess, uint32_t instance_capacity);
+	~ImpostorAtlas();
+
+	void beginBake(); // Binds and clears the atlas, keeping the viewport to put back later
+	glm::mat4 bindFrame(uint32_t frame_x, uint32_t frame_y) const; // Sets the viewport to the frame and returns the view projection to bake it with
+	void endBake(); // Builds the mip chain of the atlas and binds the default framebuffer again
+
+	void updateInstances(const void* instances_array, uint32_t num_instances); // Overwrites the instances (InstanceData) drawn as impostors
+	void setInstanceSource(uint32_t buffer_id, GLintptr offset, uint32_t num_instances); // Draws the instances straight from another buffer instead
+
+	// submit() : Queues the draw of the instances, if there are any. The count is the frame's, as the instances the
+	// atlas currently draws may still belong to the frame before
+	void submit(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader, float depth, uint32_t num_instances) const;
+	void bindMaterial(const ShaderProgram& shader) const; // Sets the uniforms and binds the atlas textures
+	void draw() const; // Draws a quad for every instance, once the material is bound
+public:
+	static glm::vec3 getFrameDirection(uint32_t frame_x, uint32_t frame_y, uint32_t frames_per_side); // Returns the model space direction the frame was viewed from
+
+	uint32_t getNumInstances() const; // Returns the number of instances drawn as impostors
+	uint32_t getFramesPerSide() const; // Returns the number of frames along each side of the atlas
+	float getRadius() const; // Returns the radius of the sphere the frames cover, in model units
+};
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "LODSelector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+LODSelector::LODSelector(const std::vector<float>& level_errors, const std::vector<uint32_t>& level_triangles,
+	float model_radius, float pixel_tolerance, float hysteresis) :
+	m_levelTriangles(level_triangles), m_modelRadius(model_radius), m_hysteresis(hysteresis),
+	m_impostorStart(std::numeric_limits<float>::max()), m_impostorEnd(std::numeric_limits<float>::max())
+{
+	// The error and the radius shrink on screen at the same rate, so level N + 1 is good enough once the projected radius
+	// drops below tolerance * model radius / error of level N + 1
+	for (uint32_t level = 0; level + 1 < level_errors.size(); level++)
+	{
+		const float NEXT_ERROR = level_errors[level + 1];
+		m_switchRadii.emplace_back(NEXT_ERROR > 0.0f ? pixel_tolerance * model_radius / NEXT_ERROR :
+			std::numeric_limits<float>::max());
+	}
+
+	m_levelOffsets.resize(level_errors.size() + 2, 0);
+	m_stats.m_instancesPerLevel.resize(level_errors.size(), 0);
+}
+
+LODSelector::~LODSelector() {}
+
+void LODSelector::setImpostorRange(float fade_start, float fade_end)
+{
+	m_impostorStart = fade_start;
+	m_impostorEnd = std::max(fade_start, fade_end);
+}
+
+uint32_t LODSelector::selectLevels(const InstanceData* instances, uint32_t num_instances, const uint32_t* visible_indices,
+	uint32_t num_visible, const glm::vec3& camera_pos, float pixels_per_unit)
+{
+	const uint32_t NUM_LEVELS = this->getNumLevels();
+	const float FINER_FACTOR = 1.0f + m_hysteresis, COARSER_FACTOR = 1.0f - m_hysteresis;
+
+	m_instanceLevels.resize(num_instances, 0);
+	m_visibleLevels.resize(num_visible);
+	m_visibleFading.resize(num_visible);
+	std::fill(m_stats.m_instancesPerLevel.begin(), m_stats.m_instancesPerLevel.end(), 0);
+	m_stats.m_impostors = 0;
+	m_stats.m_crossFading = 0;
+
+	// Pick the levels and count the instances of each
+	for (uint32_t visible = 0; visible < num_visible; visible++)
+	{
+		const uint32_t INDEX = visible_indices[visible];
+		const InstanceData& INSTANCE = instances[INDEX];
+
+		const float DX = INSTANCE.m_position.x - camera_pos.x, DY = INSTANCE.m_position.y - camera_pos.y;
+		const float DZ = INSTANCE.m_position.z - camera_pos.z;
+		const float DISTANCE = std::max(std::sqrt(DX * DX + DY * DY + DZ * DZ), 1e-3f);
+
+		const float PROJECTED_RADIUS = m_modelRadius * INSTANCE.m_scale * pixels_per_unit / DISTANCE;
+
+		uint32_t level = std::min<uint32_t>(m_instanceLevels[INDEX], NUM_LEVELS - 1);
+		while (level + 1 < NUM_LEVELS && PROJECTED_RADIUS < m_switchRadii[level] * COARSER_FACTOR)
+			level++;
+		while (level > 0 && PROJECTED_RADIUS > m_switchRadii[level - 1] * FINER_FACTOR)
+			level--;
+
+		// The level is still kept for instances drawn as impostors only, so they come back at the right level
+		m_instanceLevels[INDEX] = static_cast<uint8_t>(level);
+		m_visibleFading[visible] = DISTANCE >= m_impostorStart && DISTANCE < m_impostorEnd;
+
+		if (DISTANCE >= m_impostorStart)
+			m_stats.m_impostors++;
+
+		if (DISTANCE >= m_impostorEnd)
+		{
+			m_visibleLevels[visible] = static_cast<uint8_t>(NUM_LEVELS);
+			continue;
+		}
+
+		m_visibleLevels[visible] = static_cast<uint8_t>(level);
+		m_stats.m_instancesPerLevel[level]++;
+		m_stats.m_crossFading += m_visibleFading[visible];
+	}
+
+	m_levelOffsets[0] = 0;
+	for (uint32_t level = 0; level < NUM_LEVELS; level++)
+		m_levelOffsets[level + 1] = m_levelOffsets[level] + m_stats.m_instancesPerLevel[level];
+
+	m_levelOffsets[NUM_LEVELS + 1] = m_levelOffsets[NUM_LEVELS] + m_stats.m_impostors;
+
+	m_stats.m_trianglesSubmitted = 2 * static_cast<uint64_t>(m_stats.m_impostors);
+	for (uint32_t level = 0; level < NUM_LEVELS; level++)
+		m_stats.m_trianglesSubmitted += static_cast<uint64_t>(m_stats.m_instancesPerLevel[level]) * m_levelTriangles[level];
+
+	m_stats.m_trianglesWithoutLOD = static_cast<uint64_t>(num_visible) * m_levelTriangles[0];
+	return m_levelOffsets[NUM_LEVELS + 1];
+}
+
+void LODSelector::scatterInstances(const InstanceData* instances, const uint32_t* visible_indices, InstanceData* binned)
+{
+	const uint32_t NUM_LEVELS = this->getNumLevels();
+	const uint32_t NUM_VISIBLE = static_cast<uint32_t>(m_visibleLevels.size());
+
+	// A counting sort into each level's run that keeps the visible order within each level, the impostors going after
+	// the last level
+	m_writeOffsets.assign(m_levelOffsets.begin(), m_levelOffsets.end() - 1);
+	for (uint32_t visible = 0; visible < NUM_VISIBLE; visible++)
+	{
+		const InstanceData& INSTANCE = instances[visible_indices[visible]];
+		const uint32_t LEVEL = m_visibleLevels[visible];
+
+		binned[m_writeOffsets[LEVEL]++] = INSTANCE;
+		if (m_visibleFading[visible])
+			binned[m_writeOffsets[NUM_LEVELS]++] = INSTANCE;
+	}
+}
+
+void LODSelector::binInstances(const InstanceData* instances, uint32_t num_instances, const uint32_t* visible_indices,
+	uint32_t num_visible, const glm::vec3& camera_pos, float pixels_per_unit, InstanceData* binned)
+{
+	this->selectLevels(instances, num_instances, visible_indices, num_visible, camera_pos, pixels_per_unit);
+	this->scatterInstances(instances, visible_indices, binned);
+}
+
+uint32_t LODSelector::getNumLevels() const
+{
+	return static_cast<uint32_t>(m_levelOffsets.size()) - 2;
+}
+
+const std::vector<uint32_t>& LODSelector::getLevelOffsets() const
+{
+	return m_levelOffsets;
+}
+
+const LODStats& LODSelector::getStats() const
+{
+	return m_stats;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include "Engine/Simulation/TransformKernels.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+struct LODStats
+{
+	std::vector<uint32_t> m_instancesPerLevel; // Instances binned into each level by the last selection
+	uint32_t m_impostors = 0; // Instances drawn as impostors, including the ones fading across
+	uint32_t m_crossFading = 0; // Instances drawn both ways while they fade from one to the other
+	uint64_t m_trianglesSubmitted = 0; // Counting two per impostor quad
+	uint64_t m_trianglesWithoutLOD = 0; // What the same instances would have cost at full detail
+};
+
+// Picks a level of detail for every visible instance from its projected size on screen, and bins the instances by
+// level so each level can be drawn with a single instanced call. A level is used once its error bound projects to less
+// than the pixel tolerance. Switching only happens a set fraction past that size, so instances sitting right on a
+// switch distance don't flicker between levels.
+//
+// Past the impostor distance instances get drawn as impostors instead, binned after the last level. Across the fade
+// band before that distance they're binned both ways, so the shaders can dither from one to the other
+class LODSelector
+{
+private:
+	std::vector<float> m_switchRadii; // Projected radius in pixels below which level N switches to level N + 1
+	std::vector<uint32_t> m_levelTriangles;
+	float m_modelRadius, m_hysteresis;
+	float m_impostorStart, m_impostorEnd; // Distances the fade to impostors starts and ends at
+
+	std::vector<uint8_t> m_instanceLevels; // Level each instance was drawn with last time, by instance index
+	std::vector<uint8_t> m_visibleLevels; // Level of every visible instance picked by the last selection, the number of levels if drawn as an impostor only
+	std::vector<uint8_t> m_visibleFading; // Whether each visible instance is drawn as an impostor too
+	std::vector<uint32_t> m_levelOffsets; // Where each level starts in the binned instances, then the impostors, then the total
+	std::vector<uint32_t> m_writeOffsets;
+	LODStats m_stats;
+public:
+	LODSelector(const std::vector<float>& level_errors, const std::vector<uint32_t>& level_triangles, float model_radius,
+		float pixel_tolerance = 1.0f, float hysteresis = 0.15f);
+	~LODSelector();
+
+	void setImpostorRange(float fade_start, float fade_end); // Sets the distances instances fade into impostors across (off by default)
+
+	// selectLevels() : Picks the level of each visible instance, and whether it's drawn as an impostor, and returns the
+	// number of instances that get binned. pixels_per_unit is the size in pixels of one unit at a distance of one unit
+	// (projection[1][1] * half the height)
+	uint32_t selectLevels(const InstanceData* instances, uint32_t num_instances, const uint32_t* visible_indices,
+		uint32_t num_visible, const glm::vec3& camera_pos, float pixels_per_unit);
+
+	// scatterInstances() : Copies the instances of the last selection to the binned array (which must fit as many as it
+	// returned), grouped by level from the finest to the coarsest then the impostors, in visible order within each
+	void scatterInstances(const InstanceData* instances, const uint32_t* visible_indices, InstanceData* binned);
+
+	// binInstances() : Selects and scatters in one go, for callers that know the binned array fits the visible instances
+	// twice over (or that draw no impostors, when it only has to fit them once)
+	void binInstances(const InstanceData* instances, uint32_t num_instances, const uint32_t* visible_indices,
+		uint32_t num_visible, const glm::vec3& camera_pos, float pixels_per_unit, InstanceData* binned);
+public:
+	uint32_t getNumLevels() const; // Returns the number of levels instances are binned into
+	const std::vector<uint32_t>& getLevelOffsets() const; // Returns where each level (then the impostors) starts in the binned instances
+	const LODStats& getStats() const; // Returns the counters of the last selection
+};
\ No newline at end of file
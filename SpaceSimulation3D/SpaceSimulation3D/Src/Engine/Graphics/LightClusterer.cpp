@@ -0,0 +1,249 @@
+#include "LightClusterer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr uint32_t BOUND_GRAIN_SIZE = 256;
+	constexpr uint32_t MAX_CLUSTERED_LIGHTS = 65536; // Light indices are stored as 16 bits
+
+	// Returns the tile a normalized device coordinate falls in, clamped onto the grid
+	uint32_t getTile(float ndc, uint32_t num_tiles)
+	{
+		const float TILE = std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(num_tiles));
+		return static_cast<uint32_t>(std::min(std::max(TILE, 0.0f), static_cast<float>(num_tiles - 1)));
+	}
+}
+
+LightClusterer::LightClusterer(uint32_t grid_x, uint32_t grid_y, uint32_t grid_z, float near_plane, float far_plane) :
+	m_gridX(grid_x), m_gridY(grid_y), m_gridZ(grid_z), m_nearPlane(near_plane), m_farPlane(far_plane),
+	m_projectionScale(0.0f)
+{
+	m_sliceScale = static_cast<float>(m_gridZ) / std::log(m_farPlane / m_nearPlane);
+	m_sliceBias = -std::log(m_nearPlane) * m_sliceScale;
+
+	const uint32_t NUM_CLUSTERS = this->getNumClusters();
+	m_clusterMin.resize(NUM_CLUSTERS);
+	m_clusterMax.resize(NUM_CLUSTERS);
+	m_clusterScratch.resize(static_cast<size_t>(NUM_CLUSTERS) * MAX_LIGHTS_PER_CLUSTER);
+	m_clusterCounts.resize(NUM_CLUSTERS, 0);
+	m_sliceDropped.resize(m_gridZ, 0);
+	m_clusterRanges.resize(NUM_CLUSTERS * 2, 0);
+}
+
+LightClusterer::~LightClusterer() {}
+
+void LightClusterer::runRanges(uint32_t count, uint32_t grain_size,
+	const std::function<void(uint32_t, uint32_t)>& task) const
+{
+	if (m_jobSystem)
+		m_jobSystem->parallelFor(0, count, grain_size, task);
+	else
+		task(0, count);
+}
+
+void LightClusterer::buildClusterBounds(const glm::mat4& projection)
+{
+	m_projectionScale = glm::vec2(projection[0][0], projection[1][1]);
+
+	// A point at view depth d and normalized device coordinate n lies n * d / scale from the view axis, so the
+	// corners of each tile at the near and far depth of the slice bound the cluster
+	for (uint32_t slice = 0; slice < m_gridZ; slice++)
+	{
+		const float NEAR_DEPTH = m_nearPlane * std::pow(m_farPlane / m_nearPlane, static_cast<float>(slice) / m_gridZ);
+		const float FAR_DEPTH = m_nearPlane * std::pow(m_farPlane / m_nearPlane, static_cast<float>(slice + 1) /
+			m_gridZ);
+
+		for (uint32_t tileY = 0; tileY < m_gridY; tileY++)
+		{
+			const float BOTTOM = -1.0f + 2.0f * tileY / m_gridY, TOP = -1.0f + 2.0f * (tileY + 1) / m_gridY;
+			for (uint32_t tileX = 0; tileX < m_gridX; tileX++)
+			{
+				const float LEFT = -1.0f + 2.0f * tileX / m_gridX, RIGHT = -1.0f + 2.0f * (tileX + 1) / m_gridX;
+				const uint32_t CLUSTER = (slice * m_gridY + tileY) * m_gridX + tileX;
+
+				m_clusterMin[CLUSTER] = glm::vec3(std::min(LEFT * NEAR_DEPTH, LEFT * FAR_DEPTH) / m_projectionScale.x,
+					std::min(BOTTOM * NEAR_DEPTH, BOTTOM * FAR_DEPTH) / m_projectionScale.y, -FAR_DEPTH);
+				m_clusterMax[CLUSTER] = glm::vec3(std::max(RIGHT * NEAR_DEPTH, RIGHT * FAR_DEPTH) / m_projectionScale.x,
+					std::max(TOP * NEAR_DEPTH, TOP * FAR_DEPTH) / m_projectionScale.y, -NEAR_DEPTH);
+			}
+		}
+	}
+}
+
+void LightClusterer::boundLights(const PointLight* lights, uint32_t begin, uint32_t end, const glm::mat4& view)
+{
+	for (uint32_t index = begin; index < end; index++)
+	{
+		LightBounds& bounds = m_lightBounds[index];
+		bounds.m_center = glm::vec3(view * glm::vec4(lights[index].m_position, 1.0f));
+		bounds.m_radius = lights[index].m_radius;
+
+		const float DEPTH = -bounds.m_center.z;
+		bounds.m_visible = bounds.m_radius > 0.0f && DEPTH + bounds.m_radius > m_nearPlane &&
+			DEPTH - bounds.m_radius < m_farPlane;
+		if (!bounds.m_visible)
+			continue;
+
+		// The sphere's screen extent is widest on the side facing the view axis at its nearest depth, and on the
+		// other side at its furthest depth
+		const float NEAREST_DEPTH = std::max(DEPTH - bounds.m_radius, m_nearPlane);
+		const float FURTHEST_DEPTH = DEPTH + bounds.m_radius;
+
+		const float MIN_X = bounds.m_center.x - bounds.m_radius, MAX_X = bounds.m_center.x + bounds.m_radius;
+		const float MIN_Y = bounds.m_center.y - bounds.m_radius, MAX_Y = bounds.m_center.y + bounds.m_radius;
+		const float NDC_MIN_X = MIN_X * m_projectionScale.x / (MIN_X < 0.0f ? NEAREST_DEPTH : FURTHEST_DEPTH);
+		const float NDC_MAX_X = MAX_X * m_projectionScale.x / (MAX_X > 0.0f ? NEAREST_DEPTH : FURTHEST_DEPTH);
+		const float NDC_MIN_Y = MIN_Y * m_projectionScale.y / (MIN_Y < 0.0f ? NEAREST_DEPTH : FURTHEST_DEPTH);
+		const float NDC_MAX_Y = MAX_Y * m_projectionScale.y / (MAX_Y > 0.0f ? NEAREST_DEPTH : FURTHEST_DEPTH);
+
+		if (NDC_MAX_X < -1.0f || NDC_MIN_X > 1.0f || NDC_MAX_Y < -1.0f || NDC_MIN_Y > 1.0f)
+		{
+			bounds.m_visible = false;
+			continue;
+		}
+
+		bounds.m_minX = getTile(NDC_MIN_X, m_gridX);
+		bounds.m_maxX = getTile(NDC_MAX_X, m_gridX);
+		bounds.m_minY = getTile(NDC_MIN_Y, m_gridY);
+		bounds.m_maxY = getTile(NDC_MAX_Y, m_gridY);
+		bounds.m_minZ = this->getSlice(NEAREST_DEPTH);
+		bounds.m_maxZ = this->getSlice(std::min(FURTHEST_DEPTH, m_farPlane));
+	}
+}
+
+void LightClusterer::assignSlice(uint32_t slice)
+{
+	const uint32_t FIRST_CLUSTER = slice * m_gridX * m_gridY;
+	std::fill(m_clusterCounts.begin() + FIRST_CLUSTER, m_clusterCounts.begin() + FIRST_CLUSTER + m_gridX * m_gridY, 0);
+
+	uint32_t numDropped = 0;
+	const uint32_t NUM_LIGHTS = static_cast<uint32_t>(m_lightBounds.size());
+
+	for (uint32_t index = 0; index < NUM_LIGHTS; index++)
+	{
+		const LightBounds& BOUNDS = m_lightBounds[index];
+		if (!BOUNDS.m_visible || slice < BOUNDS.m_minZ || slice > BOUNDS.m_maxZ)
+			continue;
+
+		// The tile range is conservative, so each cluster in it still gets a sphere against box test
+		const float RADIUS_SQUARED = BOUNDS.m_radius * BOUNDS.m_radius;
+		for (uint32_t tileY = BOUNDS.m_minY; tileY <= BOUNDS.m_maxY; tileY++)
+		{
+			for (uint32_t tileX = BOUNDS.m_minX; tileX <= BOUNDS.m_maxX; tileX++)
+			{
+				const uint32_t CLUSTER = FIRST_CLUSTER + tileY * m_gridX + tileX;
+				const glm::vec3 CLOSEST = glm::max(m_clusterMin[CLUSTER], glm::min(BOUNDS.m_center,
+					m_clusterMax[CLUSTER]));
+				const glm::vec3 OFFSET = BOUNDS.m_center - CLOSEST;
+				if (glm::dot(OFFSET, OFFSET) > RADIUS_SQUARED)
+					continue;
+
+				uint32_t& count = m_clusterCounts[CLUSTER];
+				if (count < MAX_LIGHTS_PER_CLUSTER)
+					m_clusterScratch[static_cast<size_t>(CLUSTER) * MAX_LIGHTS_PER_CLUSTER + count++] =
+						static_cast<uint16_t>(index);
+				else
+					numDropped++;
+			}
+		}
+	}
+
+	m_sliceDropped[slice] = numDropped;
+}
+
+uint32_t LightClusterer::getSlice(float view_depth) const
+{
+	const float SLICE = std::floor(std::log(view_depth) * m_sliceScale + m_sliceBias);
+	return static_cast<uint32_t>(std::min(std::max(SLICE, 0.0f), static_cast<float>(m_gridZ - 1)));
+}
+
+void LightClusterer::setJobSystem(std::shared_ptr<JobSystem> job_system)
+{
+	m_jobSystem = job_system;
+}
+
+void LightClusterer::assignLights(const PointLight* lights, uint32_t num_lights, const glm::mat4& view,
+	const glm::mat4& projection)
+{
+	if (projection[0][0] != m_projectionScale.x || projection[1][1] != m_projectionScale.y)
+		this->buildClusterBounds(projection);
+
+	const uint32_t NUM_LIGHTS = std::min(num_lights, MAX_CLUSTERED_LIGHTS);
+	m_lightBounds.resize(NUM_LIGHTS);
+	this->runRanges(NUM_LIGHTS, BOUND_GRAIN_SIZE, [this, lights, &view](uint32_t begin, uint32_t end)
+	{
+		this->boundLights(lights, begin, end, view);
+	});
+
+	// Every slice only writes its own clusters, so the slices can fill their lists side by side
+	this->runRanges(m_gridZ, 1, [this](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t slice = begin; slice < end; slice++)
+			this->assignSlice(slice);
+	});
+
+	m_stats = ClusterStats();
+	m_stats.m_numLights = num_lights;
+
+	for (const LightBounds& BOUNDS : m_lightBounds)
+		m_stats.m_visibleLights += BOUNDS.m_visible ? 1 : 0;
+
+	for (uint32_t dropped : m_sliceDropped)
+		m_stats.m_droppedAssignments += dropped;
+
+	// Pack the lists one after another, the offset of each cluster being the sum of the counts before it
+	const uint32_t NUM_CLUSTERS = this->getNumClusters();
+	for (uint32_t cluster = 0; cluster < NUM_CLUSTERS; cluster++)
+	{
+		const uint32_t COUNT = m_clusterCounts[cluster];
+		m_clusterRanges[cluster * 2] = m_stats.m_numAssignments;
+		m_clusterRanges[cluster * 2 + 1] = COUNT;
+
+		m_stats.m_numAssignments += COUNT;
+		m_stats.m_occupiedClusters += COUNT > 0 ? 1 : 0;
+		m_stats.m_maxLightsPerCluster = std::max(m_stats.m_maxLightsPerCluster, COUNT);
+	}
+
+	m_lightIndices.resize(m_stats.m_numAssignments);
+	this->runRanges(m_gridZ, 1, [this](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t cluster = begin * m_gridX * m_gridY; cluster < end * m_gridX * m_gridY; cluster++)
+		{
+			const uint16_t* LIST = &m_clusterScratch[static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER];
+			std::copy(LIST, LIST + m_clusterCounts[cluster], m_lightIndices.begin() + m_clusterRanges[cluster * 2]);
+		}
+	});
+}
+
+ClusterGridParams LightClusterer::getGridParams(float viewport_width, float viewport_height) const
+{
+	ClusterGridParams params;
+	params.m_gridSize = glm::uvec3(m_gridX, m_gridY, m_gridZ);
+	params.m_sliceScale = m_sliceScale;
+	params.m_sliceBias = m_sliceBias;
+	params.m_tileScale = glm::vec2(m_gridX / viewport_width, m_gridY / viewport_height);
+
+	return params;
+}
+
+const std::vector<uint32_t>& LightClusterer::getClusterRanges() const
+{
+	return m_clusterRanges;
+}
+
+const std::vector<uint16_t>& LightClusterer::getLightIndices() const
+{
+	return m_lightIndices;
+}
+
+const ClusterStats& LightClusterer::getStats() const
+{
+	return m_stats;
+}
+
+uint32_t LightClusterer::getNumClusters() const
+{
+	return m_gridX * m_gridY * m_gridZ;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+#include "Engine/Graphics/SceneLighting.h"
+#include "Engine/Utils/JobSystem.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 256; // Lights past this many in one cluster are left out of it
+
+struct ClusterStats
+{
+	uint32_t m_numLights = 0; // Lights given to the last assignment
+	uint32_t m_visibleLights = 0; // Lights reaching at least one cluster
+	uint32_t m_numAssignments = 0; // Light indices written across every cluster
+	uint32_t m_occupiedClusters = 0; // Clusters reached by at least one light
+	uint32_t m_maxLightsPerCluster = 0;
+	uint32_t m_droppedAssignments = 0; // Lights left out of clusters that were already full
+};
+
+// Splits the view frustum into a grid of clusters (screen tiles across, exponential slices in depth) and lists the
+// point lights reaching each one, so a fragment only loops over the lights of its own cluster instead of all of them.
+// Each depth slice is assigned on its own job, writing only its own clusters, then the per-cluster lists get packed
+// into one index list with an (offset, count) range per cluster for the shaders to read.
+//
+// The bounds assume a symmetric perspective projection (as glm::perspective builds). Lights past the far plane of the
+// grid are left out, and fragments past it use the lights of the last slice
+class LightClusterer
+{
+private:
+	// A light in view space, with the range of clusters its bounding sphere may overlap
+	struct LightBounds
+	{
+		glm::vec3 m_center;
+		float m_radius;
+		uint32_t m_minX, m_maxX, m_minY, m_maxY, m_minZ, m_maxZ;
+		bool m_visible;
+	};
+
+	std::shared_ptr<JobSystem> m_jobSystem;
+	uint32_t m_gridX, m_gridY, m_gridZ;
+	float m_nearPlane, m_farPlane;
+	float m_sliceScale, m_sliceBias; // Depth slice = log(view depth) * scale + bias
+	glm::vec2 m_projectionScale; // Diagonal x and y terms of the projection the cluster bounds were built for
+
+	std::vector<glm::vec3> m_clusterMin, m_clusterMax; // View space bounds of every cluster
+	std::vector<LightBounds> m_lightBounds;
+	std::vector<uint16_t> m_clusterScratch; // MAX_LIGHTS_PER_CLUSTER slots per cluster, filled by the slice jobs
+	std::vector<uint32_t> m_clusterCounts, m_sliceDropped;
+
+	std::vector<uint32_t> m_clusterRanges; // Offset and count into the light indices for every cluster
+	std::vector<uint16_t> m_lightIndices;
+	ClusterStats m_stats;
+private:
+	void runRanges(uint32_t count, uint32_t grain_size, const std::function<void(uint32_t, uint32_t)>& task) const; // Splits the loop across the job system, if one is set
+	void buildClusterBounds(const glm::mat4& projection); // Works out the view space bounds of every cluster
+	void boundLights(const PointLight* lights, uint32_t begin, uint32_t end, const glm::mat4& view); // Finds the cluster range of each light
+	void assignSlice(uint32_t slice); // Lists the lights overlapping each cluster of the depth slice
+
+	uint32_t getSlice(float view_depth) const; // Returns the depth slice the view depth falls in
+public:
+	LightClusterer(uint32_t grid_x, uint32_t grid_y, uint32_t grid_z, float near_plane, float far_plane);
+	~LightClusterer();
+
+	void setJobSystem(std::shared_ptr<JobSystem> job_system); // Sets the job system the assignment is split across (nullptr = serial)
+
+	// assignLights() : Rebuilds the light lists of every cluster for the given camera (lights past the first 65536 are ignored)
+	void assignLights(const PointLight* lights, uint32_t num_lights, const glm::mat4& view, const glm::mat4& projection);
+public:
+	ClusterGridParams getGridParams(float viewport_width, float viewport_height) const; // Returns what the shaders need to find a fragment's cluster
+	const std::vector<uint32_t>& getClusterRanges() const; // Returns the (offset, count) of every cluster's lights
+	const std::vector<uint16_t>& getLightIndices() const; // Returns the lights of every cluster, one after another
+	const ClusterStats& getStats() const; // Returns the stats of the last assignment
+	uint32_t getNumClusters() const; // Returns the number of clusters in the grid
+};
\ No newline at end of file
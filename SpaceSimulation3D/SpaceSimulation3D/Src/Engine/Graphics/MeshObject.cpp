@@ -1,71 +1,238 @@
 #include "MeshObject.h"
+#include "Engine/Graphics/VertexQuantizer.h"
 #include <glad/glad.h>
+#include <algorithm>
+
+static_assert(sizeof(MaterialBlock) == 48, "MaterialBlock has to match the std140 layout of the Material block");
 
 MeshObject::MeshObject(const std::vector<VertexData>& vertices, const std::vector<uint32_t>& indices,
-	const Material& material, const void* instances_array, uint32_t num_instances) :
-	m_numIndices(indices.size()), m_material(material), m_instanced(false), m_numInstances(num_instances)
-{
-	// Setup the mesh's VBO and IBO
-	auto meshVBO = std::make_shared<VertexBuffer>(&vertices[0], sizeof(VertexData) * vertices.size(), 
-		GL_STATIC_DRAW);
-	auto meshIBO = std::make_shared<IndexBuffer>(&indices[0], sizeof(uint32_t) * indices.size(), GL_STATIC_DRAW);
-
-	// Finally setup the mesh's VAO
-	m_vao = std::make_shared<VertexArray>();
-	m_vao->pushLayout<float>(0, 3, sizeof(VertexData));
-	m_vao->pushLayout<float>(1, 3, sizeof(VertexData), offsetof(VertexData, m_normalPos));
-	m_vao->pushLayout<float>(2, 2, sizeof(VertexData), offsetof(VertexData, m_texturePos));
-	m_vao->attachBufferObjects(meshVBO, meshIBO);
-
-	if (instances_array)
+	const Material& material, const void* instances_array, uint32_t num_instances,
+	const std::vector<uint32_t>& lod_index_counts, VertexFormat vertex_format) :
+	m_instanceCapacity(num_instances), m_instanced(instances_array != nullptr), m_vertexFormat(vertex_format),
+	m_vertexBytes(0), m_material(material), m_materialOffset(0), m_materialID(RenderQueue::generateMaterialID())
+{
+	// Copy the vertices and indices into the pool of the vertex format, quantizing the vertices first if asked to
+	m_pool = GeometryPool::getPool(m_vertexFormat);
+	if (m_vertexFormat == VertexFormat::QUANTIZED)
+	{
+		std::vector<QuantizedVertexData> quantized;
+		m_quantization = VertexQuantizer::quantizeVertices(vertices, quantized);
+		m_vertexBytes = sizeof(QuantizedVertexData) * quantized.size();
+		m_geometry = GeometryPool::allocate(m_pool, quantized.data(), static_cast<uint32_t>(quantized.size()), indices);
+	}
+	else
 	{
-		m_instanced = true;
+		m_vertexBytes = sizeof(VertexData) * vertices.size();
+		m_geometry = GeometryPool::allocate(m_pool, vertices.data(), static_cast<uint32_t>(vertices.size()), indices);
+	}
+
+	// Only instanced meshes can draw more than one level at a time
+	std::vector<uint32_t> indexCounts = lod_index_counts;
+	if (indexCounts.empty() || !m_instanced)
+		indexCounts = { lod_index_counts.empty() ? static_cast<uint32_t>(indices.size()) : lod_index_counts[0] };
 
-		auto instancedBuffer = std::make_shared<VertexBuffer>(instances_array, sizeof(glm::mat4) * num_instances,
-			GL_STATIC_DRAW);
+	const InstanceLayout LAYOUT = m_instanced ? InstanceLayout::INSTANCES : InstanceLayout::TRANSFORMS;
+	uint32_t firstIndex = 0;
+	for (uint32_t level = 0; level < indexCounts.size(); level++)
+	{
+		MeshLOD lod;
+		lod.m_vao = m_pool->getVertexArray(m_geometry->m_page, LAYOUT);
+		lod.m_firstIndex = firstIndex;
+		lod.m_numIndices = indexCounts[level];
+		lod.m_numInstances = m_instanced ? (level == 0 ? num_instances : 0) : 1;
+		lod.m_instanceSource = m_pool->getIdentityBuffer();
+		lod.m_instanceOffset = 0;
+		firstIndex += indexCounts[level];
+
+		if (m_instanced)
+		{
+			lod.m_instanceVBO = std::make_shared<VertexBuffer>(level == 0 ? instances_array : nullptr,
+				sizeof(InstanceData) * num_instances, GL_DYNAMIC_DRAW);
+			lod.m_instanceSource = lod.m_instanceVBO->getID();
+		}
 
-		m_vao->pushLayout<float>(3, 4, sizeof(glm::mat4), 0, 1);
-		m_vao->pushLayout<float>(4, 4, sizeof(glm::mat4), sizeof(glm::vec4), 1);
-		m_vao->pushLayout<float>(5, 4, sizeof(glm::mat4), sizeof(glm::vec4) * 2, 1);
-		m_vao->pushLayout<float>(6, 4, sizeof(glm::mat4), sizeof(glm::vec4) * 3, 1);
-		m_vao->attachBufferObjects(instancedBuffer);
+		m_lods.emplace_back(lod);
 	}
 }
 
 MeshObject::~MeshObject() {}
 
-void MeshObject::render(std::shared_ptr<ShaderProgram> shader) const
+void MeshObject::updateInstances(const void* instances_array, uint32_t num_instances)
 {
-	shader->setUniform("mat.shininess", m_material.shininess);
+	if (!m_instanced)
+		return;
 
-	if (m_material.m_textures.empty())
+	// The instance buffer can't grow, so never write past the amount of instances it was created with
+	for (auto& lod : m_lods)
 	{
-		// Assign the ordinary phong component vector values in shaders
-		shader->setUniform("mat.ambient", m_material.m_ambient);
-		shader->setUniform("mat.diffuse", m_material.m_diffuse);
-		shader->setUniform("mat.specular", m_material.m_specular);
-		shader->setUniform("mat.useTextures", false);
+		lod.m_numInstances = 0;
+		lod.m_instanceSource = lod.m_instanceVBO->getID();
+		lod.m_instanceOffset = 0;
 	}
-	else
+
+	MeshLOD& fullDetail = m_lods.front();
+	fullDetail.m_numInstances = std::min(num_instances, m_instanceCapacity);
+	fullDetail.m_instanceVBO->modifyData(instances_array, 0, sizeof(InstanceData) * fullDetail.m_numInstances);
+}
+
+void MeshObject::updateLODInstances(const void* instances_array, const uint32_t* level_offsets)
+{
+	if (!m_instanced)
+		return;
+
+	for (uint32_t level = 0; level < m_lods.size(); level++)
 	{
-		// Bind the respective diffuse and specular textures
-		shader->setUniform("mat.useTextures", true);
-		int numDiffuse = 0, numSpecular = 0;
+		MeshLOD& lod = m_lods[level];
+		lod.m_numInstances = std::min(level_offsets[level + 1] - level_offsets[level], m_instanceCapacity);
+		lod.m_instanceSource = lod.m_instanceVBO->getID();
+		lod.m_instanceOffset = 0;
 
-		for (uint32_t index = 0; index < m_material.m_textures.size(); index++)
-		{
-			const auto& TEXTURE_DATA = m_material.m_textures[index];
+		if (lod.m_numInstances > 0)
+			lod.m_instanceVBO->modifyData(static_cast<const InstanceData*>(instances_array) + level_offsets[level], 0,
+				sizeof(InstanceData) * lod.m_numInstances);
+	}
+}
 
-			if (TEXTURE_DATA.m_type == "DIFFUSE_TEXTURE")
-				TEXTURE_DATA.m_texture->bind(shader, "mat.diffuseTexture" + std::to_string(numDiffuse++), index);
-			else if (TEXTURE_DATA.m_type == "SPECULAR_TEXTURE")
-				TEXTURE_DATA.m_texture->bind(shader, "mat.specularTexture" + std::to_string(numSpecular++), index);
-		}
+void MeshObject::setLODInstanceSource(uint32_t buffer_id, GLintptr offset, const uint32_t* level_offsets)
+{
+	if (!m_instanced)
+		return;
+
+	// Nothing gets copied, the levels just read from their part of the other buffer
+	for (uint32_t level = 0; level < m_lods.size(); level++)
+	{
+		MeshLOD& lod = m_lods[level];
+		lod.m_numInstances = level_offsets[level + 1] - level_offsets[level];
+		lod.m_instanceSource = buffer_id;
+		lod.m_instanceOffset = offset + static_cast<GLintptr>(sizeof(InstanceData)) * level_offsets[level];
 	}
+}
 
-	m_vao->bind();
-	if(!m_instanced)
-		glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, nullptr);
-	else
-		glDrawElementsInstanced(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, nullptr, m_numInstances);
+void MeshObject::setMaterialBuffer(std::shared_ptr<UniformBuffer> buffer, GLintptr offset)
+{
+	m_materialBuffer = buffer;
+	m_materialOffset = offset;
+}
+
+void MeshObject::submit(RenderQueue& queue, RenderCommand command, float depth, const uint32_t* level_offsets) const
+{
+	command.m_type = DrawType::MESH;
+	command.m_mesh = this;
+	command.m_material = m_materialID;
+	command.m_batchable = !m_instanced;
+
+	for (uint32_t level = 0; level < m_lods.size(); level++)
+	{
+		const uint32_t NUM_INSTANCES = level_offsets ? level_offsets[level + 1] - level_offsets[level] :
+			m_lods[level].m_numInstances;
+		if (m_instanced && NUM_INSTANCES == 0)
+			continue;
+
+		command.m_level = level;
+		command.m_vao = m_lods[level].m_vao->getID();
+		queue.submit(command, RenderPass::SOLID, depth);
+	}
+}
+
+void MeshObject::bindMaterial(const ShaderProgram& shader, const MeshUniforms& uniforms) const
+{
+	// Unquantized meshes keep the identity mapping, so the shaders can decode every mesh the same way
+	shader.setUniform(uniforms.m_positionOffset, m_quantization.m_positionOffset);
+	shader.setUniform(uniforms.m_positionScale, m_quantization.m_positionScale);
+
+	if (m_materialBuffer)
+		m_materialBuffer->setBindingPoint(MATERIAL_BLOCK_BINDING, m_materialOffset, sizeof(MaterialBlock));
+
+	// Bind the respective diffuse and specular textures
+	uint32_t numOfType[NUM_TEXTURE_TYPES] = {};
+	for (uint32_t index = 0; index < m_material.m_textures.size(); index++)
+	{
+		const auto& TEXTURE_DATA = m_material.m_textures[index];
+		const uint32_t TYPE = static_cast<uint32_t>(TEXTURE_DATA.m_type);
+
+		if (numOfType[TYPE] < MAX_TEXTURES_PER_TYPE)
+			TEXTURE_DATA.m_texture->bind(shader, uniforms.m_samplers[TYPE][numOfType[TYPE]++], index);
+	}
+}
+
+const void* MeshObject::getIndexOffset(const MeshLOD& lod) const
+{
+	return reinterpret_cast<const void*>(sizeof(uint32_t) * (static_cast<size_t>(m_geometry->m_firstIndex) +
+		lod.m_firstIndex));
+}
+
+void MeshObject::drawLevel(uint32_t level) const
+{
+	const MeshLOD& LOD = m_lods[level];
+	if (LOD.m_numInstances > 0)
+	{
+		LOD.m_vao->setInstanceSource(LOD.m_instanceSource, LOD.m_instanceOffset);
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, LOD.m_numIndices, GL_UNSIGNED_INT, this->getIndexOffset(LOD),
+			LOD.m_numInstances, m_geometry->m_baseVertex);
+	}
+}
+
+void MeshObject::drawTransforms(uint32_t level, uint32_t buffer_id, GLintptr offset, uint32_t num_transforms) const
+{
+	if (m_instanced || num_transforms == 0)
+		return;
+
+	const MeshLOD& LOD = m_lods[level];
+	LOD.m_vao->setInstanceSource(buffer_id, offset);
+	glDrawElementsInstancedBaseVertex(GL_TRIANGLES, LOD.m_numIndices, GL_UNSIGNED_INT, this->getIndexOffset(LOD),
+		num_transforms, m_geometry->m_baseVertex);
+}
+
+void MeshObject::renderSingle(std::shared_ptr<ShaderProgram> shader, const MeshUniforms& uniforms) const
+{
+	this->bindMaterial(*shader, uniforms);
+
+	// The instance attribs stay enabled in the vao, the shader just doesn't read them
+	const MeshLOD& FULL_DETAIL = m_lods.front();
+	FULL_DETAIL.m_vao->bind();
+	glDrawElementsBaseVertex(GL_TRIANGLES, FULL_DETAIL.m_numIndices, GL_UNSIGNED_INT, this->getIndexOffset(FULL_DETAIL),
+		m_geometry->m_baseVertex);
+}
+
+MaterialBlock MeshObject::getMaterialBlock() const
+{
+	MaterialBlock block = {};
+	block.m_ambient = m_material.m_ambient;
+	block.m_diffuse = m_material.m_diffuse;
+	block.m_specular = m_material.m_specular;
+	block.m_shininess = m_material.shininess;
+	block.m_useTextures = m_material.m_textures.empty() ? 0 : 1;
+
+	return block;
+}
+
+MeshUniforms MeshObject::getMeshUniforms(const ShaderProgram& shader)
+{
+	MeshUniforms uniforms;
+	const char* SAMPLER_NAMES[NUM_TEXTURE_TYPES] = { "diffuseTexture", "specularTexture" };
+
+	for (uint32_t type = 0; type < NUM_TEXTURE_TYPES; type++)
+	{
+		for (uint32_t index = 0; index < MAX_TEXTURES_PER_TYPE; index++)
+			uniforms.m_samplers[type][index] = shader.getUniformHandle(SAMPLER_NAMES[type] + std::to_string(index));
+	}
+
+	uniforms.m_positionOffset = shader.getUniformHandle("positionOffset");
+	uniforms.m_positionScale = shader.getUniformHandle("positionScale");
+	return uniforms;
+}
+
+VertexFormat MeshObject::getVertexFormat() const
+{
+	return m_vertexFormat;
+}
+
+size_t MeshObject::getVertexBytes() const
+{
+	return m_vertexBytes;
+}
+
+const QuantizationStats& MeshObject::getQuantization() const
+{
+	return m_quantization;
 }
\ No newline at end of file
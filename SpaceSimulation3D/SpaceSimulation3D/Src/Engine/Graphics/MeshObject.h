@@ -1,24 +1,58 @@
 #pragma once
 #include "Engine/Buffers/VertexArrays.h"
+#include "Engine/Graphics/GeometryPool.h"
 #include "Engine/Graphics/TextureComponent.h"
+#include "Engine/Graphics/RenderQueue.h"
+#include "Engine/Simulation/TransformKernels.h"
 
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
 
-struct VertexData
+// Maps the stored positions back to model space (offset + scale * stored value) and records how far the quantized
+// attributes ended up from the originals
+struct QuantizationStats
 {
-	glm::vec3 m_vertexPos;
-	glm::vec3 m_normalPos;
-	glm::vec2 m_texturePos;
+	glm::vec3 m_positionOffset = glm::vec3(0.0f), m_positionScale = glm::vec3(1.0f);
+
+	float m_maxPositionError = 0.0f; // In model units
+	float m_maxNormalError = 0.0f; // In degrees
+	float m_maxTextureError = 0.0f; // In texture coordinates
+};
+
+enum class TextureType
+{
+	DIFFUSE,
+	SPECULAR
 };
 
+constexpr uint32_t NUM_TEXTURE_TYPES = 2;
+constexpr uint32_t MAX_TEXTURES_PER_TYPE = 4; // Samplers of each type the material uniforms are looked up for
+
 struct TextureData
 {
-	std::string m_type;
+	TextureType m_type;
 	std::shared_ptr<TextureComponent> m_texture;
 };
 
+// Handles of the uniforms a mesh sets in a shader, looked up once per shader instead of by name every draw
+struct MeshUniforms
+{
+	UniformHandle m_samplers[NUM_TEXTURE_TYPES][MAX_TEXTURES_PER_TYPE]; // e.g. diffuseTexture0, by texture type
+	UniformHandle m_positionOffset, m_positionScale;
+};
+
+// Layout of the Material uniform block (std140), written once at load time
+struct MaterialBlock
+{
+	glm::vec3 m_ambient;
+	float m_shininess;
+	glm::vec3 m_diffuse;
+	int m_useTextures;
+	glm::vec3 m_specular;
+	float m_padding;
+};
+
 struct Material
 {
 	std::vector<TextureData> m_textures;
@@ -26,18 +60,78 @@ struct Material
 	float shininess;
 };
 
+// One level of detail of a mesh. Every level shares the mesh's vertices and the vao of its geometry pool page, which
+// gets pointed at the level's instances before each draw. Instanced levels get their own instance buffer, while
+// non-instanced meshes read a model matrix per instance, the pool's identity matrix unless the render queue points the
+// vao at the model matrices of a batch
+struct MeshLOD
+{
+	std::shared_ptr<VertexArray> m_vao; // Shared with every mesh of the page reading the same instance layout
+	std::shared_ptr<VertexBuffer> m_instanceVBO; // Instanced meshes only
+	uint32_t m_firstIndex, m_numIndices, m_numInstances;
+
+	uint32_t m_instanceSource; // Buffer the instances are read from, the level's own buffer unless streamed
+	GLintptr m_instanceOffset;
+};
+
 class MeshObject
 {
 private:
-	std::shared_ptr<VertexArray> m_vao;
-	uint32_t m_numIndices, m_numInstances;
+	std::vector<MeshLOD> m_lods;
+	uint32_t m_instanceCapacity;
 	bool m_instanced;
+
+	VertexFormat m_vertexFormat;
+	QuantizationStats m_quantization;
+	size_t m_vertexBytes; // Size of the vertices in the pool
+
+	std::shared_ptr<GeometryPool> m_pool;
+	std::shared_ptr<const GeometryAllocation> m_geometry; // Where the vertices and indices live in the pool, shared by the copies of the mesh
 	
 	Material m_material;
+	std::shared_ptr<UniformBuffer> m_materialBuffer; // Buffer holding the material block, bound by range per draw
+	GLintptr m_materialOffset;
+	uint32_t m_materialID; // Tells the material apart in the render queue
+private:
+	const void* getIndexOffset(const MeshLOD& lod) const; // Returns where the level's indices start in the pool's index buffer
 public:
+	// The levels of detail are stored one after another in the indices, lod_index_counts giving the amount of indices
+	// of each (none = the indices are a single level). The vertices are uploaded to the pool of the given vertex format
 	MeshObject(const std::vector<VertexData>& vertices, const std::vector<uint32_t>& indices,
-		const Material& material, const void* instances_array = nullptr, uint32_t num_instances = 0);
+		const Material& material, const void* instances_array = nullptr, uint32_t num_instances = 0,
+		const std::vector<uint32_t>& lod_index_counts = {}, VertexFormat vertex_format = VertexFormat::FULL);
 	~MeshObject();
 
-	void render(std::shared_ptr<ShaderProgram> shader) const;
+	void updateInstances(const void* instances_array, uint32_t num_instances); // Overwrites the per-instance transforms (InstanceData), drawn at full detail
+
+	// updateLODInstances() : Overwrites the per-instance transforms of every level, where the instances of level N
+	// are [level_offsets[N], level_offsets[N + 1]) of the array
+	void updateLODInstances(const void* instances_array, const uint32_t* level_offsets);
+
+	// setLODInstanceSource() : Draws the instances straight from another buffer instead, laid out like the array of
+	// updateLODInstances() starting at the given byte offset
+	void setLODInstanceSource(uint32_t buffer_id, GLintptr offset, const uint32_t* level_offsets);
+
+	void setMaterialBuffer(std::shared_ptr<UniformBuffer> buffer, GLintptr offset); // Sets where the material block was uploaded to
+
+	// submit() : Queues a draw of every level with any instances (just the one level if not instanced), each a copy of
+	// the command carrying the model's shader, uniforms and transform. Instanced meshes given the level offsets the frame's
+	// instances were binned with (see updateLODInstances()) count each level's instances from those instead of the
+	// instances the levels currently draw, which may still belong to the frame before
+	void submit(RenderQueue& queue, RenderCommand command, float depth, const uint32_t* level_offsets = nullptr) const;
+
+	void bindMaterial(const ShaderProgram& shader, const MeshUniforms& uniforms) const; // Sets the decoding uniforms and binds the material block and textures
+	void drawLevel(uint32_t level) const; // Draws the level with its instances, once the material is bound
+
+	// drawTransforms() : Draws the level once for each of the model matrices laid out in the buffer from the byte offset,
+	// once the material is bound (non-instanced meshes only)
+	void drawTransforms(uint32_t level, uint32_t buffer_id, GLintptr offset, uint32_t num_transforms) const;
+	void renderSingle(std::shared_ptr<ShaderProgram> shader, const MeshUniforms& uniforms) const; // Draws the full detail level once, ignoring the instances (e.g. to bake it)
+public:
+	MaterialBlock getMaterialBlock() const; // Returns the material laid out for the uniform block
+	VertexFormat getVertexFormat() const; // Returns the format the vertices were uploaded in
+	size_t getVertexBytes() const; // Returns the size of the vertices in bytes
+	const QuantizationStats& getQuantization() const; // Returns how the positions decode and the error of quantizing
+
+	static MeshUniforms getMeshUniforms(const ShaderProgram& shader); // Looks up the uniforms a mesh sets in the shader
 };
\ No newline at end of file
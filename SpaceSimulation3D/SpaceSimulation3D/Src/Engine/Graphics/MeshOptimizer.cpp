@@ -0,0 +1,455 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+	// Forsyth's scoring, tuned for an LRU cache of 32 vertices
+	constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f; // Kept below the most recent entries, so strips don't just reverse
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	constexpr uint32_t OVERDRAW_CACHE_SIZE = 16; // FIFO cache the overdraw clusters are measured against
+	constexpr int OVERDRAW_RESOLUTION = 256;
+
+	constexpr uint32_t VALENCE_TABLE_SIZE = 32; // Valences below this are looked up instead of computed
+
+	// Scores a vertex by how recently it entered the cache and how few triangles it has left, so lone triangles get
+	// picked up before they are stranded. Both terms come from tables, since every emitted triangle rescores the cache
+	class VertexScorer
+	{
+	private:
+		float m_cacheScores[FORSYTH_CACHE_SIZE];
+		float m_valenceScores[VALENCE_TABLE_SIZE];
+	public:
+		VertexScorer()
+		{
+			for (uint32_t position = 0; position < FORSYTH_CACHE_SIZE; position++)
+			{
+				const float DECAY = 1.0f - static_cast<float>(position - 3) / (FORSYTH_CACHE_SIZE - 3);
+				m_cacheScores[position] = position < 3 ? LAST_TRIANGLE_SCORE : std::pow(DECAY, CACHE_DECAY_POWER);
+			}
+
+			for (uint32_t valence = 1; valence < VALENCE_TABLE_SIZE; valence++)
+				m_valenceScores[valence] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(valence), -VALENCE_BOOST_POWER);
+			m_valenceScores[0] = 0.0f;
+		}
+
+		float scoreVertex(int cache_position, uint32_t remaining_triangles) const
+		{
+			if (remaining_triangles == 0)
+				return -1.0f;
+
+			const float VALENCE_SCORE = remaining_triangles < VALENCE_TABLE_SIZE ? m_valenceScores[remaining_triangles] :
+				VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining_triangles), -VALENCE_BOOST_POWER);
+
+			return (cache_position >= 0 ? m_cacheScores[cache_position] : 0.0f) + VALENCE_SCORE;
+		}
+	};
+
+	// A FIFO post-transform cache, vertices count as cached while fewer than the cache size misses happened since theirs
+	class FIFOCache
+	{
+	private:
+		std::vector<uint32_t> m_timestamps;
+		uint32_t m_timestamp;
+		const uint32_t m_cacheSize;
+	public:
+		FIFOCache(uint32_t num_vertices, uint32_t cache_size) :
+			m_timestamps(num_vertices, 0), m_timestamp(cache_size + 1), m_cacheSize(cache_size)
+		{}
+
+		uint32_t processTriangle(const uint32_t* triangle) // Returns how many of the triangle's vertices missed
+		{
+			uint32_t misses = 0;
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				if (m_timestamp - m_timestamps[triangle[corner]] > m_cacheSize)
+				{
+					m_timestamps[triangle[corner]] = m_timestamp++;
+					misses++;
+				}
+			}
+
+			return misses;
+		}
+
+		void flush() // Empties the cache
+		{
+			m_timestamp += m_cacheSize + 1;
+		}
+	};
+}
+
+namespace MeshOptimizer
+{
+	void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t num_vertices)
+	{
+		const uint32_t NUM_TRIANGLES = static_cast<uint32_t>(indices.size() / 3);
+		if (NUM_TRIANGLES == 0)
+			return;
+
+		// The triangles around each vertex, packed one vertex after another. Emitted triangles get swapped past the
+		// end of their vertex's range, so the first remainingTriangles entries are the ones still to draw
+		std::vector<uint32_t> remainingTriangles(num_vertices, 0), adjacencyOffsets(num_vertices + 1, 0);
+		for (uint32_t index : indices)
+			remainingTriangles[index]++;
+		for (uint32_t vertex = 0; vertex < num_vertices; vertex++)
+			adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + remainingTriangles[vertex];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t triangle = 0; triangle < NUM_TRIANGLES; triangle++)
+		{
+			for (uint32_t corner = 0; corner < 3; corner++)
+				adjacency[fillOffsets[indices[triangle * 3 + corner]]++] = triangle;
+		}
+
+		const VertexScorer SCORER;
+		std::vector<int> cachePositions(num_vertices, -1);
+		std::vector<float> vertexScores(num_vertices), triangleScores(NUM_TRIANGLES);
+		std::vector<uint8_t> emitted(NUM_TRIANGLES, 0);
+
+		for (uint32_t vertex = 0; vertex < num_vertices; vertex++)
+			vertexScores[vertex] = SCORER.scoreVertex(-1, remainingTriangles[vertex]);
+
+		uint32_t bestTriangle = 0;
+		for (uint32_t triangle = 0; triangle < NUM_TRIANGLES; triangle++)
+		{
+			const uint32_t* CORNERS = &indices[triangle * 3];
+			triangleScores[triangle] = vertexScores[CORNERS[0]] + vertexScores[CORNERS[1]] + vertexScores[CORNERS[2]];
+
+			if (triangleScores[triangle] > triangleScores[bestTriangle])
+				bestTriangle = triangle;
+		}
+
+		std::vector<uint32_t> cache, nextCache, optimized;
+		cache.reserve(FORSYTH_CACHE_SIZE + 3);
+		nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+		optimized.reserve(indices.size());
+
+		uint32_t scanPosition = 0; // Where to look for the next triangle when none around the cache are left
+		for (uint32_t numEmitted = 0; numEmitted < NUM_TRIANGLES; numEmitted++)
+		{
+			if (bestTriangle == INVALID_INDEX)
+			{
+				while (emitted[scanPosition])
+					scanPosition++;
+
+				bestTriangle = scanPosition;
+			}
+
+			const uint32_t* CORNERS = &indices[bestTriangle * 3];
+			optimized.insert(optimized.end(), CORNERS, CORNERS + 3);
+			emitted[bestTriangle] = 1;
+
+			nextCache.clear();
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				const uint32_t VERTEX = CORNERS[corner];
+				uint32_t* triangles = &adjacency[adjacencyOffsets[VERTEX]];
+				uint32_t* const LAST = triangles + --remainingTriangles[VERTEX];
+				std::iter_swap(std::find(triangles, LAST + 1, bestTriangle), LAST);
+
+				// Degenerate triangles repeat vertices, which only take up one cache entry
+				if (std::find(nextCache.begin(), nextCache.end(), VERTEX) == nextCache.end())
+					nextCache.emplace_back(VERTEX);
+			}
+
+			for (uint32_t vertex : cache)
+			{
+				if (vertex != CORNERS[0] && vertex != CORNERS[1] && vertex != CORNERS[2])
+					nextCache.emplace_back(vertex);
+			}
+
+			// Rescore everything that moved in the cache, including what just got pushed out of it
+			for (uint32_t position = 0; position < nextCache.size(); position++)
+			{
+				const uint32_t VERTEX = nextCache[position];
+				cachePositions[VERTEX] = position < FORSYTH_CACHE_SIZE ? static_cast<int>(position) : -1;
+				vertexScores[VERTEX] = SCORER.scoreVertex(cachePositions[VERTEX], remainingTriangles[VERTEX]);
+			}
+
+			nextCache.resize(std::min<size_t>(nextCache.size(), FORSYTH_CACHE_SIZE));
+			cache.swap(nextCache);
+
+			// Only triangles touching the cache can have changed score, so the next one is picked from those
+			bestTriangle = INVALID_INDEX;
+			float bestScore = -std::numeric_limits<float>::max();
+			for (uint32_t vertex : cache)
+			{
+				const uint32_t* TRIANGLES = &adjacency[adjacencyOffsets[vertex]];
+				for (uint32_t neighbour = 0; neighbour < remainingTriangles[vertex]; neighbour++)
+				{
+					const uint32_t TRIANGLE = TRIANGLES[neighbour];
+					const uint32_t* NEIGHBOUR_CORNERS = &indices[TRIANGLE * 3];
+					triangleScores[TRIANGLE] = vertexScores[NEIGHBOUR_CORNERS[0]] + vertexScores[NEIGHBOUR_CORNERS[1]] +
+						vertexScores[NEIGHBOUR_CORNERS[2]];
+
+					if (triangleScores[TRIANGLE] > bestScore)
+					{
+						bestScore = triangleScores[TRIANGLE];
+						bestTriangle = TRIANGLE;
+					}
+				}
+			}
+		}
+
+		indices.swap(optimized);
+	}
+
+	void optimizeOverdraw(const std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices, float threshold)
+	{
+		const uint32_t NUM_TRIANGLES = static_cast<uint32_t>(indices.size() / 3);
+		if (NUM_TRIANGLES < 2)
+			return;
+
+		// Hard boundaries are where the cache optimized order had to start over, every vertex of the triangle missing
+		FIFOCache cache(static_cast<uint32_t>(positions.size()), OVERDRAW_CACHE_SIZE);
+		std::vector<uint32_t> hardBoundaries;
+		for (uint32_t triangle = 0; triangle < NUM_TRIANGLES; triangle++)
+		{
+			if (cache.processTriangle(&indices[triangle * 3]) == 3)
+				hardBoundaries.emplace_back(triangle);
+		}
+		hardBoundaries.emplace_back(NUM_TRIANGLES);
+
+		// Each hard cluster is split again as soon as the part so far, drawn from a cold cache like it will be once
+		// moved, stays within the threshold of the whole cluster's miss ratio
+		std::vector<uint32_t> clusters;
+		for (uint32_t hard = 0; hard + 1 < hardBoundaries.size(); hard++)
+		{
+			const uint32_t BEGIN = hardBoundaries[hard], END = hardBoundaries[hard + 1];
+
+			cache.flush();
+			uint32_t misses = 0;
+			for (uint32_t triangle = BEGIN; triangle < END; triangle++)
+				misses += cache.processTriangle(&indices[triangle * 3]);
+
+			const float TARGET_ACMR = threshold * misses / (END - BEGIN);
+
+			cache.flush();
+			uint32_t clusterBegin = BEGIN, clusterMisses = 0;
+			for (uint32_t triangle = BEGIN; triangle < END; triangle++)
+			{
+				clusterMisses += cache.processTriangle(&indices[triangle * 3]);
+				if (triangle + 1 < END && clusterMisses <= TARGET_ACMR * (triangle + 1 - clusterBegin))
+				{
+					clusters.emplace_back(clusterBegin);
+					clusterBegin = triangle + 1;
+					clusterMisses = 0;
+					cache.flush();
+				}
+			}
+
+			clusters.emplace_back(clusterBegin);
+		}
+		clusters.emplace_back(NUM_TRIANGLES);
+
+		// Clusters facing away from the centre of the mesh are the likeliest to cover the rest from any direction
+		auto accumulate = [&positions, &indices](uint32_t begin, uint32_t end, glm::vec3& centroid, glm::vec3& normal)
+		{
+			glm::vec3 weightedSum(0.0f), plainSum(0.0f);
+			float totalArea = 0.0f;
+			normal = glm::vec3(0.0f);
+
+			for (uint32_t triangle = begin; triangle < end; triangle++)
+			{
+				const glm::vec3& A = positions[indices[triangle * 3]];
+				const glm::vec3& B = positions[indices[triangle * 3 + 1]];
+				const glm::vec3& C = positions[indices[triangle * 3 + 2]];
+
+				const glm::vec3 CROSS = glm::cross(B - A, C - A);
+				const float AREA = glm::length(CROSS);
+				const glm::vec3 CENTER = (A + B + C) * (1.0f / 3.0f);
+
+				weightedSum += CENTER * AREA;
+				plainSum += CENTER;
+				totalArea += AREA;
+				normal += CROSS;
+			}
+
+			centroid = totalArea > 0.0f ? weightedSum / totalArea : plainSum / static_cast<float>(end - begin);
+		};
+
+		glm::vec3 meshCentroid, meshNormal;
+		accumulate(0, NUM_TRIANGLES, meshCentroid, meshNormal);
+
+		const uint32_t NUM_CLUSTERS = static_cast<uint32_t>(clusters.size() - 1);
+		std::vector<float> sortKeys(NUM_CLUSTERS);
+		for (uint32_t cluster = 0; cluster < NUM_CLUSTERS; cluster++)
+		{
+			glm::vec3 centroid, normal;
+			accumulate(clusters[cluster], clusters[cluster + 1], centroid, normal);
+
+			const float NORMAL_LENGTH = glm::length(normal);
+			sortKeys[cluster] = NORMAL_LENGTH > 0.0f ? glm::dot(centroid - meshCentroid, normal / NORMAL_LENGTH) : 0.0f;
+		}
+
+		std::vector<uint32_t> order(NUM_CLUSTERS);
+		for (uint32_t cluster = 0; cluster < NUM_CLUSTERS; cluster++)
+			order[cluster] = cluster;
+
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b)
+		{
+			return sortKeys[a] > sortKeys[b];
+		});
+
+		std::vector<uint32_t> sorted;
+		sorted.reserve(indices.size());
+		for (uint32_t cluster : order)
+			sorted.insert(sorted.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + clusters[cluster + 1] * 3);
+
+		indices.swap(sorted);
+	}
+
+	std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t num_vertices)
+	{
+		std::vector<uint32_t> remap(num_vertices, INVALID_INDEX);
+		uint32_t nextVertex = 0;
+
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == INVALID_INDEX)
+				remap[index] = nextVertex++;
+
+			index = remap[index];
+		}
+
+		for (uint32_t vertex = 0; vertex < num_vertices; vertex++)
+		{
+			if (remap[vertex] == INVALID_INDEX)
+				remap[vertex] = nextVertex++;
+		}
+
+		return remap;
+	}
+
+	VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t num_vertices,
+		uint32_t cache_size)
+	{
+		VertexCacheStats stats;
+		const uint32_t NUM_TRIANGLES = static_cast<uint32_t>(indices.size() / 3);
+		if (NUM_TRIANGLES == 0)
+			return stats;
+
+		FIFOCache cache(num_vertices, cache_size);
+		uint32_t misses = 0;
+		for (uint32_t triangle = 0; triangle < NUM_TRIANGLES; triangle++)
+			misses += cache.processTriangle(&indices[triangle * 3]);
+
+		std::vector<uint8_t> used(num_vertices, 0);
+		uint32_t numUsed = 0;
+		for (uint32_t index : indices)
+		{
+			numUsed += used[index] ? 0 : 1;
+			used[index] = 1;
+		}
+
+		stats.m_acmr = static_cast<float>(misses) / NUM_TRIANGLES;
+		stats.m_atvr = static_cast<float>(misses) / numUsed;
+		return stats;
+	}
+
+	float analyzeOverdraw(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices)
+	{
+		if (positions.empty() || indices.size() < 3)
+			return 1.0f;
+
+		glm::vec3 boundsMin = positions[0], boundsMax = positions[0];
+		for (const auto& position : positions)
+		{
+			boundsMin = glm::min(boundsMin, position);
+			boundsMax = glm::max(boundsMax, position);
+		}
+
+		const glm::vec3 EXTENT = boundsMax - boundsMin;
+		const float LARGEST_EXTENT = std::max(EXTENT.x, std::max(EXTENT.y, EXTENT.z));
+		if (LARGEST_EXTENT <= 0.0f)
+			return 1.0f;
+
+		const float TO_PIXELS = (OVERDRAW_RESOLUTION - 1) / LARGEST_EXTENT;
+		std::vector<float> depthBuffer(OVERDRAW_RESOLUTION * OVERDRAW_RESOLUTION);
+		uint64_t shaded = 0, covered = 0;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const int AXIS_U = (axis + 1) % 3, AXIS_V = (axis + 2) % 3;
+			for (float direction : { 1.0f, -1.0f })
+			{
+				std::fill(depthBuffer.begin(), depthBuffer.end(), std::numeric_limits<float>::max());
+
+				for (size_t triangle = 0; triangle + 2 < indices.size(); triangle += 3)
+				{
+					glm::vec3 corners[3];
+					for (int corner = 0; corner < 3; corner++)
+					{
+						const glm::vec3 RELATIVE = positions[indices[triangle + corner]] - boundsMin;
+						corners[corner] = glm::vec3(RELATIVE[AXIS_U] * TO_PIXELS, RELATIVE[AXIS_V] * TO_PIXELS,
+							RELATIVE[axis] * direction);
+					}
+
+					float area = (corners[1].x - corners[0].x) * (corners[2].y - corners[0].y) -
+						(corners[2].x - corners[0].x) * (corners[1].y - corners[0].y);
+					if (area == 0.0f)
+						continue;
+
+					// No culling, so both windings are drawn, turned counter-clockwise to share one inside test
+					if (area < 0.0f)
+					{
+						std::swap(corners[1], corners[2]);
+						area = -area;
+					}
+
+					const int MIN_X = std::max(0, static_cast<int>(std::floor(std::min({ corners[0].x, corners[1].x,
+						corners[2].x }))));
+					const int MAX_X = std::min(OVERDRAW_RESOLUTION - 1, static_cast<int>(std::ceil(std::max({ corners[0].x,
+						corners[1].x, corners[2].x }))));
+					const int MIN_Y = std::max(0, static_cast<int>(std::floor(std::min({ corners[0].y, corners[1].y,
+						corners[2].y }))));
+					const int MAX_Y = std::min(OVERDRAW_RESOLUTION - 1, static_cast<int>(std::ceil(std::max({ corners[0].y,
+						corners[1].y, corners[2].y }))));
+
+					for (int y = MIN_Y; y <= MAX_Y; y++)
+					{
+						for (int x = MIN_X; x <= MAX_X; x++)
+						{
+							const float PX = x + 0.5f, PY = y + 0.5f;
+							float weights[3];
+							for (int edge = 0; edge < 3; edge++)
+							{
+								const glm::vec3& A = corners[(edge + 1) % 3];
+								const glm::vec3& B = corners[(edge + 2) % 3];
+								weights[edge] = (B.x - A.x) * (PY - A.y) - (PX - A.x) * (B.y - A.y);
+							}
+
+							if (weights[0] < 0.0f || weights[1] < 0.0f || weights[2] < 0.0f)
+								continue;
+
+							const float DEPTH = (weights[0] * corners[0].z + weights[1] * corners[1].z +
+								weights[2] * corners[2].z) / area;
+
+							float& stored = depthBuffer[y * OVERDRAW_RESOLUTION + x];
+							if (DEPTH < stored)
+							{
+								stored = DEPTH;
+								shaded++;
+							}
+						}
+					}
+				}
+
+				for (float depth : depthBuffer)
+					covered += depth < std::numeric_limits<float>::max() ? 1 : 0;
+			}
+		}
+
+		return covered > 0 ? static_cast<float>(shaded) / covered : 1.0f;
+	}
+}
\ No newline at end of file
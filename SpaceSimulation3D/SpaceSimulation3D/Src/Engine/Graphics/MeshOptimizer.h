@@ -0,0 +1,36 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+struct VertexCacheStats
+{
+	float m_acmr = 0.0f; // Average cache miss ratio, vertices transformed per triangle (0.5 at best, 3 at worst)
+	float m_atvr = 0.0f; // Average transform to vertex ratio, vertices transformed per vertex used (1 at best)
+};
+
+namespace MeshOptimizer
+{
+	// optimizeVertexCache() : Reorders the triangles for the post-transform vertex cache (Forsyth's linear-speed
+	// algorithm), greedily picking the triangle whose vertices score highest on cache position and remaining valence
+	void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t num_vertices);
+
+	// optimizeOverdraw() : Splits cache optimized triangles into clusters, each as small as it can be without raising
+	// the cache miss ratio past the threshold, then sorts them so the clusters facing out from the centre of the mesh
+	// come first and hide what is behind them (Sander et al., "Fast Triangle Reordering for Vertex Locality and
+	// Reduced Overdraw")
+	void optimizeOverdraw(const std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices,
+		float threshold = 1.05f);
+
+	// optimizeVertexFetch() : Returns the new index of every vertex, numbered in the order the indices first use them
+	// (unused vertices go last), and rewrites the indices to match. The vertices have to be moved the same way
+	std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t num_vertices);
+
+	// analyzeVertexCache() : Runs the indices through a FIFO post-transform cache of the given size
+	VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t num_vertices,
+		uint32_t cache_size = 16);
+
+	// analyzeOverdraw() : Rasterizes the mesh from the six axis directions without culling and returns how many times
+	// each covered pixel was shaded on average (1 = no overdraw)
+	float analyzeOverdraw(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+}
\ No newline at end of file
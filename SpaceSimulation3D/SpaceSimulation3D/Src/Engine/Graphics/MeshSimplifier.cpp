@@ -0,0 +1,375 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <queue>
+#include <tuple>
+
+namespace
+{
+	constexpr float MIN_NORMAL_AGREEMENT = 0.2f; // Collapses that rotate a triangle's normal further than this are rejected
+
+	// Symmetric 4x4 matrix summing the squared distance to a set of planes, only the upper triangle is stored
+	struct Quadric
+	{
+		double m_terms[10] = {};
+
+		void addPlane(double a, double b, double c, double d)
+		{
+			m_terms[0] += a * a; m_terms[1] += a * b; m_terms[2] += a * c; m_terms[3] += a * d;
+			m_terms[4] += b * b; m_terms[5] += b * c; m_terms[6] += b * d;
+			m_terms[7] += c * c; m_terms[8] += c * d;
+			m_terms[9] += d * d;
+		}
+
+		void add(const Quadric& other)
+		{
+			for (int term = 0; term < 10; term++)
+				m_terms[term] += other.m_terms[term];
+		}
+
+		double evaluate(const glm::vec3& point) const
+		{
+			const double X = point.x, Y = point.y, Z = point.z;
+			const double* Q = m_terms;
+
+			return Q[0] * X * X + 2.0 * Q[1] * X * Y + 2.0 * Q[2] * X * Z + 2.0 * Q[3] * X +
+				Q[4] * Y * Y + 2.0 * Q[5] * Y * Z + 2.0 * Q[6] * Y +
+				Q[7] * Z * Z + 2.0 * Q[8] * Z +
+				Q[9];
+		}
+	};
+
+	struct Collapse
+	{
+		double m_cost;
+		uint32_t m_from, m_to;
+		uint32_t m_fromStamp, m_toStamp; // Stamps of both vertices when the cost was computed, to spot stale entries
+
+		bool operator>(const Collapse& other) const { return m_cost > other.m_cost; }
+	};
+
+	glm::vec3 getTriangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		return glm::cross(b - a, c - a);
+	}
+
+	// Mesh being simplified, with the triangle lists of every vertex kept up to date as edges collapse
+	class CollapseState
+	{
+	private:
+		const std::vector<glm::vec3>& m_positions;
+		std::vector<uint32_t> m_weldedIDs; // Vertices sharing a position share an ID
+		std::vector<Quadric> m_quadrics; // Per welded ID
+		std::vector<bool> m_locked;
+		std::vector<uint32_t> m_stamps;
+
+		std::vector<uint32_t> m_triangles;
+		std::vector<bool> m_removedTriangles;
+		std::vector<std::vector<uint32_t>> m_vertexTriangles;
+		uint32_t m_numTriangles;
+
+		std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> m_queue;
+		double m_maxCost;
+
+		mutable std::vector<uint32_t> m_fromNeighbours, m_toNeighbours; // Scratch space of the collapse checks
+	private:
+		void pushCollapse(uint32_t from, uint32_t to)
+		{
+			if (m_locked[from] || m_weldedIDs[from] == m_weldedIDs[to])
+				return;
+
+			Quadric combined = m_quadrics[m_weldedIDs[from]];
+			combined.add(m_quadrics[m_weldedIDs[to]]);
+
+			m_queue.push({ std::max(0.0, combined.evaluate(m_positions[to])), from, to, m_stamps[from], m_stamps[to] });
+		}
+
+		void pushVertexCollapses(uint32_t vertex)
+		{
+			// Every neighbour shows up in two triangles, so gather them first to only price each edge once
+			m_toNeighbours.clear();
+			for (uint32_t triangle : m_vertexTriangles[vertex])
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					const uint32_t OTHER = m_triangles[triangle * 3 + corner];
+					if (OTHER != vertex)
+						m_toNeighbours.emplace_back(OTHER);
+				}
+			}
+
+			std::sort(m_toNeighbours.begin(), m_toNeighbours.end());
+			m_toNeighbours.erase(std::unique(m_toNeighbours.begin(), m_toNeighbours.end()), m_toNeighbours.end());
+
+			for (uint32_t other : m_toNeighbours)
+			{
+				this->pushCollapse(vertex, other);
+				this->pushCollapse(other, vertex);
+			}
+		}
+
+		void getNeighbours(uint32_t vertex, std::vector<uint32_t>& neighbours) const
+		{
+			neighbours.clear();
+			for (uint32_t triangle : m_vertexTriangles[vertex])
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					const uint32_t WELDED = m_weldedIDs[m_triangles[triangle * 3 + corner]];
+					if (WELDED != m_weldedIDs[vertex])
+						neighbours.emplace_back(WELDED);
+				}
+			}
+
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		}
+
+		bool isCollapseValid(uint32_t from, uint32_t to) const
+		{
+			// Only the triangles on the edge may disappear, a neighbour shared outside of them would leave the surface
+			// pinched into a non-manifold fan
+			uint32_t numEdgeTriangles = 0;
+			for (uint32_t triangle : m_vertexTriangles[from])
+			{
+				const uint32_t* CORNERS = &m_triangles[triangle * 3];
+				if (CORNERS[0] == to || CORNERS[1] == to || CORNERS[2] == to)
+				{
+					numEdgeTriangles++;
+					continue;
+				}
+
+				// The triangles that stay must not flip or fold flat when the vertex moves
+				glm::vec3 moved[3] = { m_positions[CORNERS[0]], m_positions[CORNERS[1]], m_positions[CORNERS[2]] };
+				const glm::vec3 BEFORE = getTriangleNormal(moved[0], moved[1], moved[2]);
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					if (CORNERS[corner] == from)
+						moved[corner] = m_positions[to];
+				}
+
+				const glm::vec3 AFTER = getTriangleNormal(moved[0], moved[1], moved[2]);
+				const float AFTER_LENGTH = glm::length(AFTER), BEFORE_LENGTH = glm::length(BEFORE);
+				if (AFTER_LENGTH <= 0.0f || glm::dot(BEFORE, AFTER) < MIN_NORMAL_AGREEMENT * BEFORE_LENGTH * AFTER_LENGTH)
+					return false;
+			}
+
+			if (numEdgeTriangles == 0)
+				return false;
+
+			this->getNeighbours(from, m_fromNeighbours);
+			this->getNeighbours(to, m_toNeighbours);
+
+			uint32_t numShared = 0;
+			for (uint32_t fromIndex = 0, toIndex = 0; fromIndex < m_fromNeighbours.size() &&
+				toIndex < m_toNeighbours.size();)
+			{
+				if (m_fromNeighbours[fromIndex] < m_toNeighbours[toIndex])
+					fromIndex++;
+				else if (m_toNeighbours[toIndex] < m_fromNeighbours[fromIndex])
+					toIndex++;
+				else
+				{
+					numShared++;
+					fromIndex++;
+					toIndex++;
+				}
+			}
+
+			return numShared == numEdgeTriangles;
+		}
+
+		void collapse(uint32_t from, uint32_t to)
+		{
+			for (uint32_t triangle : m_vertexTriangles[from])
+			{
+				uint32_t* corners = &m_triangles[triangle * 3];
+				if (corners[0] == to || corners[1] == to || corners[2] == to)
+				{
+					m_removedTriangles[triangle] = true;
+					m_numTriangles--;
+
+					// The edge's triangles vanish, so take them off the list of their third corner too
+					for (uint32_t corner = 0; corner < 3; corner++)
+					{
+						if (corners[corner] != from && corners[corner] != to)
+						{
+							std::vector<uint32_t>& triangles = m_vertexTriangles[corners[corner]];
+							const auto FOUND = std::find(triangles.begin(), triangles.end(), triangle);
+							if (FOUND != triangles.end())
+								triangles.erase(FOUND);
+						}
+					}
+
+					continue;
+				}
+
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					if (corners[corner] == from)
+						corners[corner] = to;
+				}
+
+				m_vertexTriangles[to].emplace_back(triangle);
+			}
+
+			// Every triangle list only ever holds live triangles
+			std::vector<uint32_t>& toTriangles = m_vertexTriangles[to];
+			toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(), [this](uint32_t triangle)
+			{
+				return m_removedTriangles[triangle];
+			}), toTriangles.end());
+
+			m_vertexTriangles[from].clear();
+			m_quadrics[m_weldedIDs[to]].add(m_quadrics[m_weldedIDs[from]]);
+			m_locked[from] = true;
+			m_stamps[from]++;
+			m_stamps[to]++;
+
+			this->pushVertexCollapses(to);
+		}
+	public:
+		CollapseState(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) :
+			m_positions(positions), m_triangles(indices), m_removedTriangles(indices.size() / 3, false),
+			m_vertexTriangles(positions.size()), m_numTriangles(static_cast<uint32_t>(indices.size() / 3)), m_maxCost(0.0)
+		{
+			const uint32_t NUM_VERTICES = static_cast<uint32_t>(positions.size());
+
+			// Weld the vertices by exact position, any position used by more than one vertex is a seam
+			std::map<std::tuple<float, float, float>, uint32_t> weldedLookup;
+			std::vector<uint32_t> weldedCounts;
+			m_weldedIDs.resize(NUM_VERTICES);
+
+			for (uint32_t vertex = 0; vertex < NUM_VERTICES; vertex++)
+			{
+				const glm::vec3& POSITION = positions[vertex];
+				const auto INSERTED = weldedLookup.emplace(std::make_tuple(POSITION.x, POSITION.y, POSITION.z),
+					static_cast<uint32_t>(weldedCounts.size()));
+
+				if (INSERTED.second)
+					weldedCounts.emplace_back(0);
+
+				m_weldedIDs[vertex] = INSERTED.first->second;
+				weldedCounts[m_weldedIDs[vertex]]++;
+			}
+
+			m_locked.resize(NUM_VERTICES);
+			m_stamps.resize(NUM_VERTICES, 0);
+			for (uint32_t vertex = 0; vertex < NUM_VERTICES; vertex++)
+				m_locked[vertex] = weldedCounts[m_weldedIDs[vertex]] > 1;
+
+			// Every vertex starts with the planes of the triangles around it
+			m_quadrics.resize(weldedCounts.size());
+			std::vector<std::pair<uint32_t, uint32_t>> edges;
+			edges.reserve(m_numTriangles * 3);
+
+			for (uint32_t triangle = 0; triangle < m_numTriangles; triangle++)
+			{
+				const uint32_t* CORNERS = &m_triangles[triangle * 3];
+				glm::vec3 normal = getTriangleNormal(positions[CORNERS[0]], positions[CORNERS[1]], positions[CORNERS[2]]);
+				const float LENGTH = glm::length(normal);
+
+				if (LENGTH > 0.0f)
+				{
+					normal = normal / LENGTH;
+					const double D = -glm::dot(normal, positions[CORNERS[0]]);
+
+					for (uint32_t corner = 0; corner < 3; corner++)
+						m_quadrics[m_weldedIDs[CORNERS[corner]]].addPlane(normal.x, normal.y, normal.z, D);
+				}
+
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					m_vertexTriangles[CORNERS[corner]].emplace_back(triangle);
+
+					const uint32_t A = m_weldedIDs[CORNERS[corner]], B = m_weldedIDs[CORNERS[(corner + 1) % 3]];
+					edges.emplace_back(std::min(A, B), std::max(A, B));
+				}
+			}
+
+			// Edges with a single triangle are on an open border
+			std::sort(edges.begin(), edges.end());
+			std::vector<bool> borderIDs(weldedCounts.size(), false);
+
+			for (size_t edge = 0; edge < edges.size();)
+			{
+				size_t next = edge + 1;
+				while (next < edges.size() && edges[next] == edges[edge])
+					next++;
+
+				if (next - edge == 1)
+					borderIDs[edges[edge].first] = borderIDs[edges[edge].second] = true;
+
+				edge = next;
+			}
+
+			for (uint32_t vertex = 0; vertex < NUM_VERTICES; vertex++)
+			{
+				if (borderIDs[m_weldedIDs[vertex]])
+					m_locked[vertex] = true;
+			}
+
+			for (uint32_t vertex = 0; vertex < NUM_VERTICES; vertex++)
+			{
+				if (!m_locked[vertex])
+					this->pushVertexCollapses(vertex);
+			}
+		}
+
+		// reduceTo() : Collapses the cheapest edges until the triangle count reaches the target or nothing can collapse
+		void reduceTo(uint32_t target_triangles)
+		{
+			while (m_numTriangles > target_triangles && !m_queue.empty())
+			{
+				const Collapse CANDIDATE = m_queue.top();
+				m_queue.pop();
+
+				if (CANDIDATE.m_fromStamp != m_stamps[CANDIDATE.m_from] || CANDIDATE.m_toStamp != m_stamps[CANDIDATE.m_to] ||
+					m_locked[CANDIDATE.m_from] || !this->isCollapseValid(CANDIDATE.m_from, CANDIDATE.m_to))
+					continue;
+
+				m_maxCost = std::max(m_maxCost, CANDIDATE.m_cost);
+				this->collapse(CANDIDATE.m_from, CANDIDATE.m_to);
+			}
+		}
+
+		SimplifiedLevel getLevel() const
+		{
+			SimplifiedLevel level;
+			level.m_indices.reserve(m_numTriangles * 3);
+			level.m_errorBound = static_cast<float>(std::sqrt(m_maxCost));
+
+			for (uint32_t triangle = 0; triangle < m_removedTriangles.size(); triangle++)
+			{
+				if (!m_removedTriangles[triangle])
+					level.m_indices.insert(level.m_indices.end(), &m_triangles[triangle * 3], &m_triangles[triangle * 3] + 3);
+			}
+
+			return level;
+		}
+	};
+}
+
+namespace MeshSimplifier
+{
+	std::vector<SimplifiedLevel> buildLODChain(const std::vector<glm::vec3>& positions,
+		const std::vector<uint32_t>& indices, uint32_t num_levels, float reduction)
+	{
+		std::vector<SimplifiedLevel> levels;
+		levels.push_back({ indices, 0.0f });
+
+		CollapseState state(positions, indices);
+		double targetTriangles = static_cast<double>(indices.size() / 3);
+
+		for (uint32_t level = 1; level < num_levels; level++)
+		{
+			targetTriangles *= reduction;
+			state.reduceTo(static_cast<uint32_t>(targetTriangles));
+			levels.emplace_back(state.getLevel());
+		}
+
+		return levels;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+struct SimplifiedLevel
+{
+	std::vector<uint32_t> m_indices; // Triangles of the level, indexing into the original vertices
+	float m_errorBound; // Furthest any collapsed vertex can sit from the original surface planes it absorbed
+};
+
+namespace MeshSimplifier
+{
+	// buildLODChain() : Repeatedly collapses the edge with the lowest quadric error (Garland-Heckbert), snapshotting the
+	// triangles each time the count halves (by default). Level 0 is the original mesh. Collapses only ever move a vertex
+	// onto one of its neighbours, so every level keeps using the original vertex buffer and its attributes. Vertices on
+	// open borders or UV/normal seams (several vertices sharing a position) are never removed, which keeps the
+	// silhouette and texture mapping intact at the cost of how far those areas can be reduced
+	std::vector<SimplifiedLevel> buildLODChain(const std::vector<glm::vec3>& positions,
+		const std::vector<uint32_t>& indices, uint32_t num_levels, float reduction = 0.5f);
+}
\ No newline at end of file
@@ -0,0 +1,447 @@
+#include "OcclusionCuller.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define OCCLUSION_CULLER_SSE
+	#include <immintrin.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t SETUP_GRAIN_SIZE = 256;
+	constexpr uint32_t RASTER_BAND_ROWS = 8; // Rows of the depth buffer each rasterization job fills
+	constexpr uint32_t REDUCE_GRAIN_ROWS = 16;
+	constexpr uint32_t TEST_GRAIN_SIZE = 1024;
+	constexpr uint32_t SPHERE_SUBDIVISIONS = 2; // 320 triangles, within 3% of the sphere's radius
+
+	// Returns the pixel a normalized device coordinate falls in, clamped onto the buffer
+	int getPixel(float ndc, uint32_t size)
+	{
+		const int PIXEL = static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(size)));
+		return std::min(std::max(PIXEL, 0), static_cast<int>(size) - 1);
+	}
+
+	// Builds a unit icosphere facing outwards with counter-clockwise triangles. Its vertices lie on the sphere, so
+	// every triangle lies inside it
+	void buildIcosphere(uint32_t subdivisions, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+	{
+		const float GOLDEN = (1.0f + std::sqrt(5.0f)) * 0.5f;
+		positions =
+		{
+			{ -1.0f, GOLDEN, 0.0f }, { 1.0f, GOLDEN, 0.0f }, { -1.0f, -GOLDEN, 0.0f }, { 1.0f, -GOLDEN, 0.0f },
+			{ 0.0f, -1.0f, GOLDEN }, { 0.0f, 1.0f, GOLDEN }, { 0.0f, -1.0f, -GOLDEN }, { 0.0f, 1.0f, -GOLDEN },
+			{ GOLDEN, 0.0f, -1.0f }, { GOLDEN, 0.0f, 1.0f }, { -GOLDEN, 0.0f, -1.0f }, { -GOLDEN, 0.0f, 1.0f }
+		};
+
+		indices =
+		{
+			0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+			3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1
+		};
+
+		for (auto& position : positions)
+			position = glm::normalize(position);
+
+		for (uint32_t level = 0; level < subdivisions; level++)
+		{
+			std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+			auto getMidpoint = [&positions, &midpoints](uint32_t a, uint32_t b)
+			{
+				const auto KEY = std::make_pair(std::min(a, b), std::max(a, b));
+				const auto FOUND = midpoints.find(KEY);
+				if (FOUND != midpoints.end())
+					return FOUND->second;
+
+				positions.emplace_back(glm::normalize((positions[a] + positions[b]) * 0.5f));
+				return midpoints[KEY] = static_cast<uint32_t>(positions.size() - 1);
+			};
+
+			std::vector<uint32_t> subdivided;
+			for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+			{
+				const uint32_t A = indices[triangle], B = indices[triangle + 1], C = indices[triangle + 2];
+				const uint32_t AB = getMidpoint(A, B), BC = getMidpoint(B, C), CA = getMidpoint(C, A);
+				subdivided.insert(subdivided.end(), { A, AB, CA, B, BC, AB, C, CA, BC, AB, BC, CA });
+			}
+
+			indices.swap(subdivided);
+		}
+	}
+}
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height, std::shared_ptr<JobSystem> job_system) :
+	m_width((std::max(width, 1u) + 3) & ~3u), m_height(std::max(height, 1u)), m_jobSystem(job_system),
+	m_view(1.0f), m_viewProjection(1.0f), m_projectionScale(1.0f), m_nearPlane(0.1f), m_coveredMinX(0),
+	m_coveredMaxX(-1), m_coveredMinY(0), m_coveredMaxY(-1), m_nearestOccluder(0.0f)
+{
+	buildIcosphere(SPHERE_SUBDIVISIONS, m_spherePositions, m_sphereIndices);
+
+	// Every level halves the one below (rounding up) down to a single texel
+	uint32_t levelWidth = m_width, levelHeight = m_height;
+	while (true)
+	{
+		m_levelWidths.emplace_back(levelWidth);
+		m_levelHeights.emplace_back(levelHeight);
+		m_depthPyramid.emplace_back(static_cast<size_t>(levelWidth) * levelHeight, 0.0f);
+
+		if (levelWidth == 1 && levelHeight == 1)
+			break;
+
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+	}
+}
+
+OcclusionCuller::~OcclusionCuller() {}
+
+void OcclusionCuller::runRanges(uint32_t count, uint32_t grain_size,
+	const std::function<void(uint32_t, uint32_t)>& task) const
+{
+	if (m_jobSystem)
+		m_jobSystem->parallelFor(0, count, grain_size, task);
+	else
+		task(0, count);
+}
+
+void OcclusionCuller::setupTriangles(const QueuedOccluder& occluder, const glm::mat4& model_view_projection,
+	uint32_t first_triangle, uint32_t begin, uint32_t end)
+{
+	for (uint32_t triangle = begin; triangle < end; triangle++)
+	{
+		ScreenTriangle& screen = m_triangles[first_triangle + triangle];
+		screen.m_minX = screen.m_minY = 0;
+		screen.m_maxX = screen.m_maxY = -1;
+
+		// The GPU clips triangles crossing the near plane, so drawing them whole could hide what shows through the gap
+		float x[3], y[3], depth[3];
+		bool pastNearPlane = true;
+
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			const glm::vec4 CLIP = model_view_projection * glm::vec4(
+				occluder.m_positions[occluder.m_indices[triangle * 3 + corner]], 1.0f);
+
+			pastNearPlane &= CLIP.w >= m_nearPlane;
+			x[corner] = (CLIP.x / CLIP.w * 0.5f + 0.5f) * m_width;
+			y[corner] = (CLIP.y / CLIP.w * 0.5f + 0.5f) * m_height;
+			depth[corner] = 1.0f / CLIP.w;
+		}
+
+		const float AREA = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if (!pastNearPlane || AREA <= 0.0f)
+			continue;
+
+		// Edge i runs from corner i to the next, the inside being on its left
+		for (uint32_t edge = 0; edge < 3; edge++)
+		{
+			const uint32_t NEXT = (edge + 1) % 3;
+			screen.m_edgeA[edge] = y[edge] - y[NEXT];
+			screen.m_edgeB[edge] = x[NEXT] - x[edge];
+			screen.m_edgeC[edge] = -(screen.m_edgeA[edge] * x[edge] + screen.m_edgeB[edge] * y[edge]);
+		}
+
+		screen.m_depthA = ((depth[1] - depth[0]) * (y[2] - y[0]) - (depth[2] - depth[0]) * (y[1] - y[0])) / AREA;
+		screen.m_depthB = ((depth[2] - depth[0]) * (x[1] - x[0]) - (depth[1] - depth[0]) * (x[2] - x[0])) / AREA;
+		screen.m_depthC = depth[0] - screen.m_depthA * x[0] - screen.m_depthB * y[0];
+		screen.m_nearestDepth = std::max({ depth[0], depth[1], depth[2] });
+
+		// Pixels are covered by their centers, so only the ones with a center inside the bounds can be
+		screen.m_minX = std::max(static_cast<int>(std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f)), 0);
+		screen.m_maxX = std::min(static_cast<int>(std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f)),
+			static_cast<int>(m_width) - 1);
+		screen.m_minY = std::max(static_cast<int>(std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f)), 0);
+		screen.m_maxY = std::min(static_cast<int>(std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f)),
+			static_cast<int>(m_height) - 1);
+	}
+}
+
+void OcclusionCuller::rasterizeRows(uint32_t first_row, uint32_t end_row)
+{
+	float* const DEPTH_BUFFER = m_depthPyramid[0].data();
+
+	for (const ScreenTriangle& TRIANGLE : m_triangles)
+	{
+		const int FIRST_ROW = std::max(TRIANGLE.m_minY, static_cast<int>(first_row));
+		const int LAST_ROW = std::min(TRIANGLE.m_maxY, static_cast<int>(end_row) - 1);
+		if (FIRST_ROW > LAST_ROW || TRIANGLE.m_minX > TRIANGLE.m_maxX)
+			continue;
+
+		for (int row = FIRST_ROW; row <= LAST_ROW; row++)
+		{
+			const float CENTER_Y = row + 0.5f;
+			float* const ROW_DEPTH = DEPTH_BUFFER + static_cast<size_t>(row) * m_width;
+
+			// The edge and depth planes only change across the row from here on
+			const float ROW_EDGE0 = TRIANGLE.m_edgeB[0] * CENTER_Y + TRIANGLE.m_edgeC[0];
+			const float ROW_EDGE1 = TRIANGLE.m_edgeB[1] * CENTER_Y + TRIANGLE.m_edgeC[1];
+			const float ROW_EDGE2 = TRIANGLE.m_edgeB[2] * CENTER_Y + TRIANGLE.m_edgeC[2];
+			const float ROW_DEPTH_C = TRIANGLE.m_depthB * CENTER_Y + TRIANGLE.m_depthC;
+
+#ifdef OCCLUSION_CULLER_SSE
+			// 4 pixels at a time from the aligned block holding the first one, the width being a multiple of 4
+			const __m128 EDGE_A0 = _mm_set1_ps(TRIANGLE.m_edgeA[0]), EDGE_ROW0 = _mm_set1_ps(ROW_EDGE0);
+			const __m128 EDGE_A1 = _mm_set1_ps(TRIANGLE.m_edgeA[1]), EDGE_ROW1 = _mm_set1_ps(ROW_EDGE1);
+			const __m128 EDGE_A2 = _mm_set1_ps(TRIANGLE.m_edgeA[2]), EDGE_ROW2 = _mm_set1_ps(ROW_EDGE2);
+			const __m128 DEPTH_A = _mm_set1_ps(TRIANGLE.m_depthA), DEPTH_ROW = _mm_set1_ps(ROW_DEPTH_C);
+			const __m128 CENTER_OFFSETS = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 ZERO = _mm_setzero_ps();
+
+			for (int column = TRIANGLE.m_minX & ~3; column <= TRIANGLE.m_maxX; column += 4)
+			{
+				const __m128 CENTER_X = _mm_add_ps(_mm_set1_ps(static_cast<float>(column)), CENTER_OFFSETS);
+				const __m128 EDGE0 = _mm_add_ps(_mm_mul_ps(EDGE_A0, CENTER_X), EDGE_ROW0);
+				const __m128 EDGE1 = _mm_add_ps(_mm_mul_ps(EDGE_A1, CENTER_X), EDGE_ROW1);
+				const __m128 EDGE2 = _mm_add_ps(_mm_mul_ps(EDGE_A2, CENTER_X), EDGE_ROW2);
+
+				const __m128 INSIDE = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(EDGE0, ZERO), _mm_cmpge_ps(EDGE1, ZERO)),
+					_mm_cmpge_ps(EDGE2, ZERO));
+				if (_mm_movemask_ps(INSIDE) == 0)
+					continue;
+
+				// The nearest depth wins, which is the largest 1 / depth
+				const __m128 DEPTH = _mm_add_ps(_mm_mul_ps(DEPTH_A, CENTER_X), DEPTH_ROW);
+				const __m128 PREVIOUS = _mm_loadu_ps(ROW_DEPTH + column);
+				const __m128 NEAREST = _mm_max_ps(PREVIOUS, DEPTH);
+				_mm_storeu_ps(ROW_DEPTH + column, _mm_or_ps(_mm_and_ps(INSIDE, NEAREST), _mm_andnot_ps(INSIDE, PREVIOUS)));
+			}
+#else
+			for (int column = TRIANGLE.m_minX; column <= TRIANGLE.m_maxX; column++)
+			{
+				const float CENTER_X = column + 0.5f;
+				if (TRIANGLE.m_edgeA[0] * CENTER_X + ROW_EDGE0 < 0.0f || TRIANGLE.m_edgeA[1] * CENTER_X + ROW_EDGE1 < 0.0f ||
+					TRIANGLE.m_edgeA[2] * CENTER_X + ROW_EDGE2 < 0.0f)
+					continue;
+
+				ROW_DEPTH[column] = std::max(ROW_DEPTH[column], TRIANGLE.m_depthA * CENTER_X + ROW_DEPTH_C);
+			}
+#endif
+		}
+	}
+}
+
+void OcclusionCuller::reduceLevel(uint32_t level, uint32_t first_row, uint32_t end_row)
+{
+	const std::vector<float>& BELOW = m_depthPyramid[level - 1];
+	const uint32_t BELOW_WIDTH = m_levelWidths[level - 1], BELOW_HEIGHT = m_levelHeights[level - 1];
+	std::vector<float>& texels = m_depthPyramid[level];
+
+	for (uint32_t row = first_row; row < end_row; row++)
+	{
+		// Odd sizes leave the last texel covering a single row or column below
+		const uint32_t BELOW_ROW0 = row * 2, BELOW_ROW1 = std::min(row * 2 + 1, BELOW_HEIGHT - 1);
+		for (uint32_t column = 0; column < m_levelWidths[level]; column++)
+		{
+			const uint32_t BELOW_COLUMN0 = column * 2, BELOW_COLUMN1 = std::min(column * 2 + 1, BELOW_WIDTH - 1);
+			texels[row * m_levelWidths[level] + column] = std::min(
+				std::min(BELOW[BELOW_ROW0 * BELOW_WIDTH + BELOW_COLUMN0], BELOW[BELOW_ROW0 * BELOW_WIDTH + BELOW_COLUMN1]),
+				std::min(BELOW[BELOW_ROW1 * BELOW_WIDTH + BELOW_COLUMN0], BELOW[BELOW_ROW1 * BELOW_WIDTH + BELOW_COLUMN1]));
+		}
+	}
+}
+
+void OcclusionCuller::setJobSystem(std::shared_ptr<JobSystem> job_system)
+{
+	m_jobSystem = job_system;
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_view = view;
+	m_viewProjection = projection * view;
+	m_projectionScale = glm::vec2(projection[0][0], projection[1][1]);
+	m_nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+
+	// Nothing is hidden until the occluders of this frame are drawn
+	m_occluders.clear();
+	m_coveredMinX = m_coveredMinY = 0;
+	m_coveredMaxX = m_coveredMaxY = -1;
+	m_nearestOccluder = 0.0f;
+
+	for (auto& level : m_depthPyramid)
+		std::fill(level.begin(), level.end(), 0.0f);
+}
+
+void OcclusionCuller::addOccluder(const glm::vec3* positions, const uint32_t* indices, uint32_t num_indices,
+	const glm::mat4& model)
+{
+	m_occluders.push_back({ positions, indices, num_indices, model });
+}
+
+void OcclusionCuller::addSphereOccluder(const glm::vec3& center, float radius)
+{
+	const glm::mat4 MODEL = glm::scale(glm::translate(glm::mat4(1.0f), center), glm::vec3(radius));
+	this->addOccluder(m_spherePositions.data(), m_sphereIndices.data(), static_cast<uint32_t>(m_sphereIndices.size()),
+		MODEL);
+}
+
+void OcclusionCuller::rasterizeOccluders()
+{
+	const auto START = std::chrono::high_resolution_clock::now();
+
+	uint32_t numTriangles = 0;
+	for (const QueuedOccluder& OCCLUDER : m_occluders)
+		numTriangles += OCCLUDER.m_numIndices / 3;
+
+	m_triangles.resize(numTriangles);
+
+	uint32_t firstTriangle = 0;
+	for (const QueuedOccluder& OCCLUDER : m_occluders)
+	{
+		const glm::mat4 MODEL_VIEW_PROJECTION = m_viewProjection * OCCLUDER.m_model;
+		this->runRanges(OCCLUDER.m_numIndices / 3, SETUP_GRAIN_SIZE,
+			[this, &OCCLUDER, &MODEL_VIEW_PROJECTION, firstTriangle](uint32_t begin, uint32_t end)
+		{
+			this->setupTriangles(OCCLUDER, MODEL_VIEW_PROJECTION, firstTriangle, begin, end);
+		});
+
+		firstTriangle += OCCLUDER.m_numIndices / 3;
+	}
+
+	// Each band of rows is only written by its own job
+	std::fill(m_depthPyramid[0].begin(), m_depthPyramid[0].end(), 0.0f);
+	const uint32_t NUM_BANDS = (m_height + RASTER_BAND_ROWS - 1) / RASTER_BAND_ROWS;
+	this->runRanges(NUM_BANDS, 1, [this](uint32_t begin, uint32_t end)
+	{
+		this->rasterizeRows(begin * RASTER_BAND_ROWS, std::min(end * RASTER_BAND_ROWS, m_height));
+	});
+
+	for (uint32_t level = 1; level < m_depthPyramid.size(); level++)
+	{
+		this->runRanges(m_levelHeights[level], REDUCE_GRAIN_ROWS, [this, level](uint32_t begin, uint32_t end)
+		{
+			this->reduceLevel(level, begin, end);
+		});
+	}
+
+	m_stats.m_occluderTriangles = numTriangles;
+	m_stats.m_rasterizedTriangles = 0;
+	m_coveredMinX = m_coveredMinY = std::numeric_limits<int>::max();
+	m_coveredMaxX = m_coveredMaxY = -1;
+	m_nearestOccluder = 0.0f;
+
+	for (const ScreenTriangle& TRIANGLE : m_triangles)
+	{
+		if (TRIANGLE.m_minX > TRIANGLE.m_maxX || TRIANGLE.m_minY > TRIANGLE.m_maxY)
+			continue;
+
+		m_stats.m_rasterizedTriangles++;
+		m_coveredMinX = std::min(m_coveredMinX, TRIANGLE.m_minX);
+		m_coveredMaxX = std::max(m_coveredMaxX, TRIANGLE.m_maxX);
+		m_coveredMinY = std::min(m_coveredMinY, TRIANGLE.m_minY);
+		m_coveredMaxY = std::max(m_coveredMaxY, TRIANGLE.m_maxY);
+		m_nearestOccluder = std::max(m_nearestOccluder, TRIANGLE.m_nearestDepth);
+	}
+
+	m_stats.m_rasterSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - START).count();
+}
+
+uint32_t OcclusionCuller::cullIndices(const InstanceData* instances, uint32_t* indices, uint32_t num_indices,
+	float model_radius)
+{
+	const auto START = std::chrono::high_resolution_clock::now();
+
+	m_occludedFlags.resize(num_indices);
+	this->runRanges(num_indices, TEST_GRAIN_SIZE, [this, instances, indices, model_radius](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t index = begin; index < end; index++)
+		{
+			const InstanceData& INSTANCE = instances[indices[index]];
+			m_occludedFlags[index] = this->isSphereOccluded(INSTANCE.m_position, INSTANCE.m_scale * model_radius) ? 1 : 0;
+		}
+	});
+
+	uint32_t numKept = 0;
+	for (uint32_t index = 0; index < num_indices; index++)
+	{
+		if (!m_occludedFlags[index])
+			indices[numKept++] = indices[index];
+	}
+
+	m_stats.m_tested = num_indices;
+	m_stats.m_occluded = num_indices - numKept;
+	m_stats.m_testSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - START).count();
+
+	return numKept;
+}
+
+bool OcclusionCuller::isSphereOccluded(const glm::vec3& center, float radius) const
+{
+	const glm::vec3 VIEW_CENTER = glm::vec3(m_view * glm::vec4(center, 1.0f));
+	const float NEAREST_DEPTH = -VIEW_CENTER.z - radius;
+	if (NEAREST_DEPTH <= m_nearPlane)
+		return false;
+
+	const float INVERSE_NEAREST = 1.0f / NEAREST_DEPTH, INVERSE_FURTHEST = 1.0f / (-VIEW_CENTER.z + radius);
+	if (INVERSE_NEAREST >= m_nearestOccluder)
+		return false;
+
+	// The sphere's screen extent is widest on the side facing the view axis at its nearest depth, and on the other
+	// side at its furthest depth
+	const float MIN_X = VIEW_CENTER.x - radius, MAX_X = VIEW_CENTER.x + radius;
+	const float MIN_Y = VIEW_CENTER.y - radius, MAX_Y = VIEW_CENTER.y + radius;
+	const float NDC_MIN_X = MIN_X * m_projectionScale.x * (MIN_X < 0.0f ? INVERSE_NEAREST : INVERSE_FURTHEST);
+	const float NDC_MAX_X = MAX_X * m_projectionScale.x * (MAX_X > 0.0f ? INVERSE_NEAREST : INVERSE_FURTHEST);
+	const float NDC_MIN_Y = MIN_Y * m_projectionScale.y * (MIN_Y < 0.0f ? INVERSE_NEAREST : INVERSE_FURTHEST);
+	const float NDC_MAX_Y = MAX_Y * m_projectionScale.y * (MAX_Y > 0.0f ? INVERSE_NEAREST : INVERSE_FURTHEST);
+
+	// Whatever is off screen is left to the frustum cull
+	if (NDC_MAX_X < -1.0f || NDC_MIN_X > 1.0f || NDC_MAX_Y < -1.0f || NDC_MIN_Y > 1.0f)
+		return false;
+
+	const int MIN_PIXEL_X = getPixel(NDC_MIN_X, m_width) - 1, MAX_PIXEL_X = getPixel(NDC_MAX_X, m_width) + 1;
+	const int MIN_PIXEL_Y = getPixel(NDC_MIN_Y, m_height) - 1, MAX_PIXEL_Y = getPixel(NDC_MAX_Y, m_height) + 1;
+	if (MIN_PIXEL_X < m_coveredMinX || MAX_PIXEL_X > m_coveredMaxX || MIN_PIXEL_Y < m_coveredMinY ||
+		MAX_PIXEL_Y > m_coveredMaxY)
+		return false;
+
+	uint32_t minX = MIN_PIXEL_X, maxX = MAX_PIXEL_X, minY = MIN_PIXEL_Y, maxY = MAX_PIXEL_Y;
+
+	// Go up the pyramid until the bounds cover at most 2x2 texels
+	uint32_t level = 0;
+	while (level + 1 < m_depthPyramid.size() && (maxX - minX > 1 || maxY - minY > 1))
+	{
+		minX >>= 1;
+		maxX >>= 1;
+		minY >>= 1;
+		maxY >>= 1;
+		level++;
+	}
+
+	const std::vector<float>& TEXELS = m_depthPyramid[level];
+	const uint32_t LEVEL_WIDTH = m_levelWidths[level];
+	float furthestOccluder = TEXELS[minY * LEVEL_WIDTH + minX];
+
+	for (uint32_t row = minY; row <= maxY; row++)
+	{
+		for (uint32_t column = minX; column <= maxX; column++)
+			furthestOccluder = std::min(furthestOccluder, TEXELS[row * LEVEL_WIDTH + column]);
+	}
+
+	return INVERSE_NEAREST < furthestOccluder;
+}
+
+const OcclusionStats& OcclusionCuller::getStats() const
+{
+	return m_stats;
+}
+
+const std::vector<float>& OcclusionCuller::getDepthBuffer() const
+{
+	return m_depthPyramid[0];
+}
+
+uint32_t OcclusionCuller::getWidth() const
+{
+	return m_width;
+}
+
+uint32_t OcclusionCuller::getHeight() const
+{
+	return m_height;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+#include "Engine/Utils/JobSystem.h"
+#include "Engine/Simulation/TransformKernels.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct OcclusionStats
+{
+	uint32_t m_occluderTriangles = 0; // Triangles queued for the last rasterization
+	uint32_t m_rasterizedTriangles = 0; // Of those, the ones on screen facing the camera, wholly past the near plane
+	uint32_t m_tested = 0; // Instances tested by the last cull
+	uint32_t m_occluded = 0;
+	double m_rasterSeconds = 0.0; // Time spent drawing the occluders and building the depth pyramid
+	double m_testSeconds = 0.0; // Time spent testing the instances
+};
+
+// Culls instances hidden behind large occluders (like the planet). The occluders get rasterized on the CPU into a small
+// depth buffer, each job filling its own band of rows 4 pixels at a time, which then gets reduced into a pyramid keeping
+// the furthest depth under each texel. An instance is hidden if the nearest point of its bounding sphere lies behind the
+// furthest occluder depth across the (at most 2x2) pyramid texels its screen bounds cover. Pixels count as covered by
+// their centers, so the bounds get widened by a pixel to stay clear of partly covered pixels along the silhouettes.
+//
+// Depths are stored as 1 / view depth, which interpolates linearly across the screen, with 0 where nothing was drawn.
+// Occluders have to lie inside whatever they stand for and face the camera with counter-clockwise triangles. Triangles
+// crossing the near plane are left out, so the cull can only ever keep more instances than it has to. Like the light
+// clusters, the instance bounds assume a symmetric perspective projection
+class OcclusionCuller
+{
+private:
+	struct QueuedOccluder
+	{
+		const glm::vec3* m_positions;
+		const uint32_t* m_indices;
+		uint32_t m_numIndices;
+		glm::mat4 m_model;
+	};
+
+	// A triangle in depth buffer pixels, as planes of the form A * x + B * y + C across the screen
+	struct ScreenTriangle
+	{
+		float m_edgeA[3], m_edgeB[3], m_edgeC[3]; // Edge functions, all 3 of them >= 0 inside the triangle
+		float m_depthA, m_depthB, m_depthC; // 1 / depth, which is linear in screen space
+		float m_nearestDepth; // Largest 1 / depth of the corners
+		int m_minX, m_maxX, m_minY, m_maxY; // Pixels whose centers may be covered, none (min > max) if rejected
+	};
+
+	uint32_t m_width, m_height;
+	std::shared_ptr<JobSystem> m_jobSystem;
+	glm::mat4 m_view, m_viewProjection;
+	glm::vec2 m_projectionScale; // Diagonal x and y terms of the projection
+	float m_nearPlane;
+
+	std::vector<glm::vec3> m_spherePositions; // Unit icosphere the sphere occluders are drawn with
+	std::vector<uint32_t> m_sphereIndices;
+
+	std::vector<QueuedOccluder> m_occluders;
+	std::vector<ScreenTriangle> m_triangles;
+	std::vector<std::vector<float>> m_depthPyramid; // Level 0 is the depth buffer, each level after halves the last
+	std::vector<uint32_t> m_levelWidths, m_levelHeights;
+	std::vector<uint8_t> m_occludedFlags;
+	OcclusionStats m_stats;
+
+	// Pixel bounds and nearest 1 / depth of everything drawn, anything outside the bounds or in front of it is visible
+	int m_coveredMinX, m_coveredMaxX, m_coveredMinY, m_coveredMaxY;
+	float m_nearestOccluder;
+private:
+	void runRanges(uint32_t count, uint32_t grain_size, const std::function<void(uint32_t, uint32_t)>& task) const; // Splits the loop across the job system, if one is set
+
+	// setupTriangles() : Projects a range of the occluder's triangles into the depth buffer, rejecting the ones that
+	// face away or cross the near plane
+	void setupTriangles(const QueuedOccluder& occluder, const glm::mat4& model_view_projection, uint32_t first_triangle,
+		uint32_t begin, uint32_t end);
+
+	void rasterizeRows(uint32_t first_row, uint32_t end_row); // Draws every triangle into the given rows of the depth buffer
+	void reduceLevel(uint32_t level, uint32_t first_row, uint32_t end_row); // Fills rows of the level with the furthest depth of the level below
+public:
+	OcclusionCuller(uint32_t width, uint32_t height, std::shared_ptr<JobSystem> job_system = nullptr); // The width is rounded up to a multiple of 4
+	~OcclusionCuller();
+
+	void setJobSystem(std::shared_ptr<JobSystem> job_system); // Sets the job system the culling is split across (nullptr = serial)
+	void beginFrame(const glm::mat4& view, const glm::mat4& projection); // Drops the queued occluders and sets the camera to cull from
+
+	// addOccluder() : Queues an indexed triangle mesh, drawn with the model matrix. The mesh has to stay alive until
+	// the occluders get rasterized
+	void addOccluder(const glm::vec3* positions, const uint32_t* indices, uint32_t num_indices, const glm::mat4& model);
+	void addSphereOccluder(const glm::vec3& center, float radius); // Queues a sphere, drawn as an icosphere inside it
+	void rasterizeOccluders(); // Draws the queued occluders into the depth buffer and rebuilds the depth pyramid
+
+	// cullIndices() : Removes the indices of the instances hidden behind the occluders, keeping the rest in their
+	// original order, and returns how many are left
+	uint32_t cullIndices(const InstanceData* instances, uint32_t* indices, uint32_t num_indices, float model_radius);
+
+	bool isSphereOccluded(const glm::vec3& center, float radius) const; // Tests a single sphere against the depth pyramid
+public:
+	const OcclusionStats& getStats() const; // Returns the counters and timings of the last rasterization and cull
+	const std::vector<float>& getDepthBuffer() const; // Returns the rasterized 1 / depth of every pixel, row by row from the bottom
+
+	uint32_t getWidth() const; // Returns the width of the depth buffer
+	uint32_t getHeight() const; // Returns the height of the depth buffer
+};
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "RenderQueue.h"
+#include "Engine/Graphics/SceneModel.h"
+#include "Engine/Graphics/SceneSkybox.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	uint32_t nextMaterialID = 1;
+}
+
+RenderQueue::RenderQueue() :
+	m_view(1.0f), m_batching(true), m_transformCapacity(0)
+{}
+
+RenderQueue::~RenderQueue() {}
+
+void RenderQueue::beginFrame(const glm::mat4& view)
+{
+	m_view = view;
+	m_commands.clear();
+	m_transforms.clear();
+	m_order.clear();
+	m_batches.clear();
+	m_batchTransforms.clear();
+}
+
+uint32_t RenderQueue::addTransform(const glm::mat4& model)
+{
+	m_transforms.push_back(model);
+	return static_cast<uint32_t>(m_transforms.size() - 1);
+}
+
+void RenderQueue::submit(RenderCommand command, RenderPass pass, float depth)
+{
+	if (command.m_shader)
+		command.m_program = command.m_shader->getID();
+
+	command.m_sortKey = RenderQueue::makeSortKey(pass, command.m_program, command.m_material, command.m_vao, depth);
+
+	m_commands.push_back(command);
+}
+
+void RenderQueue::sort()
+{
+	const auto START = std::chrono::high_resolution_clock::now();
+	const uint32_t NUM_COMMANDS = static_cast<uint32_t>(m_commands.size());
+
+	m_keys.resize(NUM_COMMANDS);
+	m_scratchKeys.resize(NUM_COMMANDS);
+	m_order.resize(NUM_COMMANDS);
+	m_scratchOrder.resize(NUM_COMMANDS);
+
+	// Count every digit of every key in one go
+	uint32_t histograms[8][256] = {};
+	for (uint32_t index = 0; index < NUM_COMMANDS; index++)
+	{
+		m_keys[index] = m_commands[index].m_sortKey;
+		m_order[index] = index;
+
+		for (uint32_t digit = 0; digit < 8; digit++)
+			histograms[digit][(m_keys[index] >> (digit * 8)) & 0xFF]++;
+	}
+
+	// Then scatter by each digit from the least significant, every pass keeping the order of the one before, so equal
+	// keys stay in the order they were submitted
+	for (uint32_t digit = 0; digit < 8 && NUM_COMMANDS > 0; digit++)
+	{
+		const uint32_t SHIFT = digit * 8;
+		uint32_t* counts = histograms[digit];
+		if (counts[(m_keys[0] >> SHIFT) & 0xFF] == NUM_COMMANDS)
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t bucket = 0; bucket < 256; bucket++)
+		{
+			const uint32_t COUNT = counts[bucket];
+			counts[bucket] = offset;
+			offset += COUNT;
+		}
+
+		for (uint32_t index = 0; index < NUM_COMMANDS; index++)
+		{
+			const uint32_t DESTINATION = counts[(m_keys[index] >> SHIFT) & 0xFF]++;
+			m_scratchKeys[DESTINATION] = m_keys[index];
+			m_scratchOrder[DESTINATION] = m_order[index];
+		}
+
+		m_keys.swap(m_scratchKeys);
+		m_order.swap(m_scratchOrder);
+	}
+
+	m_stats.m_sortSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - START).count();
+}
+
+void RenderQueue::buildBatches()
+{
+	m_batches.clear();
+	m_batchTransforms.clear();
+	m_stats.m_commands = static_cast<uint32_t>(m_order.size());
+	m_stats.m_batchedCommands = 0;
+
+	for (uint32_t position = 0; position < m_order.size(); position++)
+	{
+		const RenderCommand& COMMAND = m_commands[m_order[position]];
+
+		// A copy joins the batch before it when that draws the same level of the same mesh with the same shader. The
+		// sort key can't tell copies apart from other meshes whose IDs got truncated the same, so the full ones are compared
+		bool joined = false;
+		if (m_batching && COMMAND.m_batchable && !m_batches.empty())
+		{
+			RenderBatch& batch = m_batches.back();
+			const RenderCommand& FIRST = m_commands[m_order[batch.m_first]];
+
+			if (FIRST.m_batchable && FIRST.m_mesh == COMMAND.m_mesh && FIRST.m_level == COMMAND.m_level &&
+				FIRST.m_shader == COMMAND.m_shader)
+			{
+				batch.m_numCommands++;
+				m_stats.m_batchedCommands++;
+				joined = true;
+			}
+		}
+
+		if (!joined)
+		{
+			RenderBatch batch;
+			batch.m_first = position;
+			batch.m_numCommands = 1;
+			batch.m_firstTransform = static_cast<uint32_t>(m_batchTransforms.size());
+			m_batches.push_back(batch);
+		}
+
+		if (COMMAND.m_batchable)
+			m_batchTransforms.push_back(m_transforms[COMMAND.m_transform]);
+	}
+
+	m_stats.m_drawCalls = static_cast<uint32_t>(m_batches.size());
+}
+
+void RenderQueue::prepare()
+{
+	this->sort();
+	this->buildBatches();
+}
+
+void RenderQueue::execute(uint32_t transform_buffer, GLintptr transform_offset)
+{
+	// Without room in the caller's buffer, the transforms go through the queue's own, which only ever grows. The new
+	// buffer gets created before the old one is deleted, so the vaos never see the same name for a different buffer
+	if (transform_buffer == 0 && !m_batchTransforms.empty())
+	{
+		const GLsizeiptr SIZE = static_cast<GLsizeiptr>(sizeof(glm::mat4) * m_batchTransforms.size());
+		if (SIZE > m_transformCapacity)
+		{
+			m_transformCapacity = std::max(SIZE, 2 * m_transformCapacity);
+			m_transformVBO = std::make_shared<VertexBuffer>(nullptr, m_transformCapacity, GL_STREAM_DRAW);
+		}
+
+		m_transformVBO->modifyData(m_batchTransforms.data(), 0, SIZE);
+		transform_buffer = m_transformVBO->getID();
+		transform_offset = 0;
+	}
+
+	m_stats.m_programSwitches = m_stats.m_materialSwitches = m_stats.m_vaoSwitches = 0;
+
+	uint32_t boundProgram = 0, boundMaterial = 0, boundVAO = 0;
+
+	for (const RenderBatch& BATCH : m_batches)
+	{
+		// Every command of a batch binds the same state, so the first one stands in for the rest
+		const RenderCommand& COMMAND = m_commands[m_order[BATCH.m_first]];
+
+		// The materials set uniforms of the program, so a new program needs its material set again
+		if (COMMAND.m_program != boundProgram)
+		{
+			COMMAND.m_shader->bindProgram();
+			boundProgram = COMMAND.m_program;
+			boundMaterial = 0;
+			m_stats.m_programSwitches++;
+		}
+
+		const bool BIND_MATERIAL = COMMAND.m_material != boundMaterial;
+		if (BIND_MATERIAL)
+		{
+			boundMaterial = COMMAND.m_material;
+			m_stats.m_materialSwitches++;
+		}
+
+		// The draws bind their own vaos through the state cache, which drops the binds already in place
+		if (COMMAND.m_vao != boundVAO)
+		{
+			boundVAO = COMMAND.m_vao;
+			m_stats.m_vaoSwitches++;
+		}
+
+		switch (COMMAND.m_type)
+		{
+		case DrawType::MESH:
+			if (BIND_MATERIAL)
+				COMMAND.m_mesh->bindMaterial(*COMMAND.m_shader, COMMAND.m_modelUniforms->m_mesh);
+
+			if (COMMAND.m_batchable)
+				COMMAND.m_mesh->drawTransforms(COMMAND.m_level, transform_buffer, transform_offset +
+					static_cast<GLintptr>(sizeof(glm::mat4)) * BATCH.m_firstTransform, BATCH.m_numCommands);
+			else
+				COMMAND.m_mesh->drawLevel(COMMAND.m_level);
+			break;
+		case DrawType::IMPOSTORS:
+			if (BIND_MATERIAL)
+				COMMAND.m_impostor->bindMaterial(*COMMAND.m_shader);
+
+			COMMAND.m_impostor->draw();
+			break;
+		case DrawType::SKYBOX:
+			if (BIND_MATERIAL)
+				COMMAND.m_skybox->bindMaterial(*COMMAND.m_shader);
+
+			COMMAND.m_skybox->draw();
+			break;
+		}
+	}
+}
+
+void RenderQueue::setBatching(bool batching)
+{
+	m_batching = batching;
+}
+
+uint64_t RenderQueue::makeSortKey(RenderPass pass, uint32_t program, uint32_t material, uint32_t vao, float depth)
+{
+	// The bits of a positive float sort the same as its value, so the top 20 below the (zero) sign bit make the depth
+	// key. Anything behind the camera counts as right at it
+	const float CLAMPED_DEPTH = depth > 0.0f ? depth : 0.0f;
+	uint32_t depthBits = 0;
+	std::memcpy(&depthBits, &CLAMPED_DEPTH, sizeof(float));
+	depthBits >>= 11;
+
+	if (pass == RenderPass::BLENDED)
+		depthBits = ~depthBits & 0xFFFFF;
+
+	return (static_cast<uint64_t>(pass) & 0x3) << 62 | (static_cast<uint64_t>(program) & 0x3FF) << 52 |
+		(static_cast<uint64_t>(material) & 0xFFFF) << 36 | (static_cast<uint64_t>(vao) & 0xFFFF) << 20 | depthBits;
+}
+
+uint32_t RenderQueue::generateMaterialID()
+{
+	return nextMaterialID++;
+}
+
+float RenderQueue::getViewDepth(const glm::vec3& position) const
+{
+	return -(m_view * glm::vec4(position, 1.0f)).z;
+}
+
+const std::vector<RenderCommand>& RenderQueue::getCommands() const
+{
+	return m_commands;
+}
+
+const std::vector<uint32_t>& RenderQueue::getOrder() const
+{
+	return m_order;
+}
+
+const std::vector<RenderBatch>& RenderQueue::getBatches() const
+{
+	return m_batches;
+}
+
+const std::vector<glm::mat4>& RenderQueue::getBatchTransforms() const
+{
+	return m_batchTransforms;
+}
+
+const RenderQueueStats& RenderQueue::getStats() const
+{
+	return m_stats;
+}
\ No newline at end of file
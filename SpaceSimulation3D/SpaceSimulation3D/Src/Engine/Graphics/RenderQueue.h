@@ -0,0 +1,131 @@
+#pragma once
+#include "Engine/Buffers/BufferObjects.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class ShaderProgram;
+class MeshObject;
+class ImpostorAtlas;
+class Skybox;
+struct ModelUniforms;
+
+enum class RenderPass
+{
+	SOLID, // Front to back, so the depth test rejects as much as it can
+	SKY, // After everything solid, only filling what nothing else covered
+	BLENDED // Back to front, over everything else
+};
+
+enum class DrawType
+{
+	MESH, // One level of detail of a mesh, instanced or not
+	IMPOSTORS, // Every impostor instance of an atlas
+	SKYBOX
+};
+
+// A draw waiting in the render queue. A material is everything the drawn object binds besides its program and vao
+// (textures, material block, decoding uniforms), told apart by the IDs handed out by generateMaterialID()
+struct RenderCommand
+{
+	uint64_t m_sortKey = 0;
+	DrawType m_type = DrawType::MESH;
+	const ShaderProgram* m_shader = nullptr;
+	uint32_t m_program = 0; // Program of the shader, filled in when submitted (unless there is no shader)
+	uint32_t m_material = 0, m_vao = 0;
+
+	union
+	{
+		const MeshObject* m_mesh;
+		const ImpostorAtlas* m_impostor;
+		const Skybox* m_skybox;
+	};
+
+	const ModelUniforms* m_modelUniforms = nullptr; // Handles of the model's uniforms in the shader (meshes only)
+	uint32_t m_transform = 0; // Index of the model matrix in the queue (meshes only)
+	uint32_t m_level = 0; // Level of detail to draw (meshes only)
+	bool m_batchable = false; // Drawn once per model matrix, so copies of it can share a draw (non-instanced meshes only)
+
+	RenderCommand() : m_mesh(nullptr) {}
+};
+
+// A run of sorted commands drawn with a single draw call: copies of the same level of the same mesh, or just the one
+// command if it can't be batched
+struct RenderBatch
+{
+	uint32_t m_first = 0, m_numCommands = 0; // Where the run starts in the sorted order, and its length
+	uint32_t m_firstTransform = 0; // Where the run's model matrices start in the batch transforms (batchable only)
+};
+
+struct RenderQueueStats
+{
+	uint32_t m_commands = 0; // Commands executed by the last frame
+	uint32_t m_drawCalls = 0; // Draw calls the commands were issued with, once batched
+	uint32_t m_batchedCommands = 0; // Commands that got drawn along with a copy before them instead of on their own
+	uint32_t m_programSwitches = 0;
+	uint32_t m_materialSwitches = 0; // Texture sets (along with their material blocks) bound
+	uint32_t m_vaoSwitches = 0;
+	double m_sortSeconds = 0.0;
+};
+
+// Collects the draws of a frame as commands, then executes them ordered by their 64 bit sort keys, which pack (from
+// the most significant bits) the pass in 2 bits, the program in 10, the material in 16, the vao in 16 and the view
+// depth in 20. Sorting groups every draw sharing a program, then a material, then a vao, so executing them in order
+// binds each of those as few times as it can and skips whatever the draw before already bound. The depth only orders
+// draws sharing all of their state, front to back (back to front in the blended pass).
+//
+// The IDs get truncated to their bits in the key, so two of them may end up sharing a key range. That only costs some
+// extra switches, the execution compares the full IDs. The keys are sorted with a least significant digit radix sort,
+// 8 bits at a time, skipping every digit all the keys share.
+//
+// Copies of a non-instanced mesh (the same level, material and shader, only the model matrix differing) share every
+// bit of their keys but the depth, so sorting leaves them next to each other. Batching merges each such run into a
+// single instanced draw, the model matrices of the run laid out one after another in the batch transforms, which the
+// caller streams to the GPU before executing
+class RenderQueue
+{
+private:
+	std::vector<RenderCommand> m_commands;
+	std::vector<glm::mat4> m_transforms;
+	glm::mat4 m_view;
+
+	std::vector<uint64_t> m_keys, m_scratchKeys;
+	std::vector<uint32_t> m_order, m_scratchOrder; // Indices of the commands, by sort key once sorted
+	RenderQueueStats m_stats;
+
+	bool m_batching;
+	std::vector<RenderBatch> m_batches;
+	std::vector<glm::mat4> m_batchTransforms; // Model matrices of the batchable commands, in the order they get drawn
+	std::shared_ptr<VertexBuffer> m_transformVBO; // Holds the batch transforms when the caller had no room for them
+	GLsizeiptr m_transformCapacity;
+public:
+	RenderQueue();
+	~RenderQueue();
+
+	void beginFrame(const glm::mat4& view); // Drops the commands of the last frame, the depths are taken in the given view
+	uint32_t addTransform(const glm::mat4& model); // Stores a model matrix for the frame's commands, returning its index
+	void submit(RenderCommand command, RenderPass pass, float depth); // Queues the command, keyed for the pass at the view depth
+
+	void sort(); // Orders the queued commands by their sort keys
+	void buildBatches(); // Merges the runs of copies in the sorted order into batches, gathering their model matrices
+	void prepare(); // Sorts the commands then batches them, ready for their transforms to be uploaded
+
+	// execute() : Binds the state of the prepared batches and draws them, reading the batch transforms from the given
+	// buffer at the byte offset. With no buffer (0) they get uploaded to one of the queue's own instead (render thread only)
+	void execute(uint32_t transform_buffer, GLintptr transform_offset);
+
+	void setBatching(bool batching); // Sets whether copies get merged into batches, or each command is drawn on its own
+
+	static uint64_t makeSortKey(RenderPass pass, uint32_t program, uint32_t material, uint32_t vao, float depth); // Packs the key of a command
+	static uint32_t generateMaterialID(); // Returns a material ID no other material has (main thread only)
+public:
+	float getViewDepth(const glm::vec3& position) const; // Returns how far in front of the camera the point lies
+
+	const std::vector<RenderCommand>& getCommands() const; // Returns the commands in the order they were submitted
+	const std::vector<uint32_t>& getOrder() const; // Returns the indices of the commands, sorted once sort() ran
+	const std::vector<RenderBatch>& getBatches() const; // Returns the batches the sorted commands were merged into
+	const std::vector<glm::mat4>& getBatchTransforms() const; // Returns the model matrices the batches read, to upload before executing
+	const RenderQueueStats& getStats() const; // Returns the batching, switches and timing of the last execution
+};
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "RenderThread.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double getElapsedSeconds(const Clock::time_point& start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+}
+
+RenderThread::RenderThread(std::shared_ptr<WindowFrame> window, uint32_t num_packets,
+	std::function<void(uint32_t)> submit_task) :
+	m_window(window), m_submitTask(submit_task), m_running(true)
+{
+	for (uint32_t index = 0; index < std::max(num_packets, 1u); index++)
+		m_freePackets.push_back(index);
+
+	// The context has to be released here before the render thread can make it current
+	m_window->setContextCurrent(false);
+	m_thread = std::thread(&RenderThread::threadLoop, this);
+}
+
+RenderThread::~RenderThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_running = false;
+	}
+	m_submittedCondition.notify_all();
+
+	m_thread.join();
+	m_window->setContextCurrent(true);
+}
+
+void RenderThread::threadLoop()
+{
+	m_window->setContextCurrent(true);
+
+	while (true)
+	{
+		// Wait for the next packet, only stopping once every one submitted has been drawn
+		const Clock::time_point IDLE_START = Clock::now();
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_submittedCondition.wait(lock, [this]() { return !m_submittedPackets.empty() || !m_running; });
+
+		if (m_submittedPackets.empty())
+			break;
+
+		const uint32_t PACKET_INDEX = m_submittedPackets.front();
+		m_submittedPackets.pop_front();
+		m_timings.m_idleSeconds += getElapsedSeconds(IDLE_START);
+		lock.unlock();
+
+		const Clock::time_point SUBMIT_START = Clock::now();
+		m_submitTask(PACKET_INDEX);
+		const double SUBMIT_SECONDS = getElapsedSeconds(SUBMIT_START);
+
+		const Clock::time_point SWAP_START = Clock::now();
+		m_window->swapBuffers();
+		const double SWAP_SECONDS = getElapsedSeconds(SWAP_START);
+
+		// Every draw reading the packet has been issued, so it can be written again
+		lock.lock();
+		m_timings.m_numFrames++;
+		m_timings.m_submitSeconds += SUBMIT_SECONDS;
+		m_timings.m_swapSeconds += SWAP_SECONDS;
+		m_timings.m_stateChanges = GLState::getFrameCounters();
+
+		m_freePackets.push_back(PACKET_INDEX);
+		lock.unlock();
+		m_freedCondition.notify_all();
+	}
+
+	m_window->setContextCurrent(false);
+}
+
+uint32_t RenderThread::acquirePacket()
+{
+	const Clock::time_point WAIT_START = Clock::now();
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_freedCondition.wait(lock, [this]() { return !m_freePackets.empty(); });
+
+	const uint32_t PACKET_INDEX = m_freePackets.front();
+	m_freePackets.pop_front();
+	m_timings.m_acquireWaitSeconds += getElapsedSeconds(WAIT_START);
+
+	return PACKET_INDEX;
+}
+
+void RenderThread::submitPacket(uint32_t packet_index, double cpu_seconds)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_submittedPackets.push_back(packet_index);
+		m_timings.m_cpuSeconds += cpu_seconds;
+	}
+
+	m_submittedCondition.notify_one();
+}
+
+RenderTimings RenderThread::takeTimings()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const RenderTimings TIMINGS = m_timings;
+	m_timings = RenderTimings();
+
+	return TIMINGS;
+}
\ No newline at end of file
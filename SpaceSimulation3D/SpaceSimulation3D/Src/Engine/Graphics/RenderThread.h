@@ -0,0 +1,55 @@
+#pragma once
+#include "Engine/Graphics/WindowFrame.h"
+#include "Engine/Utils/GLStateCache.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Time spent on either side of the render thread, summed over the frames since the timings were last taken
+struct RenderTimings
+{
+	uint32_t m_numFrames = 0; // Frames the render thread finished drawing
+	double m_cpuSeconds = 0.0; // Preparing the packets (simulation, culling, binning) on the thread feeding them
+	double m_acquireWaitSeconds = 0.0; // Waiting for a free packet, the submission falling behind the preparation
+	double m_submitSeconds = 0.0; // Issuing the GL calls of the packets
+	double m_swapSeconds = 0.0; // Swapping the buffers, where the driver blocks once the GPU falls behind
+	double m_idleSeconds = 0.0; // The render thread waiting for a packet, the preparation falling behind the submission
+	GLStateCounters m_stateChanges; // State changes of the last frame drawn
+};
+
+// Owns the OpenGL context on a thread of its own, which does nothing but draw the frame packets handed to it. The
+// thread feeding it fills a packet, submits it and moves straight on to the next one, so preparing frame N + 1 overlaps
+// submitting frame N. The packets live with the caller and are referred to by index: an acquired packet is the
+// caller's to write until it gets submitted, then the render thread's to read until its draws have been issued. With 2
+// packets the preparation runs at most one frame ahead of the submission.
+//
+// While the thread runs, GL may only be touched from the submit task. The context moves over to the render thread on
+// construction and back to the constructing thread on destruction, so resources can be created before and deleted after
+class RenderThread
+{
+private:
+	const std::shared_ptr<WindowFrame> m_window;
+	const std::function<void(uint32_t)> m_submitTask; // Issues the GL calls drawing the packet of the given index
+
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_submittedCondition, m_freedCondition;
+	std::deque<uint32_t> m_freePackets, m_submittedPackets;
+	bool m_running;
+
+	RenderTimings m_timings;
+private:
+	void threadLoop(); // Draws the submitted packets in order and swaps the buffers after each, until stopped
+public:
+	RenderThread(std::shared_ptr<WindowFrame> window, uint32_t num_packets, std::function<void(uint32_t)> submit_task);
+	~RenderThread(); // Draws the packets still submitted, then gives the context back to the calling thread
+
+	uint32_t acquirePacket(); // Waits for a packet the render thread is done with and returns its index
+	void submitPacket(uint32_t packet_index, double cpu_seconds); // Hands a filled packet over to be drawn, with the time preparing it took
+
+	RenderTimings takeTimings(); // Returns the timings summed since the last call and starts summing anew
+};
\ No newline at end of file
@@ -0,0 +1,28 @@
+#include "SceneLighting.h"
+
+static_assert(sizeof(LightsBlock) == 208, "LightsBlock has to match the std140 layout of the Lights block");
+
+LightsBlock::LightsBlock(const DirectionalLight& sunlight, const SpotLight& flashlight, const glm::vec3& camera_pos,
+	const ClusterGridParams& clusters) :
+	m_sunlight(), m_flashlight(), m_cameraPos(camera_pos), m_clusterSliceScale(clusters.m_sliceScale),
+	m_clusterGridSize(clusters.m_gridSize), m_clusterSliceBias(clusters.m_sliceBias),
+	m_clusterTileScale(clusters.m_tileScale), m_padding()
+{
+	m_sunlight.m_direction = sunlight.m_direction;
+	m_sunlight.m_ambient = sunlight.m_ambient;
+	m_sunlight.m_diffuse = sunlight.m_diffuse;
+	m_sunlight.m_specular = sunlight.m_specular;
+
+	m_flashlight.m_position = flashlight.m_position;
+	m_flashlight.m_direction = flashlight.m_direction;
+	m_flashlight.m_ambient = flashlight.m_ambient;
+	m_flashlight.m_diffuse = flashlight.m_diffuse;
+	m_flashlight.m_specular = flashlight.m_specular;
+
+	m_flashlight.m_constant = flashlight.m_constant;
+	m_flashlight.m_linear = flashlight.m_linear;
+	m_flashlight.m_quadratic = flashlight.m_quadratic;
+	m_flashlight.m_innerCutOff = flashlight.m_innerCutOff;
+	m_flashlight.m_outerCutOff = flashlight.m_outerCutOff;
+	m_flashlight.m_enabled = flashlight.m_enabled ? 1 : 0;
+}
\ No newline at end of file
@@ -1,6 +1,12 @@
 #pragma once
 #include <glm/glm.hpp>
 
+struct DirectionalLight
+{
+	glm::vec3 m_direction;
+	glm::vec3 m_ambient, m_diffuse, m_specular;
+};
+
 struct SpotLight
 {
 	glm::vec3 m_position, m_direction;
@@ -9,4 +15,66 @@ struct SpotLight
 	float m_constant, m_linear, m_quadratic;
 	float m_innerCutOff, m_outerCutOff;
 	bool m_enabled = true;
+};
+
+// Light shaded through the light clusters, it lights nothing past its radius so it only lands in the clusters it
+// reaches. Its 32 bytes are uploaded as is, 2 RGBA32F texels per light
+struct PointLight
+{
+	glm::vec3 m_position;
+	float m_radius;
+	glm::vec3 m_color;
+	float m_intensity;
+};
+
+// What the shaders need to find the cluster a fragment lies in
+struct ClusterGridParams
+{
+	glm::uvec3 m_gridSize = glm::uvec3(1); // Clusters across, down and deep
+	float m_sliceScale = 0.0f, m_sliceBias = 0.0f; // Depth slice = log(view depth) * scale + bias
+	glm::vec2 m_tileScale = glm::vec2(0.0f); // Clusters per pixel across and down
+};
+
+// Layout of the Lights uniform block (std140), shared by every lit shader and streamed once per frame. Every vec3
+// takes up 16 bytes, the shaders order their members so the last 4 hold a scalar wherever they can
+struct LightsBlock
+{
+	struct
+	{
+		glm::vec3 m_direction;
+		float m_padding0;
+		glm::vec3 m_ambient;
+		float m_padding1;
+		glm::vec3 m_diffuse;
+		float m_padding2;
+		glm::vec3 m_specular;
+		float m_padding3;
+	} m_sunlight;
+
+	struct
+	{
+		glm::vec3 m_position;
+		float m_constant;
+		glm::vec3 m_direction;
+		float m_linear;
+		glm::vec3 m_ambient;
+		float m_quadratic;
+		glm::vec3 m_diffuse;
+		float m_innerCutOff;
+		glm::vec3 m_specular;
+		float m_outerCutOff;
+
+		int m_enabled; // GLSL bools are 4 bytes
+		int m_padding[3];
+	} m_flashlight;
+
+	glm::vec3 m_cameraPos;
+	float m_clusterSliceScale;
+	glm::uvec3 m_clusterGridSize;
+	float m_clusterSliceBias;
+	glm::vec2 m_clusterTileScale;
+	float m_padding[2];
+
+	LightsBlock(const DirectionalLight& sunlight, const SpotLight& flashlight, const glm::vec3& camera_pos,
+		const ClusterGridParams& clusters);
 };
\ No newline at end of file
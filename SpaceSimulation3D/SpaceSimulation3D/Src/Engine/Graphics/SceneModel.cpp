@@ -1,23 +1,134 @@
 #include "SceneModel.h"
+#include "Engine/Graphics/MeshSimplifier.h"
+#include "Engine/Graphics/MeshOptimizer.h"
 #include "Engine/Utils/LoggingManager.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <limits>
+
+namespace
+{
+	// Returns how far the point is from the closest point of the triangle (Ericson's region tests)
+	float getTriangleDistance(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		const glm::vec3 AB = b - a, AC = c - a, AP = point - a;
+		const float D1 = glm::dot(AB, AP), D2 = glm::dot(AC, AP);
+		if (D1 <= 0.0f && D2 <= 0.0f)
+			return glm::length(AP);
+
+		const glm::vec3 BP = point - b;
+		const float D3 = glm::dot(AB, BP), D4 = glm::dot(AC, BP);
+		if (D3 >= 0.0f && D4 <= D3)
+			return glm::length(BP);
+
+		const float VC = D1 * D4 - D3 * D2;
+		if (VC <= 0.0f && D1 >= 0.0f && D3 <= 0.0f)
+			return glm::length(point - (a + AB * (D1 / (D1 - D3))));
+
+		const glm::vec3 CP = point - c;
+		const float D5 = glm::dot(AB, CP), D6 = glm::dot(AC, CP);
+		if (D6 >= 0.0f && D5 <= D6)
+			return glm::length(CP);
+
+		const float VB = D5 * D2 - D1 * D6;
+		if (VB <= 0.0f && D2 >= 0.0f && D6 <= 0.0f)
+			return glm::length(point - (a + AC * (D2 / (D2 - D6))));
+
+		const float VA = D3 * D6 - D5 * D4;
+		if (VA <= 0.0f && D4 - D3 >= 0.0f && D5 - D6 >= 0.0f)
+			return glm::length(point - (b + (c - b) * ((D4 - D3) / ((D4 - D3) + (D5 - D6)))));
+
+		const float DENOM = 1.0f / (VA + VB + VC);
+		return glm::length(point - (a + AB * (VB * DENOM) + AC * (VC * DENOM)));
+	}
+}
 
 SceneModel::SceneModel(const std::string& path, const std::string& texture_dir, float shininess,
-	const void* instanced_array, uint32_t num_instances) :
+	const void* instanced_array, uint32_t num_instances, uint32_t num_lod_levels, VertexFormat vertex_format) :
 	m_shininess(shininess), m_position(glm::vec3(1.0f)), m_scale(glm::vec3(1.0f)),
 	m_rotationAxis(glm::vec3(1.0f)), m_rotationAngle(0.0f), m_textureDir(texture_dir), 
-	m_instancedArray(instanced_array), m_numInstances(num_instances)
+	m_instancedArray(instanced_array), m_numInstances(num_instances), m_vertexFormat(vertex_format),
+	m_numLODLevels(instanced_array ? std::max(num_lod_levels, 1u) : 1), m_lodErrors(m_numLODLevels, 0.0f),
+	m_lodTriangles(m_numLODLevels, 0), m_lodBuildSeconds(0.0), m_optimizeSeconds(0.0),
+	m_innerRadius(std::numeric_limits<float>::max()), m_outerRadius(0.0f)
 {
-	// Load the model data from file
+	// Load the model data from file, welding the corners that share every attribute. Formats like OBJ give each face
+	// corner its own vertex, which leaves the simplifier and the vertex cache nothing to share
 	Assimp::Importer importer;
-	const aiScene* modelScene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+	const aiScene* modelScene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices |
+		aiProcess_FlipUVs);
 	if (!modelScene || modelScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !modelScene->mRootNode)
 		OutputLog("An error occurred while loading the model from path: " + path, Logging::Severity::FATAL);
 	else
 		this->processNode(modelScene->mRootNode, modelScene);
+
+	this->uploadMaterials();
+
+	if (m_numLODLevels > 1)
+	{
+		std::stringstream report;
+		report << "Simplified " << path << " into " << m_numLODLevels << " LOD levels in " << m_lodBuildSeconds * 1e3 <<
+			" ms:";
+
+		for (uint32_t level = 0; level < m_numLODLevels; level++)
+			report << " [" << m_lodTriangles[level] << " triangles, error " << m_lodErrors[level] << "]";
+
+		OutputLog(report.str(), Logging::Severity::NOTIFICATION);
+
+		// Every vertex being locked as a seam (such as an unwelded mesh) leaves the levels as the full mesh
+		if (m_lodTriangles.back() >= m_lodTriangles.front())
+			OutputLog("The LOD levels of " + path + " lost no triangles, every level draws the full mesh",
+				Logging::Severity::WARNING);
+	}
+
+	if (m_optimizeStats.m_numTriangles > 0)
+	{
+		const IndexOptimizationStats& STATS = m_optimizeStats;
+		const double TRIANGLES = STATS.m_numTriangles, VERTICES = STATS.m_numVertices;
+
+		std::stringstream report;
+		report << "Optimized the indices of " << path << " in " << m_optimizeSeconds * 1e3 << " ms: ACMR " <<
+			STATS.m_acmrBefore / TRIANGLES << " -> " << STATS.m_acmrAfter / TRIANGLES << ", ATVR " <<
+			STATS.m_atvrBefore / VERTICES << " -> " << STATS.m_atvrAfter / VERTICES << ", overdraw " <<
+			STATS.m_overdrawBefore / TRIANGLES << " -> " << STATS.m_overdrawAfter / TRIANGLES;
+
+		OutputLog(report.str(), Logging::Severity::NOTIFICATION);
+
+		// Without a vertex shared between triangles the cache never hits, so no order can improve on ACMR 3 and ATVR 1
+		if (STATS.m_numVertices >= STATS.m_numTriangles * 3)
+			OutputLog("The meshes of " + path + " share no vertices, reordering their indices can't save any transforms",
+				Logging::Severity::WARNING);
+	}
+
+	if (m_vertexFormat == VertexFormat::QUANTIZED && !m_meshes.empty())
+	{
+		size_t numVertices = 0, vertexBytes = 0;
+		QuantizationStats worst;
+		for (const auto& mesh : m_meshes)
+		{
+			numVertices += mesh.getVertexBytes() / sizeof(QuantizedVertexData);
+			vertexBytes += mesh.getVertexBytes();
+
+			const QuantizationStats& STATS = mesh.getQuantization();
+			worst.m_maxPositionError = std::max(worst.m_maxPositionError, STATS.m_maxPositionError);
+			worst.m_maxNormalError = std::max(worst.m_maxNormalError, STATS.m_maxNormalError);
+			worst.m_maxTextureError = std::max(worst.m_maxTextureError, STATS.m_maxTextureError);
+		}
+
+		std::stringstream report;
+		report << "Quantized the " << numVertices << " vertices of " << path << ": " <<
+			numVertices * sizeof(VertexData) / 1024.0 << " KB -> " << vertexBytes / 1024.0 << " KB, max error " <<
+			worst.m_maxPositionError << " units (position), " << worst.m_maxNormalError << " degrees (normal), " <<
+			worst.m_maxTextureError << " (texture coordinates)";
+
+		OutputLog(report.str(), Logging::Severity::NOTIFICATION);
+	}
 }
 
 SceneModel::~SceneModel() {}
@@ -63,6 +174,7 @@ MeshObject SceneModel::processMeshData(aiMesh* mesh, const aiScene* scene)
 		else
 			vertex.m_texturePos = glm::vec2(0.0f);
 
+		m_outerRadius = std::max(m_outerRadius, glm::length(vertexPos));
 		vertices.emplace_back(vertex);
 	}
 
@@ -74,6 +186,13 @@ MeshObject SceneModel::processMeshData(aiMesh* mesh, const aiScene* scene)
 			indices.emplace_back(face.mIndices[count]);
 	}
 
+	// Keep track of how close the surface comes to the model origin, nothing within that distance gets drawn over
+	for (size_t index = 0; index + 2 < indices.size(); index += 3)
+	{
+		m_innerRadius = std::min(m_innerRadius, getTriangleDistance(glm::vec3(0.0f), vertices[indices[index]].m_vertexPos,
+			vertices[indices[index + 1]].m_vertexPos, vertices[indices[index + 2]].m_vertexPos));
+	}
+
 	// Finally we retrieve the mesh's material
 	material.shininess = m_shininess;
 
@@ -90,7 +209,91 @@ MeshObject SceneModel::processMeshData(aiMesh* mesh, const aiScene* scene)
 			material = this->getGenericMat(scene->mMaterials[mesh->mMaterialIndex]);
 	}
 
-	return MeshObject(vertices, indices, material, m_instancedArray, m_numInstances);
+	if (m_numLODLevels == 1)
+	{
+		m_lodTriangles[0] += static_cast<uint32_t>(indices.size() / 3);
+		this->optimizeMesh(vertices, indices, { static_cast<uint32_t>(indices.size()) });
+		return MeshObject(vertices, indices, material, m_instancedArray, m_numInstances, {}, m_vertexFormat);
+	}
+
+	// Simplify the mesh into its levels of detail and store them one after another in the same index buffer
+	const auto START = std::chrono::high_resolution_clock::now();
+
+	std::vector<glm::vec3> positions;
+	for (const auto& vertex : vertices)
+		positions.emplace_back(vertex.m_vertexPos);
+
+	const std::vector<SimplifiedLevel> LEVELS = MeshSimplifier::buildLODChain(positions, indices, m_numLODLevels);
+	std::vector<uint32_t> lodIndices, lodIndexCounts;
+
+	for (uint32_t level = 0; level < LEVELS.size(); level++)
+	{
+		lodIndices.insert(lodIndices.end(), LEVELS[level].m_indices.begin(), LEVELS[level].m_indices.end());
+		lodIndexCounts.emplace_back(static_cast<uint32_t>(LEVELS[level].m_indices.size()));
+
+		m_lodTriangles[level] += static_cast<uint32_t>(LEVELS[level].m_indices.size() / 3);
+		m_lodErrors[level] = std::max(m_lodErrors[level], LEVELS[level].m_errorBound);
+	}
+
+	m_lodBuildSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - START).count();
+	this->optimizeMesh(vertices, lodIndices, lodIndexCounts);
+	return MeshObject(vertices, lodIndices, material, m_instancedArray, m_numInstances, lodIndexCounts,
+		m_vertexFormat);
+}
+
+void SceneModel::optimizeMesh(std::vector<VertexData>& vertices, std::vector<uint32_t>& indices,
+	const std::vector<uint32_t>& level_index_counts)
+{
+	const auto START = std::chrono::high_resolution_clock::now();
+	const uint32_t NUM_VERTICES = static_cast<uint32_t>(vertices.size());
+
+	std::vector<glm::vec3> positions;
+	for (const auto& vertex : vertices)
+		positions.emplace_back(vertex.m_vertexPos);
+
+	// Every level is reordered on its own, since each gets drawn on its own
+	uint32_t firstIndex = 0;
+	for (uint32_t level = 0; level < level_index_counts.size(); level++)
+	{
+		std::vector<uint32_t> levelIndices(indices.begin() + firstIndex,
+			indices.begin() + firstIndex + level_index_counts[level]);
+
+		// The report covers the full detail level, weighted by the size of each mesh
+		const double TRIANGLES = levelIndices.size() / 3.0;
+		if (level == 0)
+		{
+			const VertexCacheStats STATS = MeshOptimizer::analyzeVertexCache(levelIndices, NUM_VERTICES);
+			m_optimizeStats.m_acmrBefore += STATS.m_acmr * TRIANGLES;
+			m_optimizeStats.m_atvrBefore += STATS.m_atvr * NUM_VERTICES;
+			m_optimizeStats.m_overdrawBefore += MeshOptimizer::analyzeOverdraw(positions, levelIndices) * TRIANGLES;
+		}
+
+		MeshOptimizer::optimizeVertexCache(levelIndices, NUM_VERTICES);
+		MeshOptimizer::optimizeOverdraw(positions, levelIndices);
+
+		if (level == 0)
+		{
+			const VertexCacheStats STATS = MeshOptimizer::analyzeVertexCache(levelIndices, NUM_VERTICES);
+			m_optimizeStats.m_acmrAfter += STATS.m_acmr * TRIANGLES;
+			m_optimizeStats.m_atvrAfter += STATS.m_atvr * NUM_VERTICES;
+			m_optimizeStats.m_overdrawAfter += MeshOptimizer::analyzeOverdraw(positions, levelIndices) * TRIANGLES;
+			m_optimizeStats.m_numTriangles += static_cast<uint32_t>(TRIANGLES);
+			m_optimizeStats.m_numVertices += NUM_VERTICES;
+		}
+
+		std::copy(levelIndices.begin(), levelIndices.end(), indices.begin() + firstIndex);
+		firstIndex += level_index_counts[level];
+	}
+
+	// The coarser levels only use vertices the full detail level does, so numbering the vertices in the order all the
+	// levels use them (full detail first) keeps fetches in order for every level
+	const std::vector<uint32_t> REMAP = MeshOptimizer::optimizeVertexFetch(indices, NUM_VERTICES);
+	std::vector<VertexData> reordered(NUM_VERTICES);
+	for (uint32_t vertex = 0; vertex < NUM_VERTICES; vertex++)
+		reordered[REMAP[vertex]] = vertices[vertex];
+
+	vertices.swap(reordered);
+	m_optimizeSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - START).count();
 }
 
 std::vector<TextureData> SceneModel::getMatTextures(aiMaterial* mat, aiTextureType type) const
@@ -102,10 +305,7 @@ std::vector<TextureData> SceneModel::getMatTextures(aiMaterial* mat, aiTextureTy
 		mat->GetTexture(type, index, &path);
 
 		TextureData textureData;
-		if (type == aiTextureType_DIFFUSE)
-			textureData.m_type = "DIFFUSE_TEXTURE";
-		else if (type == aiTextureType_SPECULAR)
-			textureData.m_type = "SPECULAR_TEXTURE";
+		textureData.m_type = type == aiTextureType_SPECULAR ? TextureType::SPECULAR : TextureType::DIFFUSE;
 
 		textureData.m_texture = std::make_shared<TextureComponent>(m_textureDir + "/" + std::string(path.C_Str()));
 		//textureData.m_texture->SetWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
@@ -131,6 +331,36 @@ Material SceneModel::getGenericMat(aiMaterial* mat) const
 	return material;
 }
 
+void SceneModel::uploadMaterials()
+{
+	if (m_meshes.empty())
+		return;
+
+	// Every block has to start on the uniform buffer offset alignment to be bound by range
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	const size_t STRIDE = (sizeof(MaterialBlock) + alignment - 1) / alignment * alignment;
+
+	std::vector<uint8_t> blocks(STRIDE * m_meshes.size(), 0);
+	for (uint32_t index = 0; index < m_meshes.size(); index++)
+	{
+		const MaterialBlock BLOCK = m_meshes[index].getMaterialBlock();
+		std::memcpy(blocks.data() + STRIDE * index, &BLOCK, sizeof(MaterialBlock));
+	}
+
+	m_materialBuffer = std::make_shared<UniformBuffer>(blocks.data(), static_cast<GLsizeiptr>(blocks.size()),
+		GL_STATIC_DRAW);
+
+	for (uint32_t index = 0; index < m_meshes.size(); index++)
+		m_meshes[index].setMaterialBuffer(m_materialBuffer, static_cast<GLintptr>(STRIDE * index));
+}
+
+void SceneModel::queryUniforms(const ShaderProgram& shader) const
+{
+	m_uniforms.m_program = shader.getID();
+	m_uniforms.m_mesh = MeshObject::getMeshUniforms(shader);
+}
+
 void SceneModel::setPosition(const glm::vec3& pos)
 {
 	m_position = pos;
@@ -147,49 +377,124 @@ void SceneModel::setRotation(const glm::vec3& axis, float angle)
 	m_rotationAngle = angle;
 }
 
-void SceneModel::render(std::shared_ptr<ShaderProgram> shader, const SceneCamera& camera, 
-	const SpotLight* flashlight) const
+void SceneModel::updateInstances(const void* instanced_array, uint32_t num_instances)
 {
-	glm::mat4 model;
-	model = glm::translate(model, m_position);
-	model = glm::scale(model, m_scale);
-	model = glm::rotate(model, glm::radians(m_rotationAngle), m_rotationAxis);
+	for (auto& mesh : m_meshes)
+		mesh.updateInstances(instanced_array, num_instances);
+}
+
+void SceneModel::updateLODInstances(const void* instanced_array, const uint32_t* level_offsets)
+{
+	for (auto& mesh : m_meshes)
+		mesh.updateLODInstances(instanced_array, level_offsets);
+}
+
+void SceneModel::setLODInstanceSource(uint32_t buffer_id, GLintptr offset, const uint32_t* level_offsets)
+{
+	for (auto& mesh : m_meshes)
+		mesh.setLODInstanceSource(buffer_id, offset, level_offsets);
+}
 
-	shader->bindProgram();
-	shader->setUniform("model", model);
-	shader->setUniform("cameraPos", camera.getPosition());
+void SceneModel::bakeImpostor(std::shared_ptr<ShaderProgram> bake_shader, uint32_t frames_per_side, uint32_t frame_size)
+{
+	if (!m_instancedArray || m_meshes.empty())
+		return;
 
-	shader->setUniform("sunlight.direction", glm::vec3(0.0f, -0.3f, 0.65f));
-	shader->setUniform("sunlight.ambient", glm::vec3(0.0f));
-	shader->setUniform("sunlight.diffuse", glm::vec3(1.0f));
-	shader->setUniform("sunlight.specular", glm::vec3(0.5f));
+	m_impostor = std::make_shared<ImpostorAtlas>(frames_per_side, frame_size, m_outerRadius, m_shininess, m_numInstances);
 
-	// Setup the other lighting uniforms in shader
-	if (flashlight)
+	bake_shader->bindProgram();
+	const UniformHandle VIEW_PROJECTION = bake_shader->getUniformHandle("viewProjection");
+	const MeshUniforms MESH_UNIFORMS = MeshObject::getMeshUniforms(*bake_shader);
+
+	// Every frame views all the meshes at once, around the model origin
+	m_impostor->beginBake();
+	for (uint32_t frameY = 0; frameY < m_impostor->getFramesPerSide(); frameY++)
 	{
-		shader->setUniform("flashlight.enabled", flashlight->m_enabled);
+		for (uint32_t frameX = 0; frameX < m_impostor->getFramesPerSide(); frameX++)
+		{
+			bake_shader->setUniform(VIEW_PROJECTION, m_impostor->bindFrame(frameX, frameY));
+			for (const auto& mesh : m_meshes)
+				mesh.renderSingle(bake_shader, MESH_UNIFORMS);
+		}
+	}
 
-		shader->setUniform("flashlight.position", flashlight->m_position);
-		shader->setUniform("flashlight.direction", flashlight->m_direction);
+	m_impostor->endBake();
 
-		shader->setUniform("flashlight.ambient", flashlight->m_ambient);
-		shader->setUniform("flashlight.diffuse", flashlight->m_diffuse);
-		shader->setUniform("flashlight.specular", flashlight->m_specular);
+	const uint32_t ATLAS_SIZE = m_impostor->getFramesPerSide() * frame_size;
+	std::stringstream report;
+	report << "Baked an impostor atlas of " << m_impostor->getFramesPerSide() << "x" << m_impostor->getFramesPerSide() <<
+		" views (" << ATLAS_SIZE << "x" << ATLAS_SIZE << " texels, " << ATLAS_SIZE * ATLAS_SIZE * 8 / (1024.0 * 1024.0) <<
+		" MB before mips) covering a radius of " << m_outerRadius << " units";
 
-		shader->setUniform("flashlight.constant", flashlight->m_constant);
-		shader->setUniform("flashlight.linear", flashlight->m_linear);
-		shader->setUniform("flashlight.specular", flashlight->m_specular);
+	OutputLog(report.str(), Logging::Severity::NOTIFICATION);
+}
 
-		shader->setUniform("flashlight.innerCutOff", flashlight->m_innerCutOff);
-		shader->setUniform("flashlight.outerCutOff", flashlight->m_outerCutOff);
-	}
+void SceneModel::updateImpostorInstances(const void* instanced_array, uint32_t num_instances)
+{
+	if (m_impostor)
+		m_impostor->updateInstances(instanced_array, num_instances);
+}
 
-	// Render all meshes in model
-	for (auto& mesh : m_meshes)
-		mesh.render(shader);
+void SceneModel::setImpostorInstanceSource(uint32_t buffer_id, GLintptr offset, uint32_t num_instances)
+{
+	if (m_impostor)
+		m_impostor->setInstanceSource(buffer_id, offset, num_instances);
+}
+
+void SceneModel::submit(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader, const uint32_t* level_offsets) const
+{
+	glm::mat4 model;
+	model = glm::translate(model, m_position);
+	model = glm::scale(model, m_scale);
+	model = glm::rotate(model, glm::radians(m_rotationAngle), m_rotationAxis);
+
+	this->submitMeshes(queue, shader, model, level_offsets);
+}
+
+void SceneModel::submit(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader, const glm::mat4& model) const
+{
+	this->submitMeshes(queue, shader, model, nullptr);
+}
+
+void SceneModel::submitMeshes(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader, const glm::mat4& model,
+	const uint32_t* level_offsets) const
+{
+	if (m_uniforms.m_program != shader->getID())
+		this->queryUniforms(*shader);
+
+	// Every mesh shares the model's shader, uniforms and transform
+	RenderCommand command;
+	command.m_shader = shader.get();
+	command.m_modelUniforms = &m_uniforms;
+	command.m_transform = queue.addTransform(model);
+
+	const float DEPTH = queue.getViewDepth(glm::vec3(model[3]));
+	for (const auto& mesh : m_meshes)
+		mesh.submit(queue, command, DEPTH, level_offsets);
+}
+
+void SceneModel::submitImpostors(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader, uint32_t num_instances) const
+{
+	if (m_impostor)
+		m_impostor->submit(queue, shader, queue.getViewDepth(m_position), num_instances);
 }
 
 const glm::vec3& SceneModel::getPosition() const
 {
 	return m_position;
+}
+
+const std::vector<float>& SceneModel::getLODErrors() const
+{
+	return m_lodErrors;
+}
+
+const std::vector<uint32_t>& SceneModel::getLODTriangles() const
+{
+	return m_lodTriangles;
+}
+
+float SceneModel::getInnerRadius() const
+{
+	return m_meshes.empty() ? 0.0f : m_innerRadius;
 }
\ No newline at end of file
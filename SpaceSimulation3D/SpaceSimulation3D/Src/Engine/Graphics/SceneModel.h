@@ -1,10 +1,26 @@
 #pragma once
 #include "Engine/Graphics/MeshObject.h"
-#include "Engine/Graphics/SceneCamera.h"
-#include "Engine/Graphics/SceneLighting.h"
+#include "Engine/Graphics/ImpostorAtlas.h"
 
 #include <assimp/scene.h>
 
+// Handles of the uniforms a model sets, looked up again whenever it gets drawn with another shader
+struct ModelUniforms
+{
+	uint32_t m_program = 0; // Shader program the handles belong to
+	MeshUniforms m_mesh;
+};
+
+// Vertex cache and overdraw figures of the full detail meshes before and after optimizing, summed over the meshes
+// weighted by their triangles (ACMR, overdraw) or vertices (ATVR)
+struct IndexOptimizationStats
+{
+	double m_acmrBefore = 0.0, m_acmrAfter = 0.0;
+	double m_atvrBefore = 0.0, m_atvrAfter = 0.0;
+	double m_overdrawBefore = 0.0, m_overdrawAfter = 0.0;
+	uint32_t m_numTriangles = 0, m_numVertices = 0;
+};
+
 class SceneModel
 {
 private:
@@ -17,23 +33,77 @@ private:
 
 	const void* m_instancedArray;
 	uint32_t m_numInstances;
+
+	const VertexFormat m_vertexFormat;
+	const uint32_t m_numLODLevels;
+	std::vector<float> m_lodErrors; // Largest error bound of each level across the meshes
+	std::vector<uint32_t> m_lodTriangles; // Triangles of each level summed across the meshes
+	double m_lodBuildSeconds;
+
+	IndexOptimizationStats m_optimizeStats;
+	double m_optimizeSeconds;
+	float m_innerRadius; // Closest any triangle comes to the model origin
+	float m_outerRadius; // Furthest any vertex is from the model origin
+
+	std::shared_ptr<ImpostorAtlas> m_impostor; // Views of every mesh the instances can be drawn with instead, if baked
+
+	std::shared_ptr<UniformBuffer> m_materialBuffer; // The material block of every mesh, each at its own aligned offset
+	mutable ModelUniforms m_uniforms;
 private:
 	void processNode(aiNode* node, const aiScene* scene); // Processes each node in the model
 	MeshObject processMeshData(aiMesh* mesh, const aiScene* scene); // Processes and retrieves mesh's data belonging to the model
 
+	// optimizeMesh() : Reorders the triangles of every level for the post-transform cache and overdraw, then the vertices
+	// for fetch locality, the levels laid out one after another in the indices like the MeshObject takes them. Only
+	// helps if triangles share vertices, which welding identical vertices on import provides
+	void optimizeMesh(std::vector<VertexData>& vertices, std::vector<uint32_t>& indices,
+		const std::vector<uint32_t>& level_index_counts);
+
 	std::vector<TextureData> getMatTextures(aiMaterial* mat, aiTextureType type) const; // Returns the textures retrieved from the aiMaterial pointer
 	Material getGenericMat(aiMaterial* mat) const; // Returns a material object with ONLY phong components retrieved (and the shininess value)
+	void uploadMaterials(); // Writes the material block of every mesh into the material buffer
+	void queryUniforms(const ShaderProgram& shader) const; // Looks up the handles of every uniform the model sets in the shader
+
+	// submitMeshes() : Queues the draws of every mesh with the model matrix, the instanced levels counted from the level
+	// offsets if given
+	void submitMeshes(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader, const glm::mat4& model,
+		const uint32_t* level_offsets) const;
 public:
+	// Instanced models given more than one LOD level get each mesh simplified into that many levels at load time, and
+	// the vertices of every mesh get uploaded in the given format
 	SceneModel(const std::string& path, const std::string& texture_dir, float shininess = 128.0f,
-		const void* instanced_array = nullptr, uint32_t num_instances = 0);
+		const void* instanced_array = nullptr, uint32_t num_instances = 0, uint32_t num_lod_levels = 1,
+		VertexFormat vertex_format = VertexFormat::FULL);
 	~SceneModel();
 
 	void setPosition(const glm::vec3& pos); // Sets the position of the model
 	void setScale(const glm::vec3& scale); // Sets the scale of the model
 	void setRotation(const glm::vec3& axis, float angle); // Sets the rotation state of the model
+	void updateInstances(const void* instanced_array, uint32_t num_instances); // Overwrites the instance data of every mesh
+	void updateLODInstances(const void* instanced_array, const uint32_t* level_offsets); // Overwrites the instance data of every level of every mesh
+	void setLODInstanceSource(uint32_t buffer_id, GLintptr offset, const uint32_t* level_offsets); // Draws every mesh's instances straight from another buffer
+
+	// bakeImpostor() : Renders every mesh from frames_per_side * frames_per_side directions into an impostor atlas, each
+	// frame frame_size texels across, which the instances can then be drawn from (instanced models only)
+	void bakeImpostor(std::shared_ptr<ShaderProgram> bake_shader, uint32_t frames_per_side, uint32_t frame_size);
+	void updateImpostorInstances(const void* instanced_array, uint32_t num_instances); // Overwrites the instances drawn as impostors
+	void setImpostorInstanceSource(uint32_t buffer_id, GLintptr offset, uint32_t num_instances); // Draws the impostors straight from another buffer
 
-	void render(std::shared_ptr<ShaderProgram> shader, const SceneCamera& camera,
-		const SpotLight* flashlight = nullptr) const; // Renders the whole model
+	// submit() : Queues the draws of the whole model (the lights are read from the Lights block). Instanced models can be
+	// given the level offsets the frame's instances were binned with, like updateLODInstances() takes them
+	void submit(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader, const uint32_t* level_offsets = nullptr) const;
+
+	// submit() : Queues the draws of a copy of the model with its own model matrix instead. Copies of a non-instanced
+	// model get batched into a single draw per mesh by the render queue
+	void submit(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader, const glm::mat4& model) const;
+	void submitImpostors(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader, uint32_t num_instances) const; // Queues the draw of the frame's impostor instances, if an impostor was baked
 public:
 	const glm::vec3& getPosition() const; // Returns the position of model
+
+	const std::vector<float>& getLODErrors() const; // Returns the error bound of each level of detail, in model units
+	const std::vector<uint32_t>& getLODTriangles() const; // Returns the triangle count of each level of detail
+
+	// getInnerRadius() : Returns the radius of the largest sphere around the model origin that no triangle cuts into, in
+	// model units. For a closed mesh around its origin (like the planet) that sphere lies wholly inside the model
+	float getInnerRadius() const;
 };
\ No newline at end of file
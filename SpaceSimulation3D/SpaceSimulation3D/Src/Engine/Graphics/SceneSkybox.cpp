@@ -1,12 +1,13 @@
 #include "SceneSkybox.h"
 #include "Engine/Utils/LoggingManager.h"
+#include "Engine/Utils/GLStateCache.h"
 
 #include <glad/glad.h>
 #include <stb_image.h>
 #include <array>
 
 Skybox::Skybox(const std::array<std::string, 6>& texture_paths) :
-	m_cubemapID(0)
+	m_cubemapID(0), m_materialID(RenderQueue::generateMaterialID()), m_shaderID(0)
 {
 	// First setup the vbo and vao of skybox
 	std::array<float, 108> vertices
@@ -62,7 +63,7 @@ Skybox::Skybox(const std::array<std::string, 6>& texture_paths) :
 
     // Now setup the cubemap texture object
     glGenTextures(1, &m_cubemapID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubemapID);
+    GLState::bindTexture(0, GL_TEXTURE_CUBE_MAP, m_cubemapID);
 
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -88,25 +89,44 @@ Skybox::Skybox(const std::array<std::string, 6>& texture_paths) :
 
         stbi_image_free(textureData);
     }
-
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 Skybox::~Skybox()
 {
     glDeleteTextures(1, &m_cubemapID);
+    GLState::onTextureDeleted(m_cubemapID);
 }
 
-void Skybox::render(std::shared_ptr<ShaderProgram> shader) const
+void Skybox::submit(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader) const
 {
-    glDepthFunc(GL_LEQUAL);
+    RenderCommand command;
+    command.m_type = DrawType::SKYBOX;
+    command.m_shader = shader.get();
+    command.m_material = m_materialID;
+    command.m_vao = m_vao->getID();
+    command.m_skybox = this;
+
+    // Its depth is always the far plane, wherever the camera is
+    queue.submit(command, RenderPass::SKY, 0.0f);
+}
 
-    shader->bindProgram();
-    shader->setUniform("skybox", 0);
-    m_vao->bind();
+void Skybox::bindMaterial(const ShaderProgram& shader) const
+{
+    if (m_shaderID != shader.getID())
+    {
+        m_shaderID = shader.getID();
+        m_samplerUniform = shader.getUniformHandle("skybox");
+    }
+
+    shader.setUniform(m_samplerUniform, 0);
+    GLState::bindTexture(0, GL_TEXTURE_CUBE_MAP, m_cubemapID);
+}
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubemapID);
+void Skybox::draw() const
+{
+    // The cube sits at the far plane, which only passes where the depth buffer was left cleared
+    GLState::setDepthFunc(GL_LEQUAL);
+    m_vao->bind();
 
     glDrawArrays(GL_TRIANGLES, 0, 36);
 }
\ No newline at end of file
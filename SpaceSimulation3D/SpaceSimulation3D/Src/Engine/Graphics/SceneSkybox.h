@@ -1,6 +1,7 @@
 #pragma once
 #include "Engine/Graphics/ShaderPrograms.h"
 #include "Engine/Buffers/VertexArrays.h"
+#include "Engine/Graphics/RenderQueue.h"
 
 #include <array>
 #include <string>
@@ -11,9 +12,15 @@ class Skybox
 private:
 	uint32_t m_cubemapID;
 	std::shared_ptr<VertexArray> m_vao;
+	uint32_t m_materialID; // Tells the cubemap apart in the render queue
+
+	mutable uint32_t m_shaderID; // Shader the sampler handle was looked up in
+	mutable UniformHandle m_samplerUniform;
 public:
 	Skybox(const std::array<std::string, 6>& texture_paths);
 	~Skybox();
 
-	void render(std::shared_ptr<ShaderProgram> shader) const;
+	void submit(RenderQueue& queue, std::shared_ptr<ShaderProgram> shader) const; // Queues the draw in the sky pass, after everything solid
+	void bindMaterial(const ShaderProgram& shader) const; // Sets the sampler and binds the cubemap
+	void draw() const; // Draws the cube around the camera, once the material is bound
 };
\ No newline at end of file
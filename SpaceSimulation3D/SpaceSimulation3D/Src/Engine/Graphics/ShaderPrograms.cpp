@@ -1,9 +1,12 @@
 #include "ShaderPrograms.h"
 #include "Engine/Utils/LoggingManager.h"
+#include "Engine/Utils/GLStateCache.h"
 
 #include <glad/glad.h>
 #include <sstream>
 #include <fstream>
+#include <cstring>
+#include <algorithm>
 
 ShaderProgram::ShaderProgram(const std::string& vsh_path, const std::string& fsh_path, const std::string& gsh_path) :
 	m_vshPath(vsh_path), m_fshPath(fsh_path), m_gshPath(gsh_path)
@@ -37,6 +40,7 @@ ShaderProgram::ShaderProgram(const std::string& vsh_path, const std::string& fsh
 
 	glLinkProgram(m_ID);
 	this->checkShaderErrors(m_ID, ShaderCheckType::LINKING);
+	this->reflectUniforms();
 
 	// Finally free the shader objects, we don't need them anymore
 	glDeleteShader(vshID);
@@ -69,6 +73,7 @@ std::string ShaderProgram::loadShaderContents(const std::string& file_path) cons
 ShaderProgram::~ShaderProgram()
 {
 	glDeleteProgram(m_ID);
+	GLState::onProgramDeleted(m_ID);
 }
 
 void ShaderProgram::generateShader(uint32_t& id, const char* src, int shader_type) const
@@ -106,15 +111,62 @@ void ShaderProgram::checkShaderErrors(const uint32_t& id, ShaderCheckType check_
 	}
 }
 
-uint32_t ShaderProgram::queryUniformLocation(const uint32_t& id, const std::string& uniform) const
+void ShaderProgram::reflectUniforms()
 {
-	if (m_uniformCache.find(uniform) == m_uniformCache.end())
+	int numUniforms = 0, maxNameLength = 0;
+	glGetProgramiv(m_ID, GL_ACTIVE_UNIFORMS, &numUniforms);
+	glGetProgramiv(m_ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+	for (int index = 0; index < numUniforms; index++)
 	{
-		const uint32_t LOCATION = glGetUniformLocation(id, uniform.c_str());
-		m_uniformCache[uniform] = LOCATION;
+		int nameLength = 0, arraySize = 0;
+		GLenum type = 0;
+		glGetActiveUniform(m_ID, index, maxNameLength, &nameLength, &arraySize, &type, nameBuffer.data());
+
+		// Uniforms inside of uniform blocks have no location, they're set through the block's buffer
+		const std::string NAME(nameBuffer.data(), nameLength);
+		const int LOCATION = glGetUniformLocation(m_ID, NAME.c_str());
+		if (LOCATION < 0)
+			continue;
+
+		// Arrays are reported once as "name[0]", each element (and the bare name) gets an entry of its own
+		const size_t BRACKET = NAME.rfind("[0]");
+		const bool IS_ARRAY = BRACKET != std::string::npos && BRACKET + 3 == NAME.size();
+		const std::string BASE_NAME = IS_ARRAY ? NAME.substr(0, BRACKET) : NAME;
+
+		for (int element = 0; element < (IS_ARRAY ? arraySize : 1); element++)
+		{
+			CachedUniform uniform;
+			uniform.m_location = element == 0 ? LOCATION : glGetUniformLocation(m_ID,
+				(BASE_NAME + "[" + std::to_string(element) + "]").c_str());
+
+			if (IS_ARRAY)
+				m_uniformIndices[BASE_NAME + "[" + std::to_string(element) + "]"] = static_cast<int>(m_uniforms.size());
+			if (element == 0)
+				m_uniformIndices[BASE_NAME] = static_cast<int>(m_uniforms.size());
+
+			m_uniforms.emplace_back(uniform);
+		}
 	}
+}
+
+int ShaderProgram::updateUniform(UniformHandle handle, const void* value, uint32_t size) const
+{
+	// Setting a uniform to the value it already holds (or one the program doesn't have) changes nothing
+	if (handle.m_index < 0)
+		return -1;
+
+	CachedUniform& cached = m_uniforms[handle.m_index];
+	const bool CHANGED = cached.m_size != size || std::memcmp(cached.m_value, value, size) != 0;
 
-	return m_uniformCache[uniform];
+	GLState::countCall(CHANGED);
+	if (!CHANGED)
+		return -1;
+
+	std::memcpy(cached.m_value, value, size);
+	cached.m_size = size;
+	return cached.m_location;
 }
 
 void ShaderProgram::bindUniformBlock(const std::string& uniform_block, uint32_t unit) const
@@ -125,47 +177,69 @@ void ShaderProgram::bindUniformBlock(const std::string& uniform_block, uint32_t
 
 void ShaderProgram::bindProgram() const
 {
-	glUseProgram(m_ID);
+	GLState::useProgram(m_ID);
 }
 
 void ShaderProgram::unbindProgram() const
 {
-	glUseProgram(0);
+	GLState::useProgram(0);
+}
+
+UniformHandle ShaderProgram::getUniformHandle(const std::string& uniform) const
+{
+	UniformHandle handle;
+	const auto INDEX = m_uniformIndices.find(uniform);
+	if (INDEX != m_uniformIndices.end())
+		handle.m_index = INDEX->second;
+
+	return handle;
 }
 
-void ShaderProgram::setUniform(const std::string& uniform, int value) const
+void ShaderProgram::setUniform(UniformHandle uniform, int value) const
 {
-	glUniform1i(this->queryUniformLocation(m_ID, uniform.c_str()), value);
+	const int LOCATION = this->updateUniform(uniform, &value, sizeof(value));
+	if (LOCATION >= 0)
+		glUniform1i(LOCATION, value);
 }
 
-void ShaderProgram::setUniform(const std::string& uniform, float value) const
+void ShaderProgram::setUniform(UniformHandle uniform, float value) const
 {
-	glUniform1f(this->queryUniformLocation(m_ID, uniform.c_str()), value);
+	const int LOCATION = this->updateUniform(uniform, &value, sizeof(value));
+	if (LOCATION >= 0)
+		glUniform1f(LOCATION, value);
 }
 
-void ShaderProgram::setUniform(const std::string& uniform, bool value) const
+void ShaderProgram::setUniform(UniformHandle uniform, bool value) const
 {
-	glUniform1i(this->queryUniformLocation(m_ID, uniform.c_str()), static_cast<int>(value));
+	this->setUniform(uniform, static_cast<int>(value));
 }
 
-void ShaderProgram::setUniform(const std::string& uniform, const glm::mat3& matrix) const
+void ShaderProgram::setUniform(UniformHandle uniform, const glm::mat3& matrix) const
 {
-	glUniformMatrix3fv(this->queryUniformLocation(m_ID, uniform.c_str()), 1, GL_FALSE, &matrix[0][0]);
+	const int LOCATION = this->updateUniform(uniform, &matrix[0][0], sizeof(matrix));
+	if (LOCATION >= 0)
+		glUniformMatrix3fv(LOCATION, 1, GL_FALSE, &matrix[0][0]);
 }
 
-void ShaderProgram::setUniform(const std::string& uniform, const glm::mat4& matrix) const
+void ShaderProgram::setUniform(UniformHandle uniform, const glm::mat4& matrix) const
 {
-	glUniformMatrix4fv(this->queryUniformLocation(m_ID, uniform.c_str()), 1, GL_FALSE, &matrix[0][0]);
+	const int LOCATION = this->updateUniform(uniform, &matrix[0][0], sizeof(matrix));
+	if (LOCATION >= 0)
+		glUniformMatrix4fv(LOCATION, 1, GL_FALSE, &matrix[0][0]);
 }
 
-void ShaderProgram::setUniform(const std::string& uniform, const glm::vec3& vector) const
+void ShaderProgram::setUniform(UniformHandle uniform, const glm::vec3& vector) const
 {
-	glUniform3fv(this->queryUniformLocation(m_ID, uniform.c_str()), 1, &vector[0]);
+	const int LOCATION = this->updateUniform(uniform, &vector[0], sizeof(vector));
+	if (LOCATION >= 0)
+		glUniform3fv(LOCATION, 1, &vector[0]);
 }
 
-void ShaderProgram::setUniform(const std::string& uniform, const glm::vec4& vector) const
+void ShaderProgram::setUniform(UniformHandle uniform, const glm::vec4& vector) const
 {
-	glUniform4fv(this->queryUniformLocation(m_ID, uniform.c_str()), 1, &vector[0]);
+	const int LOCATION = this->updateUniform(uniform, &vector[0], sizeof(vector));
+	if (LOCATION >= 0)
+		glUniform4fv(LOCATION, 1, &vector[0]);
 }
 
 const uint32_t& ShaderProgram::getID() const
@@ -2,6 +2,31 @@
 #include <unordered_map>
 #include <glm/glm.hpp>
 #include <string>
+#include <vector>
+
+// Binding points of the uniform blocks the shaders share
+constexpr uint32_t MATRICES_BLOCK_BINDING = 0;
+constexpr uint32_t LIGHTS_BLOCK_BINDING = 1;
+constexpr uint32_t MATERIAL_BLOCK_BINDING = 2;
+
+// Texture units of the light cluster buffers, kept clear of the units the materials bind their textures to
+constexpr uint32_t POINT_LIGHTS_TEXTURE_UNIT = 13;
+constexpr uint32_t CLUSTER_RANGES_TEXTURE_UNIT = 14;
+constexpr uint32_t CLUSTER_LIGHTS_TEXTURE_UNIT = 15;
+
+// Refers to a uniform of the program it was fetched from, so setting it needs no name lookup. Fetch handles once up
+// front, not per draw
+struct UniformHandle
+{
+	int m_index = -1; // Index into the program's uniform table, -1 if the program has no such active uniform
+};
+
+struct CachedUniform
+{
+	int m_location = -1;
+	uint32_t m_size = 0; // Size of the last value set, 0 until the uniform is first set
+	uint8_t m_value[sizeof(glm::mat4)]; // Last value set, uniforms keep their values while the program is unbound
+};
 
 enum class ShaderCheckType
 {
@@ -15,10 +40,12 @@ private:
 	uint32_t m_ID;
 	const std::string m_vshPath, m_gshPath, m_fshPath;
 
-	mutable std::unordered_map<std::string, uint32_t> m_uniformCache;
+	mutable std::vector<CachedUniform> m_uniforms; // Every active uniform of the program, found after linking
+	std::unordered_map<std::string, int> m_uniformIndices; // Where each uniform name is in the table
 private:
 	std::string loadShaderContents(const std::string& file_path) const; // Loads the shader contents into a string from file
-	uint32_t queryUniformLocation(const uint32_t& id, const std::string& uniform) const; // Gets the uniform location from GPU and store in cache map
+	void reflectUniforms(); // Fills the uniform table with every active uniform (and array element) of the linked program
+	int updateUniform(UniformHandle handle, const void* value, uint32_t size) const; // Caches the value, returns the location to set or -1 if unchanged
 	void generateShader(uint32_t& id, const char* src, int shader_type) const; // Generates a shader object and compiles it
 
 	void checkShaderErrors(const uint32_t& id, ShaderCheckType check_type) const; // Checks for errors in compilation or linking of shaders
@@ -31,16 +58,18 @@ public:
 	void bindProgram() const; // Binds the shader program
 	void unbindProgram() const; // Unbinds the shader program
 public:
-	// setUniform() : Sets the value of uniform in the shader
-	void setUniform(const std::string& uniform, int value) const;
-	void setUniform(const std::string& uniform, float value) const;
-	void setUniform(const std::string& uniform, bool value) const;
+	UniformHandle getUniformHandle(const std::string& uniform) const; // Returns the handle of the uniform (invalid if inactive)
+
+	// setUniform() : Sets the value of uniform in the shader (the program has to be bound)
+	void setUniform(UniformHandle uniform, int value) const;
+	void setUniform(UniformHandle uniform, float value) const;
+	void setUniform(UniformHandle uniform, bool value) const;
 
-	void setUniform(const std::string& uniform, const glm::mat3& matrix) const;
-	void setUniform(const std::string& uniform, const glm::mat4& matrix) const;
+	void setUniform(UniformHandle uniform, const glm::mat3& matrix) const;
+	void setUniform(UniformHandle uniform, const glm::mat4& matrix) const;
 
-	void setUniform(const std::string& uniform, const glm::vec3& vector) const;
-	void setUniform(const std::string& uniform, const glm::vec4& vector) const;
+	void setUniform(UniformHandle uniform, const glm::vec3& vector) const;
+	void setUniform(UniformHandle uniform, const glm::vec4& vector) const;
 public:
 	const uint32_t& getID() const; // Returns the ID of the shader
 
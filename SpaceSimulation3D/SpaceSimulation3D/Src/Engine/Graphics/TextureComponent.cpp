@@ -1,5 +1,6 @@
 #include "TextureComponent.h"
 #include "Engine/Utils/LoggingManager.h"
+#include "Engine/Utils/GLStateCache.h"
 
 #include <glad/glad.h>
 #include <stb_image.h>
@@ -8,7 +9,7 @@ TextureComponent::TextureComponent(const std::string& path, bool flip_on_load)
 {
 	// Generate the texture and configure its filtering and wrapping methods
 	glGenTextures(1, &m_ID);
-	glBindTexture(GL_TEXTURE_2D, m_ID);
+	GLState::bindTexture(0, GL_TEXTURE_2D, m_ID);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -30,42 +31,39 @@ TextureComponent::TextureComponent(const std::string& path, bool flip_on_load)
 	else
 		OutputLog("An error occurred while loading the texture at path: " + path, Logging::Severity::FATAL);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
 	stbi_image_free(textureData);
 }
 
 TextureComponent::~TextureComponent()
 {
 	glDeleteTextures(1, &m_ID);
+	GLState::onTextureDeleted(m_ID);
 }
 
 void TextureComponent::SetFilter(uint32_t min, uint32_t mag) const
 {
-	glBindTexture(GL_TEXTURE_2D, m_ID);
+	GLState::bindTexture(0, GL_TEXTURE_2D, m_ID);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag);
-	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void TextureComponent::SetWrap(uint32_t s_axis, uint32_t t_axis) const
 {
-	glBindTexture(GL_TEXTURE_2D, m_ID);
+	GLState::bindTexture(0, GL_TEXTURE_2D, m_ID);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, s_axis);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, t_axis);
-	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void TextureComponent::bind(std::shared_ptr<ShaderProgram> shader, const std::string& sampler, int unit) const
+void TextureComponent::bind(const ShaderProgram& shader, UniformHandle sampler, int unit) const
 {
-	shader->setUniform(sampler, unit);
+	shader.setUniform(sampler, unit);
 
-	glActiveTexture(GL_TEXTURE0 + unit);
-	glBindTexture(GL_TEXTURE_2D, m_ID);
+	GLState::bindTexture(unit, GL_TEXTURE_2D, m_ID);
 }
 
-void TextureComponent::unbind() const
+void TextureComponent::unbind(int unit) const
 {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::bindTexture(unit, GL_TEXTURE_2D, 0);
 }
 
 const uint32_t& TextureComponent::getID() const
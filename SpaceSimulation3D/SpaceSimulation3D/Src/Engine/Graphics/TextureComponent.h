@@ -14,8 +14,8 @@ public:
 	void SetFilter(uint32_t min, uint32_t mag) const; // Sets the filtering algorithm used on the texture
 	void SetWrap(uint32_t s_axis, uint32_t t_axis) const; // Sets the wrapping method used on the texture
 
-	void bind(std::shared_ptr<ShaderProgram> shader, const std::string& sampler, int unit) const; // Binds the texture
-	void unbind() const; // Unbinds the texture
+	void bind(const ShaderProgram& shader, UniformHandle sampler, int unit) const; // Binds the texture
+	void unbind(int unit) const; // Unbinds the texture from the unit
 public:
 	const uint32_t& getID() const; // Returns the ID of the texture
 
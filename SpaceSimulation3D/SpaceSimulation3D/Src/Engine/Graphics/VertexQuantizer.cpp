@@ -0,0 +1,99 @@
+#include "VertexQuantizer.h"
+
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
+
+static_assert(sizeof(QuantizedVertexData) == 16, "QuantizedVertexData has to match its vertex attribute layout");
+
+namespace
+{
+	constexpr float UNORM16_MAX = 65535.0f;
+
+	// Decodes a GL_INT_2_10_10_10_REV normal the way an OpenGL 3.3 context does, where a signed component c maps to
+	// (2c + 1) / 1023 rather than the c / 511 that later versions (and glm) use
+	glm::vec3 decodeSnorm10(uint32_t bits)
+	{
+		glm::vec3 decoded;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			int32_t component = static_cast<int32_t>((bits >> (axis * 10)) & 0x3FF);
+			if (component & 0x200)
+				component -= 0x400;
+
+			decoded[axis] = (2.0f * component + 1.0f) / 1023.0f;
+		}
+
+		return decoded;
+	}
+}
+
+namespace VertexQuantizer
+{
+	QuantizationStats quantizeVertices(const std::vector<VertexData>& vertices,
+		std::vector<QuantizedVertexData>& quantized)
+	{
+		QuantizationStats stats;
+		quantized.resize(vertices.size());
+		if (vertices.empty())
+			return stats;
+
+		glm::vec3 boundsMin = vertices[0].m_vertexPos, boundsMax = vertices[0].m_vertexPos;
+		for (const auto& vertex : vertices)
+		{
+			boundsMin = glm::min(boundsMin, vertex.m_vertexPos);
+			boundsMax = glm::max(boundsMax, vertex.m_vertexPos);
+		}
+
+		// A flat axis keeps a scale of one, so it doesn't divide by zero and still decodes back to the offset
+		stats.m_positionOffset = boundsMin;
+		for (int axis = 0; axis < 3; axis++)
+			stats.m_positionScale[axis] = boundsMax[axis] > boundsMin[axis] ? boundsMax[axis] - boundsMin[axis] : 1.0f;
+
+		float maxNormalCosine = 1.0f;
+		for (size_t index = 0; index < vertices.size(); index++)
+		{
+			const VertexData& VERTEX = vertices[index];
+			QuantizedVertexData& packed = quantized[index];
+
+			glm::vec3 decodedPos;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				const float NORMALIZED = (VERTEX.m_vertexPos[axis] - stats.m_positionOffset[axis]) /
+					stats.m_positionScale[axis];
+				packed.m_vertexPos[axis] = static_cast<GLushort>(std::lround(glm::clamp(NORMALIZED, 0.0f, 1.0f) *
+					UNORM16_MAX));
+
+				decodedPos[axis] = stats.m_positionOffset[axis] + stats.m_positionScale[axis] *
+					(packed.m_vertexPos[axis] / UNORM16_MAX);
+			}
+			packed.m_vertexPos[3] = 0;
+
+			// The normals get renormalized before lighting, so only the direction they decode to matters
+			const float NORMAL_LENGTH = glm::length(VERTEX.m_normalPos);
+			const glm::vec3 NORMAL = NORMAL_LENGTH > 0.0f ? VERTEX.m_normalPos / NORMAL_LENGTH : glm::vec3(0.0f);
+			packed.m_normalPos.m_bits = glm::packSnorm3x10_1x2(glm::vec4(NORMAL, 0.0f));
+
+			const glm::vec3 DECODED_DIRECTION = decodeSnorm10(packed.m_normalPos.m_bits);
+			if (NORMAL_LENGTH > 0.0f)
+			{
+				maxNormalCosine = std::min(maxNormalCosine, glm::dot(NORMAL, DECODED_DIRECTION) /
+					glm::length(DECODED_DIRECTION));
+			}
+
+			glm::vec2 decodedTexture;
+			for (int axis = 0; axis < 2; axis++)
+			{
+				packed.m_texturePos[axis].m_bits = glm::packHalf1x16(VERTEX.m_texturePos[axis]);
+				decodedTexture[axis] = glm::unpackHalf1x16(packed.m_texturePos[axis].m_bits);
+			}
+
+			stats.m_maxPositionError = std::max(stats.m_maxPositionError, glm::length(decodedPos - VERTEX.m_vertexPos));
+			stats.m_maxTextureError = std::max({ stats.m_maxTextureError,
+				std::abs(decodedTexture.x - VERTEX.m_texturePos.x), std::abs(decodedTexture.y - VERTEX.m_texturePos.y) });
+		}
+
+		stats.m_maxNormalError = glm::degrees(std::acos(glm::clamp(maxNormalCosine, -1.0f, 1.0f)));
+		return stats;
+	}
+}
\ No newline at end of file
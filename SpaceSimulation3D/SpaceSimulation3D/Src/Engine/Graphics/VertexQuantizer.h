@@ -0,0 +1,12 @@
+#pragma once
+#include "Engine/Graphics/MeshObject.h"
+
+#include <vector>
+
+namespace VertexQuantizer
+{
+	// quantizeVertices() : Packs the vertices into the quantized format, positions relative to the bounds of the mesh,
+	// then unpacks them again the way the GPU would to measure the error
+	QuantizationStats quantizeVertices(const std::vector<VertexData>& vertices,
+		std::vector<QuantizedVertexData>& quantized);
+}
\ No newline at end of file
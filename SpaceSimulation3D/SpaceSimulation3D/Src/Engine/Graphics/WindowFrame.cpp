@@ -1,13 +1,15 @@
 #include "WindowFrame.h"
 #include "Engine/Utils/LoggingManager.h"
+#include "Engine/Utils/GLStateCache.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-WindowFrame::WindowFrame(const char* title, uint32_t width, uint32_t height, bool fullscreen) :
+WindowFrame::WindowFrame(const char* title, uint32_t width, uint32_t height, bool fullscreen, bool hidden) :
 	m_width(width), m_height(height), m_depthTestEnabled(false)
 {
 	this->initGLFWLibrary();
+	glfwWindowHint(GLFW_VISIBLE, !hidden);
 
 	// Create the window and make sure its successfully created
 	if (fullscreen)
@@ -31,7 +33,9 @@ WindowFrame::WindowFrame(const char* title, uint32_t width, uint32_t height, boo
 	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
 		OutputLog("A problem occurred while initializing GLAD!", Logging::Severity::FATAL);
 
-	glDisable(GL_DEPTH_TEST);
+	// Nothing is known about the state of a fresh context
+	GLState::invalidate();
+	GLState::setDepthTest(false);
 }
 
 WindowFrame::~WindowFrame()
@@ -67,15 +71,22 @@ void WindowFrame::setDepthTestState(bool enabled) const
 {
 	m_depthTestEnabled = enabled;
 
-	if (enabled)
-		glEnable(GL_DEPTH_TEST);
-	else
-		glDisable(GL_DEPTH_TEST);
+	GLState::setDepthTest(enabled);
+}
+
+void WindowFrame::setContextCurrent(bool current) const
+{
+	// A context can only be current on one thread at a time, so it has to be released before another thread takes it
+	glfwMakeContextCurrent(current ? m_windowPtr : nullptr);
 }
 
-void WindowFrame::updateTick() const
+void WindowFrame::pollEvents() const
 {
 	glfwPollEvents();
+}
+
+void WindowFrame::swapBuffers() const
+{
 	glfwSwapBuffers(m_windowPtr);
 }
 
@@ -14,14 +14,17 @@ private:
 private:
 	void initGLFWLibrary() const; // Initializes the GLFW library
 public:
-	WindowFrame(const char* title, uint32_t width, uint32_t height, bool fullscreen = false);
+	// A hidden window only provides the OpenGL context, e.g. for benchmarks that need one
+	WindowFrame(const char* title, uint32_t width, uint32_t height, bool fullscreen = false, bool hidden = false);
 	~WindowFrame();
 
 	void requestClose() const; // Requests for the window to close
 	void setCursorState(bool enabled) const; // Sets whether the cursor is enabled or disabled (locked to window)
 	void setDepthTestState(bool enabled) const; // Sets whether depth testing is enabled or not
+	void setContextCurrent(bool current) const; // Makes the OpenGL context current on the calling thread, or releases it
 
-	void updateTick() const; // Listens and polls events and swaps the rendering buffers
+	void pollEvents() const; // Listens and polls events (only from the thread that created the window)
+	void swapBuffers() const; // Swaps the rendering buffers (only from the thread the context is current on)
 	void clearScreen(const glm::vec3& clear_color) const; // Clears the window and fills with given color
 public:
 	GLFWwindow* getFramePtr() const; // Returns a pointer to the GLFWwindow object
@@ -0,0 +1,300 @@
+#include "BarnesHutSolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr uint32_t LEAF_CAPACITY = 8; // Nodes with this many bodies or fewer aren't split any further
+	constexpr uint32_t MAX_TREE_DEPTH = 21; // Each axis is quantized to 21 bits, giving a 63 bit Morton code
+	constexpr uint32_t TRAVERSAL_STACK_SIZE = MAX_TREE_DEPTH * 8 + 8;
+	constexpr uint32_t FORCE_GRAIN_SIZE = 256; // Bodies per job when evaluating the forces
+
+	// Spreads the lower 21 bits of the value out so there are two zero bits between each of them
+	uint64_t spreadBits(uint64_t value)
+	{
+		value &= 0x1FFFFF;
+		value = (value | value << 32) & 0x1F00000000FFFF;
+		value = (value | value << 16) & 0x1F0000FF0000FF;
+		value = (value | value << 8) & 0x100F00F00F00F00F;
+		value = (value | value << 4) & 0x10C30C30C30C30C3;
+		value = (value | value << 2) & 0x1249249249249249;
+		return value;
+	}
+
+	uint64_t encodeMorton(uint32_t x, uint32_t y, uint32_t z)
+	{
+		return spreadBits(x) << 2 | spreadBits(y) << 1 | spreadBits(z);
+	}
+
+	uint32_t getOctant(uint64_t morton_code, uint32_t level)
+	{
+		return static_cast<uint32_t>(morton_code >> (3 * (MAX_TREE_DEPTH - 1 - level))) & 7;
+	}
+}
+
+BarnesHutSolver::BarnesHutSolver(float theta, float gravitational_constant, float softening,
+	std::shared_ptr<JobSystem> job_system) :
+	m_theta(theta), m_gravitationalConstant(gravitational_constant), m_softeningSquared(softening * softening),
+	m_jobSystem(job_system)
+{}
+
+BarnesHutSolver::~BarnesHutSolver() {}
+
+void BarnesHutSolver::setTheta(float theta)
+{
+	m_theta = theta;
+}
+
+void BarnesHutSolver::setJobSystem(std::shared_ptr<JobSystem> job_system)
+{
+	m_jobSystem = job_system;
+}
+
+void BarnesHutSolver::sortBodies(const BodyStore& bodies, glm::vec3& root_min, float& root_size)
+{
+	const uint32_t NUM_BODIES = bodies.getCount();
+
+	// Find the cube bounding every body, this becomes the root node of the octree
+	glm::vec3 minBounds(bodies.m_positionX[0], bodies.m_positionY[0], bodies.m_positionZ[0]);
+	glm::vec3 maxBounds = minBounds;
+
+	for (uint32_t index = 1; index < NUM_BODIES; index++)
+	{
+		const glm::vec3 POSITION(bodies.m_positionX[index], bodies.m_positionY[index], bodies.m_positionZ[index]);
+		minBounds = glm::min(minBounds, POSITION);
+		maxBounds = glm::max(maxBounds, POSITION);
+	}
+
+	const glm::vec3 EXTENT = maxBounds - minBounds;
+	root_min = minBounds;
+	root_size = std::max(std::max(EXTENT.x, EXTENT.y), std::max(EXTENT.z, 1e-6f)) * 1.0001f;
+
+	// Quantize every position onto the 21 bit grid and sort the bodies by their Morton code
+	const float QUANTIZE = static_cast<float>(1u << MAX_TREE_DEPTH) / root_size;
+	m_mortonOrder.resize(NUM_BODIES);
+
+	for (uint32_t index = 0; index < NUM_BODIES; index++)
+	{
+		const uint32_t X = static_cast<uint32_t>((bodies.m_positionX[index] - root_min.x) * QUANTIZE);
+		const uint32_t Y = static_cast<uint32_t>((bodies.m_positionY[index] - root_min.y) * QUANTIZE);
+		const uint32_t Z = static_cast<uint32_t>((bodies.m_positionZ[index] - root_min.z) * QUANTIZE);
+		m_mortonOrder[index] = { encodeMorton(X, Y, Z), index };
+	}
+
+	std::sort(m_mortonOrder.begin(), m_mortonOrder.end());
+
+	// Copy the body data into Morton order so the leaf loops read memory linearly
+	m_sortedX.resize(NUM_BODIES);
+	m_sortedY.resize(NUM_BODIES);
+	m_sortedZ.resize(NUM_BODIES);
+	m_sortedMass.resize(NUM_BODIES);
+
+	for (uint32_t index = 0; index < NUM_BODIES; index++)
+	{
+		const uint32_t BODY = m_mortonOrder[index].second;
+		m_sortedX[index] = bodies.m_positionX[BODY];
+		m_sortedY[index] = bodies.m_positionY[BODY];
+		m_sortedZ[index] = bodies.m_positionZ[BODY];
+		m_sortedMass[index] = bodies.m_mass[BODY];
+	}
+}
+
+void BarnesHutSolver::buildNode(uint32_t node_index, uint32_t level)
+{
+	const uint32_t FIRST_BODY = m_nodes[node_index].m_firstBody;
+	const uint32_t NUM_BODIES = m_nodes[node_index].m_numBodies;
+	const float CHILD_SIZE = m_nodes[node_index].m_size * 0.5f;
+
+	if (NUM_BODIES > LEAF_CAPACITY && level < MAX_TREE_DEPTH)
+	{
+		// The bodies of the node share the Morton prefix above this level, so the next three bits split them into
+		// contiguous octant ranges
+		const uint32_t FIRST_CHILD = static_cast<uint32_t>(m_nodes.size());
+		uint32_t rangeStart = FIRST_BODY;
+		const uint32_t RANGE_END = FIRST_BODY + NUM_BODIES;
+
+		while (rangeStart < RANGE_END)
+		{
+			const uint32_t OCTANT = getOctant(m_mortonOrder[rangeStart].first, level);
+			const auto OCTANT_END = std::partition_point(m_mortonOrder.begin() + rangeStart,
+				m_mortonOrder.begin() + RANGE_END, [OCTANT, level](const std::pair<uint64_t, uint32_t>& entry)
+				{ return getOctant(entry.first, level) <= OCTANT; });
+
+			const uint32_t RANGE_STOP = static_cast<uint32_t>(OCTANT_END - m_mortonOrder.begin());
+			m_nodes.push_back({ 0.0f, 0.0f, 0.0f, 0.0f, CHILD_SIZE, 0, 0, rangeStart, RANGE_STOP - rangeStart });
+			rangeStart = RANGE_STOP;
+		}
+
+		const uint32_t NUM_CHILDREN = static_cast<uint32_t>(m_nodes.size()) - FIRST_CHILD;
+		m_nodes[node_index].m_firstChild = FIRST_CHILD;
+		m_nodes[node_index].m_numChildren = NUM_CHILDREN;
+
+		// Build the children, then gather their mass and center of mass
+		float mass = 0.0f, comX = 0.0f, comY = 0.0f, comZ = 0.0f;
+		for (uint32_t child = FIRST_CHILD; child < FIRST_CHILD + NUM_CHILDREN; child++)
+		{
+			this->buildNode(child, level + 1);
+
+			const OctreeNode& CHILD_NODE = m_nodes[child];
+			mass += CHILD_NODE.m_mass;
+			comX += CHILD_NODE.m_centerOfMassX * CHILD_NODE.m_mass;
+			comY += CHILD_NODE.m_centerOfMassY * CHILD_NODE.m_mass;
+			comZ += CHILD_NODE.m_centerOfMassZ * CHILD_NODE.m_mass;
+		}
+
+		OctreeNode& node = m_nodes[node_index];
+		const float INV_MASS = mass > 0.0f ? 1.0f / mass : 0.0f;
+		node.m_mass = mass;
+		node.m_centerOfMassX = comX * INV_MASS;
+		node.m_centerOfMassY = comY * INV_MASS;
+		node.m_centerOfMassZ = comZ * INV_MASS;
+	}
+	else
+	{
+		// Leaf node, sum up the bodies directly
+		float mass = 0.0f, comX = 0.0f, comY = 0.0f, comZ = 0.0f;
+		for (uint32_t index = FIRST_BODY; index < FIRST_BODY + NUM_BODIES; index++)
+		{
+			mass += m_sortedMass[index];
+			comX += m_sortedX[index] * m_sortedMass[index];
+			comY += m_sortedY[index] * m_sortedMass[index];
+			comZ += m_sortedZ[index] * m_sortedMass[index];
+		}
+
+		OctreeNode& node = m_nodes[node_index];
+		const float INV_MASS = mass > 0.0f ? 1.0f / mass : 0.0f;
+		node.m_mass = mass;
+		node.m_centerOfMassX = comX * INV_MASS;
+		node.m_centerOfMassY = comY * INV_MASS;
+		node.m_centerOfMassZ = comZ * INV_MASS;
+	}
+}
+
+glm::vec3 BarnesHutSolver::evaluateAcceleration(float pos_x, float pos_y, float pos_z, uint32_t self) const
+{
+	const float THETA_SQUARED = m_theta * m_theta;
+	float accX = 0.0f, accY = 0.0f, accZ = 0.0f;
+
+	uint32_t stack[TRAVERSAL_STACK_SIZE];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const OctreeNode& NODE = m_nodes[stack[--stackSize]];
+
+		const float DX = NODE.m_centerOfMassX - pos_x;
+		const float DY = NODE.m_centerOfMassY - pos_y;
+		const float DZ = NODE.m_centerOfMassZ - pos_z;
+		const float DISTANCE_SQUARED = DX * DX + DY * DY + DZ * DZ;
+
+		if (NODE.m_numChildren == 0)
+		{
+			// Leaf node, sum the bodies in it directly
+			for (uint32_t index = NODE.m_firstBody; index < NODE.m_firstBody + NODE.m_numBodies; index++)
+			{
+				if (index == self)
+					continue;
+
+				const float BX = m_sortedX[index] - pos_x;
+				const float BY = m_sortedY[index] - pos_y;
+				const float BZ = m_sortedZ[index] - pos_z;
+
+				const float INV_DISTANCE = 1.0f / std::sqrt(BX * BX + BY * BY + BZ * BZ + m_softeningSquared);
+				const float STRENGTH = m_sortedMass[index] * INV_DISTANCE * INV_DISTANCE * INV_DISTANCE;
+				accX += BX * STRENGTH;
+				accY += BY * STRENGTH;
+				accZ += BZ * STRENGTH;
+			}
+		}
+		else if (NODE.m_size * NODE.m_size < THETA_SQUARED * DISTANCE_SQUARED)
+		{
+			// The node is far enough away to be treated as a single point mass
+			const float INV_DISTANCE = 1.0f / std::sqrt(DISTANCE_SQUARED + m_softeningSquared);
+			const float STRENGTH = NODE.m_mass * INV_DISTANCE * INV_DISTANCE * INV_DISTANCE;
+			accX += DX * STRENGTH;
+			accY += DY * STRENGTH;
+			accZ += DZ * STRENGTH;
+		}
+		else
+		{
+			for (uint32_t child = NODE.m_firstChild; child < NODE.m_firstChild + NODE.m_numChildren; child++)
+				stack[stackSize++] = child;
+		}
+	}
+
+	return glm::vec3(accX, accY, accZ) * m_gravitationalConstant;
+}
+
+void BarnesHutSolver::computeAccelerations(const BodyStore& bodies, float* acc_x, float* acc_y, float* acc_z)
+{
+	const uint32_t NUM_BODIES = bodies.getCount();
+	if (NUM_BODIES == 0)
+		return;
+
+	// Rebuild the linear octree from scratch, bodies move every step so refitting isn't worth it
+	glm::vec3 rootMin;
+	float rootSize;
+	this->sortBodies(bodies, rootMin, rootSize);
+
+	m_nodes.clear();
+	m_nodes.reserve(NUM_BODIES / 2);
+	m_nodes.push_back({ 0.0f, 0.0f, 0.0f, 0.0f, rootSize, 0, 0, 0, NUM_BODIES });
+	this->buildNode(0, 0);
+
+	// Evaluate the forces in Morton order so neighbouring bodies walk the same part of the tree, each job takes a
+	// contiguous range of them
+	auto evaluateRange = [this, acc_x, acc_y, acc_z](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t index = begin; index < end; index++)
+		{
+			const glm::vec3 ACCELERATION = this->evaluateAcceleration(m_sortedX[index], m_sortedY[index],
+				m_sortedZ[index], index);
+
+			const uint32_t BODY = m_mortonOrder[index].second;
+			acc_x[BODY] = ACCELERATION.x;
+			acc_y[BODY] = ACCELERATION.y;
+			acc_z[BODY] = ACCELERATION.z;
+		}
+	};
+
+	if (m_jobSystem)
+		m_jobSystem->parallelFor(0, NUM_BODIES, FORCE_GRAIN_SIZE, evaluateRange);
+	else
+		evaluateRange(0, NUM_BODIES);
+}
+
+glm::vec3 BarnesHutSolver::computeDirectAcceleration(const BodyStore& bodies, uint32_t index) const
+{
+	const float POS_X = bodies.m_positionX[index], POS_Y = bodies.m_positionY[index], POS_Z = bodies.m_positionZ[index];
+	float accX = 0.0f, accY = 0.0f, accZ = 0.0f;
+
+	for (uint32_t other = 0; other < bodies.getCount(); other++)
+	{
+		if (other == index)
+			continue;
+
+		const float DX = bodies.m_positionX[other] - POS_X;
+		const float DY = bodies.m_positionY[other] - POS_Y;
+		const float DZ = bodies.m_positionZ[other] - POS_Z;
+
+		const float INV_DISTANCE = 1.0f / std::sqrt(DX * DX + DY * DY + DZ * DZ + m_softeningSquared);
+		const float STRENGTH = bodies.m_mass[other] * INV_DISTANCE * INV_DISTANCE * INV_DISTANCE;
+		accX += DX * STRENGTH;
+		accY += DY * STRENGTH;
+		accZ += DZ * STRENGTH;
+	}
+
+	return glm::vec3(accX, accY, accZ) * m_gravitationalConstant;
+}
+
+float BarnesHutSolver::getTheta() const
+{
+	return m_theta;
+}
+
+uint32_t BarnesHutSolver::getNodeCount() const
+{
+	return static_cast<uint32_t>(m_nodes.size());
+}
\ No newline at end of file
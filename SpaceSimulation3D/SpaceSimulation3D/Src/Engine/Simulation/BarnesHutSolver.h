@@ -0,0 +1,48 @@
+#pragma once
+#include "Engine/Simulation/BodyStore.h"
+#include "Engine/Utils/JobSystem.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+struct OctreeNode
+{
+	float m_centerOfMassX, m_centerOfMassY, m_centerOfMassZ, m_mass;
+	float m_size; // Edge length of the cube covered by the node
+
+	uint32_t m_firstChild, m_numChildren; // Children are stored next to each other in the node array
+	uint32_t m_firstBody, m_numBodies; // Range of the node's bodies in Morton order
+};
+
+class BarnesHutSolver
+{
+private:
+	float m_theta, m_gravitationalConstant, m_softeningSquared;
+	std::shared_ptr<JobSystem> m_jobSystem;
+
+	std::vector<std::pair<uint64_t, uint32_t>> m_mortonOrder; // Morton code and body index, sorted by code
+	std::vector<float> m_sortedX, m_sortedY, m_sortedZ, m_sortedMass; // Body data copied into Morton order
+	std::vector<OctreeNode> m_nodes;
+private:
+	void sortBodies(const BodyStore& bodies, glm::vec3& root_min, float& root_size); // Orders the bodies along the Morton curve
+	void buildNode(uint32_t node_index, uint32_t level); // Recursively splits the node into its octants
+
+	glm::vec3 evaluateAcceleration(float pos_x, float pos_y, float pos_z, uint32_t self) const; // Walks the tree for one body
+public:
+	BarnesHutSolver(float theta = 0.5f, float gravitational_constant = 1.0f, float softening = 0.05f,
+		std::shared_ptr<JobSystem> job_system = nullptr);
+	~BarnesHutSolver();
+
+	void setTheta(float theta); // Sets the opening angle used to decide whether a node can be approximated
+	void setJobSystem(std::shared_ptr<JobSystem> job_system); // Sets the job system the force evaluation is split across (nullptr = serial)
+
+	// computeAccelerations() : Rebuilds the octree and writes the mutual gravitational acceleration of every body
+	void computeAccelerations(const BodyStore& bodies, float* acc_x, float* acc_y, float* acc_z);
+
+	// computeDirectAcceleration() : Reference O(N) sum of the acceleration acting on one body, used to measure the error
+	glm::vec3 computeDirectAcceleration(const BodyStore& bodies, uint32_t index) const;
+public:
+	float getTheta() const; // Returns the opening angle
+	uint32_t getNodeCount() const; // Returns the number of nodes in the last built octree
+};
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "BodyStore.h"
+
+uint32_t BodyStore::addBody(const glm::vec3& pos, const glm::vec3& velocity, float mass, float scale,
+	const glm::vec3& rotation_axis, float rotation_angle, float spin_rate)
+{
+	m_positionX.emplace_back(pos.x);
+	m_positionY.emplace_back(pos.y);
+	m_positionZ.emplace_back(pos.z);
+
+	m_velocityX.emplace_back(velocity.x);
+	m_velocityY.emplace_back(velocity.y);
+	m_velocityZ.emplace_back(velocity.z);
+
+	m_mass.emplace_back(mass);
+	m_scale.emplace_back(scale);
+
+	// The rotation axis is stored normalized so the instance matrices can be built without renormalizing it
+	const glm::vec3 AXIS = glm::normalize(rotation_axis);
+	m_rotationAxisX.emplace_back(AXIS.x);
+	m_rotationAxisY.emplace_back(AXIS.y);
+	m_rotationAxisZ.emplace_back(AXIS.z);
+
+	m_rotationAngle.emplace_back(rotation_angle);
+	m_spinRate.emplace_back(spin_rate);
+
+	return this->getCount() - 1;
+}
+
+void BodyStore::setBody(uint32_t index, const glm::vec3& pos, const glm::vec3& velocity, float mass, float scale,
+	const glm::vec3& rotation_axis, float rotation_angle, float spin_rate)
+{
+	m_positionX[index] = pos.x;
+	m_positionY[index] = pos.y;
+	m_positionZ[index] = pos.z;
+
+	m_velocityX[index] = velocity.x;
+	m_velocityY[index] = velocity.y;
+	m_velocityZ[index] = velocity.z;
+
+	m_mass[index] = mass;
+	m_scale[index] = scale;
+
+	const glm::vec3 AXIS = glm::normalize(rotation_axis);
+	m_rotationAxisX[index] = AXIS.x;
+	m_rotationAxisY[index] = AXIS.y;
+	m_rotationAxisZ[index] = AXIS.z;
+
+	m_rotationAngle[index] = rotation_angle;
+	m_spinRate[index] = spin_rate;
+}
+
+void BodyStore::reserve(uint32_t num_bodies)
+{
+	for (auto* component : { &m_positionX, &m_positionY, &m_positionZ, &m_velocityX, &m_velocityY, &m_velocityZ,
+		&m_mass, &m_scale, &m_rotationAxisX, &m_rotationAxisY, &m_rotationAxisZ, &m_rotationAngle, &m_spinRate })
+		component->reserve(num_bodies);
+}
+
+void BodyStore::resize(uint32_t num_bodies)
+{
+	for (auto* component : { &m_positionX, &m_positionY, &m_positionZ, &m_velocityX, &m_velocityY, &m_velocityZ,
+		&m_mass, &m_scale, &m_rotationAxisX, &m_rotationAxisY, &m_rotationAxisZ, &m_rotationAngle, &m_spinRate })
+		component->resize(num_bodies);
+}
+
+void BodyStore::clear()
+{
+	for (auto* component : { &m_positionX, &m_positionY, &m_positionZ, &m_velocityX, &m_velocityY, &m_velocityZ,
+		&m_mass, &m_scale, &m_rotationAxisX, &m_rotationAxisY, &m_rotationAxisZ, &m_rotationAngle, &m_spinRate })
+		component->clear();
+}
+
+uint32_t BodyStore::getCount() const
+{
+	return static_cast<uint32_t>(m_positionX.size());
+}
\ No newline at end of file
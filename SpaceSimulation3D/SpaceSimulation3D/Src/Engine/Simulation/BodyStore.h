@@ -0,0 +1,30 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+typedef unsigned int uint32_t;
+
+// Each body property is kept in its own contiguous array (structure-of-arrays), so the integration loops only
+// stream through the components they actually touch and can be vectorized by the compiler
+struct BodyStore
+{
+	std::vector<float> m_positionX, m_positionY, m_positionZ;
+	std::vector<float> m_velocityX, m_velocityY, m_velocityZ;
+	std::vector<float> m_mass;
+
+	std::vector<float> m_scale;
+	std::vector<float> m_rotationAxisX, m_rotationAxisY, m_rotationAxisZ;
+	std::vector<float> m_rotationAngle, m_spinRate;
+
+	uint32_t addBody(const glm::vec3& pos, const glm::vec3& velocity, float mass, float scale,
+		const glm::vec3& rotation_axis, float rotation_angle, float spin_rate); // Appends a body and returns its index
+
+	void setBody(uint32_t index, const glm::vec3& pos, const glm::vec3& velocity, float mass, float scale,
+		const glm::vec3& rotation_axis, float rotation_angle, float spin_rate); // Overwrites the body at the given index
+
+	void reserve(uint32_t num_bodies); // Reserves memory in every array for the given amount of bodies
+	void resize(uint32_t num_bodies); // Resizes every array to the given amount of bodies
+	void clear(); // Removes every body from the store
+
+	uint32_t getCount() const; // Returns the number of bodies in the store
+};
\ No newline at end of file
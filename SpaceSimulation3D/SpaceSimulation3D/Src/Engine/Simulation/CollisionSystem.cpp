@@ -0,0 +1,462 @@
+#include "CollisionSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr uint32_t KEY_UPDATE_GRAIN_SIZE = 16384; // Bodies per job when recomputing the cell keys
+	constexpr uint32_t CELL_GRAIN_SIZE = 512; // Occupied cells per job in the narrow phase
+	constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+	constexpr int32_t CELL_COORD_BIAS = 1 << 20; // Cell coordinates are stored as 21 bit unsigned values
+	constexpr int32_t CELL_COORD_MAX = (1 << 21) - 1;
+
+	constexpr float CORRECTION_PERCENT = 0.8f; // Share of the overlap removed each tick
+	constexpr float CORRECTION_SLOP = 0.001f; // Overlap that is tolerated, stops resting contacts from jittering
+
+	// Rows of neighbouring cells that come after the cell itself in lexicographic order, as dx, dy and the first and
+	// last dz. Testing only this half of the 26 neighbours still covers every pair of adjacent cells exactly once, and
+	// since the cells of a row are consecutive in the sorted order, each row is one contiguous span of bodies
+	constexpr int32_t FORWARD_ROWS[5][4]
+	{
+		{ 1, -1, -1, 1 }, { 1, 0, -1, 1 }, { 1, 1, -1, 1 },
+		{ 0, 1, -1, 1 },
+		{ 0, 0, 1, 1 }
+	};
+
+	uint64_t packCell(int32_t cell_x, int32_t cell_y, int32_t cell_z)
+	{
+		const uint64_t X = static_cast<uint64_t>(std::min(std::max(cell_x + CELL_COORD_BIAS, 0), CELL_COORD_MAX));
+		const uint64_t Y = static_cast<uint64_t>(std::min(std::max(cell_y + CELL_COORD_BIAS, 0), CELL_COORD_MAX));
+		const uint64_t Z = static_cast<uint64_t>(std::min(std::max(cell_z + CELL_COORD_BIAS, 0), CELL_COORD_MAX));
+		return X << 42 | Y << 21 | Z;
+	}
+
+	void unpackCell(uint64_t cell_key, int32_t& cell_x, int32_t& cell_y, int32_t& cell_z)
+	{
+		cell_x = static_cast<int32_t>((cell_key >> 42) & CELL_COORD_MAX) - CELL_COORD_BIAS;
+		cell_y = static_cast<int32_t>((cell_key >> 21) & CELL_COORD_MAX) - CELL_COORD_BIAS;
+		cell_z = static_cast<int32_t>(cell_key & CELL_COORD_MAX) - CELL_COORD_BIAS;
+	}
+
+	// Mixes every bit of the key into the low bits, which are the ones the table mask keeps
+	uint32_t hashCell(uint64_t cell_key)
+	{
+		cell_key ^= cell_key >> 33;
+		cell_key *= 0xFF51AFD7ED558CCDull;
+		cell_key ^= cell_key >> 33;
+		return static_cast<uint32_t>(cell_key);
+	}
+}
+
+CollisionSystem::CollisionSystem(float radius_scale, float restitution, std::shared_ptr<JobSystem> job_system) :
+	m_radiusScale(radius_scale), m_restitution(restitution), m_cellSize(0.0f), m_jobSystem(job_system), m_hashMask(0)
+{}
+
+CollisionSystem::~CollisionSystem() {}
+
+uint64_t CollisionSystem::getCellKey(float pos_x, float pos_y, float pos_z) const
+{
+	const float INV_CELL_SIZE = 1.0f / m_cellSize;
+	return packCell(static_cast<int32_t>(std::floor(pos_x * INV_CELL_SIZE)),
+		static_cast<int32_t>(std::floor(pos_y * INV_CELL_SIZE)), static_cast<int32_t>(std::floor(pos_z * INV_CELL_SIZE)));
+}
+
+uint32_t CollisionSystem::findCell(uint64_t cell_key) const
+{
+	if (m_hashTable.empty())
+		return EMPTY_SLOT;
+
+	for (uint32_t slot = hashCell(cell_key) & m_hashMask;; slot = (slot + 1) & m_hashMask)
+	{
+		const uint32_t CELL = m_hashTable[slot];
+		if (CELL == EMPTY_SLOT || m_cellKeys[CELL] == cell_key)
+			return CELL;
+	}
+}
+
+void CollisionSystem::setJobSystem(std::shared_ptr<JobSystem> job_system)
+{
+	m_jobSystem = job_system;
+}
+
+void CollisionSystem::setRestitution(float restitution)
+{
+	m_restitution = restitution;
+}
+
+void CollisionSystem::rebuildGrid(const BodyStore& bodies)
+{
+	const uint32_t NUM_BODIES = bodies.getCount();
+
+	// A cell has to be at least as wide as the largest body, otherwise overlapping bodies could be two cells apart
+	const float MAX_SCALE = *std::max_element(bodies.m_scale.begin(), bodies.m_scale.end());
+	const float CELL_SIZE = std::max(2.0f * MAX_SCALE * m_radiusScale, 1e-4f);
+
+	m_stats.m_cellChanges = 0;
+
+	if (m_cellOrder.size() != NUM_BODIES || CELL_SIZE != m_cellSize)
+	{
+		// Nothing to reuse, bin every body from scratch
+		m_cellSize = CELL_SIZE;
+		m_cellOrder.resize(NUM_BODIES);
+
+		for (uint32_t index = 0; index < NUM_BODIES; index++)
+			m_cellOrder[index] = { this->getCellKey(bodies.m_positionX[index], bodies.m_positionY[index],
+				bodies.m_positionZ[index]), index };
+
+		std::sort(m_cellOrder.begin(), m_cellOrder.end());
+		m_stats.m_cellChanges = NUM_BODIES;
+	}
+	else
+	{
+		// Recompute the key of every body in place. The bodies that stayed in their cell are still in sorted order,
+		// so only the few that moved have to be sorted and merged back in
+		std::vector<uint8_t> moved(NUM_BODIES, 0);
+
+		auto updateKeys = [this, &bodies, &moved](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t entry = begin; entry < end; entry++)
+			{
+				const uint32_t BODY = m_cellOrder[entry].second;
+				const uint64_t KEY = this->getCellKey(bodies.m_positionX[BODY], bodies.m_positionY[BODY],
+					bodies.m_positionZ[BODY]);
+
+				if (KEY != m_cellOrder[entry].first)
+				{
+					m_cellOrder[entry].first = KEY;
+					moved[entry] = 1;
+				}
+			}
+		};
+
+		if (m_jobSystem)
+			m_jobSystem->parallelFor(0, NUM_BODIES, KEY_UPDATE_GRAIN_SIZE, updateKeys);
+		else
+			updateKeys(0, NUM_BODIES);
+
+		std::vector<std::pair<uint64_t, uint32_t>> movedEntries;
+		uint32_t keptEntries = 0;
+
+		for (uint32_t entry = 0; entry < NUM_BODIES; entry++)
+		{
+			if (moved[entry])
+				movedEntries.emplace_back(m_cellOrder[entry]);
+			else
+				m_cellOrder[keptEntries++] = m_cellOrder[entry];
+		}
+
+		if (!movedEntries.empty())
+		{
+			std::sort(movedEntries.begin(), movedEntries.end());
+			std::copy(movedEntries.begin(), movedEntries.end(), m_cellOrder.begin() + keptEntries);
+			std::inplace_merge(m_cellOrder.begin(), m_cellOrder.begin() + keptEntries, m_cellOrder.end());
+		}
+
+		m_stats.m_cellChanges = static_cast<uint32_t>(movedEntries.size());
+	}
+
+	// Copy the positions and radii into the sorted order for the narrow phase
+	m_sortedX.resize(NUM_BODIES);
+	m_sortedY.resize(NUM_BODIES);
+	m_sortedZ.resize(NUM_BODIES);
+	m_sortedRadius.resize(NUM_BODIES);
+
+	auto gatherBodies = [this, &bodies](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t entry = begin; entry < end; entry++)
+		{
+			const uint32_t BODY = m_cellOrder[entry].second;
+			m_sortedX[entry] = bodies.m_positionX[BODY];
+			m_sortedY[entry] = bodies.m_positionY[BODY];
+			m_sortedZ[entry] = bodies.m_positionZ[BODY];
+			m_sortedRadius[entry] = bodies.m_scale[BODY] * m_radiusScale;
+		}
+	};
+
+	if (m_jobSystem)
+		m_jobSystem->parallelFor(0, NUM_BODIES, KEY_UPDATE_GRAIN_SIZE, gatherBodies);
+	else
+		gatherBodies(0, NUM_BODIES);
+
+	// Find where each occupied cell begins in the sorted order
+	m_cellStarts.clear();
+	m_cellKeys.clear();
+
+	for (uint32_t entry = 0; entry < NUM_BODIES; entry++)
+	{
+		if (entry == 0 || m_cellOrder[entry].first != m_cellOrder[entry - 1].first)
+		{
+			m_cellStarts.emplace_back(entry);
+			m_cellKeys.emplace_back(m_cellOrder[entry].first);
+		}
+	}
+
+	const uint32_t NUM_CELLS = static_cast<uint32_t>(m_cellStarts.size());
+	m_cellStarts.emplace_back(NUM_BODIES);
+
+	// Keep the hash table at most half full so the probe sequences stay short
+	uint32_t tableSize = 16;
+	while (tableSize < NUM_CELLS * 2)
+		tableSize *= 2;
+
+	m_hashMask = tableSize - 1;
+	m_hashTable.assign(tableSize, EMPTY_SLOT);
+
+	for (uint32_t cell = 0; cell < NUM_CELLS; cell++)
+	{
+		uint32_t slot = hashCell(m_cellKeys[cell]) & m_hashMask;
+		while (m_hashTable[slot] != EMPTY_SLOT)
+			slot = (slot + 1) & m_hashMask;
+
+		m_hashTable[slot] = cell;
+	}
+
+	m_stats.m_occupiedCells = NUM_CELLS;
+}
+
+void CollisionSystem::findContacts()
+{
+	const uint32_t NUM_CELLS = static_cast<uint32_t>(m_cellStarts.size()) - 1;
+	const uint32_t NUM_RANGES = (NUM_CELLS + CELL_GRAIN_SIZE - 1) / CELL_GRAIN_SIZE;
+
+	// Every job writes into its own contact list, so the cells can be processed without any locking
+	m_rangeContacts.resize(NUM_RANGES);
+	m_rangePairs.assign(NUM_RANGES, 0);
+
+	auto processCells = [this, NUM_CELLS](uint32_t begin, uint32_t end)
+	{
+		std::vector<BodyContact>& contacts = m_rangeContacts[begin / CELL_GRAIN_SIZE];
+		contacts.clear();
+
+		// Tests one body against a span of bodies, all indexed in the sorted order so neighbouring cells read
+		// neighbouring memory
+		auto testSpan = [&contacts, this](uint32_t entry, uint32_t span_begin, uint32_t span_end)
+		{
+			const float POS_X = m_sortedX[entry], POS_Y = m_sortedY[entry], POS_Z = m_sortedZ[entry];
+			const float RADIUS = m_sortedRadius[entry];
+
+			for (uint32_t other = span_begin; other < span_end; other++)
+			{
+				const float DX = m_sortedX[other] - POS_X;
+				const float DY = m_sortedY[other] - POS_Y;
+				const float DZ = m_sortedZ[other] - POS_Z;
+				const float DISTANCE_SQUARED = DX * DX + DY * DY + DZ * DZ;
+				const float RADII = RADIUS + m_sortedRadius[other];
+
+				if (DISTANCE_SQUARED >= RADII * RADII)
+					continue;
+
+				// Bodies sitting exactly on top of each other get pushed apart along an arbitrary axis
+				const uint32_t BODY_A = m_cellOrder[entry].second, BODY_B = m_cellOrder[other].second;
+				const float DISTANCE = std::sqrt(DISTANCE_SQUARED);
+
+				if (DISTANCE > 0.0f)
+					contacts.push_back({ BODY_A, BODY_B, DX / DISTANCE, DY / DISTANCE, DZ / DISTANCE, RADII - DISTANCE });
+				else
+					contacts.push_back({ BODY_A, BODY_B, 0.0f, 1.0f, 0.0f, RADII });
+			}
+		};
+
+		// The key of a neighbouring row is the key of the cell plus a constant, so as the cells are walked in order
+		// the rows only ever move forward through the sorted cells. One binary search places each row cursor at the
+		// start of the job, after that the rows are merged in without any lookups
+		uint32_t rowCursors[5];
+		uint64_t pairsTested = 0;
+
+		for (uint32_t cell = begin; cell < end; cell++)
+		{
+			const uint32_t CELL_BEGIN = m_cellStarts[cell], CELL_END = m_cellStarts[cell + 1];
+			const uint32_t CELL_COUNT = CELL_END - CELL_BEGIN;
+
+			// Pairs within the cell itself
+			for (uint32_t entry = CELL_BEGIN; entry < CELL_END; entry++)
+				testSpan(entry, entry + 1, CELL_END);
+
+			pairsTested += CELL_COUNT * (CELL_COUNT - 1) / 2;
+
+			// Pairs with the forward half of the neighbouring cells
+			int32_t cellX, cellY, cellZ;
+			unpackCell(m_cellKeys[cell], cellX, cellY, cellZ);
+
+			for (uint32_t row = 0; row < 5; row++)
+			{
+				const int32_t* ROW = FORWARD_ROWS[row];
+				const uint64_t FIRST_KEY = packCell(cellX + ROW[0], cellY + ROW[1], cellZ + ROW[2]);
+				const uint64_t LAST_KEY = packCell(cellX + ROW[0], cellY + ROW[1], cellZ + ROW[3]);
+
+				uint32_t& cursor = rowCursors[row];
+				if (cell == begin)
+				{
+					cursor = static_cast<uint32_t>(std::lower_bound(m_cellKeys.begin(), m_cellKeys.end(), FIRST_KEY) -
+						m_cellKeys.begin());
+				}
+				else
+				{
+					while (cursor < NUM_CELLS && m_cellKeys[cursor] < FIRST_KEY)
+						cursor++;
+				}
+
+				uint32_t rowEndCell = cursor;
+				while (rowEndCell < NUM_CELLS && m_cellKeys[rowEndCell] <= LAST_KEY)
+					rowEndCell++;
+
+				const uint32_t ROW_BEGIN = m_cellStarts[cursor], ROW_END = m_cellStarts[rowEndCell];
+				for (uint32_t entry = CELL_BEGIN; entry < CELL_END; entry++)
+					testSpan(entry, ROW_BEGIN, ROW_END);
+
+				pairsTested += static_cast<uint64_t>(CELL_COUNT) * (ROW_END - ROW_BEGIN);
+			}
+		}
+
+		m_rangePairs[begin / CELL_GRAIN_SIZE] = pairsTested;
+	};
+
+	if (m_jobSystem)
+		m_jobSystem->parallelFor(0, NUM_CELLS, CELL_GRAIN_SIZE, processCells);
+	else
+	{
+		for (uint32_t begin = 0; begin < NUM_CELLS; begin += CELL_GRAIN_SIZE)
+			processCells(begin, std::min(NUM_CELLS, begin + CELL_GRAIN_SIZE));
+	}
+
+	// Gather the contacts of every job into one list
+	m_contacts.clear();
+	m_stats.m_pairsTested = 0;
+
+	for (uint32_t range = 0; range < NUM_RANGES; range++)
+	{
+		m_contacts.insert(m_contacts.end(), m_rangeContacts[range].begin(), m_rangeContacts[range].end());
+		m_stats.m_pairsTested += m_rangePairs[range];
+	}
+
+	m_stats.m_contacts = static_cast<uint32_t>(m_contacts.size());
+}
+
+void CollisionSystem::resolveContacts(BodyStore& bodies) const
+{
+	// Contacts share bodies with each other, so they are resolved one after another
+	for (const BodyContact& contact : m_contacts)
+	{
+		const uint32_t A = contact.m_bodyA, B = contact.m_bodyB;
+		const float INV_MASS_A = 1.0f / bodies.m_mass[A], INV_MASS_B = 1.0f / bodies.m_mass[B];
+		const float INV_MASS_SUM = INV_MASS_A + INV_MASS_B;
+
+		// Only bounce the bodies if they are still moving towards each other
+		const float NORMAL_SPEED = (bodies.m_velocityX[B] - bodies.m_velocityX[A]) * contact.m_normalX +
+			(bodies.m_velocityY[B] - bodies.m_velocityY[A]) * contact.m_normalY +
+			(bodies.m_velocityZ[B] - bodies.m_velocityZ[A]) * contact.m_normalZ;
+
+		if (NORMAL_SPEED < 0.0f)
+		{
+			const float IMPULSE = -(1.0f + m_restitution) * NORMAL_SPEED / INV_MASS_SUM;
+
+			bodies.m_velocityX[A] -= IMPULSE * INV_MASS_A * contact.m_normalX;
+			bodies.m_velocityY[A] -= IMPULSE * INV_MASS_A * contact.m_normalY;
+			bodies.m_velocityZ[A] -= IMPULSE * INV_MASS_A * contact.m_normalZ;
+
+			bodies.m_velocityX[B] += IMPULSE * INV_MASS_B * contact.m_normalX;
+			bodies.m_velocityY[B] += IMPULSE * INV_MASS_B * contact.m_normalY;
+			bodies.m_velocityZ[B] += IMPULSE * INV_MASS_B * contact.m_normalZ;
+		}
+
+		// Separate the bodies in proportion to their inverse masses so the lighter one moves further
+		const float CORRECTION = std::max(contact.m_penetration - CORRECTION_SLOP, 0.0f) * CORRECTION_PERCENT /
+			INV_MASS_SUM;
+
+		bodies.m_positionX[A] -= CORRECTION * INV_MASS_A * contact.m_normalX;
+		bodies.m_positionY[A] -= CORRECTION * INV_MASS_A * contact.m_normalY;
+		bodies.m_positionZ[A] -= CORRECTION * INV_MASS_A * contact.m_normalZ;
+
+		bodies.m_positionX[B] += CORRECTION * INV_MASS_B * contact.m_normalX;
+		bodies.m_positionY[B] += CORRECTION * INV_MASS_B * contact.m_normalY;
+		bodies.m_positionZ[B] += CORRECTION * INV_MASS_B * contact.m_normalZ;
+	}
+}
+
+void CollisionSystem::detectCollisions(const BodyStore& bodies)
+{
+	if (bodies.getCount() == 0)
+	{
+		m_cellOrder.clear();
+		m_cellStarts.clear();
+		m_cellKeys.clear();
+		m_hashTable.clear();
+		m_contacts.clear();
+		m_stats = CollisionStats();
+		return;
+	}
+
+	this->rebuildGrid(bodies);
+	this->findContacts();
+}
+
+void CollisionSystem::update(BodyStore& bodies)
+{
+	this->detectCollisions(bodies);
+	this->resolveContacts(bodies);
+}
+
+bool CollisionSystem::resolveSphere(glm::vec3& center, float radius, const BodyStore& bodies) const
+{
+	if (m_hashTable.empty() || m_cellOrder.size() != bodies.getCount())
+		return false;
+
+	// Visit every cell a body overlapping the sphere could be binned in, the largest body is half a cell wide
+	const float REACH = radius + m_cellSize * 0.5f;
+	int32_t minCell[3], maxCell[3];
+
+	for (uint32_t axis = 0; axis < 3; axis++)
+	{
+		minCell[axis] = static_cast<int32_t>(std::floor((center[axis] - REACH) / m_cellSize));
+		maxCell[axis] = static_cast<int32_t>(std::floor((center[axis] + REACH) / m_cellSize));
+	}
+
+	bool moved = false;
+	for (int32_t cellX = minCell[0]; cellX <= maxCell[0]; cellX++)
+	{
+		for (int32_t cellY = minCell[1]; cellY <= maxCell[1]; cellY++)
+		{
+			for (int32_t cellZ = minCell[2]; cellZ <= maxCell[2]; cellZ++)
+			{
+				const uint32_t CELL = this->findCell(packCell(cellX, cellY, cellZ));
+				if (CELL == EMPTY_SLOT)
+					continue;
+
+				for (uint32_t entry = m_cellStarts[CELL]; entry < m_cellStarts[CELL + 1]; entry++)
+				{
+					const uint32_t BODY = m_cellOrder[entry].second;
+					const glm::vec3 OFFSET = center - glm::vec3(bodies.m_positionX[BODY], bodies.m_positionY[BODY],
+						bodies.m_positionZ[BODY]);
+
+					const float DISTANCE = glm::length(OFFSET);
+					const float RADII = radius + bodies.m_scale[BODY] * m_radiusScale;
+
+					if (DISTANCE < RADII && DISTANCE > 0.0f)
+					{
+						center += OFFSET * ((RADII - DISTANCE) / DISTANCE);
+						moved = true;
+					}
+				}
+			}
+		}
+	}
+
+	return moved;
+}
+
+const std::vector<BodyContact>& CollisionSystem::getContacts() const
+{
+	return m_contacts;
+}
+
+const CollisionStats& CollisionSystem::getStats() const
+{
+	return m_stats;
+}
+
+float CollisionSystem::getCellSize() const
+{
+	return m_cellSize;
+}
\ No newline at end of file
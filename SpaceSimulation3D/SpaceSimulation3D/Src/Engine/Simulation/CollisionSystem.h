@@ -0,0 +1,68 @@
+#pragma once
+#include "Engine/Simulation/BodyStore.h"
+#include "Engine/Utils/JobSystem.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+struct BodyContact
+{
+	uint32_t m_bodyA, m_bodyB;
+	float m_normalX, m_normalY, m_normalZ; // Unit vector pointing from body A towards body B
+	float m_penetration;
+};
+
+struct CollisionStats
+{
+	uint64_t m_pairsTested = 0; // Sphere-sphere tests run by the narrow phase
+	uint32_t m_contacts = 0;
+	uint32_t m_occupiedCells = 0;
+	uint32_t m_cellChanges = 0; // Bodies that moved to a different cell since the previous update
+};
+
+// Uniform spatial hash grid broad phase. Bodies are kept in an array sorted by cell, which stays nearly sorted from
+// one tick to the next, so the grid is rebuilt incrementally instead of from scratch
+class CollisionSystem
+{
+private:
+	float m_radiusScale, m_restitution, m_cellSize;
+	std::shared_ptr<JobSystem> m_jobSystem;
+
+	std::vector<std::pair<uint64_t, uint32_t>> m_cellOrder; // Cell key and body index, sorted by key
+	std::vector<float> m_sortedX, m_sortedY, m_sortedZ, m_sortedRadius; // Body data copied into the cell order
+	std::vector<uint32_t> m_cellStarts; // Where each occupied cell begins in the cell order (plus an end marker)
+	std::vector<uint64_t> m_cellKeys; // Key of each occupied cell, in ascending order
+	std::vector<uint32_t> m_hashTable; // Open addressing table mapping a cell key to its occupied cell
+	uint32_t m_hashMask;
+
+	std::vector<std::vector<BodyContact>> m_rangeContacts; // Contacts found by each job of the narrow phase
+	std::vector<uint64_t> m_rangePairs;
+	std::vector<BodyContact> m_contacts;
+	CollisionStats m_stats;
+private:
+	uint64_t getCellKey(float pos_x, float pos_y, float pos_z) const; // Packs the coordinates of the containing cell
+	uint32_t findCell(uint64_t cell_key) const; // Returns the occupied cell with the given key (UINT32_MAX if empty)
+
+	void rebuildGrid(const BodyStore& bodies); // Re-bins the bodies that changed cells and rebuilds the cell lookup
+	void findContacts(); // Tests every body against its own and the neighbouring cells
+	void resolveContacts(BodyStore& bodies) const; // Applies an impulse and positional correction per contact
+public:
+	// The radius of a body is its scale multiplied by the radius scale (the bounding radius of the model at scale 1)
+	CollisionSystem(float radius_scale = 1.0f, float restitution = 0.5f, std::shared_ptr<JobSystem> job_system = nullptr);
+	~CollisionSystem();
+
+	void setJobSystem(std::shared_ptr<JobSystem> job_system); // Sets the job system the cells are split across (nullptr = serial)
+	void setRestitution(float restitution); // Sets how much of the approach speed is kept after a bounce (0 - 1)
+
+	void detectCollisions(const BodyStore& bodies); // Updates the grid and finds every pair of overlapping bodies
+	void update(BodyStore& bodies); // Detects the collisions, then pushes the overlapping bodies apart
+
+	// resolveSphere() : Pushes the sphere out of every body it overlaps, the bodies themselves aren't moved.
+	// Returns whether the sphere was moved
+	bool resolveSphere(glm::vec3& center, float radius, const BodyStore& bodies) const;
+public:
+	const std::vector<BodyContact>& getContacts() const; // Returns the contacts found by the last detection
+	const CollisionStats& getStats() const; // Returns the statistics of the last detection
+	float getCellSize() const; // Returns the edge length of a grid cell
+};
\ No newline at end of file
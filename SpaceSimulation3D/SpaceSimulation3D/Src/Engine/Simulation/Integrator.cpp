@@ -0,0 +1,268 @@
+#include "Integrator.h"
+
+#include <cmath>
+
+namespace
+{
+	constexpr uint32_t INTEGRATE_GRAIN_SIZE = 16384; // Bodies per job in the kick and drift loops
+
+	// Yoshida's coefficients for composing three leapfrog steps into a 4th order symplectic step
+	const double YOSHIDA_W1 = 1.0 / (2.0 - std::cbrt(2.0));
+	const double YOSHIDA_W0 = -std::cbrt(2.0) / (2.0 - std::cbrt(2.0));
+	const float YOSHIDA_DRIFT[4] { static_cast<float>(YOSHIDA_W1 * 0.5), static_cast<float>((YOSHIDA_W0 + YOSHIDA_W1) * 0.5),
+		static_cast<float>((YOSHIDA_W0 + YOSHIDA_W1) * 0.5), static_cast<float>(YOSHIDA_W1 * 0.5) };
+	const float YOSHIDA_KICK[3] { static_cast<float>(YOSHIDA_W1), static_cast<float>(YOSHIDA_W0),
+		static_cast<float>(YOSHIDA_W1) };
+
+	void addScaled(float* __restrict target, const float* __restrict source, uint32_t num_bodies, float scale)
+	{
+		for (uint32_t index = 0; index < num_bodies; index++)
+			target[index] += source[index] * scale;
+	}
+
+	// Semi-implicit Euler in one pass: kick the velocity, then drift the position with the new velocity
+	void kickDrift(float* __restrict pos, float* __restrict vel, const float* __restrict acc, uint32_t num_bodies,
+		float delta_time)
+	{
+		for (uint32_t index = 0; index < num_bodies; index++)
+		{
+			vel[index] += acc[index] * delta_time;
+			pos[index] += vel[index] * delta_time;
+		}
+	}
+
+	// Moves an RK4 stage forward from the start of the step by the derivatives of the previous stage
+	void advanceStage(const float* __restrict start_pos, const float* __restrict start_vel,
+		float* __restrict stage_pos, float* __restrict stage_vel, const float* __restrict stage_acc, uint32_t num_bodies,
+		float step_size)
+	{
+		for (uint32_t index = 0; index < num_bodies; index++)
+		{
+			stage_pos[index] = start_pos[index] + stage_vel[index] * step_size;
+			stage_vel[index] = start_vel[index] + stage_acc[index] * step_size;
+		}
+	}
+}
+
+Integrator::Integrator(IntegratorType type, std::shared_ptr<JobSystem> job_system) :
+	m_type(type), m_jobSystem(job_system), m_accelerationsValid(false)
+{}
+
+Integrator::~Integrator() {}
+
+void Integrator::runRanges(uint32_t count, const std::function<void(uint32_t, uint32_t)>& task) const
+{
+	if (m_jobSystem)
+		m_jobSystem->parallelFor(0, count, INTEGRATE_GRAIN_SIZE, task);
+	else
+		task(0, count);
+}
+
+void Integrator::evaluate(const BodyStore& bodies, const AccelerationFunction& acceleration)
+{
+	const uint32_t NUM_BODIES = bodies.getCount();
+	m_accelerationX.resize(NUM_BODIES);
+	m_accelerationY.resize(NUM_BODIES);
+	m_accelerationZ.resize(NUM_BODIES);
+
+	acceleration(bodies, m_accelerationX.data(), m_accelerationY.data(), m_accelerationZ.data());
+}
+
+void Integrator::kick(BodyStore& bodies, float delta_time) const
+{
+	this->runRanges(bodies.getCount(), [this, &bodies, delta_time](uint32_t begin, uint32_t end)
+	{
+		addScaled(&bodies.m_velocityX[begin], &m_accelerationX[begin], end - begin, delta_time);
+		addScaled(&bodies.m_velocityY[begin], &m_accelerationY[begin], end - begin, delta_time);
+		addScaled(&bodies.m_velocityZ[begin], &m_accelerationZ[begin], end - begin, delta_time);
+	});
+}
+
+void Integrator::drift(BodyStore& bodies, float delta_time) const
+{
+	this->runRanges(bodies.getCount(), [&bodies, delta_time](uint32_t begin, uint32_t end)
+	{
+		addScaled(&bodies.m_positionX[begin], &bodies.m_velocityX[begin], end - begin, delta_time);
+		addScaled(&bodies.m_positionY[begin], &bodies.m_velocityY[begin], end - begin, delta_time);
+		addScaled(&bodies.m_positionZ[begin], &bodies.m_velocityZ[begin], end - begin, delta_time);
+	});
+}
+
+void Integrator::stepSemiImplicitEuler(BodyStore& bodies, const AccelerationFunction& acceleration, float delta_time)
+{
+	this->evaluate(bodies, acceleration);
+
+	this->runRanges(bodies.getCount(), [this, &bodies, delta_time](uint32_t begin, uint32_t end)
+	{
+		kickDrift(&bodies.m_positionX[begin], &bodies.m_velocityX[begin], &m_accelerationX[begin], end - begin, delta_time);
+		kickDrift(&bodies.m_positionY[begin], &bodies.m_velocityY[begin], &m_accelerationY[begin], end - begin, delta_time);
+		kickDrift(&bodies.m_positionZ[begin], &bodies.m_velocityZ[begin], &m_accelerationZ[begin], end - begin, delta_time);
+	});
+}
+
+void Integrator::stepVelocityVerlet(BodyStore& bodies, const AccelerationFunction& acceleration, float delta_time)
+{
+	// Kick-drift-kick leapfrog. The accelerations at the end of a step are the ones the next step starts with, so
+	// unless the bodies were moved in between only one evaluation is needed per step
+	if (!m_accelerationsValid || m_accelerationX.size() != bodies.getCount())
+		this->evaluate(bodies, acceleration);
+
+	this->kick(bodies, delta_time * 0.5f);
+	this->drift(bodies, delta_time);
+	this->evaluate(bodies, acceleration);
+	this->kick(bodies, delta_time * 0.5f);
+
+	m_accelerationsValid = true;
+}
+
+void Integrator::stepYoshida4(BodyStore& bodies, const AccelerationFunction& acceleration, float delta_time)
+{
+	// Drift-kick sequence of three leapfrog steps, the middle one runs backwards in time
+	for (uint32_t stage = 0; stage < 3; stage++)
+	{
+		this->drift(bodies, YOSHIDA_DRIFT[stage] * delta_time);
+		this->evaluate(bodies, acceleration);
+		this->kick(bodies, YOSHIDA_KICK[stage] * delta_time);
+	}
+
+	this->drift(bodies, YOSHIDA_DRIFT[3] * delta_time);
+}
+
+void Integrator::stepRK4(BodyStore& bodies, const AccelerationFunction& acceleration, float delta_time)
+{
+	constexpr float STAGE_STEPS[4] { 0.0f, 0.5f, 0.5f, 1.0f };
+	constexpr float STAGE_WEIGHTS[4] { 1.0f, 2.0f, 2.0f, 1.0f };
+
+	const uint32_t NUM_BODIES = bodies.getCount();
+
+	// The stages only need the positions and masses for the acceleration function
+	m_stageBodies.m_positionX = bodies.m_positionX;
+	m_stageBodies.m_positionY = bodies.m_positionY;
+	m_stageBodies.m_positionZ = bodies.m_positionZ;
+	m_stageBodies.m_mass = bodies.m_mass;
+
+	m_stageVelX = bodies.m_velocityX;
+	m_stageVelY = bodies.m_velocityY;
+	m_stageVelZ = bodies.m_velocityZ;
+
+	for (auto* sum : { &m_sumPosX, &m_sumPosY, &m_sumPosZ, &m_sumVelX, &m_sumVelY, &m_sumVelZ })
+		sum->assign(NUM_BODIES, 0.0f);
+
+	for (uint32_t stage = 0; stage < 4; stage++)
+	{
+		if (stage > 0)
+		{
+			const float STEP_SIZE = STAGE_STEPS[stage] * delta_time;
+
+			this->runRanges(NUM_BODIES, [this, &bodies, STEP_SIZE](uint32_t begin, uint32_t end)
+			{
+				advanceStage(&bodies.m_positionX[begin], &bodies.m_velocityX[begin], &m_stageBodies.m_positionX[begin],
+					&m_stageVelX[begin], &m_accelerationX[begin], end - begin, STEP_SIZE);
+				advanceStage(&bodies.m_positionY[begin], &bodies.m_velocityY[begin], &m_stageBodies.m_positionY[begin],
+					&m_stageVelY[begin], &m_accelerationY[begin], end - begin, STEP_SIZE);
+				advanceStage(&bodies.m_positionZ[begin], &bodies.m_velocityZ[begin], &m_stageBodies.m_positionZ[begin],
+					&m_stageVelZ[begin], &m_accelerationZ[begin], end - begin, STEP_SIZE);
+			});
+		}
+
+		this->evaluate(m_stageBodies, acceleration);
+
+		// Accumulate the weighted derivatives of the stage
+		const float WEIGHT = STAGE_WEIGHTS[stage];
+		this->runRanges(NUM_BODIES, [this, WEIGHT](uint32_t begin, uint32_t end)
+		{
+			addScaled(&m_sumPosX[begin], &m_stageVelX[begin], end - begin, WEIGHT);
+			addScaled(&m_sumPosY[begin], &m_stageVelY[begin], end - begin, WEIGHT);
+			addScaled(&m_sumPosZ[begin], &m_stageVelZ[begin], end - begin, WEIGHT);
+			addScaled(&m_sumVelX[begin], &m_accelerationX[begin], end - begin, WEIGHT);
+			addScaled(&m_sumVelY[begin], &m_accelerationY[begin], end - begin, WEIGHT);
+			addScaled(&m_sumVelZ[begin], &m_accelerationZ[begin], end - begin, WEIGHT);
+		});
+	}
+
+	const float SUM_SCALE = delta_time / 6.0f;
+	this->runRanges(NUM_BODIES, [this, &bodies, SUM_SCALE](uint32_t begin, uint32_t end)
+	{
+		addScaled(&bodies.m_positionX[begin], &m_sumPosX[begin], end - begin, SUM_SCALE);
+		addScaled(&bodies.m_positionY[begin], &m_sumPosY[begin], end - begin, SUM_SCALE);
+		addScaled(&bodies.m_positionZ[begin], &m_sumPosZ[begin], end - begin, SUM_SCALE);
+		addScaled(&bodies.m_velocityX[begin], &m_sumVelX[begin], end - begin, SUM_SCALE);
+		addScaled(&bodies.m_velocityY[begin], &m_sumVelY[begin], end - begin, SUM_SCALE);
+		addScaled(&bodies.m_velocityZ[begin], &m_sumVelZ[begin], end - begin, SUM_SCALE);
+	});
+}
+
+void Integrator::setType(IntegratorType type)
+{
+	m_type = type;
+	m_accelerationsValid = false;
+}
+
+void Integrator::setJobSystem(std::shared_ptr<JobSystem> job_system)
+{
+	m_jobSystem = job_system;
+}
+
+void Integrator::invalidate()
+{
+	m_accelerationsValid = false;
+}
+
+void Integrator::step(BodyStore& bodies, const AccelerationFunction& acceleration, float delta_time)
+{
+	if (bodies.getCount() == 0)
+		return;
+
+	switch (m_type)
+	{
+	case IntegratorType::SEMI_IMPLICIT_EULER:
+		this->stepSemiImplicitEuler(bodies, acceleration, delta_time);
+		break;
+	case IntegratorType::VELOCITY_VERLET:
+		this->stepVelocityVerlet(bodies, acceleration, delta_time);
+		break;
+	case IntegratorType::YOSHIDA4:
+		this->stepYoshida4(bodies, acceleration, delta_time);
+		break;
+	case IntegratorType::RK4:
+		this->stepRK4(bodies, acceleration, delta_time);
+		break;
+	}
+
+	// Only Verlet leaves accelerations that match the new positions
+	if (m_type != IntegratorType::VELOCITY_VERLET)
+		m_accelerationsValid = false;
+}
+
+IntegratorType Integrator::getType() const
+{
+	return m_type;
+}
+
+uint32_t Integrator::getEvaluationsPerStep() const
+{
+	switch (m_type)
+	{
+	case IntegratorType::YOSHIDA4:
+		return 3;
+	case IntegratorType::RK4:
+		return 4;
+	default:
+		return 1;
+	}
+}
+
+const char* Integrator::getName() const
+{
+	switch (m_type)
+	{
+	case IntegratorType::VELOCITY_VERLET:
+		return "Velocity Verlet";
+	case IntegratorType::YOSHIDA4:
+		return "Yoshida 4th order";
+	case IntegratorType::RK4:
+		return "RK4";
+	default:
+		return "Semi-implicit Euler";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include "Engine/Simulation/BodyStore.h"
+#include "Engine/Utils/JobSystem.h"
+
+#include <functional>
+#include <vector>
+#include <memory>
+
+enum class IntegratorType
+{
+	SEMI_IMPLICIT_EULER,
+	VELOCITY_VERLET,
+	YOSHIDA4,
+	RK4
+};
+
+// Writes the acceleration of every body in the store, evaluated at the positions held by the store
+typedef std::function<void(const BodyStore&, float*, float*, float*)> AccelerationFunction;
+
+class Integrator
+{
+private:
+	IntegratorType m_type;
+	std::shared_ptr<JobSystem> m_jobSystem;
+
+	std::vector<float> m_accelerationX, m_accelerationY, m_accelerationZ;
+	bool m_accelerationsValid; // Whether the accelerations still match the current positions (used by Verlet)
+
+	BodyStore m_stageBodies; // Positions and masses of the intermediate RK4 stages
+	std::vector<float> m_stageVelX, m_stageVelY, m_stageVelZ;
+	std::vector<float> m_sumPosX, m_sumPosY, m_sumPosZ, m_sumVelX, m_sumVelY, m_sumVelZ;
+private:
+	void runRanges(uint32_t count, const std::function<void(uint32_t, uint32_t)>& task) const; // Splits the loop across the job system, if one is set
+	void evaluate(const BodyStore& bodies, const AccelerationFunction& acceleration); // Refreshes the acceleration arrays
+
+	void kick(BodyStore& bodies, float delta_time) const; // Advances the velocities by the stored accelerations
+	void drift(BodyStore& bodies, float delta_time) const; // Advances the positions by the velocities
+
+	void stepSemiImplicitEuler(BodyStore& bodies, const AccelerationFunction& acceleration, float delta_time);
+	void stepVelocityVerlet(BodyStore& bodies, const AccelerationFunction& acceleration, float delta_time);
+	void stepYoshida4(BodyStore& bodies, const AccelerationFunction& acceleration, float delta_time);
+	void stepRK4(BodyStore& bodies, const AccelerationFunction& acceleration, float delta_time);
+public:
+	Integrator(IntegratorType type = IntegratorType::SEMI_IMPLICIT_EULER, std::shared_ptr<JobSystem> job_system = nullptr);
+	~Integrator();
+
+	void setType(IntegratorType type); // Sets the integration scheme used by the following steps
+	void setJobSystem(std::shared_ptr<JobSystem> job_system); // Sets the job system the per-body loops are split across (nullptr = serial)
+	void invalidate(); // Drops the cached accelerations, needed whenever bodies are moved outside of step()
+
+	// step() : Advances the positions and velocities of every body in the store by the given time step
+	void step(BodyStore& bodies, const AccelerationFunction& acceleration, float delta_time);
+public:
+	IntegratorType getType() const; // Returns the integration scheme in use
+	uint32_t getEvaluationsPerStep() const; // Returns how many times a step calls the acceleration function
+	const char* getName() const; // Returns the display name of the integration scheme
+};
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "OrbitalSimulation.h"
+#include "Engine/Simulation/TransformKernels.h"
+#include "Engine/Utils/RandomGenerator.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr float ASTEROID_DENSITY = 1.0f;
+
+	// Random streams of the generated asteroid properties
+	constexpr uint32_t OFFSET_X_STREAM = 0, OFFSET_Y_STREAM = 1, OFFSET_Z_STREAM = 2;
+	constexpr uint32_t SCALE_STREAM = 3, AXIS_X_STREAM = 4, AXIS_Y_STREAM = 5, AXIS_Z_STREAM = 6;
+	constexpr uint32_t ANGLE_STREAM = 7, SPIN_STREAM = 8;
+	constexpr float SOFTENING_SQUARED = 0.01f; // Stops the acceleration from blowing up near the central body
+
+	constexpr uint32_t INTEGRATE_GRAIN_SIZE = 16384; // Bodies per job in the streaming integration loops
+	constexpr uint32_t GENERATE_GRAIN_SIZE = 4096; // Asteroids per job when generating the belt
+	constexpr uint32_t INSTANCE_GRAIN_SIZE = 2048; // Bodies per job when building the instance matrices
+	constexpr uint32_t INSTANCE_BATCH_SIZE = 256; // Bodies staged on the stack per call into the transform kernels
+
+	// The kernels take their arrays as restrict-qualified parameters so the compiler knows the components never
+	// alias, which is what allows the loops to be vectorized
+	template<bool ACCUMULATE>
+	void applyCentralGravity(const float* __restrict pos_x, const float* __restrict pos_y, const float* __restrict pos_z,
+		float* __restrict acc_x, float* __restrict acc_y, float* __restrict acc_z, uint32_t num_bodies,
+		const glm::vec3& central_pos, float central_gm)
+	{
+		const float CENTRAL_X = central_pos.x, CENTRAL_Y = central_pos.y, CENTRAL_Z = central_pos.z;
+
+		// The loop body has no branches or cross-iteration dependencies
+		for (uint32_t index = 0; index < num_bodies; index++)
+		{
+			const float DX = pos_x[index] - CENTRAL_X;
+			const float DY = pos_y[index] - CENTRAL_Y;
+			const float DZ = pos_z[index] - CENTRAL_Z;
+
+			const float INV_DISTANCE = 1.0f / std::sqrt(DX * DX + DY * DY + DZ * DZ + SOFTENING_SQUARED);
+			const float STRENGTH = -central_gm * INV_DISTANCE * INV_DISTANCE * INV_DISTANCE;
+
+			acc_x[index] = (ACCUMULATE ? acc_x[index] : 0.0f) + DX * STRENGTH;
+			acc_y[index] = (ACCUMULATE ? acc_y[index] : 0.0f) + DY * STRENGTH;
+			acc_z[index] = (ACCUMULATE ? acc_z[index] : 0.0f) + DZ * STRENGTH;
+		}
+	}
+
+	void advanceSpin(float* __restrict angles, const float* __restrict spin_rates, uint32_t num_bodies,
+		float delta_time)
+	{
+		for (uint32_t index = 0; index < num_bodies; index++)
+			angles[index] += spin_rates[index] * delta_time;
+	}
+
+	void blendState(const float* __restrict previous, const float* __restrict current, float* __restrict blended,
+		uint32_t num_bodies, float alpha)
+	{
+		for (uint32_t index = 0; index < num_bodies; index++)
+			blended[index] = previous[index] + (current[index] - previous[index]) * alpha;
+	}
+}
+
+OrbitalSimulation::OrbitalSimulation(const glm::vec3& central_pos, float central_gm) :
+	m_centralPosition(central_pos), m_centralGM(central_gm)
+{}
+
+OrbitalSimulation::~OrbitalSimulation() {}
+
+void OrbitalSimulation::generateAsteroidBelt(uint32_t num_asteroids, float radius, uint64_t seed)
+{
+	m_bodies.clear();
+	m_bodies.resize(num_asteroids);
+
+	// Each property draws from its own random stream at the asteroid's index, so the ranges can be generated on any
+	// thread in any order and the belt still comes out the same for the same seed
+	this->runRanges(num_asteroids, GENERATE_GRAIN_SIZE, [this, num_asteroids, radius, seed](uint32_t begin,
+		uint32_t end)
+	{
+		const uint32_t COUNT = end - begin;
+
+		Random::fillFloats(seed, OFFSET_X_STREAM, begin, &m_bodies.m_positionX[begin], COUNT, -2.5f, 4.0f);
+		Random::fillFloats(seed, OFFSET_Y_STREAM, begin, &m_bodies.m_positionY[begin], COUNT, -0.5f, 0.5f);
+		Random::fillFloats(seed, OFFSET_Z_STREAM, begin, &m_bodies.m_positionZ[begin], COUNT, -2.5f, 4.0f);
+		Random::fillFloats(seed, SCALE_STREAM, begin, &m_bodies.m_scale[begin], COUNT, 0.03f, 0.1f);
+		Random::fillFloats(seed, AXIS_X_STREAM, begin, &m_bodies.m_rotationAxisX[begin], COUNT, 0.0f, 1.0f);
+		Random::fillFloats(seed, AXIS_Y_STREAM, begin, &m_bodies.m_rotationAxisY[begin], COUNT, 0.0f, 1.0f);
+		Random::fillFloats(seed, AXIS_Z_STREAM, begin, &m_bodies.m_rotationAxisZ[begin], COUNT, 0.0f, 1.0f);
+		Random::fillFloats(seed, ANGLE_STREAM, begin, &m_bodies.m_rotationAngle[begin], COUNT, 0.0f, glm::radians(360.0f));
+		Random::fillFloats(seed, SPIN_STREAM, begin, &m_bodies.m_spinRate[begin], COUNT, 0.1f, 0.5f);
+
+		for (uint32_t index = begin; index < end; index++)
+		{
+			// Place the asteroid around the ring, the position arrays hold its random offset from it so far
+			const float ANGLE = static_cast<float>(index) / static_cast<float>(num_asteroids) * glm::radians(360.0f);
+			const glm::vec3 POSITION(m_centralPosition.x + (cos(ANGLE) * radius) + m_bodies.m_positionX[index],
+				m_centralPosition.y + m_bodies.m_positionY[index],
+				m_centralPosition.z + (sin(ANGLE) * radius) + m_bodies.m_positionZ[index]);
+
+			// Give the asteroid the velocity of a circular orbit at its distance from the central body
+			const glm::vec3 RELATIVE_POS = POSITION - m_centralPosition;
+			const float DISTANCE = glm::length(RELATIVE_POS);
+			const glm::vec3 TANGENT = glm::normalize(glm::vec3(-RELATIVE_POS.z, 0.0f, RELATIVE_POS.x));
+			const glm::vec3 VELOCITY = TANGENT * sqrt(m_centralGM / DISTANCE);
+
+			const float SCALE = m_bodies.m_scale[index];
+			const glm::vec3 AXIS(m_bodies.m_rotationAxisX[index], m_bodies.m_rotationAxisY[index],
+				m_bodies.m_rotationAxisZ[index]);
+
+			m_bodies.setBody(index, POSITION, VELOCITY, ASTEROID_DENSITY * SCALE * SCALE * SCALE, SCALE, AXIS,
+				m_bodies.m_rotationAngle[index], m_bodies.m_spinRate[index]);
+		}
+	});
+
+	m_integrator.invalidate();
+}
+
+void OrbitalSimulation::runRanges(uint32_t count, uint32_t grain_size,
+	const std::function<void(uint32_t, uint32_t)>& task) const
+{
+	if (m_jobSystem)
+		m_jobSystem->parallelFor(0, count, grain_size, task);
+	else
+		task(0, count);
+}
+
+void OrbitalSimulation::setJobSystem(std::shared_ptr<JobSystem> job_system)
+{
+	m_jobSystem = job_system;
+	m_integrator.setJobSystem(job_system);
+}
+
+void OrbitalSimulation::setMutualGravity(std::shared_ptr<BarnesHutSolver> solver)
+{
+	m_mutualGravity = solver;
+
+	// The integrator may be holding accelerations from the old forces
+	m_integrator.invalidate();
+}
+
+void OrbitalSimulation::setCollisions(std::shared_ptr<CollisionSystem> collisions)
+{
+	m_collisions = collisions;
+}
+
+void OrbitalSimulation::setIntegrator(IntegratorType type)
+{
+	m_integrator.setType(type);
+}
+
+void OrbitalSimulation::computeAccelerations(const BodyStore& bodies, float* acc_x, float* acc_y, float* acc_z) const
+{
+	const uint32_t NUM_BODIES = bodies.getCount();
+
+	// The body-body attraction writes the arrays first, the central gravity is added on top of it
+	const bool HAS_MUTUAL_GRAVITY = m_mutualGravity != nullptr;
+	if (HAS_MUTUAL_GRAVITY)
+		m_mutualGravity->computeAccelerations(bodies, acc_x, acc_y, acc_z);
+
+	this->runRanges(NUM_BODIES, INTEGRATE_GRAIN_SIZE, [this, &bodies, acc_x, acc_y, acc_z,
+		HAS_MUTUAL_GRAVITY](uint32_t begin, uint32_t end)
+	{
+		if (HAS_MUTUAL_GRAVITY)
+		{
+			applyCentralGravity<true>(&bodies.m_positionX[begin], &bodies.m_positionY[begin], &bodies.m_positionZ[begin],
+				acc_x + begin, acc_y + begin, acc_z + begin, end - begin, m_centralPosition, m_centralGM);
+		}
+		else
+		{
+			applyCentralGravity<false>(&bodies.m_positionX[begin], &bodies.m_positionY[begin], &bodies.m_positionZ[begin],
+				acc_x + begin, acc_y + begin, acc_z + begin, end - begin, m_centralPosition, m_centralGM);
+		}
+	});
+}
+
+void OrbitalSimulation::stepTick(float delta_time)
+{
+	const uint32_t NUM_BODIES = m_bodies.getCount();
+
+	// Keep the state from before this tick so rendering can interpolate between the two
+	m_previousX = m_bodies.m_positionX;
+	m_previousY = m_bodies.m_positionY;
+	m_previousZ = m_bodies.m_positionZ;
+	m_previousAngle = m_bodies.m_rotationAngle;
+
+	m_integrator.step(m_bodies, [this](const BodyStore& bodies, float* acc_x, float* acc_y, float* acc_z)
+	{
+		this->computeAccelerations(bodies, acc_x, acc_y, acc_z);
+	}, delta_time);
+
+	this->runRanges(NUM_BODIES, INTEGRATE_GRAIN_SIZE, [this, delta_time](uint32_t begin, uint32_t end)
+	{
+		advanceSpin(&m_bodies.m_rotationAngle[begin], &m_bodies.m_spinRate[begin], end - begin, delta_time);
+	});
+
+	// Bounce apart the bodies that ended up overlapping after the drift, which invalidates any accelerations the
+	// integrator kept for the next step
+	if (m_collisions)
+	{
+		m_collisions->update(m_bodies);
+
+		if (m_collisions->getStats().m_contacts > 0)
+			m_integrator.invalidate();
+	}
+}
+
+double OrbitalSimulation::computeEnergy() const
+{
+	double kinetic = 0.0, potential = 0.0;
+
+	for (uint32_t index = 0; index < m_bodies.getCount(); index++)
+	{
+		const double DX = m_bodies.m_positionX[index] - m_centralPosition.x;
+		const double DY = m_bodies.m_positionY[index] - m_centralPosition.y;
+		const double DZ = m_bodies.m_positionZ[index] - m_centralPosition.z;
+		const double SPEED_SQUARED = double(m_bodies.m_velocityX[index]) * m_bodies.m_velocityX[index] +
+			double(m_bodies.m_velocityY[index]) * m_bodies.m_velocityY[index] +
+			double(m_bodies.m_velocityZ[index]) * m_bodies.m_velocityZ[index];
+
+		// The potential matches the softened force the bodies are integrated with
+		kinetic += 0.5 * m_bodies.m_mass[index] * SPEED_SQUARED;
+		potential -= m_centralGM * m_bodies.m_mass[index] / std::sqrt(DX * DX + DY * DY + DZ * DZ + SOFTENING_SQUARED);
+	}
+
+	return kinetic + potential;
+}
+
+glm::vec3 OrbitalSimulation::computeAngularMomentum() const
+{
+	double momentumX = 0.0, momentumY = 0.0, momentumZ = 0.0;
+
+	for (uint32_t index = 0; index < m_bodies.getCount(); index++)
+	{
+		const double MASS = m_bodies.m_mass[index];
+		const double DX = m_bodies.m_positionX[index] - m_centralPosition.x;
+		const double DY = m_bodies.m_positionY[index] - m_centralPosition.y;
+		const double DZ = m_bodies.m_positionZ[index] - m_centralPosition.z;
+		const double VX = m_bodies.m_velocityX[index], VY = m_bodies.m_velocityY[index], VZ = m_bodies.m_velocityZ[index];
+
+		momentumX += MASS * (DY * VZ - DZ * VY);
+		momentumY += MASS * (DZ * VX - DX * VZ);
+		momentumZ += MASS * (DX * VY - DY * VX);
+	}
+
+	return glm::vec3(static_cast<float>(momentumX), static_cast<float>(momentumY), static_cast<float>(momentumZ));
+}
+
+void OrbitalSimulation::stageInstanceBatch(uint32_t begin, uint32_t count, float alpha, float* pos_x, float* pos_y,
+	float* pos_z, float* quat_x, float* quat_y, float* quat_z, float* quat_w) const
+{
+	// Before the first tick there is no previous state, so the current one is used as is
+	float angle[INSTANCE_BATCH_SIZE];
+	if (m_previousX.size() == m_bodies.getCount())
+	{
+		blendState(&m_previousX[begin], &m_bodies.m_positionX[begin], pos_x, count, alpha);
+		blendState(&m_previousY[begin], &m_bodies.m_positionY[begin], pos_y, count, alpha);
+		blendState(&m_previousZ[begin], &m_bodies.m_positionZ[begin], pos_z, count, alpha);
+		blendState(&m_previousAngle[begin], &m_bodies.m_rotationAngle[begin], angle, count, alpha);
+	}
+	else
+	{
+		std::copy_n(&m_bodies.m_positionX[begin], count, pos_x);
+		std::copy_n(&m_bodies.m_positionY[begin], count, pos_y);
+		std::copy_n(&m_bodies.m_positionZ[begin], count, pos_z);
+		std::copy_n(&m_bodies.m_rotationAngle[begin], count, angle);
+	}
+
+	TransformKernels::axisAngleToQuaternion(&m_bodies.m_rotationAxisX[begin], &m_bodies.m_rotationAxisY[begin],
+		&m_bodies.m_rotationAxisZ[begin], angle, quat_x, quat_y, quat_z, quat_w, count);
+}
+
+void OrbitalSimulation::buildInstanceMatrices(std::vector<glm::mat4>& instances, float alpha) const
+{
+	const uint32_t NUM_BODIES = m_bodies.getCount();
+	instances.resize(NUM_BODIES);
+
+	this->runRanges(NUM_BODIES, INSTANCE_GRAIN_SIZE, [this, &instances, alpha](uint32_t begin, uint32_t end)
+	{
+		// The blended state is staged in small SoA batches on the stack, then the SIMD kernel turns each batch into
+		// matrices in one pass
+		float posX[INSTANCE_BATCH_SIZE], posY[INSTANCE_BATCH_SIZE], posZ[INSTANCE_BATCH_SIZE];
+		float quatX[INSTANCE_BATCH_SIZE], quatY[INSTANCE_BATCH_SIZE], quatZ[INSTANCE_BATCH_SIZE], quatW[INSTANCE_BATCH_SIZE];
+
+		for (uint32_t batchBegin = begin; batchBegin < end; batchBegin += INSTANCE_BATCH_SIZE)
+		{
+			const uint32_t BATCH_COUNT = std::min(INSTANCE_BATCH_SIZE, end - batchBegin);
+			this->stageInstanceBatch(batchBegin, BATCH_COUNT, alpha, posX, posY, posZ, quatX, quatY, quatZ, quatW);
+
+			TransformKernels::buildTRSMatrices(posX, posY, posZ, &m_bodies.m_scale[batchBegin], quatX, quatY, quatZ,
+				quatW, &instances[batchBegin], BATCH_COUNT);
+		}
+	});
+}
+
+void OrbitalSimulation::buildInstances(std::vector<InstanceData>& instances, float alpha) const
+{
+	const uint32_t NUM_BODIES = m_bodies.getCount();
+	instances.resize(NUM_BODIES);
+
+	this->runRanges(NUM_BODIES, INSTANCE_GRAIN_SIZE, [this, &instances, alpha](uint32_t begin, uint32_t end)
+	{
+		float posX[INSTANCE_BATCH_SIZE], posY[INSTANCE_BATCH_SIZE], posZ[INSTANCE_BATCH_SIZE];
+		float quatX[INSTANCE_BATCH_SIZE], quatY[INSTANCE_BATCH_SIZE], quatZ[INSTANCE_BATCH_SIZE], quatW[INSTANCE_BATCH_SIZE];
+
+		for (uint32_t batchBegin = begin; batchBegin < end; batchBegin += INSTANCE_BATCH_SIZE)
+		{
+			const uint32_t BATCH_COUNT = std::min(INSTANCE_BATCH_SIZE, end - batchBegin);
+			this->stageInstanceBatch(batchBegin, BATCH_COUNT, alpha, posX, posY, posZ, quatX, quatY, quatZ, quatW);
+
+			TransformKernels::packInstances(posX, posY, posZ, &m_bodies.m_scale[batchBegin], quatX, quatY, quatZ, quatW,
+				&instances[batchBegin], BATCH_COUNT);
+		}
+	});
+}
+
+BodyStore& OrbitalSimulation::getBodies()
+{
+	return m_bodies;
+}
+
+const BodyStore& OrbitalSimulation::getBodies() const
+{
+	return m_bodies;
+}
+
+std::shared_ptr<BarnesHutSolver> OrbitalSimulation::getMutualGravity() const
+{
+	return m_mutualGravity;
+}
+
+std::shared_ptr<CollisionSystem> OrbitalSimulation::getCollisions() const
+{
+	return m_collisions;
+}
+
+const Integrator& OrbitalSimulation::getIntegrator() const
+{
+	return m_integrator;
+}
+
+const glm::vec3& OrbitalSimulation::getCentralPosition() const
+{
+	return m_centralPosition;
+}
+
+float OrbitalSimulation::getCentralGM() const
+{
+	return m_centralGM;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include "Engine/Simulation/BodyStore.h"
+#include "Engine/Simulation/BarnesHutSolver.h"
+#include "Engine/Simulation/CollisionSystem.h"
+#include "Engine/Simulation/Integrator.h"
+#include "Engine/Simulation/TransformKernels.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+
+class OrbitalSimulation
+{
+private:
+	BodyStore m_bodies;
+	std::vector<float> m_previousX, m_previousY, m_previousZ, m_previousAngle; // State before the last tick, for interpolation
+
+	glm::vec3 m_centralPosition;
+	float m_centralGM; // Gravitational parameter (G * M) of the body everything orbits around
+
+	Integrator m_integrator;
+	std::shared_ptr<JobSystem> m_jobSystem;
+	std::shared_ptr<BarnesHutSolver> m_mutualGravity;
+	std::shared_ptr<CollisionSystem> m_collisions;
+private:
+	void runRanges(uint32_t count, uint32_t grain_size, const std::function<void(uint32_t, uint32_t)>& task) const; // Splits the loop across the job system, if one is set
+	void computeAccelerations(const BodyStore& bodies, float* acc_x, float* acc_y, float* acc_z) const; // Sums the central and mutual gravity of every body
+
+	// stageInstanceBatch() : Writes the blended positions and rotation quaternions of a batch of bodies into SoA arrays
+	void stageInstanceBatch(uint32_t begin, uint32_t count, float alpha, float* pos_x, float* pos_y, float* pos_z,
+		float* quat_x, float* quat_y, float* quat_z, float* quat_w) const;
+public:
+	OrbitalSimulation(const glm::vec3& central_pos, float central_gm);
+	~OrbitalSimulation();
+
+	void generateAsteroidBelt(uint32_t num_asteroids, float radius, uint64_t seed); // Fills the store with asteroids on circular orbits (same seed = same belt)
+	void setJobSystem(std::shared_ptr<JobSystem> job_system); // Sets the job system the per-body loops are split across (nullptr = serial)
+	void setMutualGravity(std::shared_ptr<BarnesHutSolver> solver); // Sets the solver for body-body gravity (nullptr disables it)
+	void setCollisions(std::shared_ptr<CollisionSystem> collisions); // Sets the system that keeps bodies from overlapping (nullptr disables it)
+	void setIntegrator(IntegratorType type); // Sets the scheme the bodies are integrated with
+	void stepTick(float delta_time); // Integrates every body in the store by the given time step
+
+	double computeEnergy() const; // Returns the kinetic plus potential energy of the bodies in the central gravity field
+	glm::vec3 computeAngularMomentum() const; // Returns the total angular momentum of the bodies around the central body
+
+	// buildInstanceMatrices() : Rebuilds the model matrix of every body, blended between the previous and current tick
+	void buildInstanceMatrices(std::vector<glm::mat4>& instances, float alpha = 1.0f) const;
+
+	// buildInstances() : Same as buildInstanceMatrices(), but writes the compact instance format the renderer draws with
+	void buildInstances(std::vector<InstanceData>& instances, float alpha = 1.0f) const;
+public:
+	BodyStore& getBodies(); // Returns the body store of the simulation
+	const BodyStore& getBodies() const; // Returns the body store of the simulation
+
+	std::shared_ptr<BarnesHutSolver> getMutualGravity() const; // Returns the solver used for body-body gravity
+	std::shared_ptr<CollisionSystem> getCollisions() const; // Returns the system used for body-body collisions
+	const Integrator& getIntegrator() const; // Returns the integrator the bodies are advanced with
+	const glm::vec3& getCentralPosition() const; // Returns the position of the central body
+	float getCentralGM() const; // Returns the gravitational parameter of the central body
+};
\ No newline at end of file
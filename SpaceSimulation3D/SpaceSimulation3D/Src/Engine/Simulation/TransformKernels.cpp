@@ -0,0 +1,289 @@
+#include "TransformKernels.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define TRANSFORM_KERNELS_X86
+	#include <immintrin.h>
+
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define TRANSFORM_KERNELS_AVX2_TARGET // MSVC allows AVX intrinsics in any function
+	#else
+		#define TRANSFORM_KERNELS_AVX2_TARGET __attribute__((target("avx2")))
+	#endif
+#endif
+
+static_assert(sizeof(InstanceData) == 24, "InstanceData has to match the vertex attribute layout of the instance buffer");
+
+namespace
+{
+	// Writes one column-major matrix from its nine rotation/scale terms and translation
+	inline void writeMatrix(float* out, float m00, float m01, float m02, float m10, float m11, float m12, float m20,
+		float m21, float m22, float pos_x, float pos_y, float pos_z)
+	{
+		out[0] = m00; out[1] = m01; out[2] = m02; out[3] = 0.0f;
+		out[4] = m10; out[5] = m11; out[6] = m12; out[7] = 0.0f;
+		out[8] = m20; out[9] = m21; out[10] = m22; out[11] = 0.0f;
+		out[12] = pos_x; out[13] = pos_y; out[14] = pos_z; out[15] = 1.0f;
+	}
+
+	void buildScalar(const float* pos_x, const float* pos_y, const float* pos_z, const float* scale,
+		const float* quat_x, const float* quat_y, const float* quat_z, const float* quat_w, glm::mat4* matrices,
+		uint32_t begin, uint32_t end)
+	{
+		for (uint32_t index = begin; index < end; index++)
+		{
+			const float X = quat_x[index], Y = quat_y[index], Z = quat_z[index], W = quat_w[index];
+			const float S = scale[index], S2 = S * 2.0f;
+
+			writeMatrix(&matrices[index][0][0],
+				S - S2 * (Y * Y + Z * Z), S2 * (X * Y + W * Z), S2 * (X * Z - W * Y),
+				S2 * (X * Y - W * Z), S - S2 * (X * X + Z * Z), S2 * (Y * Z + W * X),
+				S2 * (X * Z + W * Y), S2 * (Y * Z - W * X), S - S2 * (X * X + Y * Y),
+				pos_x[index], pos_y[index], pos_z[index]);
+		}
+	}
+
+	constexpr float QUATERNION_SCALE = 32767.0f;
+
+	void packScalar(const float* pos_x, const float* pos_y, const float* pos_z, const float* scale,
+		const float* quat_x, const float* quat_y, const float* quat_z, const float* quat_w, InstanceData* instances,
+		uint32_t begin, uint32_t end)
+	{
+		for (uint32_t index = begin; index < end; index++)
+		{
+			InstanceData& instance = instances[index];
+			instance.m_position = glm::vec3(pos_x[index], pos_y[index], pos_z[index]);
+			instance.m_scale = scale[index];
+
+			// Rounded to nearest even, like the SIMD conversion
+			instance.m_rotation[0] = static_cast<int16_t>(std::lrint(quat_x[index] * QUATERNION_SCALE));
+			instance.m_rotation[1] = static_cast<int16_t>(std::lrint(quat_y[index] * QUATERNION_SCALE));
+			instance.m_rotation[2] = static_cast<int16_t>(std::lrint(quat_z[index] * QUATERNION_SCALE));
+			instance.m_rotation[3] = static_cast<int16_t>(std::lrint(quat_w[index] * QUATERNION_SCALE));
+		}
+	}
+
+#ifdef TRANSFORM_KERNELS_X86
+	// Four bodies per iteration, each of the 12 matrix terms is computed for all of them at once and the results
+	// are transposed back into one matrix per body
+	uint32_t buildSSE(const float* pos_x, const float* pos_y, const float* pos_z, const float* scale,
+		const float* quat_x, const float* quat_y, const float* quat_z, const float* quat_w, glm::mat4* matrices,
+		uint32_t count)
+	{
+		const __m128 ZERO = _mm_setzero_ps();
+		const __m128 ONE = _mm_set1_ps(1.0f);
+
+		uint32_t index = 0;
+		for (; index + 4 <= count; index += 4)
+		{
+			const __m128 X = _mm_loadu_ps(quat_x + index), Y = _mm_loadu_ps(quat_y + index);
+			const __m128 Z = _mm_loadu_ps(quat_z + index), W = _mm_loadu_ps(quat_w + index);
+			const __m128 S = _mm_loadu_ps(scale + index);
+			const __m128 S2 = _mm_add_ps(S, S);
+
+			const __m128 XX = _mm_mul_ps(X, X), YY = _mm_mul_ps(Y, Y), ZZ = _mm_mul_ps(Z, Z);
+			const __m128 XY = _mm_mul_ps(X, Y), XZ = _mm_mul_ps(X, Z), YZ = _mm_mul_ps(Y, Z);
+			const __m128 WX = _mm_mul_ps(W, X), WY = _mm_mul_ps(W, Y), WZ = _mm_mul_ps(W, Z);
+
+			__m128 column0[4] = { _mm_sub_ps(S, _mm_mul_ps(S2, _mm_add_ps(YY, ZZ))),
+				_mm_mul_ps(S2, _mm_add_ps(XY, WZ)), _mm_mul_ps(S2, _mm_sub_ps(XZ, WY)), ZERO };
+			__m128 column1[4] = { _mm_mul_ps(S2, _mm_sub_ps(XY, WZ)),
+				_mm_sub_ps(S, _mm_mul_ps(S2, _mm_add_ps(XX, ZZ))), _mm_mul_ps(S2, _mm_add_ps(YZ, WX)), ZERO };
+			__m128 column2[4] = { _mm_mul_ps(S2, _mm_add_ps(XZ, WY)), _mm_mul_ps(S2, _mm_sub_ps(YZ, WX)),
+				_mm_sub_ps(S, _mm_mul_ps(S2, _mm_add_ps(XX, YY))), ZERO };
+			__m128 column3[4] = { _mm_loadu_ps(pos_x + index), _mm_loadu_ps(pos_y + index),
+				_mm_loadu_ps(pos_z + index), ONE };
+
+			_MM_TRANSPOSE4_PS(column0[0], column0[1], column0[2], column0[3]);
+			_MM_TRANSPOSE4_PS(column1[0], column1[1], column1[2], column1[3]);
+			_MM_TRANSPOSE4_PS(column2[0], column2[1], column2[2], column2[3]);
+			_MM_TRANSPOSE4_PS(column3[0], column3[1], column3[2], column3[3]);
+
+			for (uint32_t lane = 0; lane < 4; lane++)
+			{
+				float* out = &matrices[index + lane][0][0];
+				_mm_storeu_ps(out, column0[lane]);
+				_mm_storeu_ps(out + 4, column1[lane]);
+				_mm_storeu_ps(out + 8, column2[lane]);
+				_mm_storeu_ps(out + 12, column3[lane]);
+			}
+		}
+
+		return index;
+	}
+
+	// Transposes four 8-wide registers so each 128 bit half holds one column of a body (bodies 0-3 in the low
+	// halves, 4-7 in the high halves) and stores them
+	TRANSFORM_KERNELS_AVX2_TARGET inline void storeColumnsAVX(__m256 a, __m256 b, __m256 c, __m256 d,
+		glm::mat4* matrices, uint32_t column)
+	{
+		const __m256 T0 = _mm256_unpacklo_ps(a, b), T1 = _mm256_unpacklo_ps(c, d);
+		const __m256 T2 = _mm256_unpackhi_ps(a, b), T3 = _mm256_unpackhi_ps(c, d);
+
+		const __m256 ROWS[4] = { _mm256_shuffle_ps(T0, T1, _MM_SHUFFLE(1, 0, 1, 0)),
+			_mm256_shuffle_ps(T0, T1, _MM_SHUFFLE(3, 2, 3, 2)), _mm256_shuffle_ps(T2, T3, _MM_SHUFFLE(1, 0, 1, 0)),
+			_mm256_shuffle_ps(T2, T3, _MM_SHUFFLE(3, 2, 3, 2)) };
+
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			_mm_storeu_ps(&matrices[lane][column][0], _mm256_castps256_ps128(ROWS[lane]));
+			_mm_storeu_ps(&matrices[lane + 4][column][0], _mm256_extractf128_ps(ROWS[lane], 1));
+		}
+	}
+
+	TRANSFORM_KERNELS_AVX2_TARGET uint32_t buildAVX2(const float* pos_x, const float* pos_y, const float* pos_z,
+		const float* scale, const float* quat_x, const float* quat_y, const float* quat_z, const float* quat_w,
+		glm::mat4* matrices, uint32_t count)
+	{
+		const __m256 ZERO = _mm256_setzero_ps();
+		const __m256 ONE = _mm256_set1_ps(1.0f);
+
+		uint32_t index = 0;
+		for (; index + 8 <= count; index += 8)
+		{
+			const __m256 X = _mm256_loadu_ps(quat_x + index), Y = _mm256_loadu_ps(quat_y + index);
+			const __m256 Z = _mm256_loadu_ps(quat_z + index), W = _mm256_loadu_ps(quat_w + index);
+			const __m256 S = _mm256_loadu_ps(scale + index);
+			const __m256 S2 = _mm256_add_ps(S, S);
+
+			const __m256 XX = _mm256_mul_ps(X, X), YY = _mm256_mul_ps(Y, Y), ZZ = _mm256_mul_ps(Z, Z);
+			const __m256 XY = _mm256_mul_ps(X, Y), XZ = _mm256_mul_ps(X, Z), YZ = _mm256_mul_ps(Y, Z);
+			const __m256 WX = _mm256_mul_ps(W, X), WY = _mm256_mul_ps(W, Y), WZ = _mm256_mul_ps(W, Z);
+
+			storeColumnsAVX(_mm256_sub_ps(S, _mm256_mul_ps(S2, _mm256_add_ps(YY, ZZ))),
+				_mm256_mul_ps(S2, _mm256_add_ps(XY, WZ)), _mm256_mul_ps(S2, _mm256_sub_ps(XZ, WY)), ZERO,
+				matrices + index, 0);
+			storeColumnsAVX(_mm256_mul_ps(S2, _mm256_sub_ps(XY, WZ)),
+				_mm256_sub_ps(S, _mm256_mul_ps(S2, _mm256_add_ps(XX, ZZ))), _mm256_mul_ps(S2, _mm256_add_ps(YZ, WX)),
+				ZERO, matrices + index, 1);
+			storeColumnsAVX(_mm256_mul_ps(S2, _mm256_add_ps(XZ, WY)), _mm256_mul_ps(S2, _mm256_sub_ps(YZ, WX)),
+				_mm256_sub_ps(S, _mm256_mul_ps(S2, _mm256_add_ps(XX, YY))), ZERO, matrices + index, 2);
+			storeColumnsAVX(_mm256_loadu_ps(pos_x + index), _mm256_loadu_ps(pos_y + index),
+				_mm256_loadu_ps(pos_z + index), ONE, matrices + index, 3);
+		}
+
+		return index;
+	}
+
+	bool detectAVX2()
+	{
+	#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		const bool OS_SAVES_AVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+
+		__cpuidex(info, 7, 0);
+		return OS_SAVES_AVX && (info[1] & (1 << 5));
+	#else
+		return __builtin_cpu_supports("avx2");
+	#endif
+	}
+
+	// Four bodies per iteration, transposing the SoA batches into one position/scale and one quaternion per body
+	uint32_t packSSE(const float* pos_x, const float* pos_y, const float* pos_z, const float* scale,
+		const float* quat_x, const float* quat_y, const float* quat_z, const float* quat_w, InstanceData* instances,
+		uint32_t count)
+	{
+		const __m128 QUAT_SCALE = _mm_set1_ps(QUATERNION_SCALE);
+
+		uint32_t index = 0;
+		for (; index + 4 <= count; index += 4)
+		{
+			__m128 posScale0 = _mm_loadu_ps(pos_x + index), posScale1 = _mm_loadu_ps(pos_y + index);
+			__m128 posScale2 = _mm_loadu_ps(pos_z + index), posScale3 = _mm_loadu_ps(scale + index);
+			_MM_TRANSPOSE4_PS(posScale0, posScale1, posScale2, posScale3);
+
+			__m128 quat0 = _mm_loadu_ps(quat_x + index), quat1 = _mm_loadu_ps(quat_y + index);
+			__m128 quat2 = _mm_loadu_ps(quat_z + index), quat3 = _mm_loadu_ps(quat_w + index);
+			_MM_TRANSPOSE4_PS(quat0, quat1, quat2, quat3);
+
+			// Packing saturates, and a unit quaternion never goes past the scale anyway
+			const __m128i PACKED01 = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(quat0, QUAT_SCALE)),
+				_mm_cvtps_epi32(_mm_mul_ps(quat1, QUAT_SCALE)));
+			const __m128i PACKED23 = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(quat2, QUAT_SCALE)),
+				_mm_cvtps_epi32(_mm_mul_ps(quat3, QUAT_SCALE)));
+
+			InstanceData* out = instances + index;
+			_mm_storeu_ps(&out[0].m_position.x, posScale0);
+			_mm_storeu_ps(&out[1].m_position.x, posScale1);
+			_mm_storeu_ps(&out[2].m_position.x, posScale2);
+			_mm_storeu_ps(&out[3].m_position.x, posScale3);
+
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out[0].m_rotation), PACKED01);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out[1].m_rotation), _mm_unpackhi_epi64(PACKED01, PACKED01));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out[2].m_rotation), PACKED23);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out[3].m_rotation), _mm_unpackhi_epi64(PACKED23, PACKED23));
+		}
+
+		return index;
+	}
+#endif
+}
+
+namespace TransformKernels
+{
+	void axisAngleToQuaternion(const float* axis_x, const float* axis_y, const float* axis_z, const float* angle,
+		float* quat_x, float* quat_y, float* quat_z, float* quat_w, uint32_t count)
+	{
+		for (uint32_t index = 0; index < count; index++)
+		{
+			const float HALF_ANGLE = angle[index] * 0.5f;
+			const float SIN = std::sin(HALF_ANGLE);
+
+			quat_x[index] = axis_x[index] * SIN;
+			quat_y[index] = axis_y[index] * SIN;
+			quat_z[index] = axis_z[index] * SIN;
+			quat_w[index] = std::cos(HALF_ANGLE);
+		}
+	}
+
+	void buildTRSMatrices(const float* pos_x, const float* pos_y, const float* pos_z, const float* scale,
+		const float* quat_x, const float* quat_y, const float* quat_z, const float* quat_w, glm::mat4* matrices,
+		uint32_t count)
+	{
+		static const KernelPath BEST_PATH = getBestKernelPath();
+		buildTRSMatricesWith(BEST_PATH, pos_x, pos_y, pos_z, scale, quat_x, quat_y, quat_z, quat_w, matrices, count);
+	}
+
+	void buildTRSMatricesWith(KernelPath path, const float* pos_x, const float* pos_y, const float* pos_z,
+		const float* scale, const float* quat_x, const float* quat_y, const float* quat_z, const float* quat_w,
+		glm::mat4* matrices, uint32_t count)
+	{
+		uint32_t processed = 0;
+
+	#ifdef TRANSFORM_KERNELS_X86
+		if (path == KernelPath::AVX2 && getBestKernelPath() == KernelPath::AVX2)
+			processed = buildAVX2(pos_x, pos_y, pos_z, scale, quat_x, quat_y, quat_z, quat_w, matrices, count);
+		else if (path != KernelPath::SCALAR)
+			processed = buildSSE(pos_x, pos_y, pos_z, scale, quat_x, quat_y, quat_z, quat_w, matrices, count);
+	#endif
+
+		// Whatever didn't fill a whole SIMD batch is finished off one by one
+		buildScalar(pos_x, pos_y, pos_z, scale, quat_x, quat_y, quat_z, quat_w, matrices, processed, count);
+	}
+
+	void packInstances(const float* pos_x, const float* pos_y, const float* pos_z, const float* scale,
+		const float* quat_x, const float* quat_y, const float* quat_z, const float* quat_w, InstanceData* instances,
+		uint32_t count)
+	{
+		uint32_t processed = 0;
+
+	#ifdef TRANSFORM_KERNELS_X86
+		processed = packSSE(pos_x, pos_y, pos_z, scale, quat_x, quat_y, quat_z, quat_w, instances, count);
+	#endif
+
+		packScalar(pos_x, pos_y, pos_z, scale, quat_x, quat_y, quat_z, quat_w, instances, processed, count);
+	}
+
+	KernelPath getBestKernelPath()
+	{
+	#ifdef TRANSFORM_KERNELS_X86
+		static const bool HAS_AVX2 = detectAVX2();
+		return HAS_AVX2 ? KernelPath::AVX2 : KernelPath::SSE;
+	#else
+		return KernelPath::SCALAR;
+	#endif
+	}
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+
+// Compact per-instance transform, translate(position) * scale(uniform scale) * rotate(quaternion), in 24 bytes instead
+// of a 64 byte matrix. With a uniform scale the normals only need the rotation, so no inverse is needed to draw it
+struct InstanceData
+{
+	glm::vec3 m_position;
+	float m_scale;
+	int16_t m_rotation[4]; // Unit quaternion (x, y, z, w) as normalized shorts, value * 32767
+};
+
+enum class KernelPath
+{
+	SCALAR,
+	SSE,
+	AVX2
+};
+
+namespace TransformKernels
+{
+	// axisAngleToQuaternion() : Converts unit rotation axes and angles (in radians) into unit quaternions
+	void axisAngleToQuaternion(const float* axis_x, const float* axis_y, const float* axis_z, const float* angle,
+		float* quat_x, float* quat_y, float* quat_z, float* quat_w, uint32_t count);
+
+	// buildTRSMatrices() : Writes translate(pos) * scale(uniform scale) * rotate(quat) as column-major matrices,
+	// matching the result of the equivalent glm::translate -> glm::scale -> glm::rotate chain
+	void buildTRSMatrices(const float* pos_x, const float* pos_y, const float* pos_z, const float* scale,
+		const float* quat_x, const float* quat_y, const float* quat_z, const float* quat_w, glm::mat4* matrices,
+		uint32_t count);
+
+	// buildTRSMatricesWith() : Same as buildTRSMatrices(), but forces the given code path (falls back if unsupported)
+	void buildTRSMatricesWith(KernelPath path, const float* pos_x, const float* pos_y, const float* pos_z,
+		const float* scale, const float* quat_x, const float* quat_y, const float* quat_z, const float* quat_w,
+		glm::mat4* matrices, uint32_t count);
+
+	// packInstances() : Writes the same transforms as buildTRSMatrices() in the compact instance format
+	void packInstances(const float* pos_x, const float* pos_y, const float* pos_z, const float* scale,
+		const float* quat_x, const float* quat_y, const float* quat_z, const float* quat_w, InstanceData* instances,
+		uint32_t count);
+
+	KernelPath getBestKernelPath(); // Returns the widest code path the CPU supports
+}
\ No newline at end of file
@@ -0,0 +1,360 @@
+#include "GLStateCache.h"
+#include "Engine/Utils/LoggingManager.h"
+
+namespace
+{
+	constexpr uint32_t UNKNOWN = 0xFFFFFFFF; // State that has to be issued next time, whatever value it is set to
+	constexpr uint32_t MAX_TEXTURE_UNITS = 16; // GL 3.3 guarantees 16 units per shader stage
+	constexpr uint32_t MAX_UNIFORM_BINDINGS = 16;
+	constexpr uint32_t NUM_BUFFER_TARGETS = 4;
+	constexpr uint32_t NUM_TEXTURE_TARGETS = 4;
+
+	struct BufferRange
+	{
+		uint32_t m_buffer = UNKNOWN;
+		GLintptr m_offset = 0;
+		GLsizeiptr m_size = 0;
+	};
+
+	struct TrackedState
+	{
+		uint32_t m_program = UNKNOWN, m_vao = UNKNOWN, m_framebuffer = UNKNOWN;
+		uint32_t m_buffers[NUM_BUFFER_TARGETS] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+		BufferRange m_uniformRanges[MAX_UNIFORM_BINDINGS];
+
+		uint32_t m_activeUnit = UNKNOWN;
+		uint32_t m_textures[MAX_TEXTURE_UNITS][NUM_TEXTURE_TARGETS];
+
+		uint32_t m_depthTest = UNKNOWN; // 0 or 1 once known
+		GLenum m_depthFunc = UNKNOWN;
+
+		TrackedState()
+		{
+			for (auto& unit : m_textures)
+			{
+				for (uint32_t& texture : unit)
+					texture = UNKNOWN;
+			}
+		}
+	};
+
+	TrackedState state;
+	GLStateCounters frameCounters, lastFrameCounters;
+
+	// Returns where the binding of the buffer target is tracked, or -1 if it isn't
+	int getBufferSlot(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_ARRAY_BUFFER:
+			return 0;
+		case GL_ELEMENT_ARRAY_BUFFER:
+			return 1;
+		case GL_UNIFORM_BUFFER:
+			return 2;
+		case GL_TEXTURE_BUFFER:
+			return 3;
+		default:
+			return -1;
+		}
+	}
+
+	// Returns where the binding of the texture target is tracked, or -1 if it isn't
+	int getTextureSlot(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_TEXTURE_2D:
+			return 0;
+		case GL_TEXTURE_CUBE_MAP:
+			return 1;
+		case GL_TEXTURE_2D_MULTISAMPLE:
+			return 2;
+		case GL_TEXTURE_BUFFER:
+			return 3;
+		default:
+			return -1;
+		}
+	}
+
+	// Updates the tracked value and returns whether the change needs to be issued
+	bool changeState(uint32_t& tracked, uint32_t value)
+	{
+		if (tracked == value)
+		{
+			frameCounters.m_skipped++;
+			return false;
+		}
+
+		tracked = value;
+		frameCounters.m_issued++;
+		return true;
+	}
+
+	void setActiveUnit(uint32_t unit)
+	{
+		if (changeState(state.m_activeUnit, unit))
+			glActiveTexture(GL_TEXTURE0 + unit);
+	}
+
+#ifdef _DEBUG
+	// Warns if the tracked value is known and doesn't match the context, returning whether it matched
+	bool checkState(const char* name, uint32_t tracked, GLint actual)
+	{
+		if (tracked == UNKNOWN || tracked == static_cast<uint32_t>(actual))
+			return true;
+
+		OutputLog(std::string("GL state cache is out of step with the context: ") + name + " is " +
+			std::to_string(actual) + ", expected " + std::to_string(tracked), Logging::Severity::WARNING);
+		return false;
+	}
+
+	GLenum getTextureBindingQuery(uint32_t slot)
+	{
+		switch (slot)
+		{
+		case 0:
+			return GL_TEXTURE_BINDING_2D;
+		case 1:
+			return GL_TEXTURE_BINDING_CUBE_MAP;
+		case 2:
+			return GL_TEXTURE_BINDING_2D_MULTISAMPLE;
+		default:
+			return GL_TEXTURE_BINDING_BUFFER;
+		}
+	}
+#endif
+}
+
+void GLState::useProgram(uint32_t program)
+{
+	if (changeState(state.m_program, program))
+		glUseProgram(program);
+}
+
+void GLState::bindVertexArray(uint32_t vao)
+{
+	if (changeState(state.m_vao, vao))
+	{
+		glBindVertexArray(vao);
+
+		// The ibo binding is part of the vao, and only the vao knows what it is
+		state.m_buffers[getBufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+	}
+}
+
+void GLState::bindBuffer(GLenum target, uint32_t buffer)
+{
+	const int SLOT = getBufferSlot(target);
+	if (SLOT < 0)
+	{
+		frameCounters.m_issued++;
+		glBindBuffer(target, buffer);
+	}
+	else if (changeState(state.m_buffers[SLOT], buffer))
+		glBindBuffer(target, buffer);
+}
+
+void GLState::bindBufferRange(GLenum target, uint32_t index, uint32_t buffer, GLintptr offset, GLsizeiptr size)
+{
+	if (target == GL_UNIFORM_BUFFER && index < MAX_UNIFORM_BINDINGS)
+	{
+		BufferRange& range = state.m_uniformRanges[index];
+		if (range.m_buffer == buffer && range.m_offset == offset && range.m_size == size)
+		{
+			frameCounters.m_skipped++;
+			return;
+		}
+
+		range.m_buffer = buffer;
+		range.m_offset = offset;
+		range.m_size = size;
+	}
+
+	// Binding a range also binds the buffer to the generic binding point of the target, but only once it was issued
+	const int SLOT = getBufferSlot(target);
+	if (SLOT >= 0)
+		state.m_buffers[SLOT] = buffer;
+
+	frameCounters.m_issued++;
+	glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void GLState::bindTexture(uint32_t unit, GLenum target, uint32_t texture)
+{
+	const int SLOT = getTextureSlot(target);
+	if (SLOT < 0 || unit >= MAX_TEXTURE_UNITS)
+	{
+		frameCounters.m_issued += 2;
+		state.m_activeUnit = unit;
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, texture);
+		return;
+	}
+
+	// The active unit only needs switching when the binding itself changes
+	if (state.m_textures[unit][SLOT] == texture)
+	{
+		frameCounters.m_skipped++;
+		return;
+	}
+
+	setActiveUnit(unit);
+	changeState(state.m_textures[unit][SLOT], texture);
+	glBindTexture(target, texture);
+}
+
+void GLState::bindFramebuffer(uint32_t framebuffer)
+{
+	if (changeState(state.m_framebuffer, framebuffer))
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GLState::setDepthTest(bool enabled)
+{
+	if (!changeState(state.m_depthTest, enabled ? 1 : 0))
+		return;
+
+	if (enabled)
+		glEnable(GL_DEPTH_TEST);
+	else
+		glDisable(GL_DEPTH_TEST);
+}
+
+void GLState::setDepthFunc(GLenum func)
+{
+	if (changeState(state.m_depthFunc, func))
+		glDepthFunc(func);
+}
+
+void GLState::onProgramDeleted(uint32_t program)
+{
+	// A deleted program stays current until another one is used, so just make sure the next use gets issued
+	if (state.m_program == program)
+		state.m_program = UNKNOWN;
+}
+
+void GLState::onVertexArrayDeleted(uint32_t vao)
+{
+	if (state.m_vao == vao)
+	{
+		state.m_vao = 0;
+		state.m_buffers[getBufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+	}
+}
+
+void GLState::onBufferDeleted(uint32_t buffer)
+{
+	for (uint32_t& binding : state.m_buffers)
+	{
+		if (binding == buffer)
+			binding = 0;
+	}
+
+	for (BufferRange& range : state.m_uniformRanges)
+	{
+		if (range.m_buffer == buffer)
+			range.m_buffer = UNKNOWN;
+	}
+
+	// An ibo is only unbound from the vao that is bound right now, so who knows what the others hold
+	state.m_buffers[getBufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+}
+
+void GLState::onTextureDeleted(uint32_t texture)
+{
+	for (auto& unit : state.m_textures)
+	{
+		for (uint32_t& binding : unit)
+		{
+			if (binding == texture)
+				binding = 0;
+		}
+	}
+}
+
+void GLState::onFramebufferDeleted(uint32_t framebuffer)
+{
+	if (state.m_framebuffer == framebuffer)
+		state.m_framebuffer = 0;
+}
+
+void GLState::countCall(bool issued)
+{
+	if (issued)
+		frameCounters.m_issued++;
+	else
+		frameCounters.m_skipped++;
+}
+
+void GLState::invalidate()
+{
+	state = TrackedState();
+}
+
+void GLState::validate()
+{
+#ifdef _DEBUG
+	GLint actual = 0;
+	bool inStep = true;
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &actual);
+	inStep &= checkState("the current program", state.m_program, actual);
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &actual);
+	inStep &= checkState("the bound vao", state.m_vao, actual);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &actual);
+	inStep &= checkState("the bound fbo", state.m_framebuffer, actual);
+
+	glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &actual);
+	inStep &= checkState("the GL_ARRAY_BUFFER binding", state.m_buffers[0], actual);
+	glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &actual);
+	inStep &= checkState("the GL_ELEMENT_ARRAY_BUFFER binding", state.m_buffers[1], actual);
+	glGetIntegerv(GL_UNIFORM_BUFFER_BINDING, &actual);
+	inStep &= checkState("the GL_UNIFORM_BUFFER binding", state.m_buffers[2], actual);
+	glGetIntegerv(GL_TEXTURE_BUFFER_BINDING, &actual);
+	inStep &= checkState("the GL_TEXTURE_BUFFER binding", state.m_buffers[3], actual);
+
+	for (uint32_t index = 0; index < MAX_UNIFORM_BINDINGS; index++)
+	{
+		glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, index, &actual);
+		inStep &= checkState("a uniform buffer binding point", state.m_uniformRanges[index].m_buffer, actual);
+	}
+
+	actual = glIsEnabled(GL_DEPTH_TEST) ? 1 : 0;
+	inStep &= checkState("the depth test", state.m_depthTest, actual);
+	glGetIntegerv(GL_DEPTH_FUNC, &actual);
+	inStep &= checkState("the depth function", state.m_depthFunc, actual);
+
+	// Texture bindings can only be read from the active unit, so walk the units and put the active one back after
+	GLint activeUnit = 0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeUnit);
+	inStep &= checkState("the active texture unit", state.m_activeUnit, activeUnit - GL_TEXTURE0);
+
+	for (uint32_t unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		for (uint32_t slot = 0; slot < NUM_TEXTURE_TARGETS; slot++)
+		{
+			glGetIntegerv(getTextureBindingQuery(slot), &actual);
+			inStep &= checkState("a texture binding", state.m_textures[unit][slot], actual);
+		}
+	}
+
+	glActiveTexture(activeUnit);
+
+	// Start over from a clean slate rather than repeating the same warnings every frame
+	if (!inStep)
+		GLState::invalidate();
+#endif
+}
+
+void GLState::beginFrame()
+{
+	lastFrameCounters = frameCounters;
+	frameCounters = GLStateCounters();
+}
+
+const GLStateCounters& GLState::getFrameCounters()
+{
+	return lastFrameCounters;
+}
\ No newline at end of file
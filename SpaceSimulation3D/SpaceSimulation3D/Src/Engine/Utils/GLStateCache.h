@@ -0,0 +1,42 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+
+struct GLStateCounters
+{
+	uint32_t m_issued = 0; // State changes that reached the driver
+	uint32_t m_skipped = 0; // State changes dropped because the state was already set
+};
+
+// Tracks the GL state the renderer changes, so setting something that is already set never reaches the driver.
+// All bind calls on the render thread have to go through here, else the cache falls out of step with the context
+// (debug builds check for that every frame). Anything made current behind its back needs an invalidate() call
+namespace GLState
+{
+	void useProgram(uint32_t program); // Makes the program current
+	void bindVertexArray(uint32_t vao); // Binds the vao (the bound ibo goes along with it)
+
+	// bindBuffer() : Binds the buffer to the target. Binding to GL_ELEMENT_ARRAY_BUFFER changes the bound vao, so
+	// callers that aren't setting up a vao should bind vao 0 first
+	void bindBuffer(GLenum target, uint32_t buffer);
+	void bindBufferRange(GLenum target, uint32_t index, uint32_t buffer, GLintptr offset, GLsizeiptr size); // Binds a range of the buffer to an indexed binding point
+	void bindTexture(uint32_t unit, GLenum target, uint32_t texture); // Binds the texture to the texture unit
+	void bindFramebuffer(uint32_t framebuffer); // Binds the fbo for both drawing and reading
+
+	void setDepthTest(bool enabled); // Enables or disables depth testing
+	void setDepthFunc(GLenum func); // Sets the depth comparison function
+
+	// Deleted objects get unbound by GL, and their names can be handed out again, so the cache has to forget them
+	void onProgramDeleted(uint32_t program);
+	void onVertexArrayDeleted(uint32_t vao);
+	void onBufferDeleted(uint32_t buffer);
+	void onTextureDeleted(uint32_t texture);
+	void onFramebufferDeleted(uint32_t framebuffer);
+
+	void countCall(bool issued); // Counts a state change made outside of the cache (e.g. a cached uniform)
+	void invalidate(); // Forgets all tracked state, so the next change of anything gets issued
+	void validate(); // Compares the tracked state against the context and warns on mismatches (debug builds only)
+
+	void beginFrame(); // Starts counting the state changes of a new frame
+	const GLStateCounters& getFrameCounters(); // Returns the counters of the last finished frame
+}
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Identifies which job system (and which of its queues) belongs to the current thread
+	thread_local const JobSystem* localJobSystem = nullptr;
+	thread_local uint32_t localQueueIndex = 0;
+}
+
+JobSystem::JobSystem(uint32_t num_threads) :
+	m_queuedJobs(0), m_nextQueue(0), m_running(true)
+{
+	const uint32_t NUM_THREADS = num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+
+	for (uint32_t index = 0; index < NUM_THREADS; index++)
+		m_queues.emplace_back(std::make_unique<WorkQueue>());
+
+	// The constructing thread owns queue 0 and joins in whenever it waits on a job
+	localJobSystem = this;
+	localQueueIndex = 0;
+
+	for (uint32_t index = 1; index < NUM_THREADS; index++)
+		m_workers.emplace_back(&JobSystem::workerLoop, this, index);
+}
+
+JobSystem::~JobSystem()
+{
+	m_running = false;
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wakeCondition.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+
+	if (localJobSystem == this)
+		localJobSystem = nullptr;
+}
+
+void JobSystem::workerLoop(uint32_t queue_index)
+{
+	localJobSystem = this;
+	localQueueIndex = queue_index;
+
+	while (m_running)
+	{
+		if (!this->tryRunJob(queue_index))
+		{
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_wakeCondition.wait(lock, [this]() { return m_queuedJobs > 0 || !m_running; });
+		}
+	}
+}
+
+uint32_t JobSystem::getLocalQueue()
+{
+	if (localJobSystem == this)
+		return localQueueIndex;
+
+	return m_nextQueue++ % static_cast<uint32_t>(m_queues.size());
+}
+
+void JobSystem::pushJob(Job&& job)
+{
+	WorkQueue& queue = *m_queues[this->getLocalQueue()];
+	{
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+		queue.m_jobs.emplace_back(std::move(job));
+
+		// Counted before the queue is unlocked, so no worker can take the job (and count it off) before it was counted
+		m_queuedJobs++;
+	}
+
+	{
+		// Taking the lock makes sure a worker can't miss the wake up between checking the counter and sleeping
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wakeCondition.notify_one();
+}
+
+bool JobSystem::tryRunJob(uint32_t queue_index)
+{
+	Job job;
+	bool found = false;
+
+	// Newest work from our own queue first, it is the most likely to still be in cache
+	{
+		WorkQueue& queue = *m_queues[queue_index];
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+		if (!queue.m_jobs.empty())
+		{
+			job = std::move(queue.m_jobs.back());
+			queue.m_jobs.pop_back();
+			found = true;
+		}
+	}
+
+	// Otherwise steal the oldest job from one of the other queues
+	const uint32_t NUM_QUEUES = static_cast<uint32_t>(m_queues.size());
+	for (uint32_t offset = 1; !found && offset < NUM_QUEUES; offset++)
+	{
+		WorkQueue& queue = *m_queues[(queue_index + offset) % NUM_QUEUES];
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+		if (!queue.m_jobs.empty())
+		{
+			job = std::move(queue.m_jobs.front());
+			queue.m_jobs.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+		return false;
+
+	m_queuedJobs--;
+	job.m_task();
+	this->finishJob(job.m_counter);
+
+	return true;
+}
+
+void JobSystem::finishJob(const JobHandle& counter)
+{
+	if (counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	// Last job of the counter finished, release everything that was waiting on it
+	std::vector<std::shared_ptr<PendingJob>> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter->m_mutex);
+		counter->m_completed = true;
+		continuations.swap(counter->m_continuations);
+	}
+
+	for (auto& continuation : continuations)
+		this->releaseDependency(continuation);
+}
+
+void JobSystem::addContinuation(const JobHandle& dependency, std::shared_ptr<PendingJob> pending_job)
+{
+	{
+		std::lock_guard<std::mutex> lock(dependency->m_mutex);
+		if (!dependency->m_completed)
+		{
+			dependency->m_continuations.emplace_back(pending_job);
+			return;
+		}
+	}
+
+	this->releaseDependency(pending_job);
+}
+
+void JobSystem::releaseDependency(std::shared_ptr<PendingJob> pending_job)
+{
+	if (pending_job->m_remainingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		this->pushJob(std::move(pending_job->m_job));
+}
+
+JobHandle JobSystem::schedule(std::function<void()> task, const std::vector<JobHandle>& dependencies)
+{
+	auto counter = std::make_shared<JobCounter>(1);
+
+	if (dependencies.empty())
+	{
+		this->pushJob({ std::move(task), counter });
+		return counter;
+	}
+
+	// One extra dependency is held while registering, so the job can't be queued before every dependency is added
+	auto pendingJob = std::make_shared<PendingJob>();
+	pendingJob->m_job = { std::move(task), counter };
+	pendingJob->m_remainingDependencies = static_cast<uint32_t>(dependencies.size()) + 1;
+
+	for (const auto& dependency : dependencies)
+	{
+		if (dependency)
+			this->addContinuation(dependency, pendingJob);
+		else
+			this->releaseDependency(pendingJob);
+	}
+
+	this->releaseDependency(pendingJob);
+	return counter;
+}
+
+JobHandle JobSystem::parallelForAsync(uint32_t begin, uint32_t end, uint32_t grain_size,
+	std::function<void(uint32_t, uint32_t)> task, const std::vector<JobHandle>& dependencies)
+{
+	const uint32_t GRAIN = std::max(1u, grain_size);
+	const uint32_t NUM_RANGES = end > begin ? (end - begin + GRAIN - 1) / GRAIN : 0;
+
+	// Every range shares one counter, so the returned handle completes once the whole loop has run
+	auto counter = std::make_shared<JobCounter>(std::max(1u, NUM_RANGES));
+	auto sharedTask = std::make_shared<std::function<void(uint32_t, uint32_t)>>(std::move(task));
+
+	auto launchRanges = [this, begin, end, GRAIN, NUM_RANGES, counter, sharedTask]()
+	{
+		if (NUM_RANGES == 0)
+		{
+			this->finishJob(counter);
+			return;
+		}
+
+		for (uint32_t range = 0; range < NUM_RANGES; range++)
+		{
+			const uint32_t RANGE_BEGIN = begin + range * GRAIN;
+			const uint32_t RANGE_END = std::min(end, RANGE_BEGIN + GRAIN);
+			this->pushJob({ [sharedTask, RANGE_BEGIN, RANGE_END]() { (*sharedTask)(RANGE_BEGIN, RANGE_END); }, counter });
+		}
+	};
+
+	if (dependencies.empty())
+		launchRanges();
+	else
+		this->schedule(launchRanges, dependencies);
+
+	return counter;
+}
+
+void JobSystem::parallelFor(uint32_t begin, uint32_t end, uint32_t grain_size,
+	std::function<void(uint32_t, uint32_t)> task)
+{
+	// Not worth going through the queues if there is only one range (or nobody to share it with)
+	if (m_workers.empty() || end <= begin + std::max(1u, grain_size))
+	{
+		if (end > begin)
+			task(begin, end);
+
+		return;
+	}
+
+	this->wait(this->parallelForAsync(begin, end, grain_size, std::move(task)));
+}
+
+void JobSystem::wait(const JobHandle& handle)
+{
+	const uint32_t QUEUE_INDEX = this->getLocalQueue();
+
+	while (!handle->isComplete())
+	{
+		if (!this->tryRunJob(QUEUE_INDEX))
+			std::this_thread::yield();
+	}
+}
+
+uint32_t JobSystem::getThreadCount() const
+{
+	return static_cast<uint32_t>(m_queues.size());
+}
\ No newline at end of file
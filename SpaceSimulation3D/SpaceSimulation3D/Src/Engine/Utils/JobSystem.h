@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef unsigned int uint32_t;
+
+struct PendingJob;
+
+// Tracks completion of a scheduled job (or group of jobs) and the continuations waiting on it
+struct JobCounter
+{
+	std::atomic<uint32_t> m_pending;
+
+	std::mutex m_mutex;
+	bool m_completed = false;
+	std::vector<std::shared_ptr<PendingJob>> m_continuations;
+
+	JobCounter(uint32_t num_jobs) : m_pending(num_jobs) {}
+	bool isComplete() const { return m_pending.load(std::memory_order_acquire) == 0; }
+};
+
+typedef std::shared_ptr<JobCounter> JobHandle;
+
+struct Job
+{
+	std::function<void()> m_task;
+	JobHandle m_counter;
+};
+
+// A job waiting for its dependencies to finish before it gets queued
+struct PendingJob
+{
+	Job m_job;
+	std::atomic<uint32_t> m_remainingDependencies;
+};
+
+class JobSystem
+{
+private:
+	// Each thread owns a deque, it pushes and pops work at the back while idle threads steal from the front
+	struct WorkQueue
+	{
+		std::mutex m_mutex;
+		std::deque<Job> m_jobs;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue>> m_queues;
+	std::vector<std::thread> m_workers;
+
+	std::atomic<uint32_t> m_queuedJobs;
+	std::atomic<uint32_t> m_nextQueue;
+	std::atomic<bool> m_running;
+
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+private:
+	void workerLoop(uint32_t queue_index); // Runs queued jobs until the job system shuts down
+	uint32_t getLocalQueue(); // Returns the queue owned by the calling thread (or a round robin one for foreign threads)
+
+	void pushJob(Job&& job); // Queues the job on the calling thread's deque and wakes a sleeping worker
+	bool tryRunJob(uint32_t queue_index); // Runs one job from the given queue, or one stolen from another queue
+	void finishJob(const JobHandle& counter); // Signals the job's counter and releases continuations that became ready
+
+	void addContinuation(const JobHandle& dependency, std::shared_ptr<PendingJob> pending_job); // Defers the job until the dependency completes
+	void releaseDependency(std::shared_ptr<PendingJob> pending_job); // Queues the job once its last dependency is released
+public:
+	JobSystem(uint32_t num_threads = 0); // The calling thread counts as one of the threads (0 = one per core)
+	~JobSystem();
+
+	// schedule() : Queues a task that runs once every given dependency has completed
+	JobHandle schedule(std::function<void()> task, const std::vector<JobHandle>& dependencies = {});
+
+	// parallelForAsync() : Splits [begin, end) into ranges of grain_size and runs them across the threads without waiting
+	JobHandle parallelForAsync(uint32_t begin, uint32_t end, uint32_t grain_size,
+		std::function<void(uint32_t, uint32_t)> task, const std::vector<JobHandle>& dependencies = {});
+
+	// parallelFor() : Same as parallelForAsync(), but the calling thread helps out and returns once every range is done
+	void parallelFor(uint32_t begin, uint32_t end, uint32_t grain_size, std::function<void(uint32_t, uint32_t)> task);
+
+	void wait(const JobHandle& handle); // Runs queued jobs on the calling thread until the handle completes
+public:
+	uint32_t getThreadCount() const; // Returns the number of threads, including the one that owns the job system
+};
\ No newline at end of file
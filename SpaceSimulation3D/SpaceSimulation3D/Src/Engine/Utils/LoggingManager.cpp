@@ -1,7 +1,11 @@
 #include "LoggingManager.h"
 
+#ifndef HEADLESS_ONLY
 #include <glad/glad.h>
+#endif
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -11,6 +15,7 @@ namespace Logging
 {
 	void CheckGLError(const char* file, int line)
 	{
+	#ifndef HEADLESS_ONLY
 		std::stringstream info_stream;
 		info_stream << " [" << file << " (";
 		info_stream << line << ")]";
@@ -33,11 +38,12 @@ namespace Logging
 				break;
 			}
 		}
+	#endif
 	}
 
 	void HandleLogOutput(const std::string& log_msg, Severity severity_level)
 	{
-	#ifdef _DEBUG
+	#if defined(_DEBUG) && defined(_WIN32)
 		HANDLE console_handle = GetStdHandle(STD_OUTPUT_HANDLE);
 		switch (severity_level)
 		{
@@ -55,7 +61,7 @@ namespace Logging
 			assert(false);
 			break;
 		}
-	#else
+	#elif defined(_WIN32)
 		static bool cleared = false;
 		std::ofstream log_file;
 
@@ -79,6 +85,20 @@ namespace Logging
 			log_file << "Notification: " << log_msg << std::endl;
 			break;
 		}
+	#else
+		// Other platforms are only used for headless runs and benchmarks, so the log goes straight to the terminal
+		switch (severity_level)
+		{
+		case Severity::NOTIFICATION:
+			std::cout << "Notification: " << log_msg << std::endl;
+			break;
+		case Severity::WARNING:
+			std::cerr << "Warning: " << log_msg << std::endl;
+			break;
+		case Severity::FATAL:
+			std::cerr << "Fatal: " << log_msg << std::endl;
+			break;
+		}
 	#endif
 	}
 }
\ No newline at end of file
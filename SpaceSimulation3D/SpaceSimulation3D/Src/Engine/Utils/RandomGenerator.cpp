@@ -2,10 +2,74 @@
 
 #include <random>
 #include <ctime>
+#include <chrono>
 
 namespace
 {
 	std::mt19937 randEngine(static_cast<uint32_t>(time(0)));
+
+	constexpr uint32_t PHILOX_M0 = 0xD2511F53, PHILOX_M1 = 0xCD9E8D57;
+	constexpr uint32_t PHILOX_W0 = 0x9E3779B9, PHILOX_W1 = 0xBB67AE85; // Key schedule increments
+	constexpr uint32_t PHILOX_ROUNDS = 10;
+
+	struct PhiloxBlock
+	{
+		uint32_t m_values[4];
+	};
+
+	// Encrypts the 128 bit counter (index, stream) with the seed as the key, every output bit depends on every input bit
+	PhiloxBlock philox(uint64_t seed, uint32_t stream, uint64_t block_index)
+	{
+		uint32_t counter[4] { static_cast<uint32_t>(block_index), static_cast<uint32_t>(block_index >> 32), stream, 0 };
+		uint32_t key[2] { static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) };
+
+		for (uint32_t round = 0; round < PHILOX_ROUNDS; round++)
+		{
+			const uint64_t PRODUCT0 = static_cast<uint64_t>(PHILOX_M0) * counter[0];
+			const uint64_t PRODUCT1 = static_cast<uint64_t>(PHILOX_M1) * counter[2];
+
+			const uint32_t NEXT[4] { static_cast<uint32_t>(PRODUCT1 >> 32) ^ counter[1] ^ key[0],
+				static_cast<uint32_t>(PRODUCT1), static_cast<uint32_t>(PRODUCT0 >> 32) ^ counter[3] ^ key[1],
+				static_cast<uint32_t>(PRODUCT0) };
+
+			for (uint32_t word = 0; word < 4; word++)
+				counter[word] = NEXT[word];
+
+			key[0] += PHILOX_W0;
+			key[1] += PHILOX_W1;
+		}
+
+		return { { counter[0], counter[1], counter[2], counter[3] } };
+	}
+
+	// Uses the top 24 bits, which is all the precision a float in [0, 1) can hold
+	float toUnitFloat(uint32_t bits)
+	{
+		return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// Maps the bits onto [min, max] with a multiply instead of a modulo, the bias is negligible for small ranges
+	int toRangedInt(uint32_t bits, int min, int max)
+	{
+		const uint64_t RANGE = static_cast<uint64_t>(static_cast<int64_t>(max) - min + 1);
+		return static_cast<int>(min + static_cast<int64_t>((bits * RANGE) >> 32));
+	}
+
+	// Walks the blocks covering the index range, each block yields four consecutive values
+	template<typename T, typename Convert>
+	void fillValues(uint64_t seed, uint32_t stream, uint64_t first_index, T* values, uint32_t count, Convert convert)
+	{
+		uint64_t index = first_index;
+		uint32_t written = 0;
+
+		while (written < count)
+		{
+			const PhiloxBlock BLOCK = philox(seed, stream, index / 4);
+
+			for (uint32_t lane = static_cast<uint32_t>(index % 4); lane < 4 && written < count; lane++, index++)
+				values[written++] = convert(BLOCK.m_values[lane]);
+		}
+	}
 }
 
 namespace Random
@@ -21,4 +85,42 @@ namespace Random
 		std::uniform_real_distribution<float> randGenerator(min, max);
 		return randGenerator(randEngine);
 	}
+
+	uint64_t generateSeed()
+	{
+		return static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+	}
+
+	uint32_t getBits(uint64_t seed, uint32_t stream, uint64_t index)
+	{
+		return philox(seed, stream, index / 4).m_values[index % 4];
+	}
+
+	float getFloat(uint64_t seed, uint32_t stream, uint64_t index, float min, float max)
+	{
+		return min + (max - min) * toUnitFloat(getBits(seed, stream, index));
+	}
+
+	int getInt(uint64_t seed, uint32_t stream, uint64_t index, int min, int max)
+	{
+		return toRangedInt(getBits(seed, stream, index), min, max);
+	}
+
+	void fillFloats(uint64_t seed, uint32_t stream, uint64_t first_index, float* values, uint32_t count, float min,
+		float max)
+	{
+		const float RANGE = max - min;
+		fillValues(seed, stream, first_index, values, count, [min, RANGE](uint32_t bits)
+		{
+			return min + RANGE * toUnitFloat(bits);
+		});
+	}
+
+	void fillInts(uint64_t seed, uint32_t stream, uint64_t first_index, int* values, uint32_t count, int min, int max)
+	{
+		fillValues(seed, stream, first_index, values, count, [min, max](uint32_t bits)
+		{
+			return toRangedInt(bits, min, max);
+		});
+	}
 }
\ No newline at end of file
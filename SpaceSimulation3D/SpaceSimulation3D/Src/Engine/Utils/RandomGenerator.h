@@ -1,7 +1,24 @@
 #pragma once
+#include <cstdint>
 
 namespace Random
 {
 	int generateInt(int min, int max);
 	float generateFloat(float min, float max);
+
+	// Counter-based generation (Philox4x32-10). Every value is a pure function of its seed, stream and index, so
+	// values can be generated in any order and on any thread and still come out identical for the same seed.
+	// Streams keep independent sequences (e.g. one per generated property) from sharing values
+	uint64_t generateSeed(); // Returns a seed that differs between runs
+
+	uint32_t getBits(uint64_t seed, uint32_t stream, uint64_t index); // Returns 32 random bits
+	float getFloat(uint64_t seed, uint32_t stream, uint64_t index, float min, float max); // Returns a float in [min, max)
+	int getInt(uint64_t seed, uint32_t stream, uint64_t index, int min, int max); // Returns an int in [min, max]
+
+	// fillFloats() : Writes the values at indices [first_index, first_index + count) of the stream, as floats in [min, max)
+	void fillFloats(uint64_t seed, uint32_t stream, uint64_t first_index, float* values, uint32_t count, float min,
+		float max);
+
+	// fillInts() : Writes the values at indices [first_index, first_index + count) of the stream, as ints in [min, max]
+	void fillInts(uint64_t seed, uint32_t stream, uint64_t first_index, int* values, uint32_t count, int min, int max);
 }
\ No newline at end of file
@@ -1,7 +1,115 @@
+#ifndef HEADLESS_ONLY
 #include "Core/ApplicationCore.h"
+#endif
+#include "Core/HeadlessCore.h"
+#include "Benchmarks/Benchmarks.h"
+#include "Engine/Utils/LoggingManager.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	// readCount() : Reads a whole number that fits the setting, keeping the setting as it was (with a warning) if the
+	// value is anything else
+	template<typename T>
+	void readCount(const std::string& option, const std::string& value, T& setting)
+	{
+		size_t length = 0;
+		unsigned long long number = 0;
+		try
+		{
+			number = std::stoull(value, &length);
+		}
+		catch (const std::logic_error&) // Not a number, or out of range
+		{
+			length = 0;
+		}
+
+		if (length == 0 || length != value.size() || value.find('-') != std::string::npos ||
+			number > std::numeric_limits<T>::max())
+			OutputLog("Invalid value for " + option + ": " + value + ", using the default", Logging::Severity::WARNING);
+		else
+			setting = static_cast<T>(number);
+	}
+
+	// readSeconds() : Reads a duration of zero or more seconds, keeping the setting as it was (with a warning) if the
+	// value is anything else
+	void readSeconds(const std::string& option, const std::string& value, double& setting)
+	{
+		size_t length = 0;
+		double seconds = 0.0;
+		try
+		{
+			seconds = std::stod(value, &length);
+		}
+		catch (const std::logic_error&)
+		{
+			length = 0;
+		}
+
+		if (length == 0 || length != value.size() || !std::isfinite(seconds) || seconds < 0.0)
+			OutputLog("Invalid value for " + option + ": " + value + ", using the default", Logging::Severity::WARNING);
+		else
+			setting = seconds;
+	}
+
+	// parseHeadlessSettings() : Reads the "--ticks N", "--seconds S", "--asteroids N", "--seed N", "--threads N" and
+	// "--no-mutual-gravity" options from the given argument onwards
+	HeadlessSettings parseHeadlessSettings(int argc, char** argv, int first_option)
+	{
+		HeadlessSettings settings;
+
+		for (int i = first_option; i < argc; i++)
+		{
+			const std::string OPTION = argv[i];
+			const bool HAS_VALUE = i + 1 < argc;
+
+			if (OPTION == "--no-mutual-gravity")
+				settings.m_mutualGravity = false;
+			else if (OPTION == "--ticks" && HAS_VALUE)
+				readCount(OPTION, argv[++i], settings.m_numTicks);
+			else if (OPTION == "--seconds" && HAS_VALUE)
+				readSeconds(OPTION, argv[++i], settings.m_simulatedSeconds);
+			else if (OPTION == "--asteroids" && HAS_VALUE)
+				readCount(OPTION, argv[++i], settings.m_numAsteroids);
+			else if (OPTION == "--seed" && HAS_VALUE)
+				readCount(OPTION, argv[++i], settings.m_seed);
+			else if (OPTION == "--threads" && HAS_VALUE)
+				readCount(OPTION, argv[++i], settings.m_numThreads);
+			else
+				OutputLog("Unknown headless option: " + OPTION, Logging::Severity::WARNING);
+		}
+
+		return settings;
+	}
+}
 
 int main(int argc, char** argv)
 {
+	// Passing "--benchmark [filter]" runs the benchmarks instead of opening the simulation window
+	if (argc > 1 && std::string(argv[1]) == "--benchmark")
+	{
+		Benchmarks::runBenchmarks(argc > 2 ? argv[2] : "");
+		return 0;
+	}
+
+	// Passing "--headless [options]" steps the simulation without a window or OpenGL context
+	const bool HEADLESS = argc > 1 && std::string(argv[1]) == "--headless";
+
+#ifdef HEADLESS_ONLY
+	// Built without GLFW and OpenGL (see the README), so there is no window to open and every run is headless
+	HeadlessCore headless(parseHeadlessSettings(argc, argv, HEADLESS ? 2 : 1));
+#else
+	if (HEADLESS)
+	{
+		HeadlessCore headless(parseHeadlessSettings(argc, argv, 2));
+		return 0;
+	}
+
 	ApplicationCore application;
+#endif
 	return 0;
 }
\ No newline at end of file